@@ -54,6 +54,7 @@ struct FXRepaint;
 struct FXInput;
 struct FXHandles;
 struct FXInvocation;
+struct FXSubscription;
 
 
 
@@ -66,6 +67,14 @@ enum FXInputMode {
   };
 
 
+/// Event compression modes
+enum FXEventCompression {
+  COMPRESS_NONE      = 0,           /// Dispatch every event
+  COMPRESS_MOTION    = 1,           /// Collapse queued motion events for same window
+  COMPRESS_CONFIGURE = 2            /// Collapse queued configure events for same window
+  };
+
+
 /// All ways of being modal
 enum FXModality {
   MODAL_FOR_NONE,                 /// Non modal event loop (dispatch normally)
@@ -174,12 +183,27 @@ private:
   FXWindow        *dragWindow;          // Drag source window
   FXWindow        *refresher;           // GUI refresher pointer
   FXWindow        *refresherstop;       // GUI refresher end pointer
+  FXWindow       **refreshees;          // Windows to be refreshed by themselves
+  FXint            nrefreshees;         // Number of such windows
+  FXint            maxrefreshees;       // Size of array of such windows
+  FXHash           subscriptions;       // Subscription of each window
+  FXHash           subscribers;         // Subscribers to each target
+  FXTime           refreshInterval;     // Interval between refresh sweeps
+  FXival           refreshcount;        // Windows visited in this sweep
+  FXival           refreshvisits;       // Windows visited in last sweep
   FXPopup         *popupWindow;         // Current popup window
   FXRootWindow    *root;                // Root window
   FXVisual        *monoVisual;          // Monochrome visual
   FXVisual        *defaultVisual;       // Default [color] visual
-  FXTimer         *timers;              // List of timers, sorted by time
+  FXTimer        **timers;              // Heap of timers, soonest first
+  FXint            ntimers;             // Number of timers in heap
+  FXint            maxtimers;           // Size of timer heap
+  FXlong           timerstamp;          // Stamp of latest timer
+  FXHash           timermap;            // Timers of each target
   FXChore         *chores;              // List of chores
+  FXChore         *chorelast;           // Last chore in list
+  FXlong           chorestamp;          // Stamp of latest chore
+  FXHash           choremap;            // Chores of each target
   FXRepaint       *repaints;            // Unhandled repaint rectangles
   FXTimer         *timerrecs;           // List of recycled timer records
   FXChore         *chorerecs;           // List of recycled chore records
@@ -211,6 +235,7 @@ private:
   FXTime           autoHideDelay;       // Cursor autohide delay time
   FXint            dragDelta;           // Minimum distance considered a move
   FXint            wheelLines;          // Scroll by this many lines
+  FXuint           compression;         // Event compression modes
   FXint            scrollBarSize;       // Scrollbar size
   FXColor          borderColor;         // Border color
   FXColor          baseColor;           // Background color of GUI controls
@@ -340,6 +365,7 @@ private:
   void            *xim;                 // Input method
   FXbool           shmi;                // Use XSHM Image possible
   FXbool           shmp;                // Use XSHM Pixmap possible
+  void            *shmsegments[4];      // Pool of unused XSHM segments
   FXbool           xrender;             // XRender available
   FXbool           synchronize;         // Synchronized
 
@@ -354,6 +380,9 @@ private:
   static void CDECL immediatesignalhandler(int sig);
   void leaveWindow(FXWindow *window,FXWindow *ancestor);
   void enterWindow(FXWindow *window,FXWindow *ancestor);
+  void unlinkTimer(FXTimer* t);
+  void unlinkChore(FXChore* c);
+  void unlinkRefresh(FXWindow* window);
   void selectionSetData(const FXWindow* window,FXDragType type,FXuchar* data,FXuint size);
   void selectionGetData(const FXWindow* window,FXDragType type,FXuchar*& data,FXuint& size);
   void selectionGetTypes(const FXWindow* window,FXDragType*& types,FXuint& numtypes);
@@ -365,6 +394,11 @@ private:
   void dragdropGetTypes(const FXWindow* window,FXDragType*& types,FXuint& numtypes);
   void openInputDevices();
   void closeInputDevices();
+#ifndef WIN32
+  void* getShmSegment(FXuval size);
+  void putShmSegment(void* segment);
+  void freeShmSegments();
+#endif
 #ifdef WIN32
   static FXival CALLBACK wndproc(FXID hwnd,FXuint iMsg,FXuval wParam,FXival lParam);
 protected:
@@ -389,6 +423,7 @@ public:
   long onCmdQuit(FXObject*,FXSelector,void*);
   long onCmdDump(FXObject*,FXSelector,void*);
   long onCmdHover(FXObject*,FXSelector,void*);
+  long onCmdRefresh(FXObject*,FXSelector,void*);
 
 public:
 
@@ -397,6 +432,7 @@ public:
     ID_QUIT=1,    /// Terminate the application normally
     ID_DUMP,      /// Dump the current widget tree
     ID_HOVER,
+    ID_REFRESH,
     ID_LAST
     };
 
@@ -611,6 +647,9 @@ public:
   * mesage handler; often you will want to pass the file descriptor fd itself
   * as the value for ptr so that the message handler knows which file descriptor
   * is involved.
+  * Descriptors which can not be polled, such as regular files, are always
+  * considered ready for reading and writing, and the corresponding messages
+  * are sent on each pass through the event loop until the input is removed.
   */
   FXbool addInput(FXObject *tgt,FXSelector sel,FXInputHandle fd,FXuint mode=INPUT_READ,FXptr ptr=nullptr);
 
@@ -723,6 +762,47 @@ public:
   */
   void forceRefresh();
 
+  /**
+  * Schedule a SEL_UPDATE refresh of just the given window, to be
+  * performed at some future time.
+  */
+  void refresh(FXWindow* window);
+
+  /**
+  * Subscribe window to changes of target tgt; refreshSubscribers(tgt)
+  * schedules a SEL_UPDATE refresh of every window subscribed to tgt.
+  * A window subscribes to one target at a time; it is unsubscribed
+  * automatically when it is destroyed.  Widgets connected to an
+  * FXDataTarget subscribe to it while the refresh interval is set.
+  */
+  void subscribe(FXWindow* window,FXObject* tgt);
+
+  /**
+  * Unsubscribe window.
+  */
+  void unsubscribe(FXWindow* window);
+
+  /**
+  * Schedule a SEL_UPDATE refresh of every window subscribed to tgt.
+  */
+  void refreshSubscribers(FXObject* tgt);
+
+  /**
+  * Change interval between refreshes of the entire widget tree.
+  * By default, this is zero, and refresh() schedules a refresh of the
+  * entire widget tree right away, i.e. after each event is handled.
+  * If set, refresh() schedules it to start no sooner than the given
+  * time after the previous one started; in between, only windows
+  * scheduled with refresh(window) or refreshSubscribers() are refreshed.
+  */
+  void setRefreshInterval(FXTime ns);
+
+  /// Return interval between refreshes of the entire widget tree
+  FXTime getRefreshInterval() const { return refreshInterval; }
+
+  /// Return number of windows visited in the last refresh of the entire widget tree
+  FXival getRefreshVisits() const { return refreshvisits; }
+
   /**
   * Flush drawing commands to display; if sync then wait till drawing commands
   * have been performed.
@@ -814,6 +894,18 @@ public:
   void setWheelLines(FXint lines);
   FXint getWheelLines() const { return wheelLines; }
 
+  /**
+  * Access event compression modes.
+  * When compressing, a motion or configure event is collapsed with the ones
+  * queued right behind it for the same window, and only the latest is
+  * dispatched; the number of events merged into it is passed in the
+  * coalesced member of FXEvent.
+  * Both motion and configure events are compressed by default; handlers
+  * which need every sample should turn compression off.
+  */
+  void setEventCompression(FXuint modes);
+  FXuint getEventCompression() const { return compression; }
+
   /// Access scroll bar slot size
   void setScrollBarSize(FXint size);
   FXint getScrollBarSize() const { return scrollBarSize; }
@@ -1003,6 +1003,25 @@ static inline FXbool atomicBoolDCas(volatile EType* ptr,EType cmpa,EType cmpb,ET
   return atomicBoolDCas((volatile FXptr*)ptr,(FXptr)cmpa,(FXptr)cmpb,(FXptr)a,(FXptr)b);
   }
 
+
+///// Atomic wait and notify
+
+
+/**
+* Block the calling thread while the variable at ptr still contains expect, until
+* woken by atomicNotify() or atomicNotifyAll(), or until the relative timeout nsec
+* has elapsed.  Returns immediately if the variable no longer contains expect.
+* Spurious wakeups are possible, so the caller should re-examine the variable.
+* Return false if timed out, and true otherwise.
+*/
+extern FXAPI FXbool atomicWait(volatile FXuint* ptr,FXuint expect,FXTime nsec=forever);
+
+/// Wake one thread blocked in atomicWait() on variable at ptr
+extern FXAPI void atomicNotify(volatile FXuint* ptr);
+
+/// Wake all threads blocked in atomicWait() on variable at ptr
+extern FXAPI void atomicNotifyAll(volatile FXuint* ptr);
+
 }
 
 #endif
@@ -40,7 +40,6 @@ namespace FX {
 */
 class FXAPI FXBarrier {
 private:
-  FXCondition     condition;
   FXMutex         mutex;
   volatile FXuint generation;
   volatile FXuint thresh;
@@ -33,15 +33,14 @@ class FXThreadPool;
 * completion counter when started, and decrement() when finished.
 * The monitoring thread can call wait(), wait(nsec), or done() to determine
 * the status of the concurrent activity.
-* Only one thread is allowed to call any of the wait() functions; but multiple
-* threads can call increment() or decrement().
+* Multiple threads can call increment() or decrement(), and multiple threads may
+* wait for the counter to become zero.
 * The completion counter can not be destroyed until the last thread decrements
 * the counter back down to zero.
 */
 class FXAPI FXCompletion {
 private:
-  FXSemaphore     semaphore;    // Signalled when last task done
-  volatile FXuint counter;      // Task counter
+  volatile FXuint counter;      // Task counter, and waiting flag
 private:
   FXCompletion(const FXCompletion&);
   FXCompletion& operator=(const FXCompletion&);
@@ -51,7 +50,7 @@ public:
   FXCompletion();
 
   /// Return current counter value
-  FXuint count() const { return counter; }
+  FXuint count() const { return counter&0x7FFFFFFF; }
 
   /// Increment counter by cnt
   void increment(FXuint cnt=1);
@@ -66,7 +65,7 @@ public:
   FXbool wait(FXTime nsec);
 
   /// Return true if count is zero
-  FXbool done() const { return (counter==0); }
+  FXbool done() const { return (counter&0x7FFFFFFF)==0; }
 
   /// Wait till count becomes zero, then destroy
  ~FXCompletion();
@@ -0,0 +1,307 @@
+/********************************************************************************
+*                                                                               *
+*                           C o r o u t i n e   S u p p o r t                   *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#ifndef FXCOROUTINE_H
+#define FXCOROUTINE_H
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define FOX_HAVE_COROUTINES 1
+#endif
+#endif
+
+#if defined(FOX_HAVE_COROUTINES)
+
+#include <coroutine>
+#include <exception>
+
+#ifndef FXTASKDISPATCHER_H
+#include "FXTaskDispatcher.h"
+#endif
+
+namespace FX {
+
+/**
+* C++20 coroutine support.
+*
+* Coroutines returning FXCoTask may await handles becoming ready, timeouts,
+* and moving from the thread running an FXDispatcher to a worker thread of an
+* FXThreadPool, and back.  This allows asynchronous code to be written as
+* straight-line code, without a thread for each connection, and without
+* callback objects, as the awaiters live in the coroutine's frame.
+*
+*   FXCoTask<FXlong> serve(FXTaskDispatcher* disp,FXThreadPool* pool,FXInputHandle fd){
+*     while(co_await FXAwaitHandle(disp,fd,FXDispatcher::InputRead,5000000000)){
+*       ... read request ...
+*       co_await FXAwaitThreadPool(pool);       // Now running on worker thread
+*       ... crunch ...
+*       co_await FXAwaitDispatcher(disp);       // Back on dispatcher thread
+*       ... write reply ...
+*       }
+*     co_return count;
+*     }
+*
+* Awaiting a handle or a timeout must be done on the thread running the
+* dispatcher, as FXDispatcher is not thread-safe; use FXAwaitDispatcher()
+* to get back there from a worker thread.
+* This header is only available when compiling for C++20 or later.
+*/
+
+
+/// Promise parts common to all FXCoTask types
+class FXCoPromise {
+public:
+  volatile FXptr          state=nullptr;        // Awaiting coroutine, or done
+  std::exception_ptr      exception;            // Exception thrown by coroutine
+  FXbool                  started=false;        // Coroutine was started
+  FXbool                  detached=false;       // Frame destroys itself when done
+public:
+
+  /// At final suspension, resume the awaiting coroutine, if any
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template<typename PROMISE>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<PROMISE> h) noexcept {
+      FXCoPromise& promise=h.promise();
+      FXptr awaiting=atomicSet(&promise.state,(FXptr)&promise);
+      if(awaiting) return std::coroutine_handle<>::from_address(awaiting);
+      if(promise.detached){
+        if(promise.exception){ fxwarning("FXCoTask: detached task terminated by exception.\n"); }
+        h.destroy();
+        }
+      return std::noop_coroutine();
+      }
+    void await_resume() const noexcept { }
+    };
+
+  /// Coroutines start suspended
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+
+  /// And resume their awaiter when done
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  /// Keep exception to be rethrown to the awaiter
+  void unhandled_exception(){ exception=std::current_exception(); }
+
+  /// Let coroutine awaiting resume when done; start coroutine h if needed
+  std::coroutine_handle<> await(std::coroutine_handle<> h,std::coroutine_handle<> awaiting){
+    if(!started){
+      started=true;
+      state=awaiting.address();
+      return h;
+      }
+    if(atomicBoolCas(&state,(FXptr)nullptr,awaiting.address())){
+      return std::noop_coroutine();
+      }
+    return awaiting;
+    }
+
+  /// Return true if done
+  FXbool done() const { return state==(FXptr)this; }
+  };
+
+
+/**
+* FXCoTask is the return type of a coroutine producing a value of type TYPE.
+* The coroutine does not start until it is either awaited by another coroutine,
+* or explicitly started with start() or detach().
+* When awaited, the result of co_return is passed to the awaiting coroutine, and
+* an exception thrown by the coroutine is rethrown there.  A task which was
+* started earlier may be awaited later, also from another thread; the awaiting
+* coroutine then resumes when the task completes, or right away if it already did.
+* An FXCoTask owns its coroutine; it must not be destroyed while the coroutine
+* is suspended in the middle, unless it was detached.
+*/
+template<typename TYPE=void>
+class FXCoTask {
+public:
+  class promise_type : public FXCoPromise {
+  public:
+    TYPE value{};
+  public:
+    FXCoTask get_return_object(){ return FXCoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    void return_value(TYPE v){ value=static_cast<TYPE&&>(v); }
+    };
+private:
+  std::coroutine_handle<promise_type> handle;
+private:
+  explicit FXCoTask(std::coroutine_handle<promise_type> h):handle(h){ }
+  FXCoTask(const FXCoTask&)=delete;
+  FXCoTask& operator=(const FXCoTask&)=delete;
+public:
+
+  /// Move task
+  FXCoTask(FXCoTask&& org):handle(org.handle){ org.handle=nullptr; }
+
+  /// Start running the coroutine, until it first suspends
+  void start(){ handle.promise().started=true; handle.resume(); }
+
+  /// Start running the coroutine; the coroutine cleans up after itself
+  /// when it completes, and this object becomes empty
+  void detach(){ std::coroutine_handle<promise_type> h=handle; handle=nullptr; h.promise().started=true; h.promise().detached=true; h.resume(); }
+
+  /// Return true if coroutine has completed; its frame is kept until
+  /// this object is destroyed
+  FXbool done() const { return handle && handle.promise().done(); }
+
+  /// Return result of completed coroutine, or rethrow its exception
+  TYPE& get(){ if(handle.promise().exception) std::rethrow_exception(handle.promise().exception); return handle.promise().value; }
+
+  /// Awaiting task starts it, and suspends the awaiting coroutine until it is done
+  struct Awaiter {
+    FXCoTask* task;
+    bool await_ready() const noexcept { return task->handle.promise().done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept { return task->handle.promise().await(task->handle,awaiting); }
+    TYPE await_resume(){ return static_cast<TYPE&&>(task->get()); }
+    };
+  Awaiter operator co_await() noexcept { return Awaiter{this}; }
+
+  /// Destroy the coroutine
+ ~FXCoTask(){ if(handle) handle.destroy(); }
+  };
+
+
+/// FXCoTask of coroutine without result
+template<>
+class FXCoTask<void> {
+public:
+  class promise_type : public FXCoPromise {
+  public:
+    FXCoTask get_return_object(){ return FXCoTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    void return_void(){ }
+    };
+private:
+  std::coroutine_handle<promise_type> handle;
+private:
+  explicit FXCoTask(std::coroutine_handle<promise_type> h):handle(h){ }
+  FXCoTask(const FXCoTask&)=delete;
+  FXCoTask& operator=(const FXCoTask&)=delete;
+public:
+  FXCoTask(FXCoTask&& org):handle(org.handle){ org.handle=nullptr; }
+  void start(){ handle.promise().started=true; handle.resume(); }
+  void detach(){ std::coroutine_handle<promise_type> h=handle; handle=nullptr; h.promise().started=true; h.promise().detached=true; h.resume(); }
+  FXbool done() const { return handle && handle.promise().done(); }
+  void get(){ if(handle.promise().exception) std::rethrow_exception(handle.promise().exception); }
+  struct Awaiter {
+    FXCoTask* task;
+    bool await_ready() const noexcept { return task->handle.promise().done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept { return task->handle.promise().await(task->handle,awaiting); }
+    void await_resume(){ task->get(); }
+    };
+  Awaiter operator co_await() noexcept { return Awaiter{this}; }
+ ~FXCoTask(){ if(handle) handle.destroy(); }
+  };
+
+
+/**
+* Await handle becoming ready for the given mode, or a timeout, if a
+* finite timeout is given.  The awaiting coroutine is resumed by the
+* dispatcher's thread, with the mode which was raised, or zero if the
+* timeout expired first or the handle could not be watched.
+* The handle must not already be watched by the dispatcher.
+*/
+class FXAwaitHandle {
+private:
+  FXDispatcher           *dispatcher;
+  FXInputHandle           hnd;
+  FXuint                  mode;
+  FXTime                  timeout;
+  FXuint                  raised;
+  std::coroutine_handle<> waiter;
+private:
+  FXDispatcher::HandleCallback handleCallback(){ return FXDispatcher::HandleCallback::create<FXAwaitHandle,&FXAwaitHandle::onHandle>(this); }
+  FXDispatcher::TimeoutCallback timeoutCallback(){ return FXDispatcher::TimeoutCallback::create<FXAwaitHandle,&FXAwaitHandle::onTimeout>(this); }
+  FXbool onHandle(FXDispatcher*,FXInputHandle,FXuint m,void*){
+    std::coroutine_handle<> w=waiter;
+    if(timeout<forever) dispatcher->remTimeout(timeoutCallback());
+    dispatcher->remHandle(hnd);
+    raised=m;
+    w.resume();
+    return true;
+    }
+  FXbool onTimeout(FXDispatcher*,FXTime,void*){
+    std::coroutine_handle<> w=waiter;
+    dispatcher->remHandle(hnd);
+    raised=0;
+    w.resume();
+    return true;
+    }
+public:
+  FXAwaitHandle(FXDispatcher* d,FXInputHandle h,FXuint m=FXDispatcher::InputRead,FXTime to=forever):dispatcher(d),hnd(h),mode(m),timeout(to),raised(0){ }
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> w){
+    waiter=w;
+    if(!dispatcher->addHandle(handleCallback(),hnd,mode)) return false;
+    if(timeout<forever) dispatcher->addInterval(timeoutCallback(),timeout);
+    return true;
+    }
+  FXuint await_resume() const noexcept { return raised; }
+  };
+
+
+/**
+* Await expiration of a time interval, in nanoseconds.  The awaiting
+* coroutine is resumed by the dispatcher's thread.
+*/
+class FXAwaitTimeout {
+private:
+  FXDispatcher           *dispatcher;
+  FXTime                  interval;
+  std::coroutine_handle<> waiter;
+private:
+  FXbool onTimeout(FXDispatcher*,FXTime,void*){ waiter.resume(); return true; }
+public:
+  FXAwaitTimeout(FXDispatcher* d,FXTime ns):dispatcher(d),interval(ns){ }
+  bool await_ready() const noexcept { return interval<=0; }
+  void await_suspend(std::coroutine_handle<> w){
+    waiter=w;
+    dispatcher->addInterval(FXDispatcher::TimeoutCallback::create<FXAwaitTimeout,&FXAwaitTimeout::onTimeout>(this),interval);
+    }
+  void await_resume() const noexcept { }
+  };
+
+
+/**
+* Move the awaiting coroutine to a worker thread of the thread pool.
+* If the thread pool does not accept the task, the coroutine just
+* continues on the current thread.
+*/
+class FXAwaitThreadPool : public FXRunnable {
+private:
+  FXThreadPool           *threadpool;
+  std::coroutine_handle<> waiter;
+public:
+  FXAwaitThreadPool(FXThreadPool* p):threadpool(p){ }
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> w){ waiter=w; return threadpool->execute(this); }
+  void await_resume() const noexcept { }
+  virtual FXint run(){ waiter.resume(); return 0; }
+  };
+
+
+/**
+* Move the awaiting coroutine to the thread running the task dispatcher.
+* If the dispatcher has not been initialized, the coroutine just continues
+* on the current thread.
+*/
+class FXAwaitDispatcher : public FXRunnable {
+private:
+  FXTaskDispatcher       *dispatcher;
+  std::coroutine_handle<> waiter;
+public:
+  FXAwaitDispatcher(FXTaskDispatcher* d):dispatcher(d){ }
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> w){ waiter=w; return dispatcher->post(this); }
+  void await_resume() const noexcept { }
+  virtual FXint run(){ waiter.resume(); return 0; }
+  };
+
+}
+
+#endif
+
+#endif
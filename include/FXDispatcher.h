@@ -25,6 +25,7 @@ private:
   struct Signal;
   struct Idle;
   struct Timer;
+  struct Operation;
 private:
   FXHash        handles;                // Handle callbacks
   Signal      **signals;                // Signal callbacks
@@ -32,6 +33,8 @@ private:
   Idle         *idles;                  // Idle callbacks
   Timer        *timerrecs;              // Timer records
   Idle         *idlerecs;               // Idle records
+  Operation    *operations;             // Operations in progress
+  Operation    *operationrecs;          // Operation records
 private:
   FXDispatcher(const FXDispatcher&);
   FXDispatcher &operator=(const FXDispatcher&);
@@ -49,6 +52,9 @@ public:
   /// Idle callback when dispatcher is about to block
   typedef FXCallback<FXbool(FXDispatcher*,void*)> IdleCallback;
 
+  /// Completion callback when read or write is done
+  typedef FXCallback<FXbool(FXDispatcher*,FXInputHandle,FXival,void*)> CompletionCallback;
+
 public:
 
   /// Construct dispatcher object.
@@ -73,6 +79,22 @@ public:
   /// Return true if the handle was raised and the callback returned true.
   virtual FXbool dispatchHandle(FXInputHandle hnd,FXuint mode,FXuint flags);
 
+  /// Read up to len bytes from handle hnd into buffer buf, at offset off in the
+  /// file, or at the current position if off is -1.  When done, callback cb is
+  /// called with the number of bytes read, or a negative error code.
+  /// The buffer must remain valid until then.
+  virtual FXbool submitRead(CompletionCallback cb,FXInputHandle hnd,void* buf,FXival len,FXlong off=-1,void* ptr=nullptr);
+
+  /// Write up to len bytes from buffer buf to handle hnd, at offset off in the
+  /// file, or at the current position if off is -1.  When done, callback cb is
+  /// called with the number of bytes written, or a negative error code.
+  /// The buffer must remain valid until then.
+  virtual FXbool submitWrite(CompletionCallback cb,FXInputHandle hnd,const void* buf,FXival len,FXlong off=-1,void* ptr=nullptr);
+
+  /// Dispatch completion callback of read or write.
+  /// Return true if the callback returned true.
+  virtual FXbool dispatchCompletion(void* tag,FXival result);
+
   /// Add (optionally asynchronous) callback cb for signal sig to signal-set
   virtual FXbool addSignal(SignalCallback cb,FXint sig,void* ptr=nullptr,FXbool async=false);
 
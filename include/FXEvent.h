@@ -186,6 +186,7 @@ struct FXAPI FXEvent {
   FXRectangle rect;           /// Rectangle
   FXbool      synthetic;      /// True if synthetic expose event
   FXDragType  target;         /// Target drag type being requested
+  FXint       coalesced;      /// Number of events merged into this one
 
   /// Initialize empty event
   FXEvent(FXuint t=SEL_NONE){
@@ -219,6 +220,7 @@ struct FXAPI FXEvent {
     rect.h=0;
     synthetic=false;
     target=0;
+    coalesced=0;
     }
   };
 
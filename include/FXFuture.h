@@ -0,0 +1,334 @@
+/********************************************************************************
+*                                                                               *
+*                                  F u t u r e                                  *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXFUTURE_H
+#define FXFUTURE_H
+
+namespace FX {
+
+
+class FXThreadPool;
+
+
+/**
+* The state shared between an FXPromise and the FXFutures obtained from it.
+* It records whether a result is available, and keeps a completion counter
+* which is signaled when the promise is either fulfilled or broken.
+* When a thread pool is associated with the state, waiting for the result
+* will let the waiting thread help out processing tasks from that thread pool.
+*/
+class FXAPI FXFutureState {
+private:
+  FXCompletion    completion;   // Signaled when settled
+  FXThreadPool   *threadpool;   // Thread pool to help while waiting
+  volatile FXint  refs;         // Reference count
+  volatile FXuint status;       // Pending, settling, ready, or broken
+private:
+  FXFutureState(const FXFutureState&);
+  FXFutureState &operator=(const FXFutureState&);
+public:
+  enum {
+    Pending,    /// No result yet
+    Ready,      /// Result is available
+    Broken,     /// Promise was abandoned without result
+    Settling    /// Result is being stored
+    };
+public:
+
+  /// Create pending state, optionally associated with thread pool
+  FXFutureState(FXThreadPool* pool=nullptr);
+
+  /// Return associated thread pool
+  FXThreadPool* getThreadPool() const { return threadpool; }
+
+  /// Return status
+  FXuint getStatus() const { return status; }
+
+  /// Add reference
+  void ref();
+
+  /// Drop reference, and delete state when it was the last one
+  void unref();
+
+  /// Settle state to ready or broken; return false if already settled
+  FXbool settle(FXuint s);
+
+  /// Claim pending state for storing a result; return false if already claimed or settled
+  FXbool claim();
+
+  /// Settle claimed state to ready, after the result was stored
+  void publish();
+
+  /// Wait until settled, helping out the thread pool meanwhile
+  void wait();
+
+  /// Wait until settled or timeout; return false if timed out
+  FXbool wait(FXTime nsec);
+
+  /// Destroy state
+  virtual ~FXFutureState();
+  };
+
+
+/**
+* Shared state carrying a result value.
+*/
+template <typename Type>
+class FXFutureValue : public FXFutureState {
+public:
+  Type value;
+public:
+  FXFutureValue(FXThreadPool* pool=nullptr):FXFutureState(pool),value(){ }
+  };
+
+
+/**
+* Shared state without a result value.
+*/
+template <>
+class FXFutureValue<void> : public FXFutureState {
+public:
+  FXFutureValue(FXThreadPool* pool=nullptr):FXFutureState(pool){ }
+  };
+
+
+/**
+* Reference to shared state, managing the reference count.
+*/
+class FXAPI FXFutureRef {
+protected:
+  FXFutureState *state;
+public:
+
+  /// Construct empty reference
+  FXFutureRef():state(nullptr){ }
+
+  /// Construct reference to state
+  FXFutureRef(FXFutureState* s):state(s){ if(state) state->ref(); }
+
+  /// Copy reference
+  FXFutureRef(const FXFutureRef& org):state(org.state){ if(state) state->ref(); }
+
+  /// Assign reference
+  FXFutureRef& operator=(const FXFutureRef& org){ if(org.state) org.state->ref(); if(state) state->unref(); state=org.state; return *this; }
+
+  /// Return true if referring to some shared state
+  FXbool isValid() const { return state!=nullptr; }
+
+  /// Return true if the result is available
+  FXbool isReady() const { return state && state->getStatus()==FXFutureState::Ready; }
+
+  /// Return true if the promise was broken, and no result will be forthcoming
+  FXbool isBroken() const { return state && state->getStatus()==FXFutureState::Broken; }
+
+  /// Drop reference
+ ~FXFutureRef(){ if(state) state->unref(); }
+  };
+
+
+/**
+* An FXFuture represents the result of a computation which may not have completed
+* yet, typically a task executed by FXThreadPool::async().
+* The result is obtained with get(), which waits until the result is available.
+* While waiting, the calling thread helps out the FXThreadPool running the task,
+* so waiting for a future from inside a worker thread will not deadlock the pool.
+* If the promise was broken, for instance because the task threw an exception,
+* get() returns a default-constructed value, and isBroken() returns true.
+* Futures may be freely copied; all copies refer to the same result.
+*/
+template <typename Type>
+class FXFuture : public FXFutureRef {
+public:
+
+  /// Construct empty future
+  FXFuture(){ }
+
+  /// Construct future for shared state
+  FXFuture(FXFutureValue<Type>* s):FXFutureRef(s){ }
+
+  /// Wait until result is available or the promise is broken
+  void wait() const { if(state) state->wait(); }
+
+  /// Wait until result is available or timeout; return false if timed out
+  FXbool wait(FXTime nsec) const { return !state || state->wait(nsec); }
+
+  /// Wait for, and return result
+  const Type& get() const { if(!state){ fxerror("FXFuture::get: future is empty.\n"); } state->wait(); return static_cast<FXFutureValue<Type>*>(state)->value; }
+  };
+
+
+/**
+* Future without result value, signaling completion only.
+*/
+template <>
+class FXFuture<void> : public FXFutureRef {
+public:
+
+  /// Construct empty future
+  FXFuture(){ }
+
+  /// Construct future for shared state
+  FXFuture(FXFutureValue<void>* s):FXFutureRef(s){ }
+
+  /// Wait until completed or the promise is broken
+  void wait() const { if(state) state->wait(); }
+
+  /// Wait until completed or timeout; return false if timed out
+  FXbool wait(FXTime nsec) const { return !state || state->wait(nsec); }
+
+  /// Wait for completion
+  void get() const { if(!state){ fxerror("FXFuture::get: future is empty.\n"); } state->wait(); }
+  };
+
+
+/**
+* An FXPromise is the producing end of an FXFuture.  The producer fulfills the
+* promise by calling setValue(), after which the result becomes available to all
+* futures obtained through getFuture().
+* If the promise is destroyed before a value is set, the promise is broken, and
+* threads waiting for the future are released.
+*/
+template <typename Type>
+class FXPromise {
+private:
+  FXFutureValue<Type> *state;
+private:
+  FXPromise(const FXPromise&);
+  FXPromise &operator=(const FXPromise&);
+public:
+
+  /// Create promise; waiting for its future will help out the given thread pool
+  FXPromise(FXThreadPool* pool=nullptr):state(new FXFutureValue<Type>(pool)){ state->ref(); }
+
+  /// Return future for this promise
+  FXFuture<Type> getFuture() const { return FXFuture<Type>(state); }
+
+  /// Set result, making it available; return false if already set
+  FXbool setValue(const Type& v){
+    if(state->claim()){
+      state->value=v;
+      state->publish();
+      return true;
+      }
+    return false;
+    }
+
+  /// Break promise if not yet fulfilled
+ ~FXPromise(){ state->settle(FXFutureState::Broken); state->unref(); }
+  };
+
+
+/**
+* Promise without result value, signaling completion only.
+*/
+template <>
+class FXPromise<void> {
+private:
+  FXFutureValue<void> *state;
+private:
+  FXPromise(const FXPromise&);
+  FXPromise &operator=(const FXPromise&);
+public:
+
+  /// Create promise; waiting for its future will help out the given thread pool
+  FXPromise(FXThreadPool* pool=nullptr):state(new FXFutureValue<void>(pool)){ state->ref(); }
+
+  /// Return future for this promise
+  FXFuture<void> getFuture() const { return FXFuture<void>(state); }
+
+  /// Signal completion; return false if already signaled
+  FXbool setValue(){ return state->settle(FXFutureState::Ready); }
+
+  /// Break promise if not yet fulfilled
+ ~FXPromise(){ state->settle(FXFutureState::Broken); state->unref(); }
+  };
+
+
+/**
+* FXFutureTask is a helper for FXThreadPool::async().  It runs a copy of a functor on
+* a thread provided by the FXThreadPool, fulfills the promise with the functor's
+* result, and then deletes itself.
+*/
+template <typename Type,typename Functor>
+class FXFutureTask : public FXRunnable {
+  FXPromise<Type> promise;
+  Functor         functor;
+private:
+  FXFutureTask(const FXFutureTask&);
+  FXFutureTask &operator=(const FXFutureTask&);
+public:
+  FXFutureTask(FXThreadPool* pool,const Functor& fun):promise(pool),functor(fun){ }
+  FXFuture<Type> getFuture() const { return promise.getFuture(); }
+  virtual FXint run(){
+    try{
+      promise.setValue(functor());
+      }
+    catch(...){
+      delete this;
+      throw;
+      }
+    delete this;
+    return 0;
+    }
+  };
+
+
+/**
+* FXFutureTask for functors not returning a value.
+*/
+template <typename Functor>
+class FXFutureTask<void,Functor> : public FXRunnable {
+  FXPromise<void> promise;
+  Functor         functor;
+private:
+  FXFutureTask(const FXFutureTask&);
+  FXFutureTask &operator=(const FXFutureTask&);
+public:
+  FXFutureTask(FXThreadPool* pool,const Functor& fun):promise(pool),functor(fun){ }
+  FXFuture<void> getFuture() const { return promise.getFuture(); }
+  virtual FXint run(){
+    try{
+      functor();
+      promise.setValue();
+      }
+    catch(...){
+      delete this;
+      throw;
+      }
+    delete this;
+    return 0;
+    }
+  };
+
+
+// Execute copy of functor on thread pool, and return future for its result
+template <typename Functor>
+auto FXThreadPool::async(Functor fun,FXTime blocking) -> FXFuture<decltype(fun())> {
+  FXFutureTask<decltype(fun()),Functor>* task=new FXFutureTask<decltype(fun()),Functor>(this,fun);
+  FXFuture<decltype(fun())> future(task->getFuture());
+  if(!execute(task,blocking)){
+    delete task;
+    }
+  return future;
+  }
+
+}
+
+#endif
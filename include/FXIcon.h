@@ -103,6 +103,12 @@ public:
   */
   virtual void render();
 
+  /**
+  * Render the rectangle x,y,w,h of the icon; as the shape and etch
+  * bitmaps are made from the whole image, this renders the whole icon.
+  */
+  virtual void render(FXint x,FXint y,FXint w,FXint h);
+
   /**
   * Resize both client-side and server-side representations (if any) to the
   * given width and height.  The new representations typically contain garbage
@@ -76,26 +76,26 @@ private:
   virtual FXID GetDC() const;
   virtual int ReleaseDC(FXID) const;
 #else
-  void render_true_32(void *xim,FXuchar *img);
-  void render_true_24(void *xim,FXuchar *img);
-  void render_true_16_fast(void *xim,FXuchar *img);
-  void render_true_16_dither(void *xim,FXuchar *img);
-  void render_true_8_fast(void *xim,FXuchar *img);
-  void render_true_8_dither(void *xim,FXuchar *img);
-  void render_true_N_fast(void *xim,FXuchar *img);
-  void render_true_N_dither(void *xim,FXuchar *img);
-  void render_index_4_fast(void *xim,FXuchar *img);
-  void render_index_4_dither(void *xim,FXuchar *img);
-  void render_index_8_fast(void *xim,FXuchar *img);
-  void render_index_8_dither(void *xim,FXuchar *img);
-  void render_index_N_fast(void *xim,FXuchar *img);
-  void render_index_N_dither(void *xim,FXuchar *img);
-  void render_gray_8_fast(void *xim,FXuchar *img);
-  void render_gray_8_dither(void *xim,FXuchar *img);
-  void render_gray_N_fast(void *xim,FXuchar *img);
-  void render_gray_N_dither(void *xim,FXuchar *img);
-  void render_mono_1_fast(void *xim,FXuchar *img);
-  void render_mono_1_dither(void *xim,FXuchar *img);
+  void render_true_32(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_24(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_16_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_16_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_true_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_4_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_4_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_index_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_gray_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_gray_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_gray_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_gray_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_mono_1_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
+  void render_mono_1_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh);
 #endif
 protected:
   FXImage();
@@ -193,6 +193,14 @@ public:
   */
   virtual void render();
 
+  /**
+  * Render the rectangle x,y,w,h of the client-side pixels into the
+  * server-side representation of the image, for example after only
+  * that part of the pixels was changed.  The rectangle is clipped to
+  * the image.
+  */
+  virtual void render(FXint x,FXint y,FXint w,FXint h);
+
   /**
   * Release the client-side pixels buffer, free it if it was owned.
   * If it is not owned, the image just forgets about the buffer.
@@ -209,6 +217,8 @@ public:
   /**
   * Rescale pixels image to the specified width and height; this calls
   * resize() to adjust the client and server side representations.
+  * Quality 0 is nearest neighbor, 1 is box filtered, 2 is box filtered
+  * with gamma correction, 3 is Mitchell filtered, and 4 is Lanczos-3 filtered.
   */
   virtual void scale(FXint w,FXint h,FXint quality=0);
 
@@ -267,6 +277,15 @@ public:
   /// Colorize image based on luminance
   virtual void colorize(FXColor color);
 
+  /**
+  * Composite rectangle sx,sy,w,h of image src onto this image at dx,dy, using
+  * the Porter-Duff operator op, one of FXPixelBuffer::CompositeOver etc.
+  * Only the client-side pixels of both images are used; call render()
+  * afterwards to update the server-side representation.  The image src
+  * must be another image; compositing an image onto itself does nothing.
+  */
+  virtual void composite(const FXImage* src,FXint sx,FXint sy,FXint w,FXint h,FXint dx,FXint dy,FXuint op);
+
   /// Save pixel data only
   virtual FXbool savePixels(FXStream& store) const;
 
@@ -67,6 +67,12 @@ public:
   /// Remove item from queue, return true if success
   FXbool pop(FXptr& ptr);
 
+  /// Add up to n items to queue, return number of items added
+  FXuint push(const FXptr* ptrs,FXuint n);
+
+  /// Remove up to n items from queue, return number of items removed
+  FXuint pop(FXptr* ptrs,FXuint n);
+
   /// Destroy queue
  ~FXLFQueue();
   };
@@ -80,6 +86,8 @@ public:
   FXLFQueueOf(FXuint sz):FXLFQueue(sz){}
   FXbool push(TYPE* ptr){ return FXLFQueue::push((FXptr)ptr); }
   FXbool pop(TYPE*& ptr){ return FXLFQueue::pop((FXptr&)ptr); }
+  FXuint push(TYPE* const* ptrs,FXuint n){ return FXLFQueue::push((const FXptr*)ptrs,n); }
+  FXuint pop(TYPE** ptrs,FXuint n){ return FXLFQueue::pop((FXptr*)ptrs,n); }
   };
 
 }
@@ -48,14 +48,32 @@ class FXApp;
 * If the size of the optional data is zero, the message handler will be passed a
 * NULL pointer.
 * The maximum payload size passed with message() is 8192 bytes.
+* Messages are queued in a ring buffer in memory, and the main user-interface thread
+* is only awakened when the first message is queued; all messages which have been
+* queued by the time onMessage is called are delivered in one go.
+* When coalescing is turned on, only the last of the messages with the same target
+* and selector found in the channel at that time is delivered; this is useful for
+* progress reports, where only the latest state matters.
+* If the channel fills up because the main user-interface thread does not keep up,
+* message() waits until room becomes available; except when called by the main
+* user-interface thread itself, which would then wait forever, in which case
+* message() fails.
 */
 class FXAPI FXMessageChannel : public FXObject {
   FXDECLARE(FXMessageChannel)
 private:
-  FXApp *app;
+  FXApp               *app;
 protected:
-  FXInputHandle h[3];
-  FXMutex       m;
+  FXInputHandle        h[3];
+  FXMutex              m;
+private:
+  FXuchar             *ring;            // Message ring
+  volatile FXuint      whead;           // Head write pointer
+  volatile FXuint      wtail;           // Tail write pointer
+  volatile FXuint      rtail;           // Read pointer
+  volatile FXuint      signalled;       // Doorbell was rung
+  volatile FXThreadID  reader;          // Thread delivering the messages
+  FXbool               coalesce;        // Deliver only latest of same target and message
 protected:
   FXMessageChannel();
 private:
@@ -81,12 +99,24 @@ public:
   */
   FXApp* getApp() const { return app; }
 
+  /**
+  * Change coalescing of messages to the same target and selector.
+  */
+  void setCoalesce(FXbool flag){ coalesce=flag; }
+
+  /**
+  * Return true if coalescing messages.
+  */
+  FXbool getCoalesce() const { return coalesce; }
+
   /**
   * Send a message msg comprising of FXSEL(type,id) to a target tgt, and pass optional
   * data of size bytes.
   * This asynchronously calls the indicated handler in the context of the main GUI
   * thread's event loop.
   * Up to 8192 bytes may be passed along.
+  * Returns false if the channel is full and the caller is the thread delivering
+  * the messages; the caller may run the event loop, and try again.
   */
   FXbool message(FXObject* tgt,FXSelector msg,const void* data=nullptr,FXint size=0);
 
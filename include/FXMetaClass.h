@@ -32,6 +32,11 @@ typedef FXuint FXSelector;
 
 /// Describes a FOX object
 class FXAPI FXMetaClass {
+public:
+  typedef long (*Caller)(FXObject*,const void*,FXObject*,FXSelector,void*);
+private:
+  struct Range;
+  struct Table;
 private:
   const FXchar       *className;        // Class name
   FXObject*         (*manufacture)();   // Factory function
@@ -39,12 +44,15 @@ private:
   const void         *assoc;            // Associated handlers
   FXuint              nassocs;          // Count of handlers
   FXuint              assocsz;          // Size of association
+  Caller              caller;           // Calls handler of association
+  mutable Table      *volatile table;   // Flattened message map
 private:
   static const FXMetaClass **metaClassTable;    // Class table
   static FXuint              metaClassSlots;    // Number of slots
   static FXuint              metaClassCount;    // Number items
 private:
   static void resize(FXuint slots);
+  const Table* flatten() const;
 public:
   static void dumpMessageMap(const FXMetaClass* m);
   static void dumpMetaClasses();
@@ -54,11 +62,32 @@ private:
 public:
 
   /// Create one metaclass for each class
-  FXMetaClass(const FXchar* name,FXObject *(fac)(),const FXMetaClass* base,const void* ass,FXuint nass,FXuint assz);
+  FXMetaClass(const FXchar* name,FXObject *(fac)(),const FXMetaClass* base,const void* ass,FXuint nass,FXuint assz,Caller cal);
 
-  /// Search message map
+  /// Search message map of this class only
   const void* search(FXSelector key) const;
 
+  /// Search the first few entries of the message map of this class only
+  const void* searchLeading(FXSelector key) const {
+    const FXchar* lst=(const FXchar*)assoc;
+    for(FXuint n=(nassocs<8)?nassocs:8; n; --n,lst+=assocsz){
+      if(__unlikely(key<=((const FXSelector*)lst)[1]) && __likely(((const FXSelector*)lst)[0]<=key)) return lst;
+      }
+    return nullptr;
+    }
+
+  /// Search message map of this class and its base classes
+  const void* lookup(FXSelector key) const;
+
+  /// Dispatch message to handler of object of this class, or to its onDefault()
+  long dispatch(FXObject* object,FXObject* sender,FXSelector sel,void* ptr) const;
+
+  /// Call handler of message map entry of CLASS
+  template<typename CLASS>
+  static long call(FXObject* object,const void* entry,FXObject* sender,FXSelector sel,void* ptr){
+    return (static_cast<CLASS*>(object)->* static_cast<const typename CLASS::FXMapEntry*>(entry)->func)(sender,sel,ptr);
+    }
+
   /// Ask class name
   const FXchar* getClassName() const { return className; }
 
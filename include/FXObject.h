@@ -59,14 +59,23 @@ enum {
   private:
 
 
-/// Macro to set up class implementation
+/**
+* Macro to set up class implementation.
+* The handle() member it defines first tries the leading entries of the class's own
+* message map, and otherwise looks up the message in one table merging the message
+* maps of the class and all its base classes; the handler found is the same one a
+* class-by-class search would find.  Note that handle() does not call the handle() of
+* the base class: a handle() written by hand in a base class, instead of one defined
+* by FXIMPLEMENT(), is not consulted for messages sent to derived classes.  Override
+* onDefault(), or add message map entries, to intercept such messages instead.
+*/
 #define FXIMPLEMENT(classname,baseclassname,mapping,nmappings) \
   FX::FXObject* classname::manufacture(){return new classname;} \
-  const FX::FXMetaClass classname::metaClass(#classname,classname::manufacture,&baseclassname::metaClass,mapping,nmappings,sizeof(classname::FXMapEntry)); \
+  const FX::FXMetaClass classname::metaClass(#classname,classname::manufacture,&baseclassname::metaClass,mapping,nmappings,sizeof(classname::FXMapEntry),&FX::FXMetaClass::call<classname>); \
   const FX::FXMetaClass* classname::getMetaClass() const { return &classname::metaClass; } \
   long classname::handle(FX::FXObject* sender,FX::FXSelector sel,void* ptr){ \
-    const FXMapEntry* me=(const FXMapEntry*)metaClass.search(sel); \
-    return me ? (this->* me->func)(sender,sel,ptr) : baseclassname::handle(sender,sel,ptr); \
+    const FXMapEntry* me=(const FXMapEntry*)metaClass.searchLeading(sel); \
+    return me ? (this->* me->func)(sender,sel,ptr) : metaClass.dispatch(this,sender,sel,ptr); \
     }
 
 
@@ -82,11 +91,11 @@ enum {
 
 /// Macro to set up abstract class implementation
 #define FXIMPLEMENT_ABSTRACT(classname,baseclassname,mapping,nmappings) \
-  const FX::FXMetaClass classname::metaClass(#classname,FX::FXMetaClass::nullObject,&baseclassname::metaClass,mapping,nmappings,sizeof(classname::FXMapEntry)); \
+  const FX::FXMetaClass classname::metaClass(#classname,FX::FXMetaClass::nullObject,&baseclassname::metaClass,mapping,nmappings,sizeof(classname::FXMapEntry),&FX::FXMetaClass::call<classname>); \
   const FX::FXMetaClass* classname::getMetaClass() const { return &classname::metaClass; } \
   long classname::handle(FX::FXObject* sender,FX::FXSelector sel,void* ptr){ \
-    const FXMapEntry* me=(const FXMapEntry*)metaClass.search(sel); \
-    return me ? (this->* me->func)(sender,sel,ptr) : baseclassname::handle(sender,sel,ptr); \
+    const FXMapEntry* me=(const FXMapEntry*)metaClass.searchLeading(sel); \
+    return me ? (this->* me->func)(sender,sel,ptr) : metaClass.dispatch(this,sender,sel,ptr); \
     }
 
 
@@ -268,7 +268,8 @@ void FXParallelInvoke(Functor1& fun1,const Functor2& fun2,const Functor3& fun3,c
 */
 template <typename Functor,typename Index>
 class FXParallelForFunctor : public FXRunnable {
-  const Functor& functor;
+  const Functor&     functor;
+  const FXTaskGroup& group;
   const Index    fm;
   const Index    to;
   const Index    by;
@@ -276,8 +277,39 @@ private:
   FXParallelForFunctor(const FXParallelForFunctor&);
   FXParallelForFunctor &operator=(const FXParallelForFunctor&);
 public:
-  FXParallelForFunctor(const Functor& fun,Index f,Index t,Index b):functor(fun),fm(f),to(t),by(b){ }
-  virtual FXint run(){ for(Index ix=fm;ix<to;ix+=by){ functor(ix); } return 0; }
+  FXParallelForFunctor(const Functor& fun,const FXTaskGroup& g,Index f,Index t,Index b):functor(fun),group(g),fm(f),to(t),by(b){ }
+  virtual FXint run(){ for(Index ix=fm;ix<to && !group.isCancelled();ix+=by){ functor(ix); } return 0; }
+  };
+
+
+/// Parallel for loop functor running the piece matching the worker it runs on
+template <typename Functor,typename Index>
+class FXParallelForPlacedFunctor : public FXRunnable {
+  const Functor&   functor;
+  const FXTaskGroup& group;
+  FXThreadPool*    pool;
+  volatile FXuint* claimed;
+  const Index      fm;
+  const Index      by;
+  const Index      nits;
+  const Index      nc;
+private:
+  FXParallelForPlacedFunctor(const FXParallelForPlacedFunctor&);
+  FXParallelForPlacedFunctor &operator=(const FXParallelForPlacedFunctor&);
+public:
+  FXParallelForPlacedFunctor(const Functor& fun,const FXTaskGroup& g,FXThreadPool* p,volatile FXuint* cl,Index f,Index b,Index n,Index c):functor(fun),group(g),pool(p),claimed(cl),fm(f),by(b),nits(n),nc(c){ }
+  virtual FXint run(){
+    FXint w=pool->getWorkerIndex();
+    Index q=nits/nc,r=nits%nc,c=(0<=w)?((Index)w)%nc:0;
+    for(Index k=0; k<nc; ++k,c=(c+1<nc)?c+1:0){
+      if(atomicBoolCas(&claimed[c],0U,1U)){
+        Index b=c*q+(c<r?c:r),e=b+q+(c<r);
+        for(Index ix=fm+b*by; b<e && !group.isCancelled(); ix+=by,++b){ functor(ix); }
+        break;
+        }
+      }
+    return 0;
+    }
   };
 
 
@@ -285,22 +317,46 @@ public:
 * Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to.
 * The index range is split into at most nc pieces.  Each piece is executed in parallel
 * using the given FXThreadPool.
+* If the thread pool pins its workers using compact placement, each piece is preferably
+* executed by the worker whose index matches the piece number, so that neighboring
+* pieces are processed on neighboring cores.
+* When called from a task of an FXTaskGroup which gets cancelled, the loop stops
+* executing further iterations.
 */
 template <typename Functor,typename Index>
 void FXParallelFor(FXThreadPool* pool,Index fm,Index to,Index by,Index nc,const Functor& fun){
   const FXuval size=(sizeof(FXParallelForFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong);
+  const FXuval psize=(sizeof(FXParallelForPlacedFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong);
   if(fm<to){
     if(by<(to-fm)){
       FXTaskGroup group(pool);
-      FXulong space[FXParallelMax*((sizeof(FXParallelForFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong))];
       Index nits=1+(to-fm-1)/by,ni,c;
       if(nc>FXParallelMax) nc=FXParallelMax;
       if(nc>nits) nc=nits;
-      for(c=0; c<nc; fm+=ni*by,++c){
-        ni=(nits+nc-1-c)/nc;
-        group.execute(new (&space[c*size]) FXParallelForFunctor<Functor,Index>(fun,fm,fm+ni*by,by));
+      if(pool->getPlacement()==FXThreadPool::PlacementCompact){
+        FXulong space[FXParallelMax*((sizeof(FXParallelForPlacedFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong))];
+        volatile FXuint claimed[FXParallelMax]={0};
+        FXRunnable* tasks[FXParallelMax];
+        for(c=0; c<nc; ++c){
+          tasks[c]=new (&space[c*psize]) FXParallelForPlacedFunctor<Functor,Index>(fun,group,pool,claimed,fm,by,nits,nc);
+          }
+        for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+          tasks[c]->run();
+          }
+        group.wait();
+        }
+      else{
+        FXulong space[FXParallelMax*((sizeof(FXParallelForFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong))];
+        FXRunnable* tasks[FXParallelMax];
+        for(c=0; c<nc; fm+=ni*by,++c){
+          ni=(nits+nc-1-c)/nc;
+          tasks[c]=new (&space[c*size]) FXParallelForFunctor<Functor,Index>(fun,group,fm,fm+ni*by,by);
+          }
+        for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+          tasks[c]->run();
+          }
+        group.wait();
         }
-      group.wait();
       }
     else{
       fun(fm);
@@ -342,6 +398,518 @@ void FXParallelFor(Index fm,Index to,Index by,const Functor& fun){
   FXParallelFor(FXThreadPool::instance(),fm,to,by,fun);
   }
 
+/*******************************************************************************/
+
+/**
+* FXParallelForDynamicFunctor is a helper for FXParallelForDynamic.  It repeatedly claims
+* a chunk of the remaining iterations from a shared counter, and executes it on a thread
+* provided by the FXThreadPool, until no iterations are left.
+*/
+template <typename Functor,typename Index>
+class FXParallelForDynamicFunctor : public FXRunnable {
+  const Functor&  functor;
+  const FXTaskGroup& group;
+  volatile FXlong& next;
+  const FXlong    nits;
+  const FXlong    nc;
+  const FXlong    gs;
+  const Index     fm;
+  const Index     by;
+private:
+  FXParallelForDynamicFunctor(const FXParallelForDynamicFunctor&);
+  FXParallelForDynamicFunctor &operator=(const FXParallelForDynamicFunctor&);
+public:
+  FXParallelForDynamicFunctor(const Functor& fun,const FXTaskGroup& grp,volatile FXlong& nx,FXlong n,FXlong c,FXlong g,Index f,Index b):functor(fun),group(grp),next(nx),nits(n),nc(c),gs(g),fm(f),by(b){ }
+  virtual FXint run(){
+    FXlong i=next,ni,x;
+    while(i<nits && !group.isCancelled()){
+      ni=(nits-i+2*nc-1)/(2*nc);
+      if(ni<gs) ni=gs;
+      if(ni>nits-i) ni=nits-i;
+      if(atomicBoolCas(&next,i,i+ni)){
+        for(x=i+ni; i<x; ++i){ functor(fm+((Index)i)*by); }
+        }
+      i=next;
+      }
+    return 0;
+    }
+  };
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to.
+* Unlike FXParallelFor, the index range is not split up ahead of time; instead, up to nc
+* tasks are started, each of which claims chunks of iterations on the fly, until none
+* are left (guided self-scheduling).  Chunks start out large and shrink as the remaining
+* number of iterations drops, but are never smaller than the grain size gs, except for
+* the last one.  Thus, when the cost of iterations varies, idle threads will pick up
+* the remaining work rather than wait for a thread stuck with a slow piece.
+* The grain size should be large enough to amortize the cost of claiming a chunk.
+* When called from a task of an FXTaskGroup which gets cancelled, no more chunks are
+* handed out.
+*/
+template <typename Functor,typename Index>
+void FXParallelForDynamic(FXThreadPool* pool,Index fm,Index to,Index by,Index gs,Index nc,const Functor& fun){
+  const FXuval size=(sizeof(FXParallelForDynamicFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong);
+  if(fm<to){
+    FXlong nits=1+(to-fm-1)/by;
+    if(gs<1) gs=1;
+    if(nc<1) nc=1;
+    if(gs<nits){
+      FXTaskGroup group(pool);
+      FXulong space[FXParallelMax*((sizeof(FXParallelForDynamicFunctor<Functor,Index>)+sizeof(FXulong)-1)/sizeof(FXulong))];
+      FXRunnable* tasks[FXParallelMax];
+      volatile FXlong next=0;
+      Index c;
+      if(nc>FXParallelMax) nc=FXParallelMax;
+      if(nc>(nits+gs-1)/gs) nc=(Index)((nits+gs-1)/gs);
+      for(c=0; c<nc; ++c){
+        tasks[c]=new (&space[c*size]) FXParallelForDynamicFunctor<Functor,Index>(fun,group,next,nits,nc,gs,fm,by);
+        }
+      for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+        tasks[c]->run();
+        }
+      group.wait();
+      }
+    else{
+      for(Index ix=fm; ix<to; ix+=by){ fun(ix); }
+      }
+    }
+  }
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to,
+* with chunks of at least gs iterations claimed on the fly by at most nc tasks.
+* The tasks are executed on the FXThreadPool associated with the calling thread.
+*/
+template <typename Functor,typename Index>
+void FXParallelForDynamic(Index fm,Index to,Index by,Index gs,Index nc,const Functor& fun){
+  FXParallelForDynamic(FXThreadPool::instance(),fm,to,by,gs,nc,fun);
+  }
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to,
+* with chunks of at least gs iterations claimed on the fly by at most N tasks, where N is
+* the maximum number of threads of the given FXThreadPool.
+*/
+template <typename Functor,typename Index>
+void FXParallelForDynamic(FXThreadPool* pool,Index fm,Index to,Index by,Index gs,const Functor& fun){
+  FXParallelForDynamic(pool,fm,to,by,gs,(Index)pool->getMaximumThreads(),fun);
+  }
+
+
+/**
+* Perform parallel for-loop executing functor fun(x) for indexes x=fm+by*i, where x<to,
+* with chunks of at least gs iterations claimed on the fly by at most N tasks, where N is
+* the maximum number of threads of the FXThreadPool associated with the calling thread.
+*/
+template <typename Functor,typename Index>
+void FXParallelForDynamic(Index fm,Index to,Index by,Index gs,const Functor& fun){
+  FXParallelForDynamic(FXThreadPool::instance(),fm,to,by,gs,fun);
+  }
+
+/*******************************************************************************/
+
+/**
+* FXParallelReduceFunctor is a helper for FXParallelReduce.  It reduces a subrange of
+* the global indexing range on a thread provided by the FXThreadPool.
+*/
+template <typename Functor,typename Index,typename Value>
+class FXParallelReduceFunctor : public FXRunnable {
+  const Functor& functor;
+  const Index    fm;
+  const Index    to;
+public:
+  Value          value;
+private:
+  FXParallelReduceFunctor(const FXParallelReduceFunctor&);
+  FXParallelReduceFunctor &operator=(const FXParallelReduceFunctor&);
+public:
+  FXParallelReduceFunctor(const Functor& fun,Index f,Index t,const Value& v):functor(fun),fm(f),to(t),value(v){ }
+  virtual FXint run(){ value=functor(fm,to,value); return 0; }
+  };
+
+
+/**
+* Perform parallel reduction over the index range [fm,to), and return the result.
+* The index range is split into at most nc pieces of at least cutoff indexes each.
+* For each piece [f,t), the functor fun(f,t,identity) is called in parallel, which
+* returns the reduction of the piece starting from the given identity value.
+* The partial results are then combined from left to right using combine(a,b), which
+* must be associative; it need not be commutative.
+* If the range is no larger than cutoff, the reduction is performed serially.
+*/
+template <typename Value,typename Index,typename Functor,typename Combine>
+Value FXParallelReduce(FXThreadPool* pool,Index fm,Index to,Index cutoff,Index nc,const Value& identity,const Functor& fun,const Combine& combine){
+  typedef FXParallelReduceFunctor<Functor,Index,Value> ReduceFunctor;
+  const FXuval size=(sizeof(ReduceFunctor)+sizeof(FXulong)-1)/sizeof(FXulong);
+  if(fm<to){
+    if(cutoff<1) cutoff=1;
+    if(cutoff<(to-fm) && 1<nc){
+      FXTaskGroup group(pool);
+      FXulong space[FXParallelMax*((sizeof(ReduceFunctor)+sizeof(FXulong)-1)/sizeof(FXulong))];
+      Index nits=to-fm,ni,c;
+      Value result(identity);
+      if(nc>FXParallelMax) nc=FXParallelMax;
+      if(nc>(nits+cutoff-1)/cutoff) nc=(nits+cutoff-1)/cutoff;
+      FXRunnable* tasks[FXParallelMax];
+      for(c=0; c<nc; fm+=ni,++c){
+        ni=(nits+nc-1-c)/nc;
+        tasks[c]=new (&space[c*size]) ReduceFunctor(fun,fm,fm+ni,identity);
+        }
+      for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+        tasks[c]->run();
+        }
+      group.wait();
+      for(c=0; c<nc; ++c){
+        result=combine(result,((ReduceFunctor*)&space[c*size])->value);
+        ((ReduceFunctor*)&space[c*size])->~ReduceFunctor();
+        }
+      return result;
+      }
+    return fun(fm,to,identity);
+    }
+  return identity;
+  }
+
+
+/**
+* Perform parallel reduction over the index range [fm,to), split into at most N pieces
+* of at least cutoff indexes each, where N is the maximum number of threads of the given
+* FXThreadPool.
+*/
+template <typename Value,typename Index,typename Functor,typename Combine>
+Value FXParallelReduce(FXThreadPool* pool,Index fm,Index to,Index cutoff,const Value& identity,const Functor& fun,const Combine& combine){
+  return FXParallelReduce(pool,fm,to,cutoff,(Index)pool->getMaximumThreads(),identity,fun,combine);
+  }
+
+
+/**
+* Perform parallel reduction over the index range [fm,to), split into at most N pieces
+* of at least cutoff indexes each, using the FXThreadPool associated with the calling
+* thread.
+*/
+template <typename Value,typename Index,typename Functor,typename Combine>
+Value FXParallelReduce(Index fm,Index to,Index cutoff,const Value& identity,const Functor& fun,const Combine& combine){
+  return FXParallelReduce(FXThreadPool::instance(),fm,to,cutoff,identity,fun,combine);
+  }
+
+/*******************************************************************************/
+
+/**
+* Serial prefix scan of src[0..num) into dst[0..num), starting from value.
+* An inclusive scan sets dst[i] to the combination of value and src[0..i]; an exclusive
+* scan sets dst[i] to the combination of value and src[0..i-1].
+* The arrays src and dst may be the same.  Returns the combination of value and all of
+* src[0..num).
+*/
+template <typename Value,typename Combine>
+Value FXSerialScan(const Value* src,Value* dst,FXival num,Value value,const Combine& combine,FXbool inclusive){
+  if(inclusive){
+    for(FXival i=0; i<num; ++i){
+      value=combine(value,src[i]);
+      dst[i]=value;
+      }
+    }
+  else{
+    for(FXival i=0; i<num; ++i){
+      Value v(src[i]);
+      dst[i]=value;
+      value=combine(value,v);
+      }
+    }
+  return value;
+  }
+
+
+/**
+* FXParallelScanFunctor is a helper for FXParallelScan.  Each instance handles one
+* block of the array; first, it reduces its block, then, after the block's offset has
+* been determined, it performs the prefix scan of its block starting from the offset.
+*/
+template <typename Value,typename Combine>
+class FXParallelScanFunctor : public FXRunnable {
+  const Combine& combine;
+  const Value*   src;
+  Value*         dst;
+  const FXival   num;
+  const FXbool   inclusive;
+public:
+  Value          value;
+  FXbool         reduce;
+private:
+  FXParallelScanFunctor(const FXParallelScanFunctor&);
+  FXParallelScanFunctor &operator=(const FXParallelScanFunctor&);
+public:
+  FXParallelScanFunctor(const Combine& cmb,const Value* s,Value* d,FXival n,FXbool incl):combine(cmb),src(s),dst(d),num(n),inclusive(incl),value(s[0]),reduce(true){ }
+  virtual FXint run(){
+    if(reduce){
+      for(FXival i=1; i<num; ++i){ value=combine(value,src[i]); }
+      }
+    else{
+      FXSerialScan(src,dst,num,value,combine,inclusive);
+      }
+    return 0;
+    }
+  };
+
+
+/**
+* Perform parallel prefix scan of src[0..num) into dst[0..num), starting from value init.
+* The array is split into at most nc blocks of at least cutoff elements each.  In the first
+* pass, each block is reduced in parallel; next, the offset of each block is determined,
+* and in the second pass, each block is scanned in parallel starting from its offset.
+* The combine(a,b) function must be associative.  The arrays src and dst may be the same.
+* If num is no larger than cutoff, the scan is performed serially.
+*/
+template <typename Value,typename Combine>
+void FXParallelScan(FXThreadPool* pool,const Value* src,Value* dst,FXival num,FXival cutoff,FXival nc,const Value& init,const Combine& combine,FXbool inclusive){
+  typedef FXParallelScanFunctor<Value,Combine> ScanFunctor;
+  const FXuval size=(sizeof(ScanFunctor)+sizeof(FXulong)-1)/sizeof(FXulong);
+  if(0<num){
+    if(cutoff<1) cutoff=1;
+    if(cutoff<num && 1<nc){
+      FXTaskGroup group(pool);
+      FXulong space[FXParallelMax*((sizeof(ScanFunctor)+sizeof(FXulong)-1)/sizeof(FXulong))];
+      FXival fm=0,ni,c;
+      Value value(init),v(init);
+      if(nc>FXParallelMax) nc=FXParallelMax;
+      if(nc>(num+cutoff-1)/cutoff) nc=(num+cutoff-1)/cutoff;
+      FXRunnable* tasks[FXParallelMax];
+      for(c=0; c<nc; fm+=ni,++c){
+        ni=(num+nc-1-c)/nc;
+        tasks[c]=new (&space[c*size]) ScanFunctor(combine,src+fm,dst+fm,ni,inclusive);
+        }
+      for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+        tasks[c]->run();
+        }
+      group.wait();
+      for(c=0; c<nc; ++c){
+        v=((ScanFunctor*)&space[c*size])->value;
+        ((ScanFunctor*)&space[c*size])->value=value;
+        ((ScanFunctor*)&space[c*size])->reduce=false;
+        value=combine(value,v);
+        }
+      for(c=group.execute(tasks,(FXuint)nc); c<nc; ++c){
+        tasks[c]->run();
+        }
+      group.wait();
+      for(c=0; c<nc; ++c){
+        ((ScanFunctor*)&space[c*size])->~ScanFunctor();
+        }
+      return;
+      }
+    FXSerialScan(src,dst,num,init,combine,inclusive);
+    }
+  }
+
+
+/**
+* Perform parallel inclusive prefix scan of src[0..num) into dst[0..num), starting from
+* value init; thus, dst[i] becomes the combination of init and src[0..i].
+* The array is split into at most N blocks of at least cutoff elements each, where N is
+* the maximum number of threads of the given FXThreadPool.
+*/
+template <typename Value,typename Combine>
+void FXParallelInclusiveScan(FXThreadPool* pool,const Value* src,Value* dst,FXival num,FXival cutoff,const Value& init,const Combine& combine){
+  FXParallelScan(pool,src,dst,num,cutoff,(FXival)pool->getMaximumThreads(),init,combine,true);
+  }
+
+
+/**
+* Perform parallel inclusive prefix scan of src[0..num) into dst[0..num), starting from
+* value init, using the FXThreadPool associated with the calling thread.
+*/
+template <typename Value,typename Combine>
+void FXParallelInclusiveScan(const Value* src,Value* dst,FXival num,FXival cutoff,const Value& init,const Combine& combine){
+  FXParallelInclusiveScan(FXThreadPool::instance(),src,dst,num,cutoff,init,combine);
+  }
+
+
+/**
+* Perform parallel exclusive prefix scan of src[0..num) into dst[0..num), starting from
+* value init; thus, dst[i] becomes the combination of init and src[0..i-1].
+* The array is split into at most N blocks of at least cutoff elements each, where N is
+* the maximum number of threads of the given FXThreadPool.
+*/
+template <typename Value,typename Combine>
+void FXParallelExclusiveScan(FXThreadPool* pool,const Value* src,Value* dst,FXival num,FXival cutoff,const Value& init,const Combine& combine){
+  FXParallelScan(pool,src,dst,num,cutoff,(FXival)pool->getMaximumThreads(),init,combine,false);
+  }
+
+
+/**
+* Perform parallel exclusive prefix scan of src[0..num) into dst[0..num), starting from
+* value init, using the FXThreadPool associated with the calling thread.
+*/
+template <typename Value,typename Combine>
+void FXParallelExclusiveScan(const Value* src,Value* dst,FXival num,FXival cutoff,const Value& init,const Combine& combine){
+  FXParallelExclusiveScan(FXThreadPool::instance(),src,dst,num,cutoff,init,combine);
+  }
+
+/*******************************************************************************/
+
+/**
+* Stable merge of sorted runs src[0..mid) and src[mid..num) into dst[0..num).
+* The compare(a,b) function returns negative, zero, or positive, like the FOX
+* list sort functions; on ties, elements from the first run go first.
+*/
+template <typename Type,typename Compare>
+void FXStableMerge(const Type* src,Type* dst,FXival mid,FXival num,const Compare& compare){
+  FXival i=0,j=mid,k=0;
+  while(i<mid && j<num){
+    if(compare(src[j],src[i])<0){ dst[k++]=src[j++]; } else { dst[k++]=src[i++]; }
+    }
+  while(i<mid){ dst[k++]=src[i++]; }
+  while(j<num){ dst[k++]=src[j++]; }
+  }
+
+
+/**
+* Serial stable sort of data[0..num), using scratch[0..num) as temporary space.
+* Short runs are sorted by insertion sort, then merged bottom-up.
+*/
+template <typename Type,typename Compare>
+void FXStableSort(Type* data,Type* scratch,FXival num,const Compare& compare){
+  const FXival run=16;
+  Type *src=data,*dst=scratch,*tmp;
+  FXival b,i,j,w;
+  for(b=0; b<num; b+=run){
+    for(i=b+1; i<num && i<b+run; ++i){
+      Type v(data[i]);
+      for(j=i; b<j && compare(v,data[j-1])<0; --j){ data[j]=data[j-1]; }
+      data[j]=v;
+      }
+    }
+  for(w=run; w<num; w+=w){
+    for(b=0; b<num; b+=w+w){
+      FXStableMerge(src+b,dst+b,FXMIN(w,num-b),FXMIN(w+w,num-b),compare);
+      }
+    tmp=src; src=dst; dst=tmp;
+    }
+  if(src!=data){
+    for(i=0; i<num; ++i){ data[i]=src[i]; }
+    }
+  }
+
+
+/**
+* FXParallelSortScratch is a helper for FXParallelSort.  It owns the temporary array,
+* so that it is deleted even if compare, or copying an element, throws.
+*/
+template <typename Type>
+class FXParallelSortScratch {
+  Type* ptr;
+private:
+  FXParallelSortScratch(const FXParallelSortScratch&);
+  FXParallelSortScratch &operator=(const FXParallelSortScratch&);
+public:
+  explicit FXParallelSortScratch(FXival n):ptr(new Type[n]){ }
+  operator Type*() const { return ptr; }
+ ~FXParallelSortScratch(){ delete [] ptr; }
+  };
+
+
+/**
+* FXParallelSortFunctor is a helper for FXParallelSort.  It either sorts one block of
+* the array, or merges two adjacent sorted blocks, on a thread provided by the
+* FXThreadPool.
+*/
+template <typename Type,typename Compare>
+class FXParallelSortFunctor : public FXRunnable {
+  const Compare& compare;
+  Type*          src;
+  Type*          dst;
+  FXival         mid;
+  FXival         num;
+private:
+  FXParallelSortFunctor(const FXParallelSortFunctor&);
+  FXParallelSortFunctor &operator=(const FXParallelSortFunctor&);
+public:
+  FXParallelSortFunctor(const Compare& cmp,Type* s,Type* d,FXival m,FXival n):compare(cmp),src(s),dst(d),mid(m),num(n){ }
+  virtual FXint run(){
+    if(mid<0){ FXStableSort(src,dst,num,compare); }
+    else{ FXStableMerge(src,dst,mid,num,compare); }
+    return 0;
+    }
+  };
+
+
+/**
+* Perform parallel stable sort of data[0..num), using compare(a,b), which returns
+* negative, zero, or positive like the FOX list sort functions.
+* The array is split into a power-of-two number of blocks, at most nc, of at least cutoff
+* elements each.  The blocks are sorted in parallel, then adjacent blocks are merged
+* pairwise in parallel, until one sorted block remains.
+* Type must be default-constructible and assignable, as a temporary array of num elements
+* is allocated.  If num is no larger than cutoff, the array is sorted serially.
+*/
+template <typename Type,typename Compare>
+void FXParallelSort(FXThreadPool* pool,Type* data,FXival num,FXival cutoff,FXival nc,const Compare& compare){
+  typedef FXParallelSortFunctor<Type,Compare> SortFunctor;
+  const FXuval size=(sizeof(SortFunctor)+sizeof(FXulong)-1)/sizeof(FXulong);
+  if(1<num){
+    FXParallelSortScratch<Type> scratch(num);
+    if(cutoff<1) cutoff=1;
+    if(cutoff<num && 1<nc){
+      FXTaskGroup group(pool);
+      FXulong space[FXParallelMax*((sizeof(SortFunctor)+sizeof(FXulong)-1)/sizeof(FXulong))];
+      FXival bound[FXParallelMax+1];
+      Type *src=data,*dst=scratch,*tmp;
+      FXival nb=1,c,w;
+      if(nc>FXParallelMax) nc=FXParallelMax;
+      while(nb+nb<=nc && cutoff*(nb+nb)<=num){ nb+=nb; }
+      for(c=0; c<=nb; ++c){
+        bound[c]=(num*c)/nb;
+        }
+      FXRunnable* tasks[FXParallelMax];
+      for(c=0; c<nb; ++c){
+        tasks[c]=new (&space[c*size]) SortFunctor(compare,data+bound[c],scratch+bound[c],-1,bound[c+1]-bound[c]);
+        }
+      for(c=group.execute(tasks,(FXuint)nb); c<nb; ++c){
+        tasks[c]->run();
+        }
+      group.wait();
+      for(w=1; w<nb; w+=w){
+        for(c=0; c<nb; c+=w+w){
+          tasks[c]=new (&space[c*size]) SortFunctor(compare,src+bound[c],dst+bound[c],bound[c+w]-bound[c],bound[c+w+w]-bound[c]);
+          if(!group.execute(tasks[c])){ tasks[c]->run(); }
+          }
+        group.wait();
+        tmp=src; src=dst; dst=tmp;
+        }
+      if(src!=data){
+        for(c=0; c<num; ++c){ data[c]=src[c]; }
+        }
+      }
+    else{
+      FXStableSort(data,(Type*)scratch,num,compare);
+      }
+    }
+  }
+
+
+/**
+* Perform parallel stable sort of data[0..num), split into at most N blocks of at least
+* cutoff elements each, where N is the maximum number of threads of the given FXThreadPool.
+*/
+template <typename Type,typename Compare>
+void FXParallelSort(FXThreadPool* pool,Type* data,FXival num,FXival cutoff,const Compare& compare){
+  FXParallelSort(pool,data,num,cutoff,(FXival)pool->getMaximumThreads(),compare);
+  }
+
+
+/**
+* Perform parallel stable sort of data[0..num), using the FXThreadPool associated with
+* the calling thread.
+*/
+template <typename Type,typename Compare>
+void FXParallelSort(Type* data,FXival num,FXival cutoff,const Compare& compare){
+  FXParallelSort(FXThreadPool::instance(),data,num,cutoff,compare);
+  }
+
 }
 
 #endif
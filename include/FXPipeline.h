@@ -0,0 +1,171 @@
+/********************************************************************************
+*                                                                               *
+*                           P i p e l i n e   C l a s s                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXPIPELINE_H
+#define FXPIPELINE_H
+
+namespace FX {
+
+class FXThreadPool;
+class FXTaskGroup;
+
+
+/**
+* An FXPipeline passes a stream of items through a sequence of stages, executing
+* on the associated FXThreadPool.  The first stage produces the items: it is called
+* with a null item, and returns the next item, or null when the input is exhausted.
+* Each following stage is called with the item returned by the stage before it, and
+* may return the same item, or a new one to take its place.
+* A serial stage processes one item at a time, in the order the items were produced
+* by the first stage; a parallel stage may process any number of items at the same
+* time, in any order.  Thus, a pipeline of a serial reader, a parallel transform,
+* and a serial writer, will write the transformed items in the order they were read.
+* The number of items in flight is limited by the number of tokens passed to run();
+* the first stage is not called again until an item has left the last stage, which
+* caps the memory used by the pipeline, no matter how the stages are balanced.
+* Stages should not throw exceptions; an item whose stage throws is dropped, and a
+* serial stage after it will not get any more items.  The pipeline is cancelled when
+* the task which runs it is cancelled; the first stage is then no longer called, and
+* items not yet finished are dropped.
+*/
+class FXAPI FXPipeline {
+public:
+
+  /// Stage mode
+  enum Mode {
+    Serial,     /// Items processed one at a time, in input order
+    Parallel    /// Items processed concurrently
+    };
+
+private:
+  class Token;
+
+public:
+
+  /**
+  * A stage of the pipeline.  Derive from it and implement process().
+  * The first stage of a pipeline is always run serially.
+  * Stages are not owned by the pipeline, and must outlive run().
+  */
+  class FXAPI Stage {
+    friend class FXPipeline;
+  private:
+    FXMutex   mutex;            // Serializes parking of tokens
+    Token   **parked;           // Tokens waiting for their turn
+    FXulong   next;             // Sequence number of next token to process
+    Mode      mode;             // Serial or parallel
+  private:
+    Stage(const Stage&);
+    Stage &operator=(const Stage&);
+  public:
+
+    /// Create stage with given mode
+    Stage(Mode m=Parallel);
+
+    /// Return mode
+    Mode getMode() const { return mode; }
+
+    /// Process item, returning item to be passed to the next stage
+    virtual FXptr process(FXptr item)=0;
+
+    /// Destroy stage
+    virtual ~Stage();
+    };
+
+private:
+  FXThreadPool      *threadpool;        // Thread pool used by the pipeline
+  FXTaskGroup       *group;             // Group of tasks while running
+  FXPtrListOf<Stage> stages;            // Stages
+  Token             *tokens;            // Tokens
+  Token            **freetokens;        // Tokens not in flight
+  Token            **readytokens;       // Tokens the thread pool did not accept
+  FXMutex            mutex;             // Guards lists of free and ready tokens
+  volatile FXuint    nfree;             // Number of free tokens
+  FXuint             nready;            // Number of ready tokens
+  FXuint             draining;          // Ready tokens are being run
+  volatile FXuint    inputbusy;         // First stage is being run
+  volatile FXuint    exhausted;         // First stage ran out of items
+  FXuint             limit;             // Number of tokens
+  FXulong            sequence;          // Sequence number of next item
+  volatile FXulong   processed;         // Items which went through all stages
+private:
+  void pump();
+  void spawn(Token* token);
+  void advance(Token* token);
+  void retire(Token* token);
+private:
+  FXPipeline(const FXPipeline&);
+  FXPipeline &operator=(const FXPipeline&);
+public:
+
+  /**
+  * Create pipeline, using the calling thread's associated
+  * thread pool.
+  */
+  FXPipeline();
+
+  /**
+  * Create pipeline, using the given thread pool.
+  */
+  FXPipeline(FXThreadPool* p);
+
+  /**
+  * Return threadpool.
+  */
+  FXThreadPool* getThreadPool() const { return threadpool; }
+
+  /**
+  * Append stage to the pipeline.  The first stage appended
+  * produces the items.
+  */
+  void append(Stage* stage);
+
+  /**
+  * Return number of stages.
+  */
+  FXint getStages() const { return stages.no(); }
+
+  /**
+  * Return stage i.
+  */
+  Stage* getStage(FXint i) const { return stages[i]; }
+
+  /**
+  * Return true if pipeline is running.
+  */
+  FXbool isRunning() const { return group!=nullptr; }
+
+  /**
+  * Run the pipeline, with at most the given number of items in flight,
+  * until the first stage returns null and all items have gone through
+  * all stages.  The calling thread helps out in the meantime.
+  * Return the number of items which went through all stages.
+  */
+  FXulong run(FXuint tokens);
+
+  /**
+  * Destroy pipeline.
+  */
+  virtual ~FXPipeline();
+  };
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+/********************************************************************************
+*                                                                               *
+*                        P i x e l   B u f f e r   O b j e c t                  *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXPIXELBUFFER_H
+#define FXPIXELBUFFER_H
+
+namespace FX {
+
+
+/**
+* A pixel buffer is a rectangular array of FXColor pixels, stored row by row,
+* together with the operations on those pixels, such as scaling, rotation,
+* shearing, and filling with gradients.
+* Unlike FXImage, a pixel buffer needs neither an application nor a display,
+* so it can be used by programs working on images without a GUI.  FXImage uses
+* pixel buffers for the manipulation of its client-side pixels.
+* The buffer may own its pixels, in which case they're freed when the buffer
+* is destroyed, or refer to pixels owned by someone else.
+* Operations which change the size of the buffer replace the pixels by a new,
+* owned, array; they come in two flavors: one which does this, and one which
+* leaves this buffer alone and places the result into another buffer, whose
+* size must already be correct.
+* Large buffers are processed in bands of rows or columns; if the calling thread
+* has a thread pool, the bands are processed in parallel.  The 90 and 270 degree
+* rotations work on small square tiles, to make good use of the caches.
+* Pixel buffers may be composited onto each other using the Porter-Duff
+* operators; the pixels have straight alpha, but are converted to premultiplied
+* alpha for the duration of the operation.
+*/
+class FXAPI FXPixelBuffer {
+public:
+
+  /// Porter-Duff compositing operators
+  enum Operator {
+    CompositeOver,      /// Source over destination
+    CompositeIn,        /// Part of source inside destination
+    CompositeOut,       /// Part of source outside destination
+    CompositeAtop,      /// Part of source inside destination, over destination
+    CompositeXor,       /// Parts of source and destination outside each other
+    CompositeAdd,       /// Sum of source and destination
+    CompositeMultiply   /// Product of source and destination, over both
+    };
+
+private:
+  FXColor *data;        // Pixels
+  FXint    width;       // Width
+  FXint    height;      // Height
+  FXbool   owned;       // Owns pixels
+private:
+  FXPixelBuffer(const FXPixelBuffer&);
+  FXPixelBuffer &operator=(const FXPixelBuffer&);
+public:
+
+  /// Construct empty pixel buffer
+  FXPixelBuffer();
+
+  /// Construct pixel buffer of given size; the pixels are not initialized
+  FXPixelBuffer(FXint w,FXint h);
+
+  /// Construct pixel buffer around existing pixels, optionally taking ownership of them
+  FXPixelBuffer(FXColor* pix,FXint w,FXint h,FXbool own=false);
+
+  /// Return pixels
+  FXColor* getData() const { return data; }
+
+  /// Return width
+  FXint getWidth() const { return width; }
+
+  /// Return height
+  FXint getHeight() const { return height; }
+
+  /// Return true if buffer owns its pixels
+  FXbool isOwned() const { return owned; }
+
+  /// Change pixels, optionally taking ownership of them
+  void setData(FXColor* pix,FXint w,FXint h,FXbool own=false);
+
+  /// Get pixel at x,y
+  FXColor getPixel(FXint x,FXint y) const { return data[y*width+x]; }
+
+  /// Change pixel at x,y
+  void setPixel(FXint x,FXint y,FXColor color){ data[y*width+x]=color; }
+
+  /**
+  * Resize buffer to given width and height; the pixels are undefined afterwards.
+  * Return false if out of memory.
+  */
+  FXbool resize(FXint w,FXint h);
+
+  /// Give up the pixels, returning them; the caller becomes responsible for them
+  FXColor* release();
+
+  /// Swap contents with another buffer
+  void swap(FXPixelBuffer& other);
+
+  /**
+  * Scale pixels into the buffer dst, which determines the new size.
+  * Quality 0 is nearest neighbor, 1 is box filtered, 2 is box filtered
+  * with gamma correction, 3 is Mitchell filtered, and 4 is Lanczos-3 filtered.
+  * Return false if out of memory.
+  */
+  FXbool scale(FXPixelBuffer& dst,FXint quality=0) const;
+
+  /// Scale pixels to given size; return false if out of memory
+  FXbool scale(FXint w,FXint h,FXint quality=0);
+
+  /// Mirror pixels horizontally and/or vertically
+  void mirror(FXbool horizontal,FXbool vertical);
+
+  /**
+  * Rotate pixels by 90, 180, or 270 degrees ccw into the buffer dst,
+  * which must be of the rotated size.  Return false for other angles.
+  */
+  FXbool rotate(FXPixelBuffer& dst,FXint degrees) const;
+
+  /// Rotate pixels by 90, 180, or 270 degrees ccw; return false if out of memory or other angles
+  FXbool rotate(FXint degrees);
+
+  /**
+  * Crop to rectangle at x,y, of the size of the buffer dst; areas outside of
+  * the pixels are filled with color.
+  */
+  void crop(FXPixelBuffer& dst,FXint x,FXint y,FXColor color=0) const;
+
+  /// Crop to rectangle at x,y of size w,h; return false if out of memory
+  FXbool crop(FXint x,FXint y,FXint w,FXint h,FXColor color=0);
+
+  /**
+  * Shear horizontally into the buffer dst, which must be wider by the shear
+  * parameter divided by 256, rounded up.  The area outside of the pixels is
+  * filled with color.
+  */
+  void xshear(FXPixelBuffer& dst,FXint shear,FXColor clr=0) const;
+
+  /// Shear horizontally; return false if out of memory
+  FXbool xshear(FXint shear,FXColor clr=0);
+
+  /**
+  * Shear vertically into the buffer dst, which must be taller by the shear
+  * parameter divided by 256, rounded up.  The area outside of the pixels is
+  * filled with color.
+  */
+  void yshear(FXPixelBuffer& dst,FXint shear,FXColor clr=0) const;
+
+  /// Shear vertically; return false if out of memory
+  FXbool yshear(FXint shear,FXColor clr=0);
+
+  /// Fill with uniform color
+  void fill(FXColor color);
+
+  /// Fade to uniform color
+  void fade(FXColor color,FXint factor=255);
+
+  /// Fill horizontal gradient
+  void hgradient(FXColor left,FXColor right);
+
+  /// Fill vertical gradient
+  void vgradient(FXColor top,FXColor bottom);
+
+  /// Fill with gradient
+  void gradient(FXColor topleft,FXColor topright,FXColor bottomleft,FXColor bottomright);
+
+  /// Blend over uniform color
+  void blend(FXColor color);
+
+  /// Invert colors
+  void invert();
+
+  /// Colorize based on luminance
+  void colorize(FXColor color);
+
+  /// Convert pixels from straight to premultiplied alpha
+  void premultiply();
+
+  /// Convert pixels from premultiplied to straight alpha
+  void unpremultiply();
+
+  /**
+  * Composite rectangle sx,sy,w,h of buffer src onto this buffer at dx,dy,
+  * using Porter-Duff operator op.  The rectangle is clipped to both buffers;
+  * pixels outside of it are left alone, even for operators like CompositeIn.
+  * Both buffers have straight alpha.  The buffer src must not share its pixels
+  * with this buffer; if it does, nothing is done.
+  */
+  void composite(const FXPixelBuffer& src,FXint sx,FXint sy,FXint w,FXint h,FXint dx,FXint dy,Operator op=CompositeOver);
+
+  /// Composite all of buffer src onto this buffer at dx,dy, using Porter-Duff operator op
+  void composite(const FXPixelBuffer& src,FXint dx,FXint dy,Operator op=CompositeOver);
+
+  /// Destructor
+ ~FXPixelBuffer();
+  };
+
+}
+
+#endif
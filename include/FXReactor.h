@@ -54,6 +54,14 @@ namespace FX {
 * after at most FXReactor::maxwait, which is about 1 day.
 * It will continue to loop and wait for additional intervals, decreasing the initial
 * blocking time until eventually returning false when nothing happened.
+*
+* On Linux, reads and writes may be submitted to FXReactor, which dispatches to
+* dispatchCompletion() when they are done.  If configured with io_uring support,
+* and the kernel allows it, the operations are submitted to the kernel in batches,
+* just before waiting, and performed by the kernel without further system calls.
+* Otherwise, each operation is performed with a single read() or write() once its
+* handle becomes ready; note that this may block if the handle is in blocking mode
+* and the write does not fit.
 */
 class FXAPI FXReactor {
   friend class FXEventDispatcher;
@@ -74,6 +82,12 @@ private:
 private:
   static void CDECL signalhandler(FXint sig);
   static void CDECL signalhandlerasync(FXint sig);
+  FXbool openRing();
+  void closeRing();
+  void flushOperations();
+  void watchRing(FXuint flags);
+  FXbool raisedOperation(FXInputHandle hnd);
+  FXbool nextCompletion(void*& tag,FXival& result);
 public:
 
   /// Modes
@@ -91,7 +105,14 @@ public:
     DispatchTimers  = 0x00000002,       /// Dispatch timers
     DispatchIdle    = 0x00000004,       /// Dispatch idle processing
     DispatchEvents  = 0x00000008,       /// Dispatch events
-    DispatchOther   = 0x00000010        /// Dispatch other i/o
+    DispatchOther   = 0x00000010,       /// Dispatch other i/o
+    DispatchCompletions = 0x00000020    /// Dispatch completed operations
+    };
+
+  /// Asynchronous operations
+  enum {
+    OperationRead   = 1,                /// Read from handle
+    OperationWrite  = 2                 /// Write to handle
     };
 
   /// Sleep no longer than this
@@ -123,6 +144,19 @@ public:
   /// Return true if the callback returned true.
   virtual FXbool dispatchHandle(FXInputHandle hnd,FXuint mode,FXuint flags);
 
+  /// Submit asynchronous operation op, to read or write len bytes from or to
+  /// buffer buf, at offset off in the file, or at the current position if off is -1.
+  /// When done, dispatchCompletion() is called with the given tag; the buffer must
+  /// remain valid till then.  Return false if the operation could not be submitted.
+  virtual FXbool submitOperation(FXuint op,FXInputHandle hnd,void* buf,FXival len,FXlong off,void* tag);
+
+  /// Dispatch when asynchronous operation has completed; result is the number of
+  /// bytes transferred, or a negative error code.  Return true when handled.
+  virtual FXbool dispatchCompletion(void* tag,FXival result);
+
+  /// Return true if asynchronous operations are performed by io_uring.
+  FXbool hasRing() const;
+
   /// Add (optionally asynchronous) signal sig to signal-set
   virtual FXbool addSignal(FXint sig,FXbool=false);
 
@@ -58,10 +58,18 @@ public:
   /// Return false if count was zero or if an error occurred.
   FXbool trywait();
 
+  /// Try decrement semaphore by up to count, without waiting.
+  /// Return the amount by which the semaphore was decremented.
+  FXint trywait(FXint count);
+
   /// Increment semaphore by 1.
   /// Return false if an error occurred.
   FXbool post();
 
+  /// Increment semaphore by count.
+  /// Return false if an error occurred.
+  FXbool post(FXint count);
+
   /// Delete semaphore
   ~FXSemaphore();
   };
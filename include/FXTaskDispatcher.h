@@ -0,0 +1,63 @@
+/********************************************************************************
+*                                                                               *
+*                         T a s k   D i s p a t c h e r                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#ifndef FXTASKDISPATCHER_H
+#define FXTASKDISPATCHER_H
+
+#ifndef FXDISPATCHER_H
+#include "FXDispatcher.h"
+#endif
+
+namespace FX {
+
+class FXRunnable;
+
+
+/**
+* An FXTaskDispatcher is an FXDispatcher to which other threads may post
+* tasks.  A posted task is run by the thread calling dispatch(), as soon
+* as it gets around to it; thus, a worker thread can hand its results back
+* to the thread owning the dispatcher, without the need for locking the
+* data structures managed by that thread.
+* The dispatcher is woken up through a pipe, which is written only once
+* for any number of tasks posted before the dispatcher gets to them.
+* Tasks still pending when the dispatcher exits are not run.
+*/
+class FXAPI FXTaskDispatcher : public FXDispatcher {
+private:
+  FXInputHandle         wakeup[2];      // Wakeup pipe
+  FXMutex               mutex;          // Guards posted tasks
+  FXPtrListOf<FXRunnable> posted;       // Tasks posted
+  FXPtrListOf<FXRunnable> running;      // Tasks being run
+private:
+  void notify();
+  FXbool onWakeup(FXDispatcher*,FXInputHandle,FXuint,void*);
+private:
+  FXTaskDispatcher(const FXTaskDispatcher&);
+  FXTaskDispatcher &operator=(const FXTaskDispatcher&);
+public:
+
+  /// Construct task dispatcher object.
+  FXTaskDispatcher();
+
+  /// Initialize dispatcher.
+  virtual FXbool init();
+
+  /// Post task to be run by the dispatching thread; may be
+  /// called by any thread.  Return false if not initialized.
+  FXbool post(FXRunnable* task);
+
+  /// Exit dispatcher.
+  virtual FXbool exit();
+
+  /// Destroy task dispatcher object.
+  virtual ~FXTaskDispatcher();
+  };
+
+}
+
+#endif
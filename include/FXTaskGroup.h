@@ -44,13 +44,76 @@ class FXThreadPool;
 * or when the task-queue is empty (in this case another thread may still be working on
 * a task from the FXTaskGroup). Thus, the calling thread should block on the completion
 * semaphore to ensure all tasks are completed.
+* Tasks which depend on each other may be arranged in a task graph, by wrapping them
+* in FXTaskGroup::Node objects and declaring their predecessors.  A node is handed to
+* the FXThreadPool only when its last predecessor has completed, so that an entire
+* graph can run without any thread blocking, until the final wait().
+* A task group may be cancelled at any time.  Tasks of a cancelled group which have not
+* started yet are dropped; running tasks are not interrupted, but may poll isCancelled()
+* to finish early.  A task group created by a task, for example inside FXParallelFor,
+* counts as cancelled when the group of that task is cancelled, so that cancellation
+* reaches nested parallel loops as well.
 */
 class FXAPI FXTaskGroup {
+public:
+
+  /**
+  * A Node wraps an FXRunnable as part of a task graph.  Calling after() on a node
+  * declares another node as its predecessor; the node will not be run until all its
+  * predecessors have completed.  All dependencies must be declared before any of the
+  * nodes involved is scheduled.  Nodes are scheduled with FXTaskGroup::schedule(), and
+  * count as tasks of that FXTaskGroup until they have completed.
+  * If a node's runnable throws an exception, or the group is cancelled, all nodes
+  * depending on it, directly or indirectly, will be skipped rather than run.
+  * A node can be scheduled only once, and must outlive the FXTaskGroup's wait().
+  */
+  class FXAPI Node : public FXRunnable {
+    friend class FXTaskGroup;
+  private:
+    FXRunnable        *runnable;        // Wrapped runnable
+    FXTaskGroup       *taskgroup;       // Task group it was scheduled in
+    FXPtrListOf<Node>  successors;      // Nodes depending on this one
+    volatile FXuint    pending;         // Unfinished predecessors, plus one until scheduled
+    volatile FXuint    failed;          // Some predecessor failed
+  private:
+    void ready();
+    void process();
+  private:
+    Node(const Node&);
+    Node &operator=(const Node&);
+  public:
+
+    /// Create node wrapping runnable r
+    Node(FXRunnable* r=nullptr);
+
+    /// Change wrapped runnable
+    void setRunnable(FXRunnable* r){ runnable=r; }
+
+    /// Return wrapped runnable
+    FXRunnable* getRunnable() const { return runnable; }
+
+    /// Run this node only after node pred has completed
+    void after(Node* pred);
+
+    /// Return number of nodes depending on this node
+    FXint getSuccessors() const { return successors.no(); }
+
+    /// Return true if node was skipped because a predecessor failed
+    FXbool isSkipped() const { return failed!=0; }
+
+    /// Run the wrapped runnable, then release the nodes depending on it
+    virtual FXint run();
+
+    /// Destroy node
+    virtual ~Node();
+    };
+
 private:
   class Task : public FXRunnable {
   private:
     FXTaskGroup *taskgroup;     // Backlink to taskgroup
     FXRunnable  *runnable;      // Wrapped runnable
+    FXTime       stamp;         // Time submitted, if timing
   private:
     Task(const Task&);
     Task &operator=(const Task&);
@@ -61,7 +124,13 @@ private:
     };
 private:
   FXThreadPool *threadpool;     // Thread pool used by task group
+  FXTaskGroup  *parent;         // Task group of task which created this one
   FXCompletion  completion;     // Completion counter
+  volatile FXuint cancelled;    // Group was cancelled
+  volatile FXuint submitted;    // Tasks submitted
+  FXTime        waiting;        // Time spent in wait()
+private:
+  static FXAutoThreadStorageKey currentgroup;
 private:
   FXTaskGroup(const FXTaskGroup&);
   FXTaskGroup &operator=(const FXTaskGroup&);
@@ -88,11 +157,52 @@ public:
   */
   FXuint getRunningTasks() const { return completion.count(); }
 
+  /**
+  * Return number of tasks and graph nodes submitted to this group.
+  */
+  FXuint getSubmittedTasks() const { return submitted; }
+
+  /**
+  * Return number of tasks and graph nodes completed.
+  */
+  FXuint getCompletedTasks() const { return submitted-completion.count(); }
+
+  /**
+  * Return total time spent in wait(), i.e. time the calling thread spent
+  * helping out or blocked until the group was done.
+  */
+  FXTime getWaitTime() const { return waiting; }
+
+  /**
+  * Cancel, or uncancel, the task group.  Cancelling drops the tasks which have not
+  * yet started, and lets running tasks know they may stop early.  A cancelled group
+  * remains cancelled until it is explicitly uncancelled, for instance to reuse it.
+  */
+  void setCancelled(FXbool flag=true);
+
+  /**
+  * Return true if this task group, or the group of the task which created it,
+  * was cancelled.  Cheap enough to be polled by long-running tasks.
+  */
+  FXbool isCancelled() const { for(const FXTaskGroup* g=this; g; g=g->parent){ if(g->cancelled) return true; } return false; }
+
+  /**
+  * Return the task group of the task being run by the calling thread, if any.
+  * Tasks can use this to poll for cancellation.
+  */
+  static FXTaskGroup* current();
+
   /**
   * Start a task in this task group.
   */
   FXbool execute(FXRunnable* task);
 
+  /**
+  * Start n tasks in this task group at once.
+  * Return the number of tasks actually started.
+  */
+  FXuint execute(FXRunnable** batch,FXuint n);
+
   /**
   * Start task in this task group, and then enter the task-processing
   * loop, returning when all tasks have been completed.
@@ -100,6 +210,13 @@ public:
   */
   FXbool executeAndWait(FXRunnable* task);
 
+  /**
+  * Schedule task graph node in this task group.  The node is started as
+  * soon as all of its predecessors have completed, which may be right away.
+  * Return false if the node was already scheduled.
+  */
+  FXbool schedule(Node* node);
+
   /**
   * Wait until all tasks of this group have finished executing, then return.
   * The completion semaphore is reset after being signaled by the last completed
@@ -29,6 +29,9 @@ namespace FX {
 
 
 class FXWorker;
+class FXWSQueue;
+class FXTaskGroup;
+template <typename Type> class FXFuture;
 
 /// Task queue
 typedef FXLFQueueOf<FXRunnable> FXTaskQueue;
@@ -64,13 +67,53 @@ typedef FXLFQueueOf<FXRunnable> FXTaskQueue;
 * In addition, each worker will similarly be associated with the thread pool.
 * Thus both the main thread as well as the worker threads can easily find the thread
 * pool through the member-function instance().
+* With the default scheduler, all tasks pass through one shared task queue.  When the
+* work-stealing scheduler is selected, each worker thread also gets a private deque:
+* tasks spawned by a worker are placed in that worker's deque, and workers running out
+* of work will steal tasks from the deques of other workers.  Tasks submitted by threads
+* outside the thread pool still go through the shared task queue.
+* Tasks may be executed with high priority; these go through a separate queue, which
+* the workers drain before looking at any other tasks.  To keep normal tasks from being
+* starved, a worker takes a normal task, if there is one, after it has run a number of
+* high priority tasks in a row.
+* Worker threads may optionally be pinned to processors.  With compact placement, the
+* workers are assigned to physical cores first, ordered such that consecutive workers
+* run on cores sharing the same last level cache; hyper-threads are used last.
 */
 class FXAPI FXThreadPool : public FXRunnable {
+public:
+
+  /// Task scheduling policies
+  enum Scheduler {
+    SchedulerShared,    /// All tasks go through the shared task queue
+    SchedulerStealing   /// Workers queue tasks locally, idle workers steal tasks
+    };
+
+  /// Worker placement policies
+  enum Placement {
+    PlacementNone,      /// Workers may run on any processor
+    PlacementCompact    /// Pin workers to processors, neighbors share caches
+    };
+
+  /// Task priorities
+  enum Priority {
+    PriorityNormal,     /// Normal tasks, such as background jobs
+    PriorityHigh        /// Tasks run ahead of normal tasks, such as interactive work
+    };
+
+  /// Number of buckets in latency histograms
+  enum { LatencyBuckets=32 };
+
 private:
   FXTaskQueue     queue;        // Task queue
+  FXTaskQueue     urgent;       // High priority task queue
+  FXWSQueue      *deques;       // Per-worker task deques
+  volatile FXuint*owners;       // Worker slot claimed by a worker
+  FXint          *cpus;         // Processor for each worker slot
   FXCompletion    tasks;        // Active tasks
   FXCompletion    threads;      // Active threads
   FXSemaphore     freeslots;    // Free slots in queue
+  FXSemaphore     urgentslots;  // Free slots in high priority queue
   FXSemaphore     usedslots;    // Used slots in queue
   FXuval          stacksize;    // Stack size
   FXTime          expiration;   // Quit if no task within this time
@@ -78,12 +121,38 @@ private:
   volatile FXuint minimum;      // Minimum threads
   volatile FXuint workers;      // Working threads
   volatile FXuint running;      // Context is running
+  FXuint          scheduler;    // Scheduling policy
+  FXuint          placement;    // Placement policy
+  FXuint          aging;        // High priority tasks before normal task gets a turn
+  volatile FXuint streak;       // High priority tasks run in a row
+  volatile FXuint timing;       // Collect timing statistics
+  volatile FXulong submitted;   // Tasks submitted
+  volatile FXulong completed;   // Tasks completed
+  volatile FXuint queued;       // Tasks waiting to be run, in any queue
+  volatile FXuint highwater;    // Most tasks waiting to be run
+  volatile FXTime blocked;      // Time producers blocked on full queue
+  FXTime         *busytime;     // Time each worker slot spent running tasks
+  FXTime         *idletime;     // Time each worker slot spent waiting for tasks
+  FXuint          nslots;       // Number of worker slots with times
+  volatile FXulong waithist[LatencyBuckets];    // Histogram of queue wait times
+  volatile FXulong runhist[LatencyBuckets];     // Histogram of task run times
 private:
   static FXAutoThreadStorageKey reference;
+  static FXAutoThreadStorageKey workerslot;
 private:
   FXbool startWorker();
+  FXint claimSlot();
+  void releaseSlot(FXint slot);
+  FXWSQueue* localDeque() const;
+  FXbool claimTask(FXRunnable*& task);
+  FXbool waitSlot(FXSemaphore& slots,FXTime blocking);
+  void enqueued(FXuint n);
+  void recordWait(FXTime wait);
+  static FXint latencyBucket(FXTime t);
   void runWhile(FXCompletion& comp,FXTime timeout);
   virtual FXint run();
+private:
+  friend class FXTaskGroup;
 private:
   FXThreadPool(const FXThreadPool&);
   FXThreadPool &operator=(const FXThreadPool&);
@@ -133,6 +202,85 @@ public:
   /// Get stack size
   FXuval getStackSize() const { return stacksize; }
 
+  /// Change scheduling policy; only possible when not running
+  FXbool setScheduler(Scheduler policy);
+
+  /// Return scheduling policy
+  Scheduler getScheduler() const { return (Scheduler)scheduler; }
+
+  /// Change worker placement policy; only possible when not running
+  FXbool setPlacement(Placement policy);
+
+  /// Return worker placement policy
+  Placement getPlacement() const { return (Placement)placement; }
+
+  /**
+  * Change aging of high priority tasks: after running n high priority tasks in a row,
+  * a worker will run a normal task, if one is available.  The default is 8.
+  * Aging zero means high priority tasks always run before normal tasks.
+  * Only possible when not running.
+  */
+  FXbool setAging(FXuint n);
+
+  /// Return aging of high priority tasks
+  FXuint getAging() const { return aging; }
+
+  /**
+  * Return index of the calling worker thread in this thread pool, in the range
+  * [0...getMaximumThreads()-1], or -1 if the caller is not one of its workers.
+  * With compact placement, workers with adjacent indexes run on adjacent cores.
+  */
+  FXint getWorkerIndex() const;
+
+  /**
+  * Enable or disable collection of timing statistics: busy and idle time of the
+  * workers, and task latency histograms.  Task counts, queue high-water mark, and
+  * time spent by producers blocked on a full queue are always collected.
+  * May be changed while running.
+  */
+  FXbool setStatistics(FXbool flag);
+
+  /// Return true if timing statistics are collected
+  FXbool getStatistics() const { return timing!=0; }
+
+  /// Reset all statistics; may be called while running
+  FXbool resetStatistics();
+
+  /// Return number of tasks submitted since statistics were reset
+  FXulong getSubmittedTasks() const { return submitted; }
+
+  /// Return number of tasks completed since statistics were reset
+  FXulong getCompletedTasks() const { return completed; }
+
+  /**
+  * Return the most tasks waiting to be run at any time, counting the shared
+  * queue, the high priority queue, and the worker deques together.
+  */
+  FXuint getHighWater() const { return highwater; }
+
+  /// Return total time producers were blocked waiting for room in the queue
+  FXTime getBlockedTime() const { return blocked; }
+
+  /// Return time worker w spent running tasks
+  FXTime getBusyTime(FXint w) const;
+
+  /// Return time worker w spent waiting for tasks
+  FXTime getIdleTime(FXint w) const;
+
+  /**
+  * Return number of tasks whose run time fell in latency bucket b.  Bucket 0 counts
+  * tasks taking less than 1024 ns; each next bucket covers twice the time of the one
+  * before, and the last bucket counts everything beyond.
+  */
+  FXulong getRunHistogram(FXint b) const;
+
+  /**
+  * Return number of tasks whose time spent waiting in the queue fell in latency
+  * bucket b.  The queue wait can only be measured for tasks executed through an
+  * FXTaskGroup, as these are stamped when they are submitted.
+  */
+  FXulong getWaitHistogram(FXint b) const;
+
   /// Return calling thread's thread pool
   static FXThreadPool* instance();
 
@@ -155,9 +303,27 @@ public:
   * Return false if the task could not be added within the given time interval.
   * Possibly starts additional worker threads if the maximum number of worker
   * threads has not yet been exceeded.
+  * With the work-stealing scheduler, a task executed from one of the worker threads
+  * is placed in the worker's own deque, unless the deque is full.
   */
   FXbool execute(FXRunnable* task,FXTime blocking=forever);
 
+  /**
+  * Execute a task on the thread pool with given priority.  High priority tasks
+  * are entered in a separate queue, which is drained first; if that queue has no
+  * room, the caller may block as in execute() above.
+  */
+  FXbool execute(FXRunnable* task,Priority priority,FXTime blocking=forever);
+
+  /**
+  * Execute n tasks on the thread pool at once, entering as many tasks into the
+  * queue at a time as there are free slots.  The task queue and semaphores are
+  * updated once per run of tasks, rather than once per task.  Blocking as in
+  * execute() above; return the number of tasks actually entered, which may be less
+  * than n if room could not be found in time.
+  */
+  FXuint execute(FXRunnable** batch,FXuint n,FXTime blocking=forever);
+
   /**
   * Execute task on the thread pool by entering int into the queue.
   * If the task was successfully added, the calling thread will temporarily enter
@@ -180,6 +346,17 @@ public:
   */
   FXbool executeAndWaitFor(FXRunnable* task,FXCompletion& comp,FXTime blocking=forever);
 
+  /**
+  * Execute a copy of functor fun on the thread pool, and return an FXFuture
+  * through which the value returned by fun() can be obtained later.
+  * Waiting on the future lets the calling thread help out processing tasks,
+  * so even a worker thread may safely wait on it.
+  * If the task could not be added within the given time interval, the future
+  * returned is broken.  This requires FXFuture.h.
+  */
+  template <typename Functor>
+  auto async(Functor fun,FXTime blocking=forever) -> FXFuture<decltype(fun())>;
+
   /**
   * Wait until task queue becomes empty and all tasks are finished, and process tasks
   * to help the worker threads in the meantime.
@@ -86,6 +86,7 @@ protected:
   FXPixel       gpix[16][256];          // Mapping from green -> pixel
   FXPixel       bpix[16][256];          // Mapping from blue -> pixel
   FXPixel       lut[256];               // Color lookup table
+  FXuchar       linear;                 // Color tables found linear, by FXImage
 protected:
   void setuptruecolor();
   void setupdirectcolor();
@@ -208,7 +208,9 @@ protected:
     FLAG_SCROLLINSIDE = 0x00100000,     // Scroll only when inside
     FLAG_SCROLLING    = 0x00200000,     // Right mouse scrolling
     FLAG_OWNED        = 0x00400000,     // Owned window handle
-    FLAG_CURSOR       = 0x00800000      // Showing cursor
+    FLAG_CURSOR       = 0x00800000,     // Showing cursor
+    FLAG_REFRESH      = 0x01000000,     // Refresh scheduled for this window
+    FLAG_SUBSCRIBED   = 0x02000000      // Subscribed to target
     };
 
 public:
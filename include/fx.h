@@ -139,7 +139,10 @@
 #include "FXThreadPool.h"
 #include "FXCompletion.h"
 #include "FXTaskGroup.h"
+#include "FXFuture.h"
 #include "FXParallel.h"
+#include "FXPipeline.h"
+#include "FXPixelBuffer.h"
 #include "FXFont.h"
 #include "FXCursor.h"
 #include "FXVisual.h"
@@ -147,6 +150,7 @@
 #include "FXId.h"
 #include "FXReactor.h"
 #include "FXDispatcher.h"
+#include "FXTaskDispatcher.h"
 #include "FXEventDispatcher.h"
 #include "FXDrawable.h"
 #include "FXBitmap.h"
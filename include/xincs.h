@@ -180,9 +180,16 @@
 #ifdef HAVE_SYS_EPOLL_H
 #include <sys/epoll.h>
 #endif
+#ifdef HAVE_IO_URING_H
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
 #ifdef HAVE_SYS_TIMERFD_H
 #include <sys/timerfd.h>
 #endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 #ifdef HAVE_SYS_RESOURCE_H
 #include <sys/resource.h>
 #endif
@@ -299,6 +306,12 @@ typedef cpuset_t   cpu_set_t;
 #endif
 #endif
 
+// NEON Intrinsics only if available and turned on
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define FOX_HAS_NEON
+#endif
+
 
 // X11 includes
 #include <X11/X.h>
@@ -139,6 +139,58 @@
       - Popup modal.  Very similar to Modal for a window, except when clicking
         outside the popup stack is closed instead of issuing a beep.
 
+  - Timers are kept in a binary heap ordered by due time, so adding and removing
+    a timer is O(log n).  Timers with equal due time are ordered by a stamp, which
+    decreases with each addition, so the latest timer added goes first, as it did
+    when timers were kept in a sorted list.
+
+  - Chores are kept in a doubly linked list, with a pointer to the last one, so
+    appending and removing a chore is O(1).  The stamp of a chore increases with
+    each addition, and orders the chores of one target.
+
+  - Timers and chores are also linked, per target, in a chain hanging off a hash
+    table keyed by the target; the chain is searched for the selector.  Thus, finding
+    a timer or chore costs time proportional to the number of timers or chores
+    set for the one target, not the number of timers or chores in total.
+    Timers and chores without target are filed under a dummy key.
+
+  - Where available, inputs and the display connection are watched with epoll(), so
+    file descriptors beyond FD_SETSIZE may be watched, and only those inputs which
+    are ready are looked at.  Note that epoll() refuses regular files and some other
+    kinds of descriptors, which select() always reports as ready; these are kept on
+    a separate list, and are reported ready for reading and writing on every pass
+    through the event loop, just as select() would.
+
+  - Motion events are compressed with the motion events queued right behind them for
+    the same window and button state; exposures found in between are added to the
+    repaints, as they would have been anyway.  Configure events are compressed with all
+    configure events queued for the same window.  The number of events merged is stuck
+    in a field of the raw event which FOX does not use otherwise, and passed on in
+    FXEvent::coalesced.  Compression may be turned off with setEventCompression().
+
+  - Normally, refresh() is called after each event is handled, and starts a walk of
+    the entire widget tree, sending SEL_UPDATE to each widget, during idle time.  With
+    many widgets, this is a lot of work for every keystroke or mouse move.
+    With a refresh interval set, refresh() instead starts a timer, which starts the walk
+    when it fires; so the walk happens at most once per interval while events keep
+    coming, and not at all when nothing happens.
+    In between, windows which know they need updating are scheduled by refresh(window),
+    or by refreshSubscribers() for the windows subscribed to some target, and these
+    are updated during idle time ahead of the walk.  A flag on the window keeps it
+    from being scheduled twice, and tells the window to unschedule and unsubscribe
+    itself when it is destroyed.
+    The number of windows visited by the last complete walk is available from
+    getRefreshVisits().
+
+  - Images rendered through XSHM used to get a fresh shared memory segment for each
+    render, attach it to the server, and tear it all down afterward.  Now segments
+    are kept in a small pool, sized in powers of two, and reused by later renders.
+    Segments are removed with IPC_RMID as soon as the server has attached, so they
+    go away when the program exits, however it exits.
+    Instead of a round trip after each transfer, the serial number of the request
+    using a segment is remembered; the round trip is only made when the segment is
+    reused before the server is known to be done with it.
+
 */
 
 #define TOPIC_CONSTRUCT 1000
@@ -261,11 +313,13 @@ struct FXCBSpec {
 
 // Timer record
 struct FXTimer {
-  FXTimer       *next;              // Next timeout in list
+  FXTimer       *next;              // Next timer of same target
   FXObject      *target;            // Receiver object
   FXptr          data;              // User data
   FXSelector     message;           // Message sent to receiver
   FXTime         due;               // When timer is due (ns)
+  FXlong         stamp;             // Order among timers due at same time
+  FXint          slot;              // Index in timer heap
   };
 
 
@@ -281,17 +335,46 @@ struct FXSignal {
 // Idle record
 struct FXChore {
   FXChore       *next;              // Next chore in list
+  FXChore       *prev;              // Previous chore in list
+  FXChore       *link;              // Next chore of same target
   FXObject      *target;            // Receiver object
   FXptr          data;              // User data
   FXSelector     message;           // Message sent to receiver
+  FXlong         stamp;             // Order among chores of same target
   };
 
 
+// Subscription of window to target
+struct FXSubscription {
+  FXSubscription *next;             // Next subscriber to same target
+  FXSubscription *prev;             // Previous subscriber to same target
+  FXWindow       *window;           // Subscribed window
+  FXObject       *target;           // Target subscribed to
+  };
+
+
+// Dummy key for timers and chores without target
+static const FXuchar notarget=0;
+
+// Key for timers and chores of target
+#define TARGETKEY(tgt) ((tgt)?(const void*)(tgt):(const void*)&notarget)
+
+// First timer of target
+static inline FXTimer* firsttimer(const FXHash& map,const FXObject* tgt){ return (FXTimer*)map.at(TARGETKEY(tgt)); }
+
+// First chore of target
+static inline FXChore* firstchore(const FXHash& map,const FXObject* tgt){ return (FXChore*)map.at(TARGETKEY(tgt)); }
+
+
 // Input record
 struct FXInput {
   FXCBSpec       read;              // Callback spec for read
   FXCBSpec       write;             // Callback spec for write
   FXCBSpec       excpt;             // Callback spec for except
+#if !defined(WIN32) && defined(HAVE_EPOLL_CREATE1)
+  FXuint         mode;              // Modes being watched
+  FXbool         always;            // Refused by epoll, so always ready
+#endif
   };
 
 
@@ -307,8 +390,12 @@ struct FXRepaint {
 
 // Handles to be watched
 struct FXHandles {
-#ifdef WIN32
+#if defined(WIN32)
   HANDLE hnd[MAXIMUM_WAIT_OBJECTS];     // Handle table
+#elif defined(HAVE_EPOLL_CREATE1)
+  FXInputHandle hnd;                    // Poll handle
+  FXInputHandle *always;                // Inputs refused by poll handle
+  FXint nalways;                        // Number of these
 #else
   fd_set hnd[3];                        // Handle table
 #endif
@@ -459,6 +546,7 @@ static const unsigned char ver_bits[] = {
 // Map
 FXDEFMAP(FXApp) FXAppMap[]={
   FXMAPFUNC(SEL_TIMEOUT,FXApp::ID_HOVER,FXApp::onCmdHover),
+  FXMAPFUNC(SEL_TIMEOUT,FXApp::ID_REFRESH,FXApp::onCmdRefresh),
   FXMAPFUNC(SEL_TIMEOUT,FXApp::ID_QUIT,FXApp::onCmdQuit),
   FXMAPFUNC(SEL_SIGNAL,FXApp::ID_QUIT,FXApp::onCmdQuit),
   FXMAPFUNC(SEL_CHORE,FXApp::ID_QUIT,FXApp::onCmdQuit),
@@ -495,9 +583,20 @@ FXApp::FXApp(const FXString& name,const FXString& vendor):registry(name,vendor){
   dragWindow=nullptr;                     // Drop target window
   refresher=nullptr;                      // GUI refresher pointer
   refresherstop=nullptr;                  // GUI refresher end pointer
+  refreshees=nullptr;                     // No windows to be refreshed by themselves
+  nrefreshees=0;                          // Number of such windows
+  maxrefreshees=0;                        // Size of array of such windows
+  refreshInterval=0;                      // Refresh entire tree right away
+  refreshcount=0;                         // Windows visited in this sweep
+  refreshvisits=0;                        // Windows visited in last sweep
   popupWindow=nullptr;                    // No popup windows
   timers=nullptr;                         // No timers present
+  ntimers=0;                              // Number of timers
+  maxtimers=0;                            // Size of timer heap
+  timerstamp=0;                           // Timer stamp
   chores=nullptr;                         // No chores present
+  chorelast=nullptr;                      // Last chore
+  chorestamp=0;                           // Chore stamp
   repaints=nullptr;                       // No outstanding repaints
   timerrecs=nullptr;                      // No timer records
   chorerecs=nullptr;                      // No chore records
@@ -508,6 +607,10 @@ FXApp::FXApp(const FXString& name,const FXString& vendor):registry(name,vendor){
   callocElms(inputs,8);                   // Input file descriptors
   ninputs=8;                              // Number of these
   callocElms(handles,1);                  // Input handles
+#if !defined(WIN32) && defined(HAVE_EPOLL_CREATE1)
+  handles->hnd=epoll_create1(EPOLL_CLOEXEC);  // Poll handle
+  if(handles->hnd<0){ fxerror("%s::FXApp: unable to create poll handle.\n",getClassName()); }
+#endif
   maxhandle=-1;                           // Maximum handle number
   inputmethod="";                         // Input method name
   inputstyle="overthespot";               // Input method style
@@ -716,6 +819,10 @@ FXApp::FXApp(const FXString& name,const FXString& vendor):registry(name,vendor){
   // Miscellaneous stuff
   shmi=true;
   shmp=true;
+  shmsegments[0]=nullptr;                 // Pool of XSHM segments
+  shmsegments[1]=nullptr;
+  shmsegments[2]=nullptr;
+  shmsegments[3]=nullptr;
   xrender=false;
   synchronize=false;
 
@@ -736,6 +843,7 @@ FXApp::FXApp(const FXString& name,const FXString& vendor):registry(name,vendor){
   // Miscellaneous settings
   dragDelta=6;
   wheelLines=10;
+  compression=COMPRESS_MOTION|COMPRESS_CONFIGURE;
   scrollBarSize=15;
 
   // Make font
@@ -1540,6 +1648,15 @@ FXbool FXApp::openDisplay(const FXchar* dpy){
     // For debugging
     if(synchronize) XSynchronize((Display*)display,true);
 
+#if defined(HAVE_EPOLL_CREATE1)
+
+    // Watch display connection
+    struct epoll_event ev;
+    ev.events=EPOLLIN;
+    ev.data.fd=ConnectionNumber((Display*)display);
+    epoll_ctl(handles->hnd,EPOLL_CTL_ADD,ev.data.fd,&ev);
+#endif
+
     // Setup locales and input method if given
     if(XSupportsLocale()){
       FXchar mods[100]="";
@@ -1781,6 +1898,108 @@ FXbool FXApp::openDisplay(const FXchar* dpy){
   }
 
 
+#if !defined(WIN32)
+
+#if defined(HAVE_XSHM_H)
+
+// Shared memory segment, attached to the server
+struct FXShmSegment {
+  XShmSegmentInfo info;         // Segment info, must be first
+  FXuval          size;         // Size of segment
+  unsigned long   serial;       // Last request using segment
+  };
+
+
+// Smallest segment size
+const FXuval SHMMINSIZE=65536;
+
+
+// Detach segment from server, and free it
+static void destroyShmSegment(Display* dpy,FXShmSegment* seg){
+  FXTRACE((TOPIC_DETAIL,"XSHM segment detached at memory=%p (%lu bytes)\n",seg->info.shmaddr,seg->size));
+  XShmDetach(dpy,&seg->info);
+  shmdt(seg->info.shmaddr);
+  delete seg;
+  }
+
+#endif
+
+
+// Get shared memory segment, attached to the server, of at least size bytes;
+// segment from the pool is reused if there is one of the right size
+void* FXApp::getShmSegment(FXuval size){
+#if defined(HAVE_XSHM_H)
+  FXuval bucket=SHMMINSIZE;
+  FXShmSegment *seg;
+  while(bucket<size){ bucket<<=1; }
+  for(FXuint i=0; i<ARRAYNUMBER(shmsegments); ++i){
+    seg=(FXShmSegment*)shmsegments[i];
+    if(seg && seg->size==bucket){
+      shmsegments[i]=nullptr;
+      if((long)(seg->serial-LastKnownRequestProcessed((Display*)display))>0){
+        XSync((Display*)display,False);
+        }
+      return seg;
+      }
+    }
+  seg=new FXShmSegment;
+  seg->info.shmid=shmget(IPC_PRIVATE,bucket,IPC_CREAT|0777);
+  if(seg->info.shmid!=-1){
+    seg->info.shmaddr=(char*)shmat(seg->info.shmid,0,0);
+    if(seg->info.shmaddr!=(char*)-1){
+      seg->info.readOnly=false;
+      if(XShmAttach((Display*)display,&seg->info)){
+        XSync((Display*)display,False);
+        shmctl(seg->info.shmid,IPC_RMID,0);
+        seg->size=bucket;
+        seg->serial=0;
+        FXTRACE((TOPIC_DETAIL,"XSHM segment attached at memory=%p (%lu bytes)\n",seg->info.shmaddr,seg->size));
+        return seg;
+        }
+      shmdt(seg->info.shmaddr);
+      }
+    shmctl(seg->info.shmid,IPC_RMID,0);
+    }
+  delete seg;
+#endif
+  return nullptr;
+  }
+
+
+// Return segment to the pool after the last request using it was issued; if
+// the pool is full, the smallest segment is freed
+void FXApp::putShmSegment(void* segment){
+#if defined(HAVE_XSHM_H)
+  FXShmSegment *seg=(FXShmSegment*)segment;
+  FXShmSegment *smallest=seg;
+  FXuint s=ARRAYNUMBER(shmsegments);
+  seg->serial=NextRequest((Display*)display)-1;
+  for(FXuint i=0; i<ARRAYNUMBER(shmsegments); ++i){
+    if(!shmsegments[i]){ shmsegments[i]=seg; return; }
+    if(((FXShmSegment*)shmsegments[i])->size<smallest->size){ smallest=(FXShmSegment*)shmsegments[i]; s=i; }
+    }
+  if(s<ARRAYNUMBER(shmsegments)){ shmsegments[s]=seg; }
+  destroyShmSegment((Display*)display,smallest);
+#endif
+  }
+
+
+// Free all segments in the pool
+void FXApp::freeShmSegments(){
+#if defined(HAVE_XSHM_H)
+  for(FXuint i=0; i<ARRAYNUMBER(shmsegments); ++i){
+    if(shmsegments[i]){
+      destroyShmSegment((Display*)display,(FXShmSegment*)shmsegments[i]);
+      shmsegments[i]=nullptr;
+      }
+    }
+#endif
+  }
+
+
+#endif
+
+
 // Close display
 FXbool FXApp::closeDisplay(){
   if(initialized){
@@ -1850,11 +2069,23 @@ FXbool FXApp::closeDisplay(){
     XFreePixmap((Display*)display,stipples[STIPPLE_REVDIAG]);
     XFreePixmap((Display*)display,stipples[STIPPLE_CROSSDIAG]);
 
+    // Free pooled shared memory segments
+    freeShmSegments();
+
     // Close input method
 #ifndef NO_XIM
     if(xim){XCloseIM((XIM)xim);}
 #endif
 
+#if defined(HAVE_EPOLL_CREATE1)
+
+    // Stop watching display connection
+    struct epoll_event ev;
+    ev.events=0;
+    ev.data.fd=0;
+    epoll_ctl(handles->hnd,EPOLL_CTL_DEL,ConnectionNumber((Display*)display),&ev);
+#endif
+
     // Close display
     XCloseDisplay((Display*)display);
 
@@ -1875,27 +2106,99 @@ FXbool FXApp::closeDisplay(){
 
 /*******************************************************************************/
 
+// Timer a goes before timer b
+static inline FXbool before(const FXTimer* a,const FXTimer* b){
+  return a->due<b->due || (a->due==b->due && a->stamp<b->stamp);
+  }
+
+
+// Move timer at slot i up the heap
+static void siftup(FXTimer** heap,FXint i){
+  FXTimer* t=heap[i];
+  FXint p;
+  while(0<i && before(t,heap[p=(i-1)>>1])){
+    heap[i]=heap[p];
+    heap[i]->slot=i;
+    i=p;
+    }
+  heap[i]=t;
+  t->slot=i;
+  }
+
+
+// Move timer at slot i down the heap of n timers
+static void siftdown(FXTimer** heap,FXint n,FXint i){
+  FXTimer* t=heap[i];
+  FXint c;
+  while((c=i+i+1)<n){
+    if(c+1<n && before(heap[c+1],heap[c])) c++;
+    if(!before(heap[c],t)) break;
+    heap[i]=heap[c];
+    heap[i]->slot=i;
+    i=c;
+    }
+  heap[i]=t;
+  t->slot=i;
+  }
+
+
+// Take timer out of heap of n timers
+static void heapremove(FXTimer** heap,FXint& n,FXTimer* t){
+  FXint i=t->slot;
+  if(i<--n){
+    FXTimer* m=heap[n];
+    heap[i]=m;
+    m->slot=i;
+    siftdown(heap,n,i);
+    siftup(heap,m->slot);
+    }
+  }
+
+
+// Unlink timer from heap and target, and recycle it
+void FXApp::unlinkTimer(FXTimer* t){
+  FXival pos=timermap.find(TARGETKEY(t->target));
+  FXTimer **tt=(FXTimer**)&timermap.data(pos);
+  while(*tt!=t) tt=&(*tt)->next;
+  *tt=t->next;
+  if(!timermap.data(pos)) timermap.erase(pos);
+  heapremove(timers,ntimers,t);
+  t->next=timerrecs;
+  timerrecs=t;
+  }
+
+
 // Add deadline in nanoseconds
 FXptr FXApp::addDeadline(FXObject* tgt,FXSelector sel,FXTime due,FXptr ptr){
   FXptr result=nullptr;
-  FXTimer *t,**tt;
-  for(tt=&timers; (t=*tt)!=nullptr; tt=&t->next){
-    if(t->target==tgt && t->message==sel){ *tt=t->next; result=t->data; goto a; }
-    }
-  if(timerrecs){
-    t=timerrecs;
-    timerrecs=t->next;
+  FXTimer *t=firsttimer(timermap,tgt);
+  while(t && t->message!=sel) t=t->next;
+  if(t){
+    heapremove(timers,ntimers,t);
+    result=t->data;
     }
   else{
-    t=new FXTimer;
+    if(timerrecs){
+      t=timerrecs;
+      timerrecs=t->next;
+      }
+    else{
+      t=new FXTimer;
+      }
+    t->target=tgt;
+    t->message=sel;
+    t->next=firsttimer(timermap,tgt);
+    timermap.insert(TARGETKEY(tgt),t);
+    }
+  if(ntimers>=maxtimers){
+    maxtimers=maxtimers+maxtimers+16;
+    resizeElms(timers,maxtimers);
     }
-a:t->data=ptr;
-  t->target=tgt;
-  t->message=sel;
+  t->data=ptr;
   t->due=due;
-  for(tt=&timers; *tt!=nullptr && ((*tt)->due < t->due); tt=&(*tt)->next){}
-  t->next=*tt;
-  *tt=t;
+  t->stamp=--timerstamp;
+  timers[ntimers]=t;
+  siftup(timers,ntimers++);
   return result;
   }
 
@@ -1908,24 +2211,26 @@ FXptr FXApp::addTimeout(FXObject* tgt,FXSelector sel,FXTime ns,FXptr ptr){
 
 // Check if timeout identified by tgt and sel has been set
 FXbool FXApp::hasTimeout(FXObject* tgt,FXSelector sel) const {
-  for(FXTimer *t=timers; t; t=t->next){
-    if(t->target==tgt && (sel==0 || t->message==sel)) return true;
+  for(const FXTimer *t=firsttimer(timermap,tgt); t; t=t->next){
+    if(sel==0 || t->message==sel) return true;
     }
   return false;
   }
 
 
-// Remove timeout(s) identified by tgt and sel from the list
+// Remove timeout(s) identified by tgt and sel from the list;
+// return the data of the one which would have fired last
 FXptr FXApp::removeTimeout(FXObject* tgt,FXSelector sel){
+  FXTimer *t=firsttimer(timermap,tgt);
+  FXTimer *last=nullptr;
   FXptr result=nullptr;
-  FXTimer **tt=&timers;
-  FXTimer *t;
-  while((t=*tt)!=nullptr){
-    if(t->target==tgt && (sel==0 || t->message==sel)){
-      *tt=t->next; result=t->data; t->next=timerrecs; timerrecs=t;
-      continue;
+  while(t){
+    FXTimer *n=t->next;
+    if(sel==0 || t->message==sel){
+      if(!last || before(last,t)){ last=t; result=t->data; }
+      unlinkTimer(t);
       }
-    tt=&t->next;
+    t=n;
     }
   return result;
   }
@@ -1933,11 +2238,13 @@ FXptr FXApp::removeTimeout(FXObject* tgt,FXSelector sel){
 
 // Return the remaining time, in nanoseconds
 FXTime FXApp::remainingTimeout(FXObject *tgt,FXSelector sel) const {
-  for(FXTimer *t=timers; t; t=t->next){
-    if(t->target==tgt && (sel==0 || t->message==sel)){
-      FXTime now=FXThread::time();
-      return t->due>now ? t->due-now : 0L;
-      }
+  const FXTimer *first=nullptr;
+  for(const FXTimer *t=firsttimer(timermap,tgt); t; t=t->next){
+    if((sel==0 || t->message==sel) && (!first || before(t,first))) first=t;
+    }
+  if(first){
+    FXTime now=FXThread::time();
+    return first->due>now ? first->due-now : 0L;
     }
   return forever;
   }
@@ -2030,41 +2337,66 @@ void FXApp::removeSignal(FXint sig){
 /*******************************************************************************/
 
 
+// Unlink chore from list and target, and recycle it
+void FXApp::unlinkChore(FXChore* c){
+  FXival pos=choremap.find(TARGETKEY(c->target));
+  FXChore **cc=(FXChore**)&choremap.data(pos);
+  while(*cc!=c) cc=&(*cc)->link;
+  *cc=c->link;
+  if(!choremap.data(pos)) choremap.erase(pos);
+  if(c->prev) c->prev->next=c->next; else chores=c->next;
+  if(c->next) c->next->prev=c->prev; else chorelast=c->prev;
+  c->next=chorerecs;
+  chorerecs=c;
+  }
+
+
 // Add chore to the END of the list
 FXptr FXApp::addChore(FXObject* tgt,FXSelector sel,FXptr ptr){
   FXptr result=nullptr;
-  FXChore *c,**cc;
-  for(cc=&chores; (c=*cc)!=nullptr; cc=&c->next){
-    if(c->target==tgt && c->message==sel){ *cc=c->next; result=c->data; goto a; }
-    }
-  if(chorerecs){
-    c=chorerecs;
-    chorerecs=c->next;
+  FXChore *c=firstchore(choremap,tgt);
+  while(c && c->message!=sel) c=c->link;
+  if(c){
+    if(c->prev) c->prev->next=c->next; else chores=c->next;
+    if(c->next) c->next->prev=c->prev; else chorelast=c->prev;
+    result=c->data;
     }
   else{
-    c=new FXChore;
+    if(chorerecs){
+      c=chorerecs;
+      chorerecs=c->next;
+      }
+    else{
+      c=new FXChore;
+      }
+    c->target=tgt;
+    c->message=sel;
+    c->link=firstchore(choremap,tgt);
+    choremap.insert(TARGETKEY(tgt),c);
     }
-a:c->data=ptr;
-  c->target=tgt;
-  c->message=sel;
-  for(cc=&chores; *cc; cc=&(*cc)->next){}
+  c->data=ptr;
+  c->stamp=++chorestamp;
   c->next=nullptr;
-  *cc=c;
+  c->prev=chorelast;
+  if(chorelast) chorelast->next=c; else chores=c;
+  chorelast=c;
   return result;
   }
 
 
-// Remove chore(s) identified by tgt and sel from the list
+// Remove chore(s) identified by tgt and sel from the list;
+// return the data of the one which would have run last
 FXptr FXApp::removeChore(FXObject* tgt,FXSelector sel){
+  FXChore *c=firstchore(choremap,tgt);
+  FXChore *last=nullptr;
   FXptr result=nullptr;
-  FXChore **cc=&chores;
-  FXChore *c;
-  while((c=*cc)!=nullptr){
-    if(c->target==tgt && (sel==0 || c->message==sel)){
-      *cc=c->next; result=c->data; c->next=chorerecs; chorerecs=c;
-      continue;
+  while(c){
+    FXChore *n=c->link;
+    if(sel==0 || c->message==sel){
+      if(!last || last->stamp<c->stamp){ last=c; result=c->data; }
+      unlinkChore(c);
       }
-    cc=&c->next;
+    c=n;
     }
   return result;
   }
@@ -2072,8 +2404,8 @@ FXptr FXApp::removeChore(FXObject* tgt,FXSelector sel){
 
 // Check if chore identified by tgt and sel has been set
 FXbool FXApp::hasChore(FXObject* tgt,FXSelector sel) const {
-  for(FXChore *c=chores; c; c=c->next){
-    if(c->target==tgt && (sel==0 || c->message==sel)) return true;
+  for(const FXChore *c=firstchore(choremap,tgt); c; c=c->link){
+    if(sel==0 || c->message==sel) return true;
     }
   return false;
   }
@@ -2114,6 +2446,46 @@ r:FXASSERT(in<ninputs);
     inputs[in].excpt.message=sel;
     inputs[in].excpt.data=ptr;
     }
+#elif defined(HAVE_EPOLL_CREATE1)
+  struct epoll_event ev;
+  if(fd<0) return false;
+  if(fd>=ninputs){                      // Grow table of callbacks
+    resizeElms(inputs,fd+1);
+    clearElms(&inputs[ninputs],fd+1-ninputs);
+    ninputs=fd+1;
+    }
+  FXASSERT(inputs);
+  FXASSERT(fd<ninputs);
+  ev.events=0;
+  ev.data.fd=fd;
+  if((inputs[fd].mode|mode)&INPUT_READ) ev.events|=EPOLLIN;
+  if((inputs[fd].mode|mode)&INPUT_WRITE) ev.events|=EPOLLOUT;
+  if((inputs[fd].mode|mode)&INPUT_EXCEPT) ev.events|=EPOLLPRI;
+  if(inputs[fd].mode){                  // Already watched; but may have been closed and reopened
+    if(!inputs[fd].always && epoll_ctl(handles->hnd,EPOLL_CTL_MOD,fd,&ev)!=0 && (errno!=ENOENT || epoll_ctl(handles->hnd,EPOLL_CTL_ADD,fd,&ev)!=0)) return false;
+    }
+  else if(epoll_ctl(handles->hnd,EPOLL_CTL_ADD,fd,&ev)!=0){
+    if(errno!=EPERM) return false;      // Regular file and such are always ready
+    if(!resizeElms(handles->always,handles->nalways+1)) return false;
+    handles->always[handles->nalways++]=fd;
+    inputs[fd].always=true;
+    }
+  inputs[fd].mode|=mode;
+  if(mode&INPUT_READ){
+    inputs[fd].read.target=tgt;
+    inputs[fd].read.message=sel;
+    inputs[fd].read.data=ptr;
+    }
+  if(mode&INPUT_WRITE){
+    inputs[fd].write.target=tgt;
+    inputs[fd].write.message=sel;
+    inputs[fd].write.data=ptr;
+    }
+  if(mode&INPUT_EXCEPT){
+    inputs[fd].excpt.target=tgt;
+    inputs[fd].excpt.message=sel;
+    inputs[fd].excpt.data=ptr;
+    }
 #else
   if(fd<0 || fd>=FD_SETSIZE) return false;
   if(fd>=ninputs){                      // Grow table of callbacks
@@ -2177,6 +2549,40 @@ r:if(mode&INPUT_READ){
     inputs[in]=inputs[maxhandle];
     maxhandle--;
     }
+#elif defined(HAVE_EPOLL_CREATE1)
+  struct epoll_event ev;
+  if(fd<0 || fd>=ninputs || !inputs[fd].mode) return false;
+  if(mode&INPUT_READ){
+    inputs[fd].read.target=nullptr;
+    inputs[fd].read.message=0;
+    inputs[fd].read.data=nullptr;
+    }
+  if(mode&INPUT_WRITE){
+    inputs[fd].write.target=nullptr;
+    inputs[fd].write.message=0;
+    inputs[fd].write.data=nullptr;
+    }
+  if(mode&INPUT_EXCEPT){
+    inputs[fd].excpt.target=nullptr;
+    inputs[fd].excpt.message=0;
+    inputs[fd].excpt.data=nullptr;
+    }
+  inputs[fd].mode&=~mode;
+  if(inputs[fd].always){                // Not in poll handle; drop from list when no longer watched
+    if(!inputs[fd].mode){
+      for(FXint i=0; i<handles->nalways; ++i){
+        if(handles->always[i]==fd){ handles->always[i]=handles->always[--handles->nalways]; break; }
+        }
+      inputs[fd].always=false;
+      }
+    return true;
+    }
+  ev.events=0;
+  ev.data.fd=fd;
+  if(inputs[fd].mode&INPUT_READ) ev.events|=EPOLLIN;
+  if(inputs[fd].mode&INPUT_WRITE) ev.events|=EPOLLOUT;
+  if(inputs[fd].mode&INPUT_EXCEPT) ev.events|=EPOLLPRI;
+  epoll_ctl(handles->hnd,inputs[fd].mode?EPOLL_CTL_MOD:EPOLL_CTL_DEL,fd,&ev);   // May fail if already closed
 #else
   if(fd<0 || fd>maxhandle) return false;
   if(mode&INPUT_READ){
@@ -2377,11 +2783,9 @@ FXbool FXApp::getNextEvent(FXRawEvent& ev,FXTime blocking){
 a:ev.xany.type=0;
 
   // If a timer is due, handle it
-  if(timers && timers->due<=FXThread::time()){
-    FXTimer* t=timers;
-    timers=t->next;
-    t->next=timerrecs;
-    timerrecs=t;
+  if(ntimers && timers[0]->due<=FXThread::time()){
+    FXTimer* t=timers[0];
+    unlinkTimer(t);
     if(t->target && t->target->tryHandle(this,FXSEL(SEL_TIMEOUT,t->message),t->data)) refresh();
     return false;
     }
@@ -2399,6 +2803,17 @@ a:ev.xany.type=0;
 
   // Are there no events already queued up?
   if(!initialized || !XEventsQueued((Display*)display,QueuedAfterFlush)){
+#if defined(HAVE_EPOLL_CREATE1)
+    struct epoll_event events[128];
+    FXbool ready=false;
+    int    nevents=0;
+    int    nfds=0;
+    int    ms;
+
+    // Do a quick poll for any ready events or inputs; inputs refused by epoll are always ready
+    nevents=epoll_pwait(handles->hnd,events,ARRAYNUMBER(events),0,nullptr);
+    nfds=(0<=nevents)?nevents+handles->nalways:nevents;
+#else
 #if defined(__USE_XOPEN2K)
     struct timespec delta;
 #else
@@ -2432,6 +2847,7 @@ a:ev.xany.type=0;
     delta.tv_usec=0;
     delta.tv_sec=0;
     nfds=select(maxfds+1,&readfds,&writefds,&exceptfds,&delta);
+#endif
 #endif
 
     // Nothing to do, so perform idle processing
@@ -2456,12 +2872,18 @@ a:ev.xany.type=0;
       // Do our chores :-)
       if(chores){
         FXChore *c=chores;
-        chores=c->next;
-        c->next=chorerecs;
-        chorerecs=c;
+        unlinkChore(c);
         if(c->target && c->target->tryHandle(this,FXSEL(SEL_CHORE,c->message),c->data)) refresh();
         }
 
+      // GUI updating:- windows scheduled by themselves first
+      if(nrefreshees){
+        FXWindow* w=refreshees[--nrefreshees];
+        w->flags&=~FXWindow::FLAG_REFRESH;
+        w->handle(this,FXSEL(SEL_UPDATE,0),nullptr);
+        return false;
+        }
+
       // GUI updating:- walk the whole widget tree, stop after updating refresherstop
       if(refresher){
         if(refresher->getFirst()){
@@ -2474,8 +2896,11 @@ a:ev.xany.type=0;
             }
           }
         refresher->handle(this,FXSEL(SEL_UPDATE,0),nullptr);
+        refreshcount++;
         if(refresher!=refresherstop) return false;
         refresher=refresherstop=nullptr;
+        refreshvisits=refreshcount;
+        refreshcount=0;
         }
 
       // There are more chores to do
@@ -2484,6 +2909,36 @@ a:ev.xany.type=0;
       // We're not blocking
       if(blocking<=0) return false;
 
+#if defined(HAVE_EPOLL_CREATE1)
+
+      // Block indefinitely, unless there are timers
+      ms=-1;
+
+      // If there are timers, we block only for a little while.
+      if(ntimers || blocking<forever){
+        FXTime interval;
+
+        // All that testing above may have taken some time...
+        if(ntimers && (interval=timers[0]->due-FXThread::time())<blocking) blocking=interval;
+
+        // Some timers are already due; do them right away!
+        if(blocking<=0) return false;
+
+        // Round up to milliseconds so as not to wake up too early; wake up at least once a day
+        ms=(int)((FXMIN(blocking,FXLONG(86400000000000))+999999)/1000000);
+        }
+
+      // Exit critical section
+      appMutex.unlock();
+
+      // Block till timer or event or interrupt; don't block if chores added inputs which are always ready
+      nevents=epoll_pwait(handles->hnd,events,ARRAYNUMBER(events),handles->nalways?0:ms,nullptr);
+      nfds=(0<=nevents)?nevents+handles->nalways:nevents;
+
+      // Enter critical section
+      appMutex.lock();
+#else
+
       // Now, block till timeout, i/o, or event
       maxfds=maxhandle;
       readfds=handles->hnd[0];
@@ -2497,11 +2952,11 @@ a:ev.xany.type=0;
         }
 
       // If there are timers, we block only for a little while.
-      if(timers || blocking<forever){
+      if(ntimers || blocking<forever){
         FXTime interval;
 
         // All that testing above may have taken some time...
-        if(timers && (interval=timers->due-FXThread::time())<blocking) blocking=interval;
+        if(ntimers && (interval=timers[0]->due-FXThread::time())<blocking) blocking=interval;
 
         // Some timers are already due; do them right away!
         if(blocking<=0) return false;
@@ -2540,6 +2995,7 @@ a:ev.xany.type=0;
         // Enter critical section
         appMutex.lock();
         }
+#endif
       }
 
     // Timed out or interrupted
@@ -2548,6 +3004,50 @@ a:ev.xany.type=0;
       return false;
       }
 
+#if defined(HAVE_EPOLL_CREATE1)
+
+    // Examine I/O file descriptors which are ready; each invocation has its own list,
+    // and the callbacks may remove inputs, so look at the records again
+    for(int n=0; n<nevents; n++){
+      FXInputHandle fff=events[n].data.fd;
+
+      // The display connection is treated differently
+      if(initialized && (fff==ConnectionNumber((Display*)display))){ ready=true; continue; }
+
+      // Input may have been removed by earlier callback
+      if(fff>=ninputs) continue;
+
+      // Copy the record as the callbacks may try to change things
+      FXInput in=inputs[fff];
+
+      // Check file descriptors; hangup or error make it readable, as with select()
+      if((in.mode&INPUT_READ) && (events[n].events&(EPOLLIN|EPOLLHUP|EPOLLERR))){
+        if(in.read.target && in.read.target->tryHandle(this,FXSEL(SEL_IO_READ,in.read.message),in.read.data)) refresh();
+        }
+      if((in.mode&INPUT_WRITE) && (events[n].events&(EPOLLOUT|EPOLLERR))){
+        if(in.write.target && in.write.target->tryHandle(this,FXSEL(SEL_IO_WRITE,in.write.message),in.write.data)) refresh();
+        }
+      if((in.mode&INPUT_EXCEPT) && (events[n].events&EPOLLPRI)){
+        if(in.excpt.target && in.excpt.target->tryHandle(this,FXSEL(SEL_IO_EXCEPT,in.excpt.message),in.excpt.data)) refresh();
+        }
+      }
+
+    // Inputs refused by epoll are always readable and writable, as with select(); callbacks
+    // may remove them from the list, in which case one may be skipped till the next pass
+    for(int a=0; a<handles->nalways; a++){
+      FXInput in=inputs[handles->always[a]];
+      if(in.mode&INPUT_READ){
+        if(in.read.target && in.read.target->tryHandle(this,FXSEL(SEL_IO_READ,in.read.message),in.read.data)) refresh();
+        }
+      if(in.mode&INPUT_WRITE){
+        if(in.write.target && in.write.target->tryHandle(this,FXSEL(SEL_IO_WRITE,in.write.message),in.write.data)) refresh();
+        }
+      }
+
+    // If there is no event, we're done
+    if(!ready || !XEventsQueued((Display*)display,QueuedAfterReading)) return false;
+#else
+
 // FIXME
 // When handling callback and entering recursive event loop, the value
 // in readfds in the upper invocation is no longer correct.  This needs
@@ -2580,6 +3080,7 @@ a:ev.xany.type=0;
 
     // If there is no event, we're done
     if(!initialized || !FD_ISSET(ConnectionNumber((Display*)display),&readfds) || !XEventsQueued((Display*)display,QueuedAfterReading)) return false;
+#endif
     }
 
   // Get an event
@@ -2606,13 +3107,23 @@ a:ev.xany.type=0;
     goto a;
     }
 
-  // Compress motion events
+  // Compress motion events; exposures in between just add to the repaints
   if(ev.xany.type==MotionNotify){
-    while(XPending((Display*)display)){
-      XPeekEvent((Display*)display,&e);
-      if((e.xany.type!=MotionNotify) || (ev.xmotion.window!=e.xmotion.window) || (ev.xmotion.state!=e.xmotion.state)) break;
-      XNextEvent((Display*)display,&ev);
+    FXint count=0;
+    if(compression&COMPRESS_MOTION){
+      while(XPending((Display*)display)){
+        XPeekEvent((Display*)display,&e);
+        if(e.xany.type==Expose || e.xany.type==GraphicsExpose){
+          XNextEvent((Display*)display,&e);
+          addRepaint((FXID)e.xexpose.window,e.xexpose.x,e.xexpose.y,e.xexpose.width,e.xexpose.height,false);
+          continue;
+          }
+        if((e.xany.type!=MotionNotify) || (ev.xmotion.window!=e.xmotion.window) || (ev.xmotion.state!=e.xmotion.state)) break;
+        XNextEvent((Display*)display,&ev);
+        count++;
+        }
       }
+    ev.xmotion.subwindow=(Window)count;   // Stick it here for later
     }
 
   // Compress wheel events
@@ -2629,14 +3140,19 @@ a:ev.xany.type=0;
 
   // Compress configure events
   else if(ev.xany.type==ConfigureNotify){
-    while(XCheckTypedWindowEvent((Display*)display,ev.xconfigure.window,ConfigureNotify,&e)){
-      ev.xconfigure.width=e.xconfigure.width;
-      ev.xconfigure.height=e.xconfigure.height;
-      if(e.xconfigure.send_event){
-        ev.xconfigure.x=e.xconfigure.x;
-        ev.xconfigure.y=e.xconfigure.y;
+    FXint count=0;
+    if(compression&COMPRESS_CONFIGURE){
+      while(XCheckTypedWindowEvent((Display*)display,ev.xconfigure.window,ConfigureNotify,&e)){
+        ev.xconfigure.width=e.xconfigure.width;
+        ev.xconfigure.height=e.xconfigure.height;
+        if(e.xconfigure.send_event){
+          ev.xconfigure.x=e.xconfigure.x;
+          ev.xconfigure.y=e.xconfigure.y;
+          }
+        count++;
         }
       }
+    ev.xconfigure.above=(Window)count;    // Stick it here for later
     }
 
   // Regular event
@@ -2650,34 +3166,57 @@ a:ev.xany.type=0;
 // Peek for event
 FXbool FXApp::peekEvent(){
   if(initialized){
-#if defined(__USE_XOPEN2K)
+#if defined(HAVE_EPOLL_CREATE1)
+    struct epoll_event events[128];
+#elif defined(__USE_XOPEN2K)
     struct timespec delta;
 #else
     struct timeval delta;
 #endif
+#if !defined(HAVE_EPOLL_CREATE1)
     fd_set readfds;
     fd_set writefds;
     fd_set exceptfds;
     int    maxfds;
+#endif
     int    nfds;
 
     // Outstanding repaints
     if(repaints) return true;
 
     // Still need GUI update
-    if(refresher) return true;
+    if(refresher || nrefreshees) return true;
 
     // Outstanding chores
     if(chores) return true;
 
     // Timers are due?
-    if(timers){
-      if(timers->due <= FXThread::time()) return true;
+    if(ntimers){
+      if(timers[0]->due <= FXThread::time()) return true;
       }
 
     // Events queued up in client already (Shouldn't this not be QueuedAlready?)
     if(XEventsQueued((Display*)display,QueuedAfterFlush)) return true;
 
+#if defined(HAVE_EPOLL_CREATE1)
+
+    // Do a quick poll for any ready events; inputs stay ready till handled
+    nfds=epoll_pwait(handles->hnd,events,ARRAYNUMBER(events),0,nullptr);
+
+    // Interrupt
+    if(nfds<0 && errno!=EAGAIN && errno!=EINTR){
+      fxerror("Application terminated: interrupt or lost connection errno=%d\n",errno);
+      }
+
+    // Display connection activity
+    for(int e=0; e<nfds; e++){
+      if(events[e].data.fd==ConnectionNumber((Display*)display)){
+        if(XEventsQueued((Display*)display,QueuedAfterReading)) return true;
+        break;
+        }
+      }
+#else
+
     // Prepare fd's to watch
     FD_ZERO(&readfds);
     FD_ZERO(&writefds);
@@ -2707,6 +3246,7 @@ FXbool FXApp::peekEvent(){
     if((nfds>0) && FD_ISSET(ConnectionNumber((Display*)display),&readfds)){
       if(XEventsQueued((Display*)display,QueuedAfterReading)) return true;
       }
+#endif
     }
   return false;
   }
@@ -3033,6 +3573,9 @@ FXbool FXApp::dispatchEvent(FXRawEvent& ev){
   // Was one of our windows, so dispatch
   if(window){
 
+    // Not merged with other events, unless we say so
+    event.coalesced=0;
+
     switch(ev.xany.type){
 
       // Repaint event
@@ -3177,6 +3720,7 @@ FXbool FXApp::dispatchEvent(FXRawEvent& ev){
         event.root_x=ev.xmotion.x_root;
         event.root_y=ev.xmotion.y_root;
         event.code=0;
+        event.coalesced=(FXint)ev.xmotion.subwindow;
 
         // Mouse buttons and modifiers but no wheel buttons
         event.state=(ev.xmotion.state&~(Button4Mask|Button5Mask)) | stickyMods;
@@ -3380,6 +3924,7 @@ FXbool FXApp::dispatchEvent(FXRawEvent& ev){
         event.rect.w=ev.xconfigure.width;
         event.rect.h=ev.xconfigure.height;
         event.synthetic=ev.xconfigure.send_event;
+        event.coalesced=(FXint)ev.xconfigure.above;
         if(window->handle(this,FXSEL(SEL_CONFIGURE,0),&event)) refresh();
         return true;
 
@@ -3808,11 +4353,9 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
   msg.message=0;
 
   // If a timer is due, handle it
-  if(timers && timers->due<=FXThread::time()){
-    FXTimer* t=timers;
-    timers=t->next;
-    t->next=timerrecs;
-    timerrecs=t;
+  if(ntimers && timers[0]->due<=FXThread::time()){
+    FXTimer* t=timers[0];
+    unlinkTimer(t);
     if(t->target && t->target->tryHandle(this,FXSEL(SEL_TIMEOUT,t->message),t->data)) refresh();
     return false;
     }
@@ -3845,12 +4388,18 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
     // Do our chores :-)
     if(chores){
       FXChore *c=chores;
-      chores=c->next;
-      c->next=chorerecs;
-      chorerecs=c;
+      unlinkChore(c);
       if(c->target && c->target->tryHandle(this,FXSEL(SEL_CHORE,c->message),c->data)) refresh();
       }
 
+    // GUI updating:- windows scheduled by themselves first
+    if(nrefreshees){
+      FXWindow* w=refreshees[--nrefreshees];
+      w->flags&=~FXWindow::FLAG_REFRESH;
+      w->handle(this,FXSEL(SEL_UPDATE,0),nullptr);
+      return false;
+      }
+
     // GUI updating:- walk the whole widget tree, stop after updating refresherstop
     if(refresher){
       if(refresher->getFirst()){
@@ -3863,8 +4412,11 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
           }
         }
       refresher->handle(this,FXSEL(SEL_UPDATE,0),nullptr);
+      refreshcount++;
       if(refresher!=refresherstop) return false;
       refresher=refresherstop=nullptr;
+      refreshvisits=refreshcount;
+      refreshcount=0;
       }
 
     // There are more chores to do
@@ -3882,11 +4434,11 @@ FXbool FXApp::getNextEvent(FXRawEvent& msg,FXTime blocking){
 
     // If there are timers, block only a little time
     allinputs=maxhandle+1;
-    if(timers || blocking<forever){
+    if(ntimers || blocking<forever){
       FXTime interval;
 
       // All that testing above may have taken some time...
-      if(timers && (interval=timers->due-FXThread::time())<blocking) blocking=interval;
+      if(ntimers && (interval=timers[0]->due-FXThread::time())<blocking) blocking=interval;
 
       // Some timers are already due; do them right away!
       if(blocking<=0) return false;
@@ -3958,14 +4510,14 @@ FXbool FXApp::peekEvent(){
     MSG msg;
 
     // Still need GUI update
-    if(refresher) return true;
+    if(refresher || nrefreshees) return true;
 
     // Outstanding chores
     if(chores) return true;
 
     // Timers are due?
-    if(timers){
-      if(timers->due <= FXThread::time()) return true;
+    if(ntimers){
+      if(timers[0]->due <= FXThread::time()) return true;
       }
 
     // Other events due?
@@ -4012,12 +4564,99 @@ void FXApp::forceRefresh(){
 // Schedule a future refresh; if we were in the middle of
 // one, we continue with the current cycle until we wrap
 // around to the current widget about to be updated.
+// With a refresh interval, the next cycle is started by
+// a timer instead, unless one is already underway.
 void FXApp::refresh(){
+  if(0<refreshInterval){
+    if(!refresher && !hasTimeout(this,ID_REFRESH)) addTimeout(this,ID_REFRESH,refreshInterval);
+    return;
+    }
   if(!refresher) refresher=root;
   refresherstop=refresher;
   }
 
 
+// Start refresh cycle; returns 0 so as not to schedule another
+long FXApp::onCmdRefresh(FXObject*,FXSelector,void*){
+  if(!refresher) refresher=root;
+  refresherstop=refresher;
+  return 0;
+  }
+
+
+// Schedule a future refresh of just this window
+void FXApp::refresh(FXWindow* window){
+  if(window && !(window->flags&FXWindow::FLAG_REFRESH)){
+    if(nrefreshees>=maxrefreshees){
+      maxrefreshees=FXMAX(16,maxrefreshees<<1);
+      resizeElms(refreshees,maxrefreshees);
+      }
+    refreshees[nrefreshees++]=window;
+    window->flags|=FXWindow::FLAG_REFRESH;
+    }
+  }
+
+
+// Unschedule refresh of window
+void FXApp::unlinkRefresh(FXWindow* window){
+  for(FXint i=nrefreshees-1; 0<=i; --i){
+    if(refreshees[i]==window){
+      refreshees[i]=refreshees[--nrefreshees];
+      break;
+      }
+    }
+  window->flags&=~FXWindow::FLAG_REFRESH;
+  }
+
+
+// Subscribe window to changes of target
+void FXApp::subscribe(FXWindow* window,FXObject* tgt){
+  if(window && tgt){
+    FXSubscription* s=(FXSubscription*)((const FXHash&)subscriptions).at(window);
+    if(s){
+      if(s->target==tgt) return;
+      unsubscribe(window);
+      }
+    s=new FXSubscription;
+    s->window=window;
+    s->target=tgt;
+    s->prev=nullptr;
+    s->next=(FXSubscription*)((const FXHash&)subscribers).at(tgt);
+    if(s->next) s->next->prev=s;
+    subscribers.insert(tgt,s);
+    subscriptions.insert(window,s);
+    window->flags|=FXWindow::FLAG_SUBSCRIBED;
+    }
+  }
+
+
+// Unsubscribe window
+void FXApp::unsubscribe(FXWindow* window){
+  FXSubscription* s=(FXSubscription*)subscriptions.remove(window);
+  if(s){
+    if(s->next) s->next->prev=s->prev;
+    if(s->prev) s->prev->next=s->next; else if(s->next) subscribers.insert(s->target,s->next); else subscribers.remove(s->target);
+    delete s;
+    }
+  window->flags&=~FXWindow::FLAG_SUBSCRIBED;
+  }
+
+
+// Schedule refresh of windows subscribed to target
+void FXApp::refreshSubscribers(FXObject* tgt){
+  for(const FXSubscription* s=(const FXSubscription*)((const FXHash&)subscribers).at(tgt); s; s=s->next){
+    refresh(s->window);
+    }
+  }
+
+
+// Change interval between refreshes of entire widget tree
+void FXApp::setRefreshInterval(FXTime ns){
+  if(ns<=0) removeTimeout(this,ID_REFRESH);
+  refreshInterval=FXMAX(ns,0);
+  }
+
+
 // Paint all windows marked for repainting
 void FXApp::repaint(){
   if(initialized){
@@ -5756,6 +6395,11 @@ void FXApp::setWheelLines(FXint lines){
   wheelLines=lines;
   }
 
+// Change event compression modes
+void FXApp::setEventCompression(FXuint modes){
+  compression=modes;
+  }
+
 // Change scroll bar size
 void FXApp::setScrollBarSize(FXint size){
   scrollBarSize=size;
@@ -5878,6 +6522,10 @@ FXApp::~FXApp(){
   delete translator;
 
   // Free inputs and handles
+#if !defined(WIN32) && defined(HAVE_EPOLL_CREATE1)
+  ::close(handles->hnd);
+  freeElms(handles->always);
+#endif
   freeElms(inputs);
   freeElms(handles);
 
@@ -5913,12 +6561,19 @@ FXApp::~FXApp(){
     delete r;
     }
 
+  // Free windows to be refreshed
+  freeElms(refreshees);
+
+  // Free subscriptions of windows outside widget tree
+  for(FXival i=0; i<subscriptions.no(); ++i){
+    if(!subscriptions.empty(i)) delete (FXSubscription*)subscriptions.data(i);
+    }
+
   // Kill outstanding timers
-  while(timers){
-    t=timers;
-    timers=timers->next;
-    delete t;
+  while(ntimers){
+    delete timers[--ntimers];
     }
+  freeElms(timers);
 
   // Free recycled timer records
   while(timerrecs){
@@ -5933,6 +6588,7 @@ FXApp::~FXApp(){
     chores=chores->next;
     delete c;
     }
+  chorelast=nullptr;
 
   // Free recycled chore records
   while(chorerecs){
@@ -0,0 +1,134 @@
+/********************************************************************************
+*                                                                               *
+*                         A t o m i c   O p e r a t i o n s                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2006,2024 by Jeroen van der Zijp.   All Rights Reserved.        *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXAtomic.h"
+#include "FXMutex.h"
+#include "FXCondition.h"
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+/*
+  Notes:
+
+  - Atomic wait and notify allow a thread to block until a variable changes, without
+    any shared mutex; the common case, where nobody is waiting, is handled entirely
+    by the atomic operations of the caller and need not enter the kernel at all.
+
+  - On Linux, this maps directly onto the futex system call.  Only process-private
+    futexes are used, which are a bit cheaper than shared ones.
+
+  - Elsewhere, waiting threads are parked on a condition variable picked from a small
+    table, hashed by address.  The value is checked under the mutex of the bucket, so
+    a notify following a change of the variable can not slip in between the check and
+    the wait.  Since unrelated addresses may share a bucket, notify always broadcasts;
+    waiters must expect spurious wakeups in any case.
+
+  - Notifying an address on which nobody waits, or which was already recycled, is
+    harmless; a thread waiting there will merely observe a spurious wakeup.
+*/
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+#if !defined(__linux__)
+
+// Table of wait buckets
+struct WaitBucket {
+  FXMutex     mutex;
+  FXCondition condition;
+  };
+
+
+// Wait buckets
+static WaitBucket buckets[64];
+
+
+// Pick wait bucket for address
+static inline WaitBucket& bucketOf(volatile FXuint* ptr){
+  return buckets[(((FXuval)ptr)>>4)&63];
+  }
+
+#endif
+
+
+// Wait while value at ptr equals expect
+FXbool atomicWait(volatile FXuint* ptr,FXuint expect,FXTime nsec){
+#if defined(__linux__)
+  if(0<nsec){
+    if(nsec<forever){
+      struct timespec ts;
+      ts.tv_sec=nsec/1000000000;
+      ts.tv_nsec=nsec%1000000000;
+      return syscall(SYS_futex,ptr,FUTEX_WAIT_PRIVATE,expect,&ts,nullptr,0)==0 || errno!=ETIMEDOUT;
+      }
+    syscall(SYS_futex,ptr,FUTEX_WAIT_PRIVATE,expect,nullptr,nullptr,0);
+    return true;
+    }
+  return *ptr!=expect;
+#else
+  WaitBucket& bucket=bucketOf(ptr);
+  FXScopedMutex locker(bucket.mutex);
+  if(*ptr==expect){
+    if(0<nsec){
+      if(nsec<forever){
+        return bucket.condition.wait(bucket.mutex,nsec);
+        }
+      bucket.condition.wait(bucket.mutex);
+      return true;
+      }
+    return false;
+    }
+  return true;
+#endif
+  }
+
+
+// Wake one thread waiting on ptr
+void atomicNotify(volatile FXuint* ptr){
+#if defined(__linux__)
+  syscall(SYS_futex,ptr,FUTEX_WAKE_PRIVATE,1,nullptr,nullptr,0);
+#else
+  WaitBucket& bucket=bucketOf(ptr);
+  FXScopedMutex locker(bucket.mutex);
+  bucket.condition.broadcast();
+#endif
+  }
+
+
+// Wake all threads waiting on ptr
+void atomicNotifyAll(volatile FXuint* ptr){
+#if defined(__linux__)
+  syscall(SYS_futex,ptr,FUTEX_WAKE_PRIVATE,0x7fffffff,nullptr,nullptr,0);
+#else
+  WaitBucket& bucket=bucketOf(ptr);
+  FXScopedMutex locker(bucket.mutex);
+  bucket.condition.broadcast();
+#endif
+  }
+
+}
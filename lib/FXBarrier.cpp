@@ -21,8 +21,8 @@
 #include "xincs.h"
 #include "fxver.h"
 #include "fxdefs.h"
+#include "FXAtomic.h"
 #include "FXMutex.h"
-#include "FXCondition.h"
 #include "FXBarrier.h"
 
 /*
@@ -44,6 +44,11 @@
 
   - Many scenarios are possible, and often necessary.
 
+  - The mutex only protects the count and threshold; threads held back by the barrier
+    don't sleep on a condition variable but in atomicWait() on the generation number,
+    without holding the mutex.  Breaking through the barrier bumps the generation and
+    wakes them all; they don't need to reacquire the mutex on the way out.
+
 */
 
 using namespace FX;
@@ -60,16 +65,18 @@ FXBarrier::FXBarrier(FXuint thr):generation(0),thresh(FXMAX(thr,1)),count(0){
 
 // Wait for all threads to hit the barrier
 FXbool FXBarrier::wait(){
-  FXScopedMutex locker(mutex);
+  mutex.lock();
   FXuint gen=generation;
   if(++count>=thresh){
     count=0;
-    generation++;
-    condition.broadcast();
+    atomicAdd(&generation,1U);
+    mutex.unlock();
+    atomicNotifyAll(&generation);
     return true;
     }
+  mutex.unlock();
   while(gen==generation){
-    condition.wait(mutex);
+    atomicWait(&generation,gen);
     }
   return false;
   }
@@ -81,8 +88,8 @@ FXbool FXBarrier::threshold(FXuint thr){
   thresh=FXMAX(thr,1);
   if(count>=thresh){
     count=0;
-    generation++;
-    condition.broadcast();
+    atomicAdd(&generation,1U);
+    atomicNotifyAll(&generation);
     return true;
     }
   return false;
@@ -94,8 +101,8 @@ FXbool FXBarrier::release(){
   FXScopedMutex locker(mutex);
   if(count){
     count=0;
-    generation++;
-    condition.broadcast();
+    atomicAdd(&generation,1U);
+    atomicNotifyAll(&generation);
     return true;
     }
   return false;
@@ -23,6 +23,9 @@
 #include "fxdefs.h"
 #include "FXAtomic.h"
 #include "FXSemaphore.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
 #include "FXCompletion.h"
 
 /*
@@ -31,29 +34,29 @@
   - Completion allows a single thread to monitor a number of ongoing concurrent
     activities for completion.
 
-  - When an activity is started, the counter is incremented.  If this was the first
-    activity, the monitoring semaphore will be decremented to zero.  Starting
-    subsequent activities will increment the count but leave the semaphore alone.
+  - When an activity is started, the counter is incremented; when an activity is
+    finished, the counter is decremented.  Neither needs to enter the kernel, unless
+    the decrement brings the counter to zero while some thread is waiting.
 
-  - When an activity is finished, the counter is decremented; if this was the last
-    activity, the semaphore will be incremented, causing the thread that called
-    wait to unblock, and subsequently reset the semaphore for next time.
+  - The topmost bit of the counter flags that some thread is, or may be, blocked on
+    the counter.  A waiting thread sets it before blocking in atomicWait() on the
+    counter; the activity bringing the count to zero sees the flag as part of the
+    same atomic decrement, and wakes all waiters.  Since flag and count are in the
+    same word, no wakeup can be lost.
 
-  - A semaphore is set to 1 when no activities are in progress; a call to wait()
-    will immediately succeed in that case; the semaphore is automatically reset to
-    1 after examination by the calling thread.
+  - The flag is cleared again only if the count is still zero; if new activities
+    were started in the meantime, the flag stays set for other waiting threads, at
+    the cost of a possibly unnecessary wakeup later.
 
-  - Note that the first activity being started may have to wait until the calling
-    thread from a previous activity completion check has returned from the wait()
-    call.
-
-  - Don't block in wait() or wait(nsec) if counter was zero already; no need to
-    test semaphore in trywait(), since counter tells all.
+  - Don't block in wait() or wait(nsec) if counter was zero already.
 
   - A completion should NOT go out of scope until counter becomes zero again, since
     other activities are still outstanding.
 */
 
+#define WAITING 0x80000000      // Some thread may be waiting
+#define COUNTER 0x7FFFFFFF      // Count of activities
+
 using namespace FX;
 
 /*******************************************************************************/
@@ -62,37 +65,54 @@ namespace FX {
 
 
 // Initialize completion counter
-FXCompletion::FXCompletion():semaphore(1),counter(0){
+FXCompletion::FXCompletion():counter(0){
   }
 
 
 // Increment counter
 void FXCompletion::increment(FXuint cnt){
-  if(atomicAdd(&counter,cnt)==0 && cnt){semaphore.wait();}
+  atomicAdd(&counter,cnt);
   }
 
 
 // Decrement counter
 void FXCompletion::decrement(FXuint cnt){
-  if(atomicAdd(&counter,0-cnt)==cnt && cnt){semaphore.post();}
+  FXuint old=atomicAdd(&counter,0-cnt);
+  if((old&COUNTER)==cnt && (old&WAITING) && cnt){ atomicNotifyAll(&counter); }
   }
 
 
 // Wait till complete
 void FXCompletion::wait(){
-  if(counter){
-    semaphore.wait();
-    semaphore.post();
+  FXuint c;
+  while((c=counter)&COUNTER){
+    if((c&WAITING) || atomicBoolCas(&counter,c,c|WAITING)){
+      atomicWait(&counter,c|WAITING);
+      }
     }
+  atomicBoolCas(&counter,WAITING,0U);
   }
 
 
 // Wait till complete or timeout; return false if timed out
 FXbool FXCompletion::wait(FXTime nsec){
-  if(counter){
-    if(!semaphore.wait(nsec)) return false;
-    semaphore.post();
+  FXTime deadline=forever;
+  FXTime remaining=nsec;
+  FXuint c;
+  if(0<nsec && nsec<forever){
+    FXTime now=FXThread::steadytime();
+    if(nsec<forever-now) deadline=now+nsec;
+    }
+  while((c=counter)&COUNTER){
+    if(deadline<forever){
+      remaining=deadline-FXThread::steadytime();
+      }
+    if(remaining<=0) return false;
+    if((c&WAITING) || atomicBoolCas(&counter,c,c|WAITING)){
+      atomicWait(&counter,c|WAITING,remaining);
+      }
     }
+  atomicBoolCas(&counter,WAITING,0U);
   return true;
   }
 
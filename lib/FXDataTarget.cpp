@@ -61,6 +61,10 @@
     passes along the message to data target's target; an update message will be a
     no-op, but return 1 so that the sending message will remain sensitized if auto-
     gray is on.
+  - When the application refreshes the entire widget tree only once in a while, the
+    widgets asking a data target for its value subscribe to it; when the value is
+    changed from one widget, the others are then refreshed right away.  Likewise,
+    after changing the value in the program, call FXApp::refreshSubscribers().
 */
 
 using namespace FX;
@@ -83,6 +87,23 @@ FXDEFMAP(FXDataTarget) FXDataTargetMap[]={
 FXIMPLEMENT(FXDataTarget,FXObject,FXDataTargetMap,ARRAYNUMBER(FXDataTargetMap))
 
 
+// Subscribe widget to changes of data target
+static void subscribe(FXObject* sender,FXDataTarget* dt){
+  if(sender && sender->isMemberOf(FXMETACLASS(FXWindow))){
+    FXApp* app=static_cast<FXWindow*>(sender)->getApp();
+    if(0<app->getRefreshInterval()) app->subscribe(static_cast<FXWindow*>(sender),dt);
+    }
+  }
+
+
+// Refresh widgets subscribed to data target
+static void refreshSubscribers(FXObject* sender,FXDataTarget* dt){
+  if(sender && sender->isMemberOf(FXMETACLASS(FXWindow))){
+    static_cast<FXWindow*>(sender)->getApp()->refreshSubscribers(dt);
+    }
+  }
+
+
 // Value changed from widget
 long FXDataTarget::onCmdValue(FXObject* sender,FXSelector sel,void*){
   FXdouble d;
@@ -137,6 +158,7 @@ long FXDataTarget::onCmdValue(FXObject* sender,FXSelector sel,void*){
     default:
       return 0;
     }
+  refreshSubscribers(sender,this);
   if(target){
     target->handle(this,FXSEL(FXSELTYPE(sel),message),data);
     }
@@ -148,6 +170,7 @@ long FXDataTarget::onCmdValue(FXObject* sender,FXSelector sel,void*){
 long FXDataTarget::onUpdValue(FXObject* sender,FXSelector,void*){
   FXdouble d;
   FXint    i;
+  subscribe(sender,this);
   switch(type){
     case DT_VOID:
       break;
@@ -197,7 +220,7 @@ long FXDataTarget::onUpdValue(FXObject* sender,FXSelector,void*){
 
 
 // Value set from message id
-long FXDataTarget::onCmdOption(FXObject*,FXSelector sel,void*){
+long FXDataTarget::onCmdOption(FXObject* sender,FXSelector sel,void*){
   FXint num=((FXint)FXSELID(sel))-ID_OPTION;
   switch(type){
     case DT_VOID:
@@ -238,6 +261,7 @@ long FXDataTarget::onCmdOption(FXObject*,FXSelector sel,void*){
     default:
       return 0;
     }
+  refreshSubscribers(sender,this);
   if(target){
     target->handle(this,FXSEL(FXSELTYPE(sel),message),data);
     }
@@ -249,6 +273,7 @@ long FXDataTarget::onCmdOption(FXObject*,FXSelector sel,void*){
 long FXDataTarget::onUpdOption(FXObject* sender,FXSelector sel,void*){
   FXint num=((FXint)FXSELID(sel))-ID_OPTION;
   FXint i=0;
+  subscribe(sender,this);
   switch(type){
     case DT_VOID:
       break;
@@ -41,6 +41,10 @@
     it must be filtered via overrides of dispatchSignal prior to being processed
     by this implementation of dispatchSignal(); otherwise, a core dump may result.
 
+  - Reads and writes submitted to the dispatcher are tagged with an operation record,
+    which holds the callback; the records of operations in progress are kept in a
+    list, so they can be deleted when the dispatcher exits before they completed.
+
   - Sample usage:
 
     disp->addInterval(TimeoutCallback::create<MyClass,&MyClass::memfunc>(target),dt,ptr);
@@ -102,10 +106,20 @@ struct FXDispatcher::Idle {
   };
 
 
+// Operation callback
+struct FXDispatcher::Operation {
+  CompletionCallback cb;          // Callback
+  Operation         *next;        // Next operation in list
+  Operation         *prev;        // Previous operation in list
+  FXInputHandle      hnd;         // Handle
+  void              *ptr;         // User data
+  };
+
+
 /*******************************************************************************/
 
 // Construct dispatcher object
-FXDispatcher::FXDispatcher():signals(nullptr),timers(nullptr),idles(nullptr),timerrecs(nullptr),idlerecs(nullptr){
+FXDispatcher::FXDispatcher():signals(nullptr),timers(nullptr),idles(nullptr),timerrecs(nullptr),idlerecs(nullptr),operations(nullptr),operationrecs(nullptr){
   }
 
 
@@ -117,6 +131,8 @@ FXbool FXDispatcher::init(){
     idles=nullptr;
     timerrecs=nullptr;
     idlerecs=nullptr;
+    operations=nullptr;
+    operationrecs=nullptr;
     return true;
     }
   return false;
@@ -388,9 +404,82 @@ FXbool FXDispatcher::dispatchHandle(FXInputHandle hnd,FXuint mode,FXuint){
 
 /*******************************************************************************/
 
+// Submit read, tagged with operation record
+FXbool FXDispatcher::submitRead(CompletionCallback cb,FXInputHandle hnd,void* buf,FXival len,FXlong off,void* ptr){
+  if(isInitialized()){
+    Operation *o=operationrecs;
+    if(o){
+      operationrecs=o->next;
+      }
+    else{
+      o=new Operation;
+      }
+    if(FXReactor::submitOperation(OperationRead,hnd,buf,len,off,o)){
+      o->cb=cb;
+      o->hnd=hnd;
+      o->ptr=ptr;
+      o->prev=nullptr;
+      o->next=operations;
+      if(operations) operations->prev=o;
+      operations=o;
+      return true;
+      }
+    o->next=operationrecs;
+    operationrecs=o;
+    }
+  return false;
+  }
+
+
+// Submit write, tagged with operation record
+FXbool FXDispatcher::submitWrite(CompletionCallback cb,FXInputHandle hnd,const void* buf,FXival len,FXlong off,void* ptr){
+  if(isInitialized()){
+    Operation *o=operationrecs;
+    if(o){
+      operationrecs=o->next;
+      }
+    else{
+      o=new Operation;
+      }
+    if(FXReactor::submitOperation(OperationWrite,hnd,const_cast<void*>(buf),len,off,o)){
+      o->cb=cb;
+      o->hnd=hnd;
+      o->ptr=ptr;
+      o->prev=nullptr;
+      o->next=operations;
+      if(operations) operations->prev=o;
+      operations=o;
+      return true;
+      }
+    o->next=operationrecs;
+    operationrecs=o;
+    }
+  return false;
+  }
+
+
+// Dispatch completion callback of read or write
+FXbool FXDispatcher::dispatchCompletion(void* tag,FXival result){
+  Operation *o=static_cast<Operation*>(tag);
+  if(o){
+    CompletionCallback cb=o->cb;
+    FXInputHandle hnd=o->hnd;
+    void* ptr=o->ptr;
+    if(o->prev) o->prev->next=o->next; else operations=o->next;
+    if(o->next) o->next->prev=o->prev;
+    o->next=operationrecs;
+    operationrecs=o;
+    return cb(this,hnd,result,ptr);
+    }
+  return false;
+  }
+
+/*******************************************************************************/
+
 // Exit dispatcher
 FXbool FXDispatcher::exit(){
   if(FXReactor::exit()){
+    Operation *o;
     Idle  *c;
     Timer *t;
     FXival i;
@@ -414,6 +503,14 @@ FXbool FXDispatcher::exit(){
       idlerecs=c->next;
       delete c;
       }
+    while((o=operations)!=nullptr){
+      operations=o->next;
+      delete o;
+      }
+    while((o=operationrecs)!=nullptr){
+      operationrecs=o->next;
+      delete o;
+      }
     for(i=0; i<64; ++i){
       delete signals[i];
       }
@@ -254,6 +254,8 @@ FXbool FXEventDispatcher::dispatch(FXTime blocking,FXuint flags){
     FXuint sig,nxt,ms,mode,ticks;
     FXInputHandle hnd;
     FXRawEvent event,ev;
+    FXival result;
+    void* tag;
 
     // Loop till we got something
     while(1){
@@ -283,6 +285,14 @@ FXbool FXEventDispatcher::dispatch(FXTime blocking,FXuint flags){
           }
         }
 
+      // Check for completed operation
+      if(flags&DispatchCompletions){
+        if(nextCompletion(tag,result)){
+          if(dispatchCompletion(tag,result)) return true; // Completion activity
+          continue;
+          }
+        }
+
       // Handle events
       if(flags&DispatchEvents){
         if(XEventsQueued((Display*)display,QueuedAfterFlush)){
@@ -340,6 +350,9 @@ FXbool FXEventDispatcher::dispatch(FXTime blocking,FXuint flags){
         // Display connection became active
         if(ConnectionNumber((Display*)display)==hnd) continue;
 
+        // Operation became ready
+        if(raisedOperation(hnd)) continue;
+
         // Regular handle became active
         if(dispatchHandle(hnd,mode,flags)) return true; // IO activity
         continue;
@@ -348,6 +361,10 @@ FXbool FXEventDispatcher::dispatch(FXTime blocking,FXuint flags){
       // All handles have been handled...
       FXASSERT(numraised==0);
 
+      // Hand submitted operations to kernel
+      flushOperations();
+      watchRing(flags);
+
       // Select active handles and check signals; don't block
       numwatched=epoll_pwait(internals->handle,internals->events,ARRAYNUMBER(internals->events),0,nullptr);
 
@@ -372,6 +389,9 @@ FXbool FXEventDispatcher::dispatch(FXTime blocking,FXuint flags){
           ms=(FXuint)(interval/milliseconds);
           }
 
+        // Hand operations submitted by idle callback to kernel
+        flushOperations();
+
         // Select active handles and check signals, waiting for timeout or maximum block time
         numwatched=epoll_pwait(internals->handle,internals->events,ARRAYNUMBER(internals->events),ms,nullptr);
 
@@ -0,0 +1,125 @@
+/********************************************************************************
+*                                                                               *
+*                                  F u t u r e                                  *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXElement.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXFuture.h"
+
+/*
+  Notes:
+
+  - The shared state of a promise and its futures is reference counted; it is
+    deleted when the promise and the last future referring to it are gone.
+
+  - The completion counter is incremented when the state is created, and
+    decremented once, when the state is settled; this wakes up waiting threads.
+    A promise which is destroyed without having been fulfilled settles the state
+    as broken, so waiting threads are never left hanging.
+
+  - Storing a value is not atomic, so a promise first claims the state, flipping it
+    from pending to settling, then stores the value, and only then publishes it as
+    ready; of two threads setting a value at the same time, only one gets to store
+    it, and a broken promise can not overtake a value being stored.
+
+  - Waiting for the result lets the calling thread run tasks from the thread pool,
+    the same way FXThreadPool::waitFor() does; thus waiting for a future inside a
+    worker thread will not deadlock the pool, even if the task producing the result
+    is still in the queue.
+*/
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Create pending state
+FXFutureState::FXFutureState(FXThreadPool* pool):threadpool(pool),refs(0),status(Pending){
+  completion.increment();
+  }
+
+
+// Add reference
+void FXFutureState::ref(){
+  atomicAdd(&refs,1);
+  }
+
+
+// Drop reference, deleting the state when it was the last one
+void FXFutureState::unref(){
+  if(atomicAdd(&refs,-1)==1){
+    delete this;
+    }
+  }
+
+
+// Settle state; only the first call has any effect
+FXbool FXFutureState::settle(FXuint s){
+  if(atomicBoolCas(&status,(FXuint)Pending,s)){
+    completion.decrement();
+    return true;
+    }
+  return false;
+  }
+
+
+// Claim pending state for storing result; only the first call succeeds
+FXbool FXFutureState::claim(){
+  return atomicBoolCas(&status,(FXuint)Pending,(FXuint)Settling);
+  }
+
+
+// Publish result stored after claiming the state
+void FXFutureState::publish(){
+  atomicSet(&status,(FXuint)Ready);
+  completion.decrement();
+  }
+
+
+// Wait until settled, helping out the thread pool if possible
+void FXFutureState::wait(){
+  if(!threadpool || !threadpool->waitFor(completion)){
+    completion.wait();
+    }
+  }
+
+
+// Wait until settled or timeout
+FXbool FXFutureState::wait(FXTime nsec){
+  return completion.wait(nsec);
+  }
+
+
+// Destroy state
+FXFutureState::~FXFutureState(){
+  }
+
+}
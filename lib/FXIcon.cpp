@@ -352,7 +352,7 @@ void FXIcon::render(){
     XGCValues values;
     GC gc;
 #ifdef HAVE_XSHM_H
-    XShmSegmentInfo shminfo;
+    XShmSegmentInfo *shminfo=nullptr;
 #endif
 
     FXTRACE((TOPIC_CREATION,"%s::render shape %p\n",getClassName(),this));
@@ -371,16 +371,14 @@ void FXIcon::render(){
       // First try XShm
 #ifdef HAVE_XSHM_H
       if(shmi){
-        xim=XShmCreateImage((Display*)getApp()->getDisplay(),(Visual*)visual->visual,1,ZPixmap,nullptr,&shminfo,width,height);
+        xim=XShmCreateImage((Display*)getApp()->getDisplay(),(Visual*)visual->visual,1,ZPixmap,nullptr,nullptr,width,height);
         if(!xim){ shmi=0; }
         if(shmi){
-          shminfo.shmid=shmget(IPC_PRIVATE,xim->bytes_per_line*xim->height,IPC_CREAT|0777);
-          if(shminfo.shmid==-1){ xim->data=nullptr; XDestroyImage(xim); xim=nullptr; shmi=0; }
+          shminfo=(XShmSegmentInfo*)getApp()->getShmSegment(xim->bytes_per_line*xim->height);
+          if(!shminfo){ XDestroyImage(xim); xim=nullptr; shmi=0; }
           if(shmi){
-            shminfo.shmaddr=xim->data=(char*)shmat(shminfo.shmid,0,0);
-            shminfo.readOnly=false;
-            XShmAttach((Display*)getApp()->getDisplay(),&shminfo);
-            FXTRACE((TOPIC_DETAIL,"Bitmap XSHM attached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
+            xim->obdata=(char*)shminfo;
+            xim->data=shminfo->shmaddr;
             }
           }
         }
@@ -487,7 +485,6 @@ void FXIcon::render(){
 #ifdef HAVE_XSHM_H
       if(shmi){
         XShmPutImage((Display*)getApp()->getDisplay(),etch,gc,xim,0,0,0,0,width,height,False);
-        XSync((Display*)getApp()->getDisplay(),False);
         }
 #endif
       if(!shmi){
@@ -497,12 +494,9 @@ void FXIcon::render(){
       // Clean up
 #ifdef HAVE_XSHM_H
       if(shmi){
-        FXTRACE((TOPIC_DETAIL,"Bitmap XSHM detached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
-        XShmDetach((Display*)getApp()->getDisplay(),&shminfo);
         xim->data=nullptr;
         XDestroyImage(xim);
-        shmdt(shminfo.shmaddr);
-        shmctl(shminfo.shmid,IPC_RMID,0);
+        getApp()->putShmSegment(shminfo);
         }
 #endif
       if(!shmi){
@@ -517,6 +511,12 @@ void FXIcon::render(){
 #endif
 
 
+// Render rectangle of icon; shape and etch need the whole image
+void FXIcon::render(FXint,FXint,FXint,FXint){
+  render();
+  }
+
+
 // Resize pixmap to the specified width and height; the contents become undefined
 void FXIcon::resize(FXint w,FXint h){
   if(w<1) w=1;
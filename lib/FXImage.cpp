@@ -22,10 +22,21 @@
 #include "fxver.h"
 #include "fxdefs.h"
 #include "fxmath.h"
+#include "fxcpuid.h"
 #include "FXElement.h"
 #include "FXMetaClass.h"
 #include "FXHash.h"
 #include "FXMutex.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXTaskGroup.h"
+#include "FXParallel.h"
 #include "FXElement.h"
 #include "FXStream.h"
 #include "FXString.h"
@@ -41,14 +52,20 @@
 #include "FXWindow.h"
 #include "FXDCWindow.h"
 #include "FXApp.h"
+#include "FXPixelBuffer.h"
 #include "FXImage.h"
+#include "fxtruerow.h"
 
 
 /*
   Notes:
   - FXImage::create() renders rgb[a] data into X/GDI resident, device
     dependent pixmap.
-  - Need to be able to re-render subpart of image.
+  - With render(x,y,w,h), part of the image may be re-rendered; the rendering
+    routines take the rectangle, and their dither patterns line up with those
+    of rendering the whole image, so there are no seams.
+  - XSHM segments come from a pool kept by FXApp, so rendering repeatedly does not
+    create, attach, and tear down a shared memory segment each time.
   - We should implement shared pixmaps.
   - If IMAGE_KEEP, repeated rendering is usually desired; should we
     hang on to XImage, and the shared memory segment in that case?
@@ -60,7 +77,15 @@
     No pixel buffer will be allocated if neither IMAGE_OWNED nor pixels
     are passed.
   - When using shared image/pixmaps, if IMAGE_KEEP is set, hang on to pixel buffer.
-  - We need to speed up 16/15 bpp true color.
+  - The manipulations of the client-side pixels, like scaling, rotating, and shearing,
+    are done by FXPixelBuffer, which does not need a display.
+  - When the visual's color tables are linear, i.e. without gamma correction, 32, 24,
+    and dithered 16/15 bpp true color are converted a row at a time using vector
+    instructions, selected at run time; large images are split into bands of rows
+    which are converted in parallel, if the calling thread has a thread pool.
+  - The visual's color tables are checked for being linear only the first time
+    an image is rendered with them; FXVisual keeps the outcome, for each pixel
+    size, until the tables are set up again.
   - We need dither tables with 3bit and 2bit rounding for 5,6,5/5,5,5 modes
   - We need dither tables with 5bit, 6bit rounding for 3,3,2 mode.
   - We need to split true color from direct color, because direct color
@@ -481,7 +506,7 @@ void FXImage::restore(){
     FXuchar gtab[MAX_MAPSIZE];
     FXuchar btab[MAX_MAPSIZE];
 #ifdef HAVE_XSHM_H
-    XShmSegmentInfo shminfo;
+    XShmSegmentInfo *shminfo=nullptr;
 #endif
 
     FXTRACE((TOPIC_CREATION,"%s::restore image %p\n",getClassName(),this));
@@ -513,18 +538,15 @@ void FXImage::restore(){
       // First try XShm
 #ifdef HAVE_XSHM_H
       if(shmi){
-        xim=XShmCreateImage(DISPLAY(getApp()),vis,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,nullptr,&shminfo,width,height);
+        xim=XShmCreateImage(DISPLAY(getApp()),vis,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,nullptr,nullptr,width,height);
         if(!xim){ shmi=0; }
         if(shmi){
-          shminfo.shmid=shmget(IPC_PRIVATE,xim->bytes_per_line*xim->height,IPC_CREAT|0777);
-          if(shminfo.shmid==-1){ xim->data=nullptr; XDestroyImage(xim); xim=nullptr; shmi=0; }
+          shminfo=(XShmSegmentInfo*)getApp()->getShmSegment(xim->bytes_per_line*xim->height);
+          if(!shminfo){ XDestroyImage(xim); xim=nullptr; shmi=0; }
           if(shmi){
-            shminfo.shmaddr=xim->data=(char*)shmat(shminfo.shmid,0,0);
-            shminfo.readOnly=false;
-            XShmAttach(DISPLAY(getApp()),&shminfo);
-            FXTRACE((TOPIC_DETAIL,"RGBPixmap XSHM attached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
+            xim->obdata=(char*)shminfo;
+            xim->data=shminfo->shmaddr;
             XShmGetImage(DISPLAY(getApp()),xid,xim,0,0,AllPlanes);
-            XSync(DISPLAY(getApp()),False);
             }
           }
         }
@@ -638,11 +660,9 @@ void FXImage::restore(){
       // Destroy image
 #ifdef HAVE_XSHM_H
       if(shmi){
-        FXTRACE((TOPIC_DETAIL,"RGBPixmap XSHM detached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
-        XShmDetach(DISPLAY(getApp()),&shminfo);
+        xim->data=nullptr;
         XDestroyImage(xim);
-        shmdt(shminfo.shmaddr);
-        shmctl(shminfo.shmid,IPC_RMID,0);
+        getApp()->putShmSegment(shminfo);
         }
 #endif
 
@@ -728,12 +748,227 @@ void FXImage::render(){
   }
 
 
+// Render rectangle of pixels into pixmap
+void FXImage::render(FXint x,FXint y,FXint w,FXint h){
+  if(xid){
+    FXint bytes_per_line,skip,hh,ww;
+    FXuchar *src,*dst;
+    BITMAPINFO bmi;
+    FXuchar *pixels;
+    HBITMAP hold;
+    HDC hdcmem;
+
+    FXTRACE((TOPIC_CREATION,"%s::render %p %d,%d %dx%d\n",getClassName(),this,x,y,w,h));
+
+    // Clip to image
+    if(x<0){ w+=x; x=0; }
+    if(y<0){ h+=y; y=0; }
+    if(x+w>width){ w=width-x; }
+    if(y+h>height){ h=height-y; }
+
+    // Fill with pixels if there is data
+    if(data && 0<w && 0<h){
+
+      // Set up the bitmap info
+      bmi.bmiHeader.biSize=sizeof(BITMAPINFOHEADER);
+      bmi.bmiHeader.biWidth=w;
+      bmi.bmiHeader.biHeight=h;
+      bmi.bmiHeader.biPlanes=1;
+      bmi.bmiHeader.biBitCount=24;
+      bmi.bmiHeader.biCompression=BI_RGB;
+      bmi.bmiHeader.biSizeImage=0;
+      bmi.bmiHeader.biXPelsPerMeter=0;
+      bmi.bmiHeader.biYPelsPerMeter=0;
+      bmi.bmiHeader.biClrUsed=0;
+      bmi.bmiHeader.biClrImportant=0;
+
+      // DIB format pads to multiples of 4 bytes...
+      bytes_per_line=(w*3+3)&~3;
+      pixels=(FXuchar*)VirtualAlloc(0,bytes_per_line*h,MEM_COMMIT,PAGE_READWRITE);
+      if(!pixels){ throw FXMemoryException("unable to render image"); }
+      skip=-bytes_per_line-w*3;
+      src=(FXuchar*)(data+y*width+x);
+      dst=pixels+h*bytes_per_line+w*3;
+      hh=h;
+      do{
+        dst+=skip;
+        ww=w;
+        do{
+          dst[0]=src[0];
+          dst[1]=src[1];
+          dst[2]=src[2];
+          src+=4;
+          dst+=3;
+          }
+        while(--ww);
+        src+=(width-w)<<2;
+        }
+      while(--hh);
+
+      // Bitmap selected into memory DC, so just the rectangle can be set
+      hdcmem=::CreateCompatibleDC(nullptr);
+      hold=(HBITMAP)::SelectObject(hdcmem,(HBITMAP)xid);
+      if(!SetDIBitsToDevice(hdcmem,x,y,w,h,0,0,0,h,pixels,&bmi,DIB_RGB_COLORS)){
+        throw FXImageException("unable to render image");
+        }
+      ::SelectObject(hdcmem,hold);
+      GdiFlush();
+      VirtualFree(pixels,0,MEM_RELEASE);
+      ::DeleteDC(hdcmem);
+      }
+    }
+  }
+
+
 #else                   // X11
 
 
+// Smallest rectangle converted with vector instructions
+const FXint MINVECTORWIDTH=16;
+const FXint MINVECTORPIXELS=4096;
+
+// Pixels per band of rows converted in parallel
+const FXint BANDPIXELS=65536;
+
+
+// Ordered dither matrix, same as that of the visual
+static const FXushort dithermatrix[16]={
+   0*16,  8*16,  2*16, 10*16,
+  12*16,  4*16, 14*16,  6*16,
+   3*16, 11*16,  1*16,  9*16,
+  15*16,  7*16, 13*16,  5*16,
+  };
+
+
+// Which of the visual's color tables have been checked, for each pixel size; the
+// bit above each says they were found to be linear
+const FXuchar CHECKED24=1;
+const FXuchar CHECKED32=4;
+const FXuchar CHECKED16=16;
+
+
+// Check that channel table maps linearly onto byte of pixel, i.e. tab[i]=alpha|(i<<shift);
+// the entries are only compared if check is set
+static FXbool linearchannel(const FXPixel tab[],FXPixel alpha,FXuint top,FXuint& shift,FXbool check){
+  FXPixel bits=tab[255]&~alpha;
+  if(bits){
+    shift=findshift(bits);
+    if((bits>>shift)==255 && !(shift&7) && shift<=top){
+      if(check){
+        for(FXuint i=0; i<256; ++i){
+          if(tab[i]!=(alpha|((FXPixel)i<<shift))) return false;
+          }
+        }
+      return true;
+      }
+    }
+  return false;
+  }
+
+
+// Check that channel tables dither linearly onto bits of pixel, i.e. tab[d][i]=alpha|(((max*i+dither[d])/255)<<shift);
+// the entries are only compared if check is set
+static FXbool ditheredchannel(const FXPixel tab[][256],FXPixel alpha,FXuint& shift,FXuint& max,FXbool check){
+  FXPixel bits=tab[0][255]&~alpha;
+  if(bits && bits<=0xFFFF){
+    shift=findshift(bits);
+    max=(FXuint)(bits>>shift);
+    if(!(max&(max+1)) && max<=63){
+      if(check){
+        for(FXuint d=0; d<16; ++d){
+          for(FXuint i=0; i<256; ++i){
+            if(tab[d][i]!=(alpha|((FXPixel)((max*i+dithermatrix[d])/255)<<shift))) return false;
+            }
+          }
+        }
+      return true;
+      }
+    }
+  return false;
+  }
+
+
+// Find layout of 24 or 32 bpp pixels, with top being the shift of the last byte; the
+// tables are compared only the first time, and the outcome is kept in linear
+static FXbool truelayout(TrueLayout& lay,const FXPixel rtab[],const FXPixel gtab[],const FXPixel btab[],FXuint top,FXbool flip,FXuchar& linear,FXuchar checked){
+  FXbool check=!(linear&checked);
+  FXPixel alpha=rtab[0];
+  if(check || (linear&(checked<<1))){
+    if(!FOX_BIGENDIAN && gtab[0]==alpha && btab[0]==alpha){
+      if(linearchannel(rtab,alpha,top,lay.rs,check) && linearchannel(gtab,alpha,top,lay.gs,check) && linearchannel(btab,alpha,top,lay.bs,check)){
+        lay.alpha=0;
+        for(FXuint k=0; k<=top; k+=8){
+          lay.alpha|=(FXuint)((alpha>>k)&255)<<(flip?top-k:k);
+          }
+        if(flip){
+          lay.rs=top-lay.rs;
+          lay.gs=top-lay.gs;
+          lay.bs=top-lay.bs;
+          }
+        lay.rm=lay.gm=lay.bm=255;
+        lay.swap=false;
+        lay.dy=0;
+        linear|=checked|(checked<<1);
+        return true;
+        }
+      }
+    }
+  linear|=checked;
+  return false;
+  }
+
+
+// Find layout of dithered 16 bpp pixels; the tables are compared only the first
+// time, and the outcome is kept in linear
+static FXbool ditherlayout(TrueLayout& lay,const FXPixel rtab[][256],const FXPixel gtab[][256],const FXPixel btab[][256],FXbool flip,FXuchar& linear){
+  FXbool check=!(linear&CHECKED16);
+  FXPixel alpha=rtab[0][0];
+  if(check || (linear&(CHECKED16<<1))){
+    if(!FOX_BIGENDIAN && gtab[0][0]==alpha && btab[0][0]==alpha){
+      if(ditheredchannel(rtab,alpha,lay.rs,lay.rm,check) && ditheredchannel(gtab,alpha,lay.gs,lay.gm,check) && ditheredchannel(btab,alpha,lay.bs,lay.bm,check)){
+        lay.alpha=(FXuint)(alpha&0xFFFF);
+        lay.swap=flip;
+        linear|=CHECKED16|(CHECKED16<<1);
+        return true;
+        }
+      }
+    }
+  linear|=CHECKED16;
+  return false;
+  }
+
+
+// Select fastest conversion of rows to bpp pixels
+static TrueRowFunc truerowfunc(FXuint bpp){
+  TrueRowFunc funcs[4];
+  return funcs[fxtruerowfuncs(funcs,bpp)-1];
+  }
+
+
+// Convert rectangle of pixels row by row; large rectangles are split into
+// bands of rows, converted in parallel if the calling thread has a thread pool
+static void truerows(TrueRowFunc func,const TrueLayout& lay,FXuchar* pix,FXint bpl,const FXuchar* img,FXint stride,FXint rw,FXint rh){
+  FXThreadPool* pool=FXThreadPool::instance();
+  FXint by=FXMAX(BANDPIXELS/rw,1);
+  if(pool && by<rh){
+    FXParallelFor(pool,0,rh,by,[&](FXint j){
+      for(FXint e=FXMIN(j+by,rh); j<e; ++j){
+        func(pix+(FXival)j*bpl,img+(FXival)j*stride,rw,lay.dither[(lay.dy-j)&3],lay);
+        }
+      });
+    return;
+    }
+  for(FXint j=0; j<rh; ++j){
+    func(pix+(FXival)j*bpl,img+(FXival)j*stride,rw,lay.dither[(lay.dy-j)&3],lay);
+    }
+  }
+
+
 // True generic mode
-void FXImage::render_true_N_fast(void *xim,FXuchar *img){
+void FXImage::render_true_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"True MSB/LSB N bpp render nearest\n"));
   y=0;
   do{
@@ -742,41 +977,55 @@ void FXImage::render_true_N_fast(void *xim,FXuchar *img){
       XPutPixel(((XImage*)xim),x,y,visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // True generic mode
-void FXImage::render_true_N_dither(void *xim,FXuchar *img){
+void FXImage::render_true_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y,d;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"True MSB/LSB N bpp render dither\n"));
   y=0;
   do{
     x=0;
     do{
-      d=((y&3)<<2)|(x&3);
+      d=(((y+ry)&3)<<2)|((x+rx)&3);
       XPutPixel(((XImage*)xim),x,y,visual->rpix[d][img[2]] | visual->gpix[d][img[1]] | visual->bpix[d][img[0]]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // True 24 bit color
-void FXImage::render_true_24(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-(width*3);
+void FXImage::render_true_24(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-(rw*3);
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXPixel val;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
+  TrueLayout lay;
+
+  // Linear color tables
+  if(MINVECTORWIDTH<=rw && MINVECTORPIXELS<=rw*rh && truelayout(lay,visual->rpix[1],visual->gpix[1],visual->bpix[1],16,((XImage*)xim)->byte_order==MSBFirst,visual->linear,CHECKED24)){
+    FXTRACE((TOPIC_DETAIL,"True MSB/LSB 24bpp render linear\n"));
+    truerows(truerowfunc(24),lay,pix,((XImage*)xim)->bytes_per_line,img,width<<2,rw,rh);
+    return;
+    }
   if(((XImage*)xim)->byte_order==MSBFirst){    // MSB
     FXTRACE((TOPIC_DETAIL,"True MSB 24bpp render\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)(val>>16);
@@ -787,14 +1036,15 @@ void FXImage::render_true_24(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
   else{                             // LSB
     FXTRACE((TOPIC_DETAIL,"True LSB 24bpp render\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)val;
@@ -805,6 +1055,7 @@ void FXImage::render_true_24(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -812,18 +1063,28 @@ void FXImage::render_true_24(void *xim,FXuchar *img){
 
 
 // True 32 bit color
-void FXImage::render_true_32(void *xim,FXuchar *img){
+void FXImage::render_true_32(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
-  FXuint jmp=((XImage*)xim)->bytes_per_line-(width<<2);
+  FXuint jmp=((XImage*)xim)->bytes_per_line-(rw<<2);
   FXPixel val;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
+  TrueLayout lay;
+
+  // Linear color tables
+  if(MINVECTORWIDTH<=rw && MINVECTORPIXELS<=rw*rh && truelayout(lay,visual->rpix[1],visual->gpix[1],visual->bpix[1],24,((XImage*)xim)->byte_order==MSBFirst,visual->linear,CHECKED32)){
+    FXTRACE((TOPIC_DETAIL,"True MSB/LSB 32bpp render linear\n"));
+    truerows(truerowfunc(32),lay,pix,((XImage*)xim)->bytes_per_line,img,width<<2,rw,rh);
+    return;
+    }
 
   // Byte order matches
   if(((XImage*)xim)->byte_order == FOX_BIGENDIAN){
     FXTRACE((TOPIC_DETAIL,"True MSB/LSB 32bpp render\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         *((FXuint*)pix)=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         img+=4;
@@ -831,6 +1092,7 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -838,9 +1100,9 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
   // MSB Byte order
   else if(((XImage*)xim)->byte_order==MSBFirst){
     FXTRACE((TOPIC_DETAIL,"True MSB 32bpp render\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)(val>>24);
@@ -852,6 +1114,7 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -859,9 +1122,9 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
   // LSB Byte order
   else{
     FXTRACE((TOPIC_DETAIL,"True LSB 32bpp render\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)val;
@@ -873,6 +1136,7 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -880,18 +1144,20 @@ void FXImage::render_true_32(void *xim,FXuchar *img){
 
 
 // True 16 bit color
-void FXImage::render_true_16_fast(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-(width<<1);
+void FXImage::render_true_16_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-(rw<<1);
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXPixel val;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
 
   // Byte order matches
   if(((XImage*)xim)->byte_order == FOX_BIGENDIAN){
     FXTRACE((TOPIC_DETAIL,"True MSB/LSB 16bpp 5,6,5/5,5,5 render nearest\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         *((FXushort*)pix)=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         img+=4;
@@ -899,6 +1165,7 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -906,9 +1173,9 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
   // MSB Byte order
   else if(((XImage*)xim)->byte_order==MSBFirst){
     FXTRACE((TOPIC_DETAIL,"True MSB 16bpp 5,6,5/5,5,5 render nearest\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)(val>>8);
@@ -918,6 +1185,7 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -925,9 +1193,9 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
   // LSB Byte order
   else{
     FXTRACE((TOPIC_DETAIL,"True LSB 16bpp 5,6,5/5,5,5 render nearest\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
         val=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
         pix[0]=(FXuchar)val;
@@ -937,6 +1205,7 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -944,26 +1213,44 @@ void FXImage::render_true_16_fast(void *xim,FXuchar *img){
 
 
 // True 16 bit color, dithered
-void FXImage::render_true_16_dither(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-(width<<1);
+void FXImage::render_true_16_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-(rw<<1);
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXPixel val;
   FXint w,h,d;
+  FXuint skip=(width-rw)<<2;
+  FXint dx=width-rx-rw,dy=height-ry-rh;
+  img+=(ry*width+rx)<<2;
+  TrueLayout lay;
+
+  // Linear color tables; dither rows and columns count down from the bottom-right
+  if(MINVECTORWIDTH<=rw && MINVECTORPIXELS<=rw*rh && ditherlayout(lay,visual->rpix,visual->gpix,visual->bpix,((XImage*)xim)->byte_order==MSBFirst,visual->linear)){
+    FXTRACE((TOPIC_DETAIL,"True MSB/LSB 16bpp 5,6,5/5,5,5 render linear dither\n"));
+    for(h=0; h<4; ++h){
+      for(w=0; w<16; ++w){
+        lay.dither[h][w]=dithermatrix[(h<<2)|((width-1-rx-w)&3)];
+        }
+      }
+    lay.dy=height-1-ry;
+    truerows(truerowfunc(16),lay,pix,((XImage*)xim)->bytes_per_line,img,width<<2,rw,rh);
+    return;
+    }
 
   // Byte order matches
   if(((XImage*)xim)->byte_order == FOX_BIGENDIAN){
     FXTRACE((TOPIC_DETAIL,"True MSB/LSB 16bpp 5,6,5/5,5,5 render dither\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
-        d=((h&3)<<2)|(w&3);
+        d=(((h+dy)&3)<<2)|((w+dx)&3);
         *((FXushort*)pix)=visual->rpix[d][img[2]] | visual->gpix[d][img[1]] | visual->bpix[d][img[0]];
         img+=4;
         pix+=2;
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -971,11 +1258,11 @@ void FXImage::render_true_16_dither(void *xim,FXuchar *img){
   // MSB Byte order
   else if(((XImage*)xim)->byte_order==MSBFirst){
     FXTRACE((TOPIC_DETAIL,"True MSB 16bpp 5,6,5/5,5,5 render dither\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
-        d=((h&3)<<2)|(w&3);
+        d=(((h+dy)&3)<<2)|((w+dx)&3);
         val=visual->rpix[d][img[2]] | visual->gpix[d][img[1]] | visual->bpix[d][img[0]];
         pix[0]=(FXuchar)(val>>8);
         pix[1]=(FXuchar)val;
@@ -984,6 +1271,7 @@ void FXImage::render_true_16_dither(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -991,11 +1279,11 @@ void FXImage::render_true_16_dither(void *xim,FXuchar *img){
   // LSB Byte order
   else{
     FXTRACE((TOPIC_DETAIL,"True LSB 16bpp 5,6,5/5,5,5 render dither\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       do{
-        d=((h&3)<<2)|(w&3);
+        d=(((h+dy)&3)<<2)|((w+dx)&3);
         val=visual->rpix[d][img[2]] | visual->gpix[d][img[1]] | visual->bpix[d][img[0]];
         pix[0]=(FXuchar)val;
         pix[1]=(FXuchar)(val>>8);
@@ -1004,6 +1292,7 @@ void FXImage::render_true_16_dither(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -1011,14 +1300,16 @@ void FXImage::render_true_16_dither(void *xim,FXuchar *img){
 
 
 // True 8 bit color
-void FXImage::render_true_8_fast(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+void FXImage::render_true_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"True MSB/LSB 8bpp render nearest\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
       *pix=visual->rpix[1][img[2]] | visual->gpix[1][img[1]] | visual->bpix[1][img[0]];
       img+=4;
@@ -1026,44 +1317,51 @@ void FXImage::render_true_8_fast(void *xim,FXuchar *img){
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // True 8 bit color, dithered
-void FXImage::render_true_8_dither(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+void FXImage::render_true_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXint w,h,d;
+  FXuint skip=(width-rw)<<2;
+  FXint dx=width-rx-rw,dy=height-ry-rh;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"True MSB/LSB 8bpp render dither\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
-      d=((h&3)<<2)|(w&3);
+      d=(((h+dy)&3)<<2)|((w+dx)&3);
       *pix=visual->rpix[d][img[2]] | visual->gpix[d][img[1]] | visual->bpix[d][img[0]];
       img+=4;
       pix++;
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // Render 4 bit index color mode
-void FXImage::render_index_4_fast(void *xim,FXuchar *img){
+void FXImage::render_index_4_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuint val,half;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   if(((XImage*)xim)->byte_order==MSBFirst){    // MSB
     FXTRACE((TOPIC_DETAIL,"Index MSB 4bpp render nearest\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       half=0;
       do{
         val=visual->lut[visual->rpix[1][img[2]]+visual->gpix[1][img[1]]+visual->bpix[1][img[0]]];
@@ -1074,14 +1372,15 @@ void FXImage::render_index_4_fast(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
   else{                               // LSB
     FXTRACE((TOPIC_DETAIL,"Index LSB 4bpp render nearest\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       half=0;
       do{
         val=visual->lut[visual->rpix[1][img[2]]+visual->gpix[1][img[1]]+visual->bpix[1][img[0]]];
@@ -1092,6 +1391,7 @@ void FXImage::render_index_4_fast(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -1099,19 +1399,22 @@ void FXImage::render_index_4_fast(void *xim,FXuchar *img){
 
 
 // Render 4 bit index color mode
-void FXImage::render_index_4_dither(void *xim,FXuchar *img){
+void FXImage::render_index_4_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuint val,half,d;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  FXint dx=width-rx-rw,dy=height-ry-rh;
+  img+=(ry*width+rx)<<2;
   if(((XImage*)xim)->byte_order==MSBFirst){    // MSB
     FXTRACE((TOPIC_DETAIL,"Index MSB 4bpp render dither\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       half=0;
       do{
-        d=((h&3)<<2)|(w&3);
+        d=(((h+dy)&3)<<2)|((w+dx)&3);
         val=visual->lut[visual->rpix[d][img[2]]+visual->gpix[d][img[1]]+visual->bpix[d][img[0]]];
         if(half) *pix++|=val;
         else *pix=val<<4;
@@ -1120,17 +1423,18 @@ void FXImage::render_index_4_dither(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
   else{                               // LSB
     FXTRACE((TOPIC_DETAIL,"Index LSB 4bpp render dither\n"));
-    h=height-1;
+    h=rh-1;
     do{
-      w=width-1;
+      w=rw-1;
       half=0;
       do{
-        d=((h&3)<<2)|(w&3);
+        d=(((h+dy)&3)<<2)|((w+dx)&3);
         val=visual->lut[visual->rpix[d][img[2]]+visual->gpix[d][img[1]]+visual->bpix[d][img[0]]];
         if(half) *pix++|=val<<4;
         else *pix=val;
@@ -1139,6 +1443,7 @@ void FXImage::render_index_4_dither(void *xim,FXuchar *img){
         }
       while(--w>=0);
       pix+=jmp;
+      img+=skip;
       }
     while(--h>=0);
     }
@@ -1146,14 +1451,16 @@ void FXImage::render_index_4_dither(void *xim,FXuchar *img){
 
 
 // Render 8 bit index color mode
-void FXImage::render_index_8_fast(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+void FXImage::render_index_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Index MSB/LSB 8bpp render nearest\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
       *pix=visual->lut[visual->rpix[1][img[2]]+visual->gpix[1][img[1]]+visual->bpix[1][img[0]]];
       img+=4;
@@ -1161,36 +1468,43 @@ void FXImage::render_index_8_fast(void *xim,FXuchar *img){
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // Render 8 bit index color mode
-void FXImage::render_index_8_dither(void *xim,FXuchar *img){
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+void FXImage::render_index_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
   FXint w,h,d;
+  FXuint skip=(width-rw)<<2;
+  FXint dx=width-rx-rw,dy=height-ry-rh;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Index MSB/LSB 8bpp render dither\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
-      d=((h&3)<<2)|(w&3);
+      d=(((h+dy)&3)<<2)|((w+dx)&3);
       *pix=visual->lut[visual->rpix[d][img[2]]+visual->gpix[d][img[1]]+visual->bpix[d][img[0]]];
       img+=4;
       pix++;
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // Render generic N bit index color mode
-void FXImage::render_index_N_fast(void *xim,FXuchar *img){
+void FXImage::render_index_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Index MSB/LSB N bpp render nearest\n"));
   y=0;
   do{
@@ -1199,39 +1513,45 @@ void FXImage::render_index_N_fast(void *xim,FXuchar *img){
       XPutPixel(((XImage*)xim),x,y,visual->lut[visual->rpix[1][img[2]]+visual->gpix[1][img[1]]+visual->bpix[1][img[0]]]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // Render generic N bit index color mode
-void FXImage::render_index_N_dither(void *xim,FXuchar *img){
+void FXImage::render_index_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y,d;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Index MSB/LSB N bpp render dither\n"));
   y=0;
   do{
     x=0;
     do{
-      d=((y&3)<<2)|(x&3);
+      d=(((y+ry)&3)<<2)|((x+rx)&3);
       XPutPixel(((XImage*)xim),x,y,visual->lut[visual->rpix[d][img[2]]+visual->gpix[d][img[1]]+visual->bpix[d][img[0]]]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // Render 8 bit gray mode
-void FXImage::render_gray_8_fast(void *xim,FXuchar *img){
+void FXImage::render_gray_8_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Gray MSB/LSB 8bpp render nearest\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
       *pix=visual->gpix[1][(77*img[2]+151*img[1]+29*img[0])>>8];
       img+=4;
@@ -1239,35 +1559,42 @@ void FXImage::render_gray_8_fast(void *xim,FXuchar *img){
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // Render 8 bit gray mode
-void FXImage::render_gray_8_dither(void *xim,FXuchar *img){
+void FXImage::render_gray_8_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXuchar *pix=(FXuchar*)((XImage*)xim)->data;
-  FXuint jmp=((XImage*)xim)->bytes_per_line-width;
+  FXuint jmp=((XImage*)xim)->bytes_per_line-rw;
   FXint w,h;
+  FXuint skip=(width-rw)<<2;
+  FXint dx=width-rx-rw,dy=height-ry-rh;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Gray MSB/LSB 8bpp render dither\n"));
-  h=height-1;
+  h=rh-1;
   do{
-    w=width-1;
+    w=rw-1;
     do{
-      *pix=visual->gpix[((h&3)<<2)|(w&3)][(77*img[2]+151*img[1]+29*img[0])>>8];
+      *pix=visual->gpix[(((h+dy)&3)<<2)|((w+dx)&3)][(77*img[2]+151*img[1]+29*img[0])>>8];
       img+=4;
       pix++;
       }
     while(--w>=0);
     pix+=jmp;
+    img+=skip;
     }
   while(--h>=0);
   }
 
 
 // Render generic N bit gray mode
-void FXImage::render_gray_N_fast(void *xim,FXuchar *img){
+void FXImage::render_gray_N_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Gray MSB/LSB N bpp render nearest\n"));
   y=0;
   do{
@@ -1276,32 +1603,38 @@ void FXImage::render_gray_N_fast(void *xim,FXuchar *img){
       XPutPixel(((XImage*)xim),x,y,visual->gpix[1][(77*img[2]+151*img[1]+29*img[0])>>8]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // Render generic N bit gray mode
-void FXImage::render_gray_N_dither(void *xim,FXuchar *img){
+void FXImage::render_gray_N_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Gray MSB/LSB N bpp render dither\n"));
   y=0;
   do{
     x=0;
     do{
-      XPutPixel(((XImage*)xim),x,y,visual->gpix[((y&3)<<2)|(x&3)][(77*img[2]+151*img[1]+29*img[0])>>8]);
+      XPutPixel(((XImage*)xim),x,y,visual->gpix[(((y+ry)&3)<<2)|((x+rx)&3)][(77*img[2]+151*img[1]+29*img[0])>>8]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // Render monochrome mode
-void FXImage::render_mono_1_fast(void *xim,FXuchar *img){
+void FXImage::render_mono_1_fast(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Monochrome MSB/LSB 1bpp render nearest\n"));
   y=0;
   do{
@@ -1310,44 +1643,54 @@ void FXImage::render_mono_1_fast(void *xim,FXuchar *img){
       XPutPixel(((XImage*)xim),x,y,visual->gpix[1][(77*img[2]+151*img[1]+29*img[0])>>8]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
 // Render monochrome mode
-void FXImage::render_mono_1_dither(void *xim,FXuchar *img){
+void FXImage::render_mono_1_dither(void *xim,FXuchar *img,FXint rx,FXint ry,FXint rw,FXint rh){
   FXint x,y;
+  FXuint skip=(width-rw)<<2;
+  img+=(ry*width+rx)<<2;
   FXTRACE((TOPIC_DETAIL,"Monochrome MSB/LSB 1bpp render dither\n"));
   y=0;
   do{
     x=0;
     do{
-      XPutPixel(((XImage*)xim),x,y,visual->gpix[((y&3)<<2)|(x&3)][(77*img[2]+151*img[1]+29*img[0])>>8]);
+      XPutPixel(((XImage*)xim),x,y,visual->gpix[(((y+ry)&3)<<2)|((x+rx)&3)][(77*img[2]+151*img[1]+29*img[0])>>8]);
       img+=4;
       }
-    while(++x<width);
+    while(++x<rw);
+    img+=skip;
     }
-  while(++y<height);
+  while(++y<rh);
   }
 
 
-// Render into pixmap
-void FXImage::render(){
+// Render rectangle of pixels into pixmap
+void FXImage::render(FXint x,FXint y,FXint w,FXint h){
   if(xid){
     FXbool shmi=false;
     XImage *xim=nullptr;
     XGCValues values;
     GC gc;
 #ifdef HAVE_XSHM_H
-    XShmSegmentInfo shminfo;
+    XShmSegmentInfo *shminfo=nullptr;
 #endif
 
-    FXTRACE((TOPIC_CREATION,"%s::render image %p\n",getClassName(),this));
+    FXTRACE((TOPIC_CREATION,"%s::render image %p %d,%d %dx%d\n",getClassName(),this,x,y,w,h));
+
+    // Clip to image
+    if(x<0){ w+=x; x=0; }
+    if(y<0){ h+=y; y=0; }
+    if(x+w>width){ w=width-x; }
+    if(y+h>height){ h=height-y; }
 
     // Fill with pixels if there is data
-    if(data && 0<width && 0<height){
+    if(data && 0<w && 0<h){
 
       // Make GC
       values.foreground=BlackPixel(DISPLAY(getApp()),DefaultScreen(DISPLAY(getApp())));
@@ -1362,16 +1705,14 @@ void FXImage::render(){
       // First try XShm
 #ifdef HAVE_XSHM_H
       if(shmi){
-        xim=XShmCreateImage(DISPLAY(getApp()),(Visual*)visual->visual,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,nullptr,&shminfo,width,height);
+        xim=XShmCreateImage(DISPLAY(getApp()),(Visual*)visual->visual,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,nullptr,nullptr,w,h);
         if(!xim){ shmi=0; }
         if(shmi){
-          shminfo.shmid=shmget(IPC_PRIVATE,xim->bytes_per_line*xim->height,IPC_CREAT|0777);
-          if(shminfo.shmid==-1){ xim->data=nullptr; XDestroyImage(xim); xim=nullptr; shmi=0; }
+          shminfo=(XShmSegmentInfo*)getApp()->getShmSegment(xim->bytes_per_line*xim->height);
+          if(!shminfo){ XDestroyImage(xim); xim=nullptr; shmi=0; }
           if(shmi){
-            shminfo.shmaddr=xim->data=(char*)shmat(shminfo.shmid,0,0);
-            shminfo.readOnly=false;
-            XShmAttach(DISPLAY(getApp()),&shminfo);
-            FXTRACE((TOPIC_DETAIL,"RGBPixmap XSHM attached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
+            xim->obdata=(char*)shminfo;
+            xim->data=shminfo->shmaddr;
             }
           }
         }
@@ -1379,11 +1720,11 @@ void FXImage::render(){
 
       // Try the old fashioned way
       if(!shmi){
-        xim=XCreateImage(DISPLAY(getApp()),(Visual*)visual->visual,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,0,nullptr,width,height,32,0);
+        xim=XCreateImage(DISPLAY(getApp()),(Visual*)visual->visual,visual->depth,(visual->depth==1)?XYPixmap:ZPixmap,0,nullptr,w,h,32,0);
         if(!xim){ throw FXImageException("unable to render image"); }
 
         // Try create temp pixel store
-        if(!allocElms(xim->data,xim->bytes_per_line*height)){ throw FXMemoryException("unable to render image"); }
+        if(!allocElms(xim->data,xim->bytes_per_line*h)){ throw FXMemoryException("unable to render image"); }
         }
 
       // Should have succeeded
@@ -1406,29 +1747,29 @@ void FXImage::render(){
         case FXVisual::Color:
           switch(xim->bits_per_pixel){
             case 32:
-              render_true_32(xim,(FXuchar*)data);
+              render_true_32(xim,(FXuchar*)data,x,y,w,h);
               break;
             case 24:
-              render_true_24(xim,(FXuchar*)data);
+              render_true_24(xim,(FXuchar*)data,x,y,w,h);
               break;
             case 15:
             case 16:
               if(options&IMAGE_NEAREST)
-                render_true_16_fast(xim,(FXuchar*)data);
+                render_true_16_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_true_16_dither(xim,(FXuchar*)data);
+                render_true_16_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             case 8:
               if(options&IMAGE_NEAREST)
-                render_true_8_fast(xim,(FXuchar*)data);
+                render_true_8_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_true_8_dither(xim,(FXuchar*)data);
+                render_true_8_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             default:
               if(options&IMAGE_NEAREST)
-                render_true_N_fast(xim,(FXuchar*)data);
+                render_true_N_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_true_N_dither(xim,(FXuchar*)data);
+                render_true_N_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             }
           break;
@@ -1436,21 +1777,21 @@ void FXImage::render(){
           switch(xim->bits_per_pixel){
             case 1:
               if(options&IMAGE_NEAREST)
-                render_mono_1_fast(xim,(FXuchar*)data);
+                render_mono_1_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_mono_1_dither(xim,(FXuchar*)data);
+                render_mono_1_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             case 8:
               if(options&IMAGE_NEAREST)
-                render_gray_8_fast(xim,(FXuchar*)data);
+                render_gray_8_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_gray_8_dither(xim,(FXuchar*)data);
+                render_gray_8_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             default:
               if(options&IMAGE_NEAREST)
-                render_gray_N_fast(xim,(FXuchar*)data);
+                render_gray_N_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_gray_N_dither(xim,(FXuchar*)data);
+                render_gray_N_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             }
           break;
@@ -1458,48 +1799,44 @@ void FXImage::render(){
           switch(xim->bits_per_pixel){
             case 4:
               if(options&IMAGE_NEAREST)
-                render_index_4_fast(xim,(FXuchar*)data);
+                render_index_4_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_index_4_dither(xim,(FXuchar*)data);
+                render_index_4_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             case 8:
               if(options&IMAGE_NEAREST)
-                render_index_8_fast(xim,(FXuchar*)data);
+                render_index_8_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_index_8_dither(xim,(FXuchar*)data);
+                render_index_8_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             default:
               if(options&IMAGE_NEAREST)
-                render_index_N_fast(xim,(FXuchar*)data);
+                render_index_N_fast(xim,(FXuchar*)data,x,y,w,h);
               else
-                render_index_N_dither(xim,(FXuchar*)data);
+                render_index_N_dither(xim,(FXuchar*)data,x,y,w,h);
               break;
             }
           break;
         case FXVisual::Mono:
           if(options&IMAGE_NEAREST)
-            render_mono_1_fast(xim,(FXuchar*)data);
+            render_mono_1_fast(xim,(FXuchar*)data,x,y,w,h);
           else
-            render_mono_1_dither(xim,(FXuchar*)data);
+            render_mono_1_dither(xim,(FXuchar*)data,x,y,w,h);
         }
 
       // Transfer image with shared memory
 #ifdef HAVE_XSHM_H
       if(shmi){
-        XShmPutImage(DISPLAY(getApp()),xid,gc,xim,0,0,0,0,width,height,False);
-        XSync(DISPLAY(getApp()),False);
-        FXTRACE((TOPIC_DETAIL,"RGBPixmap XSHM detached at memory=%p (%d bytes)\n",xim->data,xim->bytes_per_line*xim->height));
-        XShmDetach(DISPLAY(getApp()),&shminfo);
+        XShmPutImage(DISPLAY(getApp()),xid,gc,xim,0,0,x,y,w,h,False);
         xim->data=nullptr;
         XDestroyImage(xim);
-        shmdt(shminfo.shmaddr);
-        shmctl(shminfo.shmid,IPC_RMID,0);
+        getApp()->putShmSegment(shminfo);
         }
 #endif
 
       // Transfer the image old way
       if(!shmi){
-        XPutImage(DISPLAY(getApp()),xid,gc,xim,0,0,0,0,width,height);
+        XPutImage(DISPLAY(getApp()),xid,gc,xim,0,0,x,y,w,h);
         freeElms(xim->data);
         XDestroyImage(xim);
         }
@@ -1508,6 +1845,13 @@ void FXImage::render(){
     }
   }
 
+
+
+// Render into pixmap
+void FXImage::render(){
+  FXImage::render(0,0,width,height);
+  }
+
 #endif
 
 
@@ -1563,274 +1907,6 @@ void FXImage::resize(FXint w,FXint h){
   }
 
 
-// Gamma-corrected image scaling.
-// In a nutshell: convert pixel value to intensities, scale, then convert
-// them back to pixel value:
-//
-//      I = pow(P,2.2)
-//      P = pow(I,1/2.2)
-//
-// Reference: http://www.ericbrasseur.org/gamma.html
-// At some future time this should be based around the gamma used in
-// FXVisual; this means generating the table at run time.
-
-// Table lookup: y=pow(x,2.2)
-static const FXuint gammatable[256]={
-       0,     1,     4,    11,    21,    34,    51,    72,
-      97,   125,   158,   195,   236,   282,   332,   386,
-     445,   509,   577,   650,   728,   810,   898,   990,
-    1087,  1189,  1297,  1409,  1526,  1649,  1776,  1909,
-    2048,  2191,  2340,  2494,  2653,  2818,  2988,  3164,
-    3346,  3532,  3725,  3923,  4126,  4335,  4550,  4771,
-    4997,  5229,  5466,  5710,  5959,  6214,  6475,  6742,
-    7014,  7293,  7577,  7868,  8164,  8466,  8775,  9089,
-    9410,  9736, 10069, 10407, 10752, 11103, 11460, 11824,
-   12193, 12569, 12951, 13339, 13733, 14134, 14541, 14954,
-   15374, 15800, 16232, 16671, 17116, 17567, 18025, 18490,
-   18961, 19438, 19922, 20412, 20908, 21412, 21922, 22438,
-   22961, 23490, 24026, 24569, 25118, 25674, 26237, 26806,
-   27382, 27965, 28554, 29150, 29753, 30362, 30978, 31601,
-   32231, 32867, 33511, 34161, 34818, 35482, 36152, 36830,
-   37514, 38205, 38903, 39608, 40320, 41039, 41765, 42497,
-   43237, 43984, 44737, 45498, 46266, 47040, 47822, 48610,
-   49406, 50209, 51019, 51836, 52660, 53491, 54329, 55174,
-   56027, 56886, 57753, 58627, 59508, 60396, 61291, 62194,
-   63103, 64020, 64944, 65876, 66815, 67760, 68714, 69674,
-   70642, 71617, 72599, 73588, 74585, 75590, 76601, 77620,
-   78646, 79680, 80721, 81769, 82825, 83888, 84958, 86036,
-   87122, 88214, 89314, 90422, 91537, 92660, 93790, 94927,
-   96072, 97224, 98384, 99552,100727,101909,103099,104297,
-  105502,106715,107935,109163,110398,111641,112892,114150,
-  115415,116689,117970,119259,120555,121859,123170,124490,
-  125817,127151,128493,129843,131201,132566,133940,135320,
-  136709,138105,139509,140921,142340,143768,145203,146646,
-  148096,149555,151021,152495,153977,155466,156964,158469,
-  159982,161503,163032,164569,166114,167666,169226,170795,
-  172371,173955,175547,177147,178754,180370,181994,183625,
-  185265,186912,188568,190231,191902,193582,195269,196964
-  };
-
-
-static FXuint gammaLookup(FXuint i){
-  return gammatable[i];
-  }
-
-
-#if 0
-static FXuint gammaInvertLookup(FXuint val){    // New
-  FXint m,l=0,h=255;
-  while(l<(m=(h+l)>>1)){
-    if(gammatable[m]<=val) l=m; else h=m;
-    }
-  return l;
-  }
-#endif
-
-static FXuint gammaInvertLookup(FXuint val){
-  FXint mid,low=0,high=255;
-  while((high-low)>1){
-    mid=low+(high-low)/2;
-    if(val<gammatable[mid])
-      high=mid;
-    else
-      low=mid;
-    }
-  return (gammatable[high]==val) ? high : low;
-  }
-
-
-// Horizontal box-filtered, gamma-corrected
-static void hscalergbagamma(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw,FXint ){
-  FXint fin,fout,ar,ag,ab,aa;
-  FXint ss=4*sw;
-  FXint ds=4*dw;
-  FXuchar *end=dst+ds*dh;
-  FXuchar *d;
-  const FXuchar *s;
-  do{
-    s=src; src+=ss;
-    d=dst; dst+=ds;
-    fin=dw;
-    fout=sw;
-    ar=ag=ab=aa=0;
-    while(1){
-      if(fin<fout){
-        aa+=fin*s[3];
-        ar+=fin*gammaLookup(s[2]);
-        ag+=fin*gammaLookup(s[1]);
-        ab+=fin*gammaLookup(s[0]);
-        fout-=fin;
-        fin=dw;
-        s+=4;
-        }
-      else{
-        aa+=fout*s[3];              d[3]=aa/sw;
-        ar+=fout*gammaLookup(s[2]); d[2]=gammaInvertLookup(ar/sw);
-        ag+=fout*gammaLookup(s[1]); d[1]=gammaInvertLookup(ag/sw);
-        ab+=fout*gammaLookup(s[0]); d[0]=gammaInvertLookup(ab/sw);
-        ar=ag=ab=aa=0;
-        fin-=fout;
-        fout=sw;
-        d+=4;
-        if(d>=dst) break;
-        }
-      }
-    }
-  while(dst<end);
-  }
-
-
-// Vertical box-filtered, gamma-corrected
-static void vscalergbagamma(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw,FXint sh){
-  FXint fin,fout,ar,ag,ab,aa;
-  FXint ss=4*sw;
-  FXint ds=4*dw;
-  FXint dss=ds*dh;
-  FXuchar *end=dst+ds;
-  FXuchar *d,*dd;
-  const FXuchar *s;
-  do{
-    s=src; src+=4;
-    d=dst; dst+=4;
-    dd=d+dss;
-    fin=dh;
-    fout=sh;
-    ar=ag=ab=aa=0;
-    while(1){
-      if(fin<fout){
-        aa+=fin*s[3];
-        ar+=fin*gammaLookup(s[2]);
-        ag+=fin*gammaLookup(s[1]);
-        ab+=fin*gammaLookup(s[0]);
-        fout-=fin;
-        fin=dh;
-        s+=ss;
-        }
-      else{
-        aa+=fout*s[3];              d[3]=aa/sh;
-        ar+=fout*gammaLookup(s[2]); d[2]=gammaInvertLookup(ar/sh);
-        ag+=fout*gammaLookup(s[1]); d[1]=gammaInvertLookup(ag/sh);
-        ab+=fout*gammaLookup(s[0]); d[0]=gammaInvertLookup(ab/sh);
-        ar=ag=ab=aa=0;
-        fin-=fout;
-        fout=sh;
-        d+=ds;
-        if(d>=dd) break;
-        }
-      }
-    }
-  while(dst<end);
-  }
-
-
-// Horizontal box-filtered
-static void hscalergba(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw,FXint ){
-  FXint fin,fout,ar,ag,ab,aa;
-  FXint ss=4*sw;
-  FXint ds=4*dw;
-  FXuchar *end=dst+ds*dh;
-  FXuchar *d;
-  const FXuchar *s;
-  do{
-    s=src; src+=ss;
-    d=dst; dst+=ds;
-    fin=dw;
-    fout=sw;
-    ar=ag=ab=aa=0;
-    while(1){
-      if(fin<fout){
-        aa+=fin*s[3];
-        ar+=fin*s[2];
-        ag+=fin*s[1];
-        ab+=fin*s[0];
-        fout-=fin;
-        fin=dw;
-        s+=4;
-        }
-      else{
-        aa+=fout*s[3]; d[3]=aa/sw; aa=0;
-        ar+=fout*s[2]; d[2]=ar/sw; ar=0;
-        ag+=fout*s[1]; d[1]=ag/sw; ag=0;
-        ab+=fout*s[0]; d[0]=ab/sw; ab=0;
-        fin-=fout;
-        fout=sw;
-        d+=4;
-        if(d>=dst) break;
-        }
-      }
-    }
-  while(dst<end);
-  }
-
-
-// Vertical box-filtered
-static void vscalergba(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw,FXint sh){
-  FXint fin,fout,ar,ag,ab,aa;
-  FXint ss=4*sw;
-  FXint ds=4*dw;
-  FXint dss=ds*dh;
-  FXuchar *end=dst+ds;
-  FXuchar *d,*dd;
-  const FXuchar *s;
-  do{
-    s=src; src+=4;
-    d=dst; dst+=4;
-    dd=d+dss;
-    fin=dh;
-    fout=sh;
-    ar=ag=ab=aa=0;
-    while(1){
-      if(fin<fout){
-        aa+=fin*s[3];
-        ar+=fin*s[2];
-        ag+=fin*s[1];
-        ab+=fin*s[0];
-        fout-=fin;
-        fin=dh;
-        s+=ss;
-        }
-      else{
-        aa+=fout*s[3]; d[3]=aa/sh; aa=0;
-        ar+=fout*s[2]; d[2]=ar/sh; ar=0;
-        ag+=fout*s[1]; d[1]=ag/sh; ag=0;
-        ab+=fout*s[0]; d[0]=ab/sh; ab=0;
-        fin-=fout;
-        fout=sh;
-        d+=ds;
-        if(d>=dd) break;
-        }
-      }
-    }
-  while(dst<end);
-  }
-
-
-// Simple nearest neighbor scaling; fast but ugly
-static void scalenearest(FXColor *dst,const FXColor* src,FXint dw,FXint dh,FXint sw,FXint sh){
-  FXint xs=(sw<<16)/dw;
-  FXint ys=(sh<<16)/dh;
-  FXint i,j,x,y;
-  const FXColor *q;
-  FXColor *p;
-  i=0;
-  y=ys>>1;
-  p=dst;
-  do{
-    j=0;
-    x=xs>>1;
-    q=src+(y>>16)*sw;
-    do{
-      p[j]=q[x>>16];
-      x+=xs;
-      }
-    while(++j<dw);
-    p+=dw;
-    y+=ys;
-    }
-  while(++i<dh);
-  }
-
-
 // Resize drawable to the specified width and height
 void FXImage::scale(FXint w,FXint h,FXint quality){
   if(w<1) w=1;
@@ -1838,81 +1914,12 @@ void FXImage::scale(FXint w,FXint h,FXint quality){
   FXTRACE((TOPIC_CREATION,"%s::scale(%d,%d)\n",getClassName(),w,h));
   if(w!=width || h!=height){
     if(data){
-      FXint ow=width;
-      FXint oh=height;
-      FXColor *interim;
-
-      switch(quality){
-        case 0:         // Fast but ugly scale
-
-          // Copy to old buffer
-          if(!dupElms(interim,data,ow*oh)){ throw FXMemoryException("unable to scale image"); }
-
-          // Resize the pixmap and target buffer
-          resize(w,h);
-
-          // Fast nearest neighbor scale
-          scalenearest(data,interim,w,h,ow,oh);
-
-          // Free old buffer
-          freeElms(interim);
-          break;
-        case 1:         // Slower box filtered scale
-
-          // Allocate interim buffer
-          if(!allocElms(interim,w*oh)){ throw FXMemoryException("unable to scale image"); }
-
-          // Scale horizontally first, placing result into interim buffer
-          if(w==ow){
-            memcpy((FXuchar*)interim,(FXuchar*)data,w*oh*4);
-            }
-          else{
-            hscalergba((FXuchar*)interim,(FXuchar*)data,w,oh,ow,oh);
-            }
-
-          // Resize the pixmap and target buffer
-          resize(w,h);
-
-          // Scale vertically from the interim buffer into target buffer
-          if(h==oh){
-            memcpy((FXuchar*)data,(FXuchar*)interim,w*h*4);
-            }
-          else{
-            vscalergba((FXuchar*)data,(FXuchar*)interim,w,h,w,oh);
-            }
-
-          // Free interim buffer
-          freeElms(interim);
-          break;
-        case 2:         // Slow gamma corrected scale
-        default:
-
-          // Allocate interim buffer
-          if(!allocElms(interim,w*oh)){ throw FXMemoryException("unable to scale image"); }
-
-          // Scale horizontally first, placing result into interim buffer
-          if(w==ow){
-            memcpy((FXuchar*)interim,(FXuchar*)data,w*oh*4);
-            }
-          else{
-            hscalergbagamma((FXuchar*)interim,(FXuchar*)data,w,oh,ow,oh);
-            }
-
-          // Resize the pixmap and target buffer
-          resize(w,h);
-
-          // Scale vertically from the interim buffer into target buffer
-          if(h==oh){
-            memcpy((FXuchar*)data,(FXuchar*)interim,w*h*4);
-            }
-          else{
-            vscalergbagamma((FXuchar*)data,(FXuchar*)interim,w,h,w,oh);
-            }
-
-          // Free interim buffer
-          freeElms(interim);
-          break;
-        }
+      FXColor *olddata;
+      if(!dupElms(olddata,data,width*height)){ throw FXMemoryException("unable to scale image"); }
+      FXPixelBuffer src(olddata,width,height,true);
+      resize(w,h);
+      FXPixelBuffer dst(data,width,height);
+      if(!src.scale(dst,quality)){ throw FXMemoryException("unable to scale image"); }
       render();
       }
     else{
@@ -1927,33 +1934,8 @@ void FXImage::mirror(FXbool horizontal,FXbool vertical){
   FXTRACE((TOPIC_CREATION,"%s::mirror(%d,%d)\n",getClassName(),horizontal,vertical));
   if(horizontal || vertical){
     if(data){
-      FXColor *paa,*pa,*pbb,*pb,t;
-      if(vertical && height>1){     // Mirror vertically
-        paa=data;
-        pbb=data+width*(height-1);
-        do{
-          pa=paa; paa+=width;
-          pb=pbb; pbb-=width;
-          do{
-            t=*pa; *pa++=*pb; *pb++=t;
-            }
-          while(pa<paa);
-          }
-        while(paa<pbb);
-        }
-      if(horizontal && width>1){    // Mirror horizontally
-        paa=data;
-        pbb=data+width*height;
-        do{
-          pa=paa; paa+=width;
-          pb=paa;
-          do{
-            t=*--pb; *pb=*pa; *pa++=t;
-            }
-          while(pa<pb);
-          }
-        while(paa<pbb);
-        }
+      FXPixelBuffer pixels(data,width,height);
+      pixels.mirror(horizontal,vertical);
       render();
       }
     }
@@ -1965,83 +1947,30 @@ void FXImage::rotate(FXint degrees){
   FXTRACE((TOPIC_CREATION,"%s::rotate(%d)\n",getClassName(),degrees));
   degrees=(degrees+360)%360;
   if(degrees!=0 && width>1 && height>1){
+    if(degrees!=90 && degrees!=180 && degrees!=270){
+      fxwarning("%s::rotate: rotation by %d degrees not implemented.\n",getClassName(),degrees);
+      return;
+      }
     if(data){
-      FXColor *paa,*pbb,*end,*pa,*pb;
-      FXint size=width*height;
       FXColor *olddata;
-      if(!dupElms(olddata,data,size)){ throw FXMemoryException("unable to rotate image"); }
-      switch(degrees){
-        case 90:
-          resize(height,width);
-          paa=data;
-          pbb=olddata+(height-1);
-          end=data+size;
-          do{
-            pa=paa; paa+=width;
-            pb=pbb; pbb-=1;
-            do{
-              *pa=*pb;
-              pa+=1;
-              pb+=height;
-              }
-            while(pa<paa);
-            }
-          while(paa<end);
-          break;
-        case 180:
-          paa=data;
-          pbb=olddata+size;
-          end=data+size;
-          do{
-            pa=paa; paa+=width;
-            pb=pbb; pbb-=width;
-            do{
-              pb-=1;
-              *pa=*pb;
-              pa+=1;
-              }
-            while(pa<paa);
-            }
-          while(paa<end);
-          break;
-        case 270:
-          resize(height,width);
-          paa=data;
-          pbb=olddata+height*(width-1);
-          end=data+size;
-          do{
-            pa=paa; paa+=width;
-            pb=pbb; pbb+=1;
-            do{
-              *pa=*pb;
-              pa+=1;
-              pb-=height;
-              }
-            while(pa<paa);
-            }
-          while(paa<end);
-          break;
-        default:
-          fxwarning("%s::rotate: rotation by %d degrees not implemented.\n",getClassName(),degrees);
-          break;
+      if(!dupElms(olddata,data,width*height)){ throw FXMemoryException("unable to rotate image"); }
+      FXPixelBuffer src(olddata,width,height,true);
+      if(degrees==180){
+        resize(width,height);
         }
-      freeElms(olddata);
+      else{
+        resize(height,width);
+        }
+      FXPixelBuffer dst(data,width,height);
+      src.rotate(dst,degrees);
       render();
       }
     else{
-      switch(degrees){
-        case 90:
-          resize(height,width);
-          break;
-        case 180:
-          resize(width,height);
-          break;
-        case 270:
-          resize(height,width);
-          break;
-        default:
-          fxwarning("%s::rotate: rotation by %d degrees not implemented.\n",getClassName(),degrees);
-          break;
+      if(degrees==180){
+        resize(width,height);
+        }
+      else{
+        resize(height,width);
         }
       }
     }
@@ -2055,66 +1984,12 @@ void FXImage::crop(FXint x,FXint y,FXint w,FXint h,FXColor color){
   if(x>=width || y>=height || x+w<=0 || y+h<=0){ fxerror("%s::crop: bad arguments.\n",getClassName()); }
   FXTRACE((TOPIC_CREATION,"%s::crop(%d,%d,%d,%d)\n",getClassName(),x,y,w,h));
   if(data){
-    FXColor *pnn,*poo,*yyy,*pn,*po,*xx;
-    FXint ow=width;
-    FXint oh=height;
-    FXint nw=w;
-    FXint nh=h;
-    FXint cw;
-    FXint ch;
     FXColor *olddata;
     if(!dupElms(olddata,data,width*height)){ throw FXMemoryException("unable to crop image"); }
-    resize(nw,nh);
-    pnn=data;
-    yyy=data+nw*nh;
-    do{
-      *pnn++=color;
-      }
-    while(pnn<yyy);
-    if(x<0){
-      cw=FXMIN(ow,x+nw);
-      if(y<0){
-        pnn=data-nw*y;
-        poo=olddata;
-        ch=FXMIN(oh,y+nh);
-        }
-      else{
-        pnn=data;
-        poo=olddata+ow*y;
-        ch=FXMIN(oh,y+nh)-y;
-        }
-      pnn-=x;
-      }
-    else{
-      cw=FXMIN(ow,x+nw)-x;
-      if(y<0){
-        pnn=data-nw*y;
-        poo=olddata;
-        ch=FXMIN(oh,y+nh);
-        }
-      else{
-        pnn=data;
-        poo=olddata+ow*y;
-        ch=FXMIN(oh,y+nh)-y;
-        }
-      poo+=x;
-      }
-    FXASSERT(cw>0);
-    FXASSERT(ch>0);
-    yyy=pnn+nw*ch;
-    do{
-      pn=pnn;
-      po=poo;
-      xx=pnn+cw;
-      do{
-        *pn++=*po++;
-        }
-      while(pn<xx);
-      pnn+=nw;
-      poo+=ow;
-      }
-    while(pnn<yyy);
-    freeElms(olddata);
+    FXPixelBuffer src(olddata,width,height,true);
+    resize(w,h);
+    FXPixelBuffer dst(data,width,height);
+    src.crop(dst,x,y,color);
     render();
     }
   else{
@@ -2123,222 +1998,20 @@ void FXImage::crop(FXint x,FXint y,FXint w,FXint h,FXColor color){
   }
 
 
-/*
-    FXuint r=FXREDVAL(color);
-    FXuint g=FXGREENVAL(color);
-    FXuint b=FXBLUEVAL(color);
-    FXuint a=FXALPHAVAL(color);
-    FXuchar *pix=data;
-    FXuchar *end=pix+height*width*channels;
-    FXuchar  tbl[512];
-
-    // Fill table
-    for(int i=0; i<256; i++){
-      tbl[255+i]=-(i*factor+127)/255;
-      tbl[255-i]= (i*factor+127)/255;
-      }
-
-    // Fade
-    if(channels==4){
-      do{
-        pix[0]=pix[0]+tbl[255+pix[0]-r];
-        pix[1]=pix[1]+tbl[255+pix[1]-g];
-        pix[2]=pix[2]+tbl[255+pix[2]-b];
-        pix[3]=pix[3]+tbl[255+pix[3]-a];
-        pix+=4;
-        }
-      while(pix<end);
-      }
-    else{
-      do{
-        pix[0]=pix[0]+tbl[255+pix[0]-r];
-        pix[1]=pix[1]+tbl[255+pix[1]-g];
-        pix[2]=pix[2]+tbl[255+pix[2]-b];
-        pix+=3;
-        }
-      while(pix<end);
-      }
-    }
-*/
-
-  // FXColor ____blend(FXColor fg,FXColor bg){
-//   FXuint r,g,b,s,t,tmp;
-//   s=FXALPHAVAL(fg);
-//   t=~s;
-//   tmp=FXREDVAL(fg)*s+FXREDVAL(bg)*t+127;     r=(tmp+(tmp>>8))>>8;
-//   tmp=FXGREENVAL(fg)*s+FXGREENVAL(bg)*t+127; g=(tmp+(tmp>>8))>>8;
-//   tmp=FXBLUEVAL(fg)*s+FXBLUEVAL(bg)*t+127;   b=(tmp+(tmp>>8))>>8;
-//   return FXRGB(r,g,b);
-//   }
-/*
-        s=pix[3];
-        t=s^0xff;
-        w=pix[0]*s+r*t; pix[0]=(w+(w>>8))>>8;
-        w=pix[1]*s+g*t; pix[1]=(w+(w>>8))>>8;
-        w=pix[2]*s+b*t; pix[2]=(w+(w>>8))>>8;
-        s=pix[3];
-
-*/
-
-
 // Fill image with color
 void FXImage::fill(FXColor color){
   if(data){
-    FXColor *pix=data;
-    FXColor *end=pix+height*width;
-    do{ *pix++=color; }while(pix<end);
+    FXPixelBuffer pixels(data,width,height);
+    pixels.fill(color);
     }
   }
 
 
-
 // Fade image to uniform color
 void FXImage::fade(FXColor color,FXint factor){
   if(data){
-    FXuint s=factor;
-    FXuint t=~factor;
-    FXuint r=FXREDVAL(color)*t;
-    FXuint g=FXGREENVAL(color)*t;
-    FXuint b=FXBLUEVAL(color)*t;
-    FXuint a=FXALPHAVAL(color)*t;
-    FXuint w;
-    FXuchar *pix=(FXuchar*)data;
-    FXuchar *end=pix+height*width*4;
-    do{
-      w=pix[3]*s+a; pix[3]=(w+(w>>8))>>8;
-      w=pix[2]*s+r; pix[2]=(w+(w>>8))>>8;
-      w=pix[1]*s+g; pix[1]=(w+(w>>8))>>8;
-      w=pix[0]*s+b; pix[0]=(w+(w>>8))>>8;
-      pix+=4;
-      }
-    while(pix<end);
-    }
-  }
-
-
-// Shear in X
-static void shearx(FXuchar *out,FXuchar* in,FXint nwidth,FXint owidth,FXint height,FXint shear,FXColor clr){
-  FXuchar *ppp,*pp,*qq,*p,*q,*k;
-  FXuint r=FXREDVAL(clr);
-  FXuint g=FXGREENVAL(clr);
-  FXuint b=FXBLUEVAL(clr);
-  FXuint a=FXALPHAVAL(clr);
-  FXint dp=owidth<<2;
-  FXint dq=nwidth<<2;
-  FXint s,z,y,d;
-  if(shear){
-    if(shear>0){ y=height-1; d=-1; } else { shear=-shear; y=0; d=1; }
-    pp=in;
-    ppp=pp+height*dp;
-    qq=out;
-    do{
-      p=pp; pp+=dp;
-      q=qq; qq+=dq;
-      z=(y*shear-1)/(height-1); y+=d;
-      s=z&255;
-      k=q+(z>>8)*4;
-      while(q<k){
-        q[3]=a;
-        q[2]=r;
-        q[1]=g;
-        q[0]=b;
-        q+=4;
-        }
-      q[3]=((a-p[3])*s+(p[3]<<8)+127)>>8;
-      q[2]=((r-p[2])*s+(p[2]<<8)+127)>>8;
-      q[1]=((g-p[1])*s+(p[1]<<8)+127)>>8;
-      q[0]=((b-p[0])*s+(p[0]<<8)+127)>>8;
-      q+=4;
-      p+=4;
-      while(p<pp){
-        q[3]=((p[3-4]-p[3])*s+(p[3]<<8)+127)>>8;
-        q[2]=((p[2-4]-p[2])*s+(p[2]<<8)+127)>>8;
-        q[1]=((p[1-4]-p[1])*s+(p[1]<<8)+127)>>8;
-        q[0]=((p[0-4]-p[0])*s+(p[0]<<8)+127)>>8;
-        q+=4;
-        p+=4;
-        }
-      q[3]=((p[3-4]-a)*s+(a<<8)+127)>>8;
-      q[2]=((p[2-4]-r)*s+(r<<8)+127)>>8;
-      q[1]=((p[1-4]-g)*s+(g<<8)+127)>>8;
-      q[0]=((p[0-4]-b)*s+(b<<8)+127)>>8;
-      q+=4;
-      while(q<qq){
-        q[3]=a;
-        q[2]=r;
-        q[1]=g;
-        q[0]=b;
-        q+=4;
-        }
-      }
-    while(pp!=ppp);
-    }
-  else{
-    memcpy(out,in,owidth*height*4);
-    }
-  }
-
-
-// Shear in Y
-static void sheary(FXuchar *out,FXuchar* in,FXint width,FXint nheight,FXint oheight,FXint shear,FXColor clr){
-  FXuchar *ppp,*pp,*qq,*p,*q,*k;
-  FXuint r=FXREDVAL(clr);
-  FXuint g=FXGREENVAL(clr);
-  FXuint b=FXBLUEVAL(clr);
-  FXuint a=FXALPHAVAL(clr);
-  FXint dp=width<<2;
-  FXint s,z,x,d;
-  if(shear){
-    if(shear>0){ x=width-1; d=-1; } else { shear=-shear; x=0; d=1; }
-    pp=in+dp*oheight;
-    ppp=pp+dp;
-    qq=out+dp*nheight;
-    do{
-      p=pp-dp*oheight;
-      q=qq-dp*nheight;
-      z=(x*shear-1)/(width-1); x+=d;
-      s=z&255;
-      k=q+(z>>8)*dp;
-      while(q<k){
-        q[3]=r;
-        q[2]=g;
-        q[1]=b;
-        q[0]=a;
-        q+=dp;
-        }
-      q[3]=((a-p[3])*s+(p[3]<<8)+127)>>8;
-      q[2]=((r-p[2])*s+(p[2]<<8)+127)>>8;
-      q[1]=((g-p[1])*s+(p[1]<<8)+127)>>8;
-      q[0]=((b-p[0])*s+(p[0]<<8)+127)>>8;
-      q+=dp;
-      p+=dp;
-      while(p<pp){
-        q[3]=((p[3-dp]-p[3])*s+(p[3]<<8)+127)>>8;
-        q[2]=((p[2-dp]-p[2])*s+(p[2]<<8)+127)>>8;
-        q[1]=((p[1-dp]-p[1])*s+(p[1]<<8)+127)>>8;
-        q[0]=((p[0-dp]-p[0])*s+(p[0]<<8)+127)>>8;
-        q+=dp;
-        p+=dp;
-        }
-      q[3]=((p[3-dp]-a)*s+(a<<8)+127)>>8;
-      q[2]=((p[2-dp]-r)*s+(r<<8)+127)>>8;
-      q[1]=((p[1-dp]-g)*s+(g<<8)+127)>>8;
-      q[0]=((p[0-dp]-b)*s+(b<<8)+127)>>8;
-      q+=dp;
-      while(q<qq){
-        q[3]=a;
-        q[2]=r;
-        q[1]=g;
-        q[0]=b;
-        q+=dp;
-        }
-      pp+=4;
-      qq+=4;
-      }
-    while(pp!=ppp);
-    }
-  else{
-    memcpy(out,in,width*oheight*4);
+    FXPixelBuffer pixels(data,width,height);
+    pixels.fade(color,factor);
     }
   }
 
@@ -2346,14 +2019,14 @@ static void sheary(FXuchar *out,FXuchar* in,FXint width,FXint nheight,FXint ohei
 // Shear image horizontally
 void FXImage::xshear(FXint shear,FXColor clr){
   FXint neww=width+((FXABS(shear)+255)>>8);
-  FXint oldw=width;
   FXTRACE((TOPIC_CREATION,"%s::xshear(%d)\n",getClassName(),shear));
   if(data){
     FXColor *olddata;
     if(!dupElms(olddata,data,width*height)){ throw FXMemoryException("unable to xshear image"); }
+    FXPixelBuffer src(olddata,width,height,true);
     resize(neww,height);
-    shearx((FXuchar*)data,(FXuchar*)olddata,neww,oldw,height,shear,clr);
-    freeElms(olddata);
+    FXPixelBuffer dst(data,width,height);
+    src.xshear(dst,shear,clr);
     render();
     }
   else{
@@ -2365,14 +2038,14 @@ void FXImage::xshear(FXint shear,FXColor clr){
 // Shear image vertically
 void FXImage::yshear(FXint shear,FXColor clr){
   FXint newh=height+((FXABS(shear)+255)>>8);
-  FXint oldh=height;
   FXTRACE((TOPIC_CREATION,"%s::yshear(%d)\n",getClassName(),shear));
   if(data){
     FXColor *olddata;
     if(!dupElms(olddata,data,width*height)){ throw FXMemoryException("unable to yshear image"); }
+    FXPixelBuffer src(olddata,width,height,true);
     resize(width,newh);
-    sheary((FXuchar*)data,(FXuchar*)olddata,width,newh,oldh,shear,clr);
-    freeElms(olddata);
+    FXPixelBuffer dst(data,width,height);
+    src.yshear(dst,shear,clr);
     render();
     }
   else{
@@ -2383,155 +2056,27 @@ void FXImage::yshear(FXint shear,FXColor clr){
 
 // Fill horizontal gradient
 void FXImage::hgradient(FXColor left,FXColor right){
-  FXint rr,gg,bb,aa,dr,dg,db,da,r1,g1,b1,a1,r2,g2,b2,a2,x;
-  FXuchar *ptr=(FXuchar*)data;
-  FXuchar *prv=(FXuchar*)data;
-  if(ptr && width>1 && height>1){
-    r1=FXREDVAL(left);
-    r2=FXREDVAL(right);
-    rr=(r1<<16)+32768;
-    dr=((r2-r1)<<16)/(width-1);
-    g1=FXGREENVAL(left);
-    g2=FXGREENVAL(right);
-    gg=(g1<<16)+32768;
-    dg=((g2-g1)<<16)/(width-1);
-    b1=FXBLUEVAL(left);
-    b2=FXBLUEVAL(right);
-    bb=(b1<<16)+32768;
-    db=((b2-b1)<<16)/(width-1);
-    a1=FXALPHAVAL(left);
-    a2=FXALPHAVAL(right);
-    aa=(a1<<16)+32768;
-    da=((a2-a1)<<16)/(width-1);
-    x=width;
-    do{
-      ptr[3]=aa>>16; aa+=da;
-      ptr[2]=rr>>16; rr+=dr;
-      ptr[1]=gg>>16; gg+=dg;
-      ptr[0]=bb>>16; bb+=db;
-      ptr+=4;
-      }
-    while(--x);
-    x=width*(height-1);
-    do{
-      ptr[0]=prv[0];
-      ptr[1]=prv[1];
-      ptr[2]=prv[2];
-      ptr[3]=prv[3];
-      ptr+=4;
-      prv+=4;
-      }
-    while(--x);
+  if(data){
+    FXPixelBuffer pixels(data,width,height);
+    pixels.hgradient(left,right);
     }
   }
 
 
 // Fill vertical gradient
 void FXImage::vgradient(FXColor top,FXColor bottom){
-  FXint rr,gg,bb,aa,dr,dg,db,da,r1,g1,b1,a1,r2,g2,b2,a2,x,y;
-  FXuchar *ptr=(FXuchar*)data;
-  if(ptr && width>1 && height>1){
-    r1=FXREDVAL(top);
-    r2=FXREDVAL(bottom);
-    rr=(r1<<16)+32768;
-    dr=((r2-r1)<<16)/(height-1);
-    g1=FXGREENVAL(top);
-    g2=FXGREENVAL(bottom);
-    gg=(g1<<16)+32768;
-    dg=((g2-g1)<<16)/(height-1);
-    b1=FXBLUEVAL(top);
-    b2=FXBLUEVAL(bottom);
-    bb=(b1<<16)+32768;
-    db=((b2-b1)<<16)/(height-1);
-    a1=FXALPHAVAL(top);
-    a2=FXALPHAVAL(bottom);
-    aa=(a1<<16)+32768;
-    da=((a2-a1)<<16)/(height-1);
-    y=height;
-    do{
-      a1=aa>>16; aa+=da;
-      r1=rr>>16; rr+=dr;
-      g1=gg>>16; gg+=dg;
-      b1=bb>>16; bb+=db;
-      x=width;
-      do{
-        ptr[3]=a1;
-        ptr[2]=r1;
-        ptr[1]=g1;
-        ptr[0]=b1;
-        ptr+=4;
-        }
-      while(--x);
-      }
-    while(--y);
+  if(data){
+    FXPixelBuffer pixels(data,width,height);
+    pixels.vgradient(top,bottom);
     }
   }
 
 
 // Fill with gradient
 void FXImage::gradient(FXColor topleft,FXColor topright,FXColor bottomleft,FXColor bottomright){
-  FXint rl,gl,bl,al,rr,gr,br,ar,drl,dgl,dbl,dal,drr,dgr,dbr,dar,r,g,b,a,dr,dg,db,da,x,y;
-  FXint rtl,gtl,btl,atl,rtr,gtr,btr,atr,rbl,gbl,bbl,abl,rbr,gbr,bbr,abr;
-  FXuchar *ptr=(FXuchar*)data;
-  if(ptr && width>1 && height>1){
-
-    rtl=FXREDVAL(topleft);
-    rbl=FXREDVAL(bottomleft);
-    rl=(rtl<<16)+32768; drl=((rbl-rtl)<<16)/(height-1);
-
-    gtl=FXGREENVAL(topleft);
-    gbl=FXGREENVAL(bottomleft);
-    gl=(gtl<<16)+32768; dgl=((gbl-gtl)<<16)/(height-1);
-
-    btl=FXBLUEVAL(topleft);
-    bbl=FXBLUEVAL(bottomleft);
-    bl=(btl<<16)+32768; dbl=((bbl-btl)<<16)/(height-1);
-
-    rtr=FXREDVAL(topright);
-    rbr=FXREDVAL(bottomright);
-    rr=(rtr<<16)+32768; drr=((rbr-rtr)<<16)/(height-1);
-
-    gtr=FXGREENVAL(topright);
-    gbr=FXGREENVAL(bottomright);
-    gr=(gtr<<16)+32768; dgr=((gbr-gtr)<<16)/(height-1);
-
-    btr=FXBLUEVAL(topright);
-    bbr=FXBLUEVAL(bottomright);
-    br=(btr<<16)+32768; dbr=((bbr-btr)<<16)/(height-1);
-
-    atl=FXALPHAVAL(topleft);
-    abl=FXALPHAVAL(bottomleft);
-    al=(atl<<16)+32768; dal=((abl-atl)<<16)/(height-1);
-
-    atr=FXALPHAVAL(topright);
-    abr=FXALPHAVAL(bottomright);
-    ar=(atr<<16)+32768; dar=((abr-atr)<<16)/(height-1);
-
-    y=height;
-    do{
-      a=al; da=(ar-al)/(width-1);
-      r=rl; dr=(rr-rl)/(width-1);
-      g=gl; dg=(gr-gl)/(width-1);
-      b=bl; db=(br-bl)/(width-1);
-      x=width;
-      do{
-        ptr[3]=a>>16; a+=da;
-        ptr[2]=r>>16; r+=dr;
-        ptr[1]=g>>16; g+=dg;
-        ptr[0]=b>>16; b+=db;
-        ptr+=4;
-        }
-      while(--x);
-      rl+=drl;
-      gl+=dgl;
-      bl+=dbl;
-      al+=dal;
-      rr+=drr;
-      gr+=dgr;
-      br+=dbr;
-      ar+=dar;
-      }
-    while(--y);
+  if(data){
+    FXPixelBuffer pixels(data,width,height);
+    pixels.gradient(topleft,topright,bottomleft,bottomright);
     }
   }
 
@@ -2539,20 +2084,8 @@ void FXImage::gradient(FXColor topleft,FXColor topright,FXColor bottomleft,FXCol
 // Blend image over uniform color
 void FXImage::blend(FXColor color){
   if(data){
-    FXuchar *pix=(FXuchar*)data;
-    FXuchar *end=pix+height*width*4;
-    FXint r=FXREDVAL(color);
-    FXint g=FXGREENVAL(color);
-    FXint b=FXBLUEVAL(color);
-    FXint s,w;
-    do{
-      s=pix[3];
-      w=(pix[2]-r)*s; pix[2]=r+((w+(w>>8)+128)>>8);
-      w=(pix[1]-g)*s; pix[1]=g+((w+(w>>8)+128)>>8);
-      w=(pix[0]-b)*s; pix[0]=b+((w+(w>>8)+128)>>8);             /* FIXME need to write new alpha also */
-      pix+=4;
-      }
-    while(pix<end);
+    FXPixelBuffer pixels(data,width,height);
+    pixels.blend(color);
     }
   }
 
@@ -2560,15 +2093,8 @@ void FXImage::blend(FXColor color){
 // Invert colors of an image
 void FXImage::invert(){
   if(data){
-    FXuchar *pix=(FXuchar*)data;
-    FXuchar *end=pix+height*width*4;
-    do{
-      pix[1]=255-pix[1];
-      pix[2]=255-pix[2];
-      pix[3]=255-pix[3];
-      pix+=4;
-      }
-    while(pix<end);
+    FXPixelBuffer pixels(data,width,height);
+    pixels.invert();
     }
   }
 
@@ -2576,22 +2102,18 @@ void FXImage::invert(){
 // Colorize image based on luminance
 void FXImage::colorize(FXColor color){
   if(data){
-    FXuchar *pix=(FXuchar*)data;
-    FXuchar *end=pix+height*width*4;
-    FXint r=FXREDVAL(color);
-    FXint g=FXGREENVAL(color);
-    FXint b=FXBLUEVAL(color);
-    FXint lum,w;
-    do{
-      if(pix[3]){
-        lum=(77*pix[2]+151*pix[1]+29*pix[0])>>8;
-        w=r*lum; pix[2]=(w+(w>>8))>>8;
-        w=g*lum; pix[1]=(w+(w>>8))>>8;
-        w=b*lum; pix[0]=(w+(w>>8))>>8;
-        }
-      pix+=4;
-      }
-    while(pix<end);
+    FXPixelBuffer pixels(data,width,height);
+    pixels.colorize(color);
+    }
+  }
+
+
+// Composite rectangle of other image onto this image
+void FXImage::composite(const FXImage* src,FXint sx,FXint sy,FXint w,FXint h,FXint dx,FXint dy,FXuint op){
+  if(data && src && src->data && src!=this){
+    FXPixelBuffer pixels(data,width,height);
+    FXPixelBuffer source(src->data,src->width,src->height);
+    pixels.composite(source,sx,sy,w,h,dx,dy,(FXPixelBuffer::Operator)op);
     }
   }
 
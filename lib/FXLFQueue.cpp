@@ -37,6 +37,8 @@
   - Multiple threads can read from the queue, and multiple threads can write to
     the queue.
   - Push may fail if queue is full; pop may fail if queue is empty.
+  - Batch push and pop reserve a run of slots with a single compare-and-swap, and
+    commit them all at once; they transfer as many items as fit, or are available.
 */
 
 
@@ -125,6 +127,40 @@ x:r=rhead;
   }
 
 
+// Add up to n items to queue, return number of items added
+FXuint FXLFQueue::push(const FXptr* ptrs,FXuint n){
+  FXuint mask=getSize()-1;
+  FXuint w,m,i;
+x:w=whead;
+  m=mask+1-(w-rtail);
+  if(m>n) m=n;
+  if(__likely(m)){
+    if(__unlikely(!atomicBoolCas(&whead,w,w+m))) goto x;
+    for(i=0; i<m; ++i){ items[(w+i)&mask]=ptrs[i]; }
+    while(__unlikely(wtail!=w)){}
+    wtail=w+m;
+    }
+  return m;
+  }
+
+
+// Remove up to n items from queue, return number of items removed
+FXuint FXLFQueue::pop(FXptr* ptrs,FXuint n){
+  FXuint mask=getSize()-1;
+  FXuint r,m,i;
+x:r=rhead;
+  m=wtail-r;
+  if(m>n) m=n;
+  if(__likely(m)){
+    if(__unlikely(!atomicBoolCas(&rhead,r,r+m))) goto x;
+    for(i=0; i<m; ++i){ ptrs[i]=items[(r+i)&mask]; }
+    while(__unlikely(rtail!=r)){}
+    rtail=r+m;
+    }
+  return m;
+  }
+
+
 // Destroy job queue
 FXLFQueue::~FXLFQueue(){
   }
@@ -27,7 +27,9 @@
 #include "FXArray.h"
 #include "FXMetaClass.h"
 #include "FXHash.h"
+#include "FXAtomic.h"
 #include "FXMutex.h"
+#include "FXAutoThreadStorageKey.h"
 #include "FXStream.h"
 #include "FXString.h"
 #include "FXSize.h"
@@ -36,6 +38,7 @@
 #include "FXStringDictionary.h"
 #include "FXSettings.h"
 #include "FXRegistry.h"
+#include "FXThread.h"
 #include "FXEvent.h"
 #include "FXWindow.h"
 #include "FXApp.h"
@@ -45,21 +48,42 @@
 /*
   Notes:
   - Inter-thread messaging is handy to have.
-  - A pipe is used to pass data from worker thread to main GUI thread, so that
-    small messages may be sent from worker thread to main GUI thread asynchronously.
-  - On windows, an additional semaphore is needed to provide a watchable handle
-    for FXApp to block on, in MsgWaitForMultipleObjects().
+  - Messages are passed from worker thread to main GUI thread through a ring buffer in
+    memory, so that small messages may be sent from worker thread to main GUI thread
+    asynchronously, without system calls, and without locking.
+  - Writers reserve space in the ring by advancing whead with compare-and-swap, copy
+    the message in, and then commit it by advancing wtail, after the writers which
+    reserved space earlier have committed theirs; this is the same scheme as FXLFQueue,
+    except that a writer waiting for an earlier writer yields rather than spins, as the
+    earlier writer may have been preempted when there are more writers than processors.
+    The main GUI thread is the only reader, and frees space by advancing rtail.
+  - Each message is a header with target, selector, and payload size, followed by the
+    payload, padded to a multiple of the header size; thus a header never wraps around
+    the end of the ring, but a payload may.
   - Main GUI thread blocks on a set of input sources, and wakes up and dispatches
-    to a handler when any one of them is raised.  For the message channel, control
-    will dispatch to onMessage(), which will pull the message from the pipe, and
-    invoke the handler read from the FXMessage struct.
+    to a handler when any one of them is raised.  For the message channel, this is
+    a doorbell: an eventfd on Linux, a pipe on other systems, and a manual-reset event
+    on Windows, which is watched by MsgWaitForMultipleObjects().
+  - The doorbell is only rung by the writer which finds the signalled flag clear, i.e.
+    the first message after the channel was drained.  The reader clears the doorbell,
+    then clears the flag, and then takes all messages committed so far; any message
+    committed after the flag was cleared rings the doorbell again, so no message is
+    left behind.  At worst, an extra wakeup finds the channel already drained.
+  - Each message is copied out and its space freed before it is dispatched, so the
+    handler may send more messages, or recursively run the event loop, without risk
+    of deadlock or of delivering a message twice.
+  - With coalescing, the headers of the messages to be delivered are scanned first,
+    noting the position of the last message for each target and selector; only that
+    message is delivered, in its place in the sequence.  The number of distinct pairs
+    tracked in one drain is limited; messages for pairs beyond that are all delivered.
+  - If the ring is full, message() yields until the main GUI thread frees some space.
+    When the main GUI thread itself finds the ring full, it would wait forever, so
+    message() fails instead.  The main GUI thread is the one which constructed the
+    channel, or which last delivered messages from it.
+  - The handle h[2] and mutex m are no longer used, but are kept so that the members
+    seen by derived classes stay where they were.
   - Note that the handler may get called later than message(); it depends on when
     the main GUI thread returns to the event processing loop.
-  - Based on suggestion from Axel Schmidt <axel.schmidt@analytica-karlsruhe.de>,
-    the Event object was replaced by counting Semaphore.
-    This way, the number of calls to message() has to be equal to the number of calls
-    to MsgWaitForMultipleObjects.  Thus, each call to message() results in exactly
-    one callback in the GUI thread.
   - FIXME technically, FXMessageChannel should refer to an event loop instance (or
     FXDispatcher instance), not FXApp.  Not all applications are GUI applications.
 */
@@ -68,6 +92,12 @@
 // Maximum message size
 #define MAXMESSAGE 8192
 
+// Ring size, power of two
+#define RINGSIZE   65536
+
+// Number of target and selector pairs coalesced, power of two
+#define MAXPAIRS   256
+
 // Bad handle value
 #if defined(WIN32)
 #define BadHandle  INVALID_HANDLE_VALUE
@@ -106,6 +136,76 @@ struct FXDataMessage {
   };
 
 
+// Last position of target and selector pair
+struct FXLatest {
+  FXObject  *target;            // Message target
+  FXSelector message;           // Message type,id
+  FXuint     pos;               // Position of last such message
+  };
+
+
+// Space taken by message with payload of size bytes
+static inline FXuint footprint(FXint size){
+  return (sizeof(FXMessage)+size+sizeof(FXMessage)-1)/sizeof(FXMessage)*sizeof(FXMessage);
+  }
+
+
+// Copy bytes into ring at position pos, wrapping around
+static inline void copyIn(FXuchar* ring,FXuint pos,const void* src,FXuint n){
+  FXuint p=pos&(RINGSIZE-1);
+  FXuint m=FXMIN(n,RINGSIZE-p);
+  if(m) memcpy(ring+p,src,m);
+  if(n-m) memcpy(ring,(const FXuchar*)src+m,n-m);
+  }
+
+
+// Copy bytes out of ring from position pos, wrapping around
+static inline void copyOut(const FXuchar* ring,FXuint pos,void* dst,FXuint n){
+  FXuint p=pos&(RINGSIZE-1);
+  FXuint m=FXMIN(n,RINGSIZE-p);
+  if(m) memcpy(dst,ring+p,m);
+  if(n-m) memcpy((FXuchar*)dst+m,ring,n-m);
+  }
+
+
+// Locate slot for target and selector pair
+static inline FXLatest* locate(FXLatest* latest,FXObject* tgt,FXSelector msg){
+  FXuint b=(((FXuint)((FXuval)tgt>>4))^(msg*0x9E3779B1))&(MAXPAIRS-1);
+  while(latest[b].target && (latest[b].target!=tgt || latest[b].message!=msg)){
+    b=(b+1)&(MAXPAIRS-1);
+    }
+  return &latest[b];
+  }
+
+
+// Ring doorbell
+static inline void ringDoorbell(const FXInputHandle* h){
+#if defined(WIN32)
+  ::SetEvent(h[0]);
+#elif defined(HAVE_EVENTFD)
+  FXulong one=1;
+  if(::write(h[0],&one,sizeof(one))!=sizeof(one)){ }
+#else
+  FXuchar byte=0;
+  if(::write(h[1],&byte,1)!=1){ }
+#endif
+  }
+
+
+// Clear doorbell
+static inline void clearDoorbell(const FXInputHandle* h){
+#if defined(WIN32)
+  ::ResetEvent(h[0]);
+#elif defined(HAVE_EVENTFD)
+  FXulong count;
+  if(::read(h[0],&count,sizeof(count))!=sizeof(count)){ }
+#else
+  FXuchar buffer[64];
+  while(0<::read(h[0],buffer,sizeof(buffer))){ }
+#endif
+  }
+
+
 // Map
 FXDEFMAP(FXMessageChannel) FXMessageChannelMap[]={
   FXMAPFUNC(SEL_IO_READ,FXMessageChannel::ID_IO_READ,FXMessageChannel::onMessage)
@@ -117,90 +217,136 @@ FXIMPLEMENT(FXMessageChannel,FXObject,FXMessageChannelMap,ARRAYNUMBER(FXMessageC
 
 
 // Initialize to empty
-FXMessageChannel::FXMessageChannel():app((FXApp*)-1L){
+FXMessageChannel::FXMessageChannel():app((FXApp*)-1L),ring(nullptr),whead(0),wtail(0),rtail(0),signalled(0),reader(0),coalesce(false){
   h[0]=h[1]=h[2]=BadHandle;
   }
 
 
 // Add handler to application
-FXMessageChannel::FXMessageChannel(FXApp* a):app(a){
+FXMessageChannel::FXMessageChannel(FXApp* a):app(a),ring(nullptr),whead(0),wtail(0),rtail(0),signalled(0),reader(FXThread::current()),coalesce(false){
+  h[0]=h[1]=h[2]=BadHandle;
+  if(!allocElms(ring,RINGSIZE)){ throw FXMemoryException("unable to allocate ring."); }
 #if defined(WIN32)
-  if((h[2]=::CreateSemaphore(nullptr,0,2147483647,nullptr))==nullptr){ throw FXResourceException("unable to create semaphore."); }
-  if(::CreatePipe(&h[0],&h[1],nullptr,0)==0){ throw FXResourceException("unable to create pipe."); }
-  app->addInput(this,ID_IO_READ,h[2],INPUT_READ,nullptr);
+  if((h[0]=::CreateEvent(nullptr,true,false,nullptr))==nullptr){ throw FXResourceException("unable to create event."); }
+#elif defined(HAVE_EVENTFD)
+  if((h[0]=::eventfd(0,EFD_CLOEXEC|EFD_NONBLOCK))<0){ throw FXResourceException("unable to create eventfd."); }
 #else
   if(::pipe(h)!=0){ throw FXResourceException("unable to create pipe."); }
   ::fcntl(h[0],F_SETFD,FD_CLOEXEC);
   ::fcntl(h[1],F_SETFD,FD_CLOEXEC);
-  app->addInput(this,ID_IO_READ,h[0],INPUT_READ,nullptr);
+  ::fcntl(h[0],F_SETFL,O_NONBLOCK);
+  ::fcntl(h[1],F_SETFL,O_NONBLOCK);
 #endif
+  app->addInput(this,ID_IO_READ,h[0],INPUT_READ,nullptr);
   }
 
 
-// Fire signal message to target
+// Fire signal messages to targets
 long FXMessageChannel::onMessage(FXObject*,FXSelector,void*){
+  FXLatest latest[MAXPAIRS];
   FXDataMessage pkg;
-#if defined(WIN32)
-  DWORD nread=-1;
-  if(::ReadFile(h[0],&pkg,sizeof(FXMessage),&nread,nullptr) && nread==sizeof(FXMessage)){
-    if(0<pkg.size && (::ReadFile(h[0],pkg.data,pkg.size,&nread,nullptr) && nread==pkg.size)){
-      return pkg.target && pkg.target->tryHandle(this,pkg.message,pkg.data);
+  FXLatest *l;
+  FXuint w,r,n;
+  long result=0;
+
+  // Delivering thread
+  reader=FXThread::current();
+
+  // Take doorbell down first; messages committed after this ring it again
+  clearDoorbell(h);
+  atomicSet(&signalled,0U);
+
+  // Messages committed so far
+  w=wtail;
+  atomicThreadFence();
+
+  // Note last message for each target and selector
+  if(coalesce){
+    clearElms(latest,MAXPAIRS);
+    for(r=rtail,n=0; (FXint)(w-r)>0; r+=footprint(pkg.size)){
+      copyOut(ring,r,&pkg,sizeof(FXMessage));
+      l=locate(latest,pkg.target,pkg.message);
+      if(!l->target){
+        if(n>=MAXPAIRS*3/4) continue;
+        l->target=pkg.target;
+        l->message=pkg.message;
+        n++;
+        }
+      l->pos=r;
       }
-    return pkg.target && pkg.target->tryHandle(this,pkg.message,nullptr);
     }
-#else
-  if(::read(h[0],&pkg,sizeof(FXMessage))==sizeof(FXMessage)){
-    if(0<pkg.size && (::read(h[0],pkg.data,pkg.size)==pkg.size)){
-      return pkg.target && pkg.target->tryHandle(this,pkg.message,pkg.data);
+
+  // Deliver messages, freeing their space before calling the handler
+  while((FXint)(w-(r=rtail))>0){
+    copyOut(ring,r,&pkg,sizeof(FXMessage));
+    copyOut(ring,r+sizeof(FXMessage),pkg.data,pkg.size);
+    atomicThreadFence();
+    rtail=r+footprint(pkg.size);
+    if(coalesce){
+      l=locate(latest,pkg.target,pkg.message);
+      if(l->target && l->pos!=r) continue;
       }
-    return pkg.target && pkg.target->tryHandle(this,pkg.message,nullptr);
+    if(pkg.target && pkg.target->tryHandle(this,pkg.message,(0<pkg.size)?pkg.data:nullptr)) result=1;
     }
-#endif
-  return 0;
+  return result;
   }
 
 
 // Send a message to a target
 FXbool FXMessageChannel::message(FXObject* tgt,FXSelector msg,const void* data,FXint size){
-  FXScopedMutex locker(m);
-  FXMessage pkg;
-  pkg.target=tgt;
-  pkg.message=msg;
+  if(__likely(ring)){
+    FXMessage pkg;
+    FXuint need,w;
+    pkg.target=tgt;
+    pkg.message=msg;
 #if !(defined(__LP64__) || defined(_LP64) || (_MIPS_SZLONG == 64) || (__WORDSIZE == 64) || defined(_WIN64))
-  pkg.pad=0;
+    pkg.pad=0;
 #endif
-  pkg.size=FXMIN(size,MAXMESSAGE);
-#if defined(WIN32)
-  DWORD nwritten=-1;
-  if(::WriteFile(h[1],&pkg,sizeof(FXMessage),&nwritten,nullptr) && nwritten==sizeof(FXMessage)){
-    if(pkg.size<=0 || (::WriteFile(h[1],data,pkg.size,&nwritten,nullptr) && nwritten==pkg.size)){
-      ::ReleaseSemaphore(h[2],1,nullptr);
-      return true;
+    pkg.size=data?FXCLAMP(0,size,MAXMESSAGE):0;
+    need=footprint(pkg.size);
+
+    // Reserve space, waiting for reader if ring is full, unless we are the reader
+x:  w=whead;
+    if(__unlikely(RINGSIZE<(w-rtail)+need)){
+      if(FXThread::current()==reader) return false;
+      FXThread::yield();
+      goto x;
       }
-    }
-#else
-  if(::write(h[1],&pkg,sizeof(FXMessage))==sizeof(FXMessage)){
-    if(pkg.size<=0 || (::write(h[1],data,pkg.size)==pkg.size)){		// Write with one call...
-      return true;
+    if(__unlikely(!atomicBoolCas(&whead,w,w+need))) goto x;
+
+    // Copy message in
+    copyIn(ring,w,&pkg,sizeof(FXMessage));
+    copyIn(ring,w+sizeof(FXMessage),data,pkg.size);
+
+    // Commit after earlier writers did
+    while(__unlikely(wtail!=w)){ FXThread::yield(); }
+    atomicThreadFence();
+    wtail=w+need;
+
+    // First message since reader drained the channel rings the doorbell
+    if(atomicSet(&signalled,1U)==0){
+      ringDoorbell(h);
       }
+    return true;
     }
-#endif
   return false;
   }
 
 
 // Remove handler from application
 FXMessageChannel::~FXMessageChannel(){
+  if(ring){
+    app->removeInput(h[0],INPUT_READ);
 #if defined(WIN32)
-  app->removeInput(h[2],INPUT_READ);
-  ::CloseHandle(h[0]);
-  ::CloseHandle(h[1]);
-  ::CloseHandle(h[2]);
+    ::CloseHandle(h[0]);
+#elif defined(HAVE_EVENTFD)
+    ::close(h[0]);
 #else
-  app->removeInput(h[0],INPUT_READ);
-  ::close(h[0]);
-  ::close(h[1]);
+    ::close(h[0]);
+    ::close(h[1]);
 #endif
+    freeElms(ring);
+    }
   app=(FXApp*)-1L;
   }
 
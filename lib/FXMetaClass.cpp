@@ -22,6 +22,7 @@
 #include "fxver.h"
 #include "fxdefs.h"
 #include "fxmath.h"
+#include "FXAtomic.h"
 #include "FXElement.h"
 #include "FXString.h"
 #include "FXMetaClass.h"
@@ -43,8 +44,35 @@
       - No need to recompute it during destruction or growth of hash table.
       - Quick equality test inside getMetaClassFromName().
       - Very minor space penalty.
+  - Message dispatch used to search the message map of the class, then call
+    the base class's handle() to search the next one, and so on up to FXObject.
+    For messages handled far up the hierarchy, like SEL_UPDATE, or not handled
+    at all, this meant linear scans of several message maps.
+  - Now, upon the first message dispatched through a class, its message map and
+    those of all its base classes are flattened into one table of disjoint selector
+    ranges, sorted by selector and covering all possible selectors; each range
+    refers to the message map entry handling it, or to none.  Dispatching is then
+    a binary search of this table, followed by one call.
+  - Most messages are handled by the most derived class, often by one of the first
+    entries of its message map; a linear search of these is cheaper than the binary
+    search and the call through the caller.  So handle() tries the first eight
+    entries of the class's own map directly, as it used to, and only then goes to
+    the flattened table.  The entry found is the same, as the class's own entries
+    take precedence anyway.
+  - The handler of a range is the same one the old search would find: entries of
+    a class take precedence over those of its base classes, and within a message
+    map, the first matching entry wins.
+  - Since message map entries of different classes have different types, each
+    metaclass holds a caller, instantiated by FXIMPLEMENT() for its class, which
+    casts the object and entry back, and calls the handler.
+  - A consequence is that handle() of a class no longer calls its base class's
+    handle(); a hand-written handle() of a class without FXIMPLEMENT() is still
+    called by the virtual call, but skipped by the handle() of derived classes.
+  - The table is built without locking: threads racing to build it each build
+    their own, and all but the first one to install it throw theirs away.
 */
 
+
 #define TOPIC_CONSTRUCT 1000
 
 using namespace FX;
@@ -122,6 +150,22 @@ void fxfree(void** ptr){
 
 /*************************  FXMetaClass Implementation  ************************/
 
+// Range of selectors handled by a message map entry
+struct FXMetaClass::Range {
+  FXSelector         keylo;             // First selector of range
+  FXSelector         keyhi;             // Last selector of range
+  const void        *entry;             // Message map entry, or NULL
+  Caller             caller;            // Calls handler of entry
+  };
+
+
+// Flattened message map
+struct FXMetaClass::Table {
+  FXuint             count;             // Number of ranges
+  Range              ranges[1];         // Ranges, sorted by selector
+  };
+
+
 // Empty but previously used hash table slot
 #define EMPTY   ((const FXMetaClass*)-1L)
 
@@ -155,7 +199,7 @@ void FXMetaClass::resize(FXuint slots){
 
 
 // Constructor adds metaclass to the table
-FXMetaClass::FXMetaClass(const FXchar* name,FXObject *(fac)(),const FXMetaClass* base,const void* ass,FXuint nass,FXuint assz):className(name),manufacture(fac),baseClass(base),assoc(ass),nassocs(nass),assocsz(assz){
+FXMetaClass::FXMetaClass(const FXchar* name,FXObject *(fac)(),const FXMetaClass* base,const void* ass,FXuint nass,FXuint assz,Caller cal):className(name),manufacture(fac),baseClass(base),assoc(ass),nassocs(nass),assocsz(assz),caller(cal),table(nullptr){
   FXTRACE((TOPIC_CONSTRUCT,"FXMetaClass::FXMetaClass(%s)\n",className));
   FXuint p=FXString::hash(className);
   FXuint x=(p<<1)|1;
@@ -183,6 +227,111 @@ const void* FXMetaClass::search(FXSelector key) const {
   }
 
 
+// Compare selectors
+static int compareselectors(const void* a,const void* b){
+  return (*(const FXSelector*)a>*(const FXSelector*)b)-(*(const FXSelector*)a<*(const FXSelector*)b);
+  }
+
+
+// Flatten message maps of this class and its base classes
+const FXMetaClass::Table* FXMetaClass::flatten() const {
+  const FXObject::FXMapEntry* lst;
+  const FXMetaClass *cls;
+  const FXMetaClass **owners;
+  const void **entries;
+  FXSelector *starts;
+  Table *result;
+  FXuint nentries=0;
+  FXuint nstarts=1;
+  FXuint i,j,n;
+
+  // Count entries of all classes
+  for(cls=this; cls; cls=cls->baseClass){
+    nentries+=cls->nassocs;
+    }
+
+  // Entries in order of precedence, and selectors where handler may change
+  allocElms(entries,nentries+1);
+  allocElms(owners,nentries+1);
+  allocElms(starts,nentries+nentries+1);
+  starts[0]=0;
+  for(cls=this,n=0; cls; cls=cls->baseClass){
+    for(i=0,lst=(const FXObject::FXMapEntry*)cls->assoc; i<cls->nassocs; ++i){
+      entries[n]=lst;
+      owners[n]=cls;
+      starts[nstarts++]=lst->keylo;
+      if(lst->keyhi<0xFFFFFFFF) starts[nstarts++]=lst->keyhi+1;
+      lst=(const FXObject::FXMapEntry*) (((const FXchar*)lst)+cls->assocsz);
+      n++;
+      }
+    }
+  ::qsort(starts,nstarts,sizeof(FXSelector),compareselectors);
+
+  // Worst case, each start begins a range
+  fxmalloc((void**)&result,sizeof(Table)+sizeof(Range)*(nstarts-1));
+  result->count=0;
+
+  // Handler of each range is the first entry matching its start; merge
+  // adjacent ranges with the same handler
+  for(i=0; i<nstarts; ++i){
+    if(i && starts[i]==starts[i-1]) continue;
+    for(j=0; j<nentries; ++j){
+      lst=(const FXObject::FXMapEntry*)entries[j];
+      if(lst->keylo<=starts[i] && starts[i]<=lst->keyhi) break;
+      }
+    if(result->count && result->ranges[result->count-1].entry==(j<nentries?entries[j]:nullptr)){
+      continue;
+      }
+    if(result->count){
+      result->ranges[result->count-1].keyhi=starts[i]-1;
+      }
+    result->ranges[result->count].keylo=starts[i];
+    result->ranges[result->count].keyhi=0xFFFFFFFF;
+    result->ranges[result->count].entry=(j<nentries)?entries[j]:nullptr;
+    result->ranges[result->count].caller=(j<nentries)?owners[j]->caller:nullptr;
+    result->count++;
+    }
+  freeElms(starts);
+  freeElms(owners);
+  freeElms(entries);
+
+  // Install table, unless another thread beat us to it
+  if(!atomicBoolCas(&table,(Table*)nullptr,result)){
+    fxfree((void**)&result);
+    }
+  return table;
+  }
+
+
+// Search message maps of this class and its base classes
+const void* FXMetaClass::lookup(FXSelector key) const {
+  const Table* tab=table;
+  if(__unlikely(!tab)) tab=flatten();
+  FXuint l=0,h=tab->count-1,m;
+  while(l<h){
+    m=(l+h+1)>>1;
+    if(key<tab->ranges[m].keylo) h=m-1; else l=m;
+    }
+  return tab->ranges[l].entry;
+  }
+
+
+// Dispatch message to handler, or onDefault() if there is none
+long FXMetaClass::dispatch(FXObject* object,FXObject* sender,FXSelector sel,void* ptr) const {
+  const Table* tab=table;
+  if(__unlikely(!tab)) tab=flatten();
+  FXuint l=0,h=tab->count-1,m;
+  while(l<h){
+    m=(l+h+1)>>1;
+    if(sel<tab->ranges[m].keylo) h=m-1; else l=m;
+    }
+  if(tab->ranges[l].entry){
+    return (*tab->ranges[l].caller)(object,tab->ranges[l].entry,sender,sel,ptr);
+    }
+  return object->onDefault(sender,sel,ptr);
+  }
+
+
 // Test if subclass
 FXbool FXMetaClass::isSubClassOf(const FXMetaClass* metaclass) const {
   const FXMetaClass* cls;
@@ -247,6 +396,7 @@ FXMetaClass::~FXMetaClass(){
   FXTRACE((TOPIC_CONSTRUCT,"FXMetaClass::~FXMetaClass(%s)\n",className));
   FXuint p=FXString::hash(className);
   FXuint x=(p<<1)|1;
+  fxfree((void**)&table);
   while(metaClassTable[p=(p+x)&(metaClassSlots-1)]!=this){
     if(!metaClassTable[p]) return;
     }
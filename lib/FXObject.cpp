@@ -75,7 +75,7 @@ the price is that you either need to say decltype everywhere, or you wrap that i
 
 
 // Have to do this one `by hand' as it has no base class
-const FXMetaClass FXObject::metaClass("FXObject",FXObject::manufacture,nullptr,nullptr,0,0);
+const FXMetaClass FXObject::metaClass("FXObject",FXObject::manufacture,nullptr,nullptr,0,0,nullptr);
 
 
 // Build an object
@@ -0,0 +1,288 @@
+/********************************************************************************
+*                                                                               *
+*                           P i p e l i n e   C l a s s                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "FXElement.h"
+#include "FXArray.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXMutex.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXTaskGroup.h"
+#include "FXPipeline.h"
+
+/*
+  Notes:
+
+  - Each item travels through the pipeline on a token, which is the runnable handed to
+    the thread pool.  A token carries the item, its sequence number, and the index of
+    the stage it is at.  There are as many tokens as the limit passed to run(), allocated
+    up front; a new item can only be started when a token is free.  Thus, memory use is
+    bounded, and a slow final stage throttles the first stage, rather than letting
+    items pile up in between.
+
+  - Only one thread at a time runs the first stage; it claims the right to do so by
+    flipping inputbusy.  After obtaining an item, it releases inputbusy, starts another
+    token if one is free, and then carries its own item on through the following stages.
+    Whoever frees up a token also tries to start a new one.  Since a token may be freed
+    while the first stage runs (and the attempt to start another fails), the thread
+    releasing inputbusy checks again for free tokens afterwards.
+
+  - A serial stage processes only the token whose sequence number is next in line;
+    tokens arriving out of order are parked at the stage.  Having processed its item,
+    a token bumps the stage's next sequence number, and hands the token parked for it,
+    if any, back to the thread pool, before continuing with its own item.
+
+  - Since all tokens from the one being processed by a serial stage up to the most
+    recently started one are still in flight, fewer than limit tokens can be parked at
+    a stage at the same time, and their sequence numbers are all different modulo
+    limit; so each stage simply parks token s in slot s%limit.
+
+  - Parallel stages run the item without any locking at all.
+
+  - When the thread pool does not accept a token, e.g. because it was stopped, the token
+    is added to a list of ready tokens, which the thread adding it runs until none are
+    left, unless another thread is already doing so.  Running the token directly instead would recurse, as the token
+    starts or resumes other tokens, and the stack would grow with the number of items.
+    The list is drained the same way as the task wrappers run tokens: when the group
+    is cancelled, the tokens are dropped.
+
+  - Tokens are run as tasks of a task group, which run() waits for.  When the group is
+    cancelled, the task wrappers drop the tokens on the floor, and the first stage is
+    no longer called; as the tokens are owned by the pipeline, nothing is lost.
+
+  - Possible improvements:
+
+      o A token resumed by a serial stage could be run directly by the thread which
+        released it, trading places with its own token, to keep the serial stage's
+        data in the same cache.
+*/
+
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Token carrying an item through the pipeline
+class FXPipeline::Token : public FXRunnable {
+public:
+  FXPipeline *pipeline;         // Pipeline it belongs to
+  FXptr       item;             // Item being processed
+  FXulong     seq;              // Sequence number of item
+  FXint       stage;            // Stage token is at
+public:
+  Token():pipeline(nullptr),item(nullptr),seq(0),stage(0){ }
+  virtual FXint run(){ pipeline->advance(this); return 0; }
+  };
+
+
+// Create stage
+FXPipeline::Stage::Stage(Mode m):parked(nullptr),next(0),mode(m){
+  }
+
+
+// Destroy stage
+FXPipeline::Stage::~Stage(){
+  }
+
+
+// Create pipeline
+FXPipeline::FXPipeline():threadpool(FXThreadPool::instance()),group(nullptr),tokens(nullptr),freetokens(nullptr),readytokens(nullptr),nfree(0),nready(0),draining(0),inputbusy(0),exhausted(0),limit(0),sequence(0),processed(0){
+  if(!threadpool){ fxerror("FXPipeline::FXPipeline: No thread pool was set."); }
+  }
+
+
+// Create pipeline
+FXPipeline::FXPipeline(FXThreadPool* p):threadpool(p),group(nullptr),tokens(nullptr),freetokens(nullptr),readytokens(nullptr),nfree(0),nready(0),draining(0),inputbusy(0),exhausted(0),limit(0),sequence(0),processed(0){
+  if(!threadpool){ fxerror("FXPipeline::FXPipeline: No thread pool was set."); }
+  }
+
+
+// Append stage
+void FXPipeline::append(Stage* stage){
+  if(group){ fxerror("FXPipeline::append: pipeline is running.\n"); }
+  stages.append(stage);
+  }
+
+
+// Hand token to the thread pool; if that fails, add it to the ready tokens,
+// which are run by this thread unless another is already running them
+void FXPipeline::spawn(Token* token){
+  if(!group->execute(token)){
+    mutex.lock();
+    readytokens[nready++]=token;
+    if(!draining){
+      draining=1;
+      while(0<nready){
+        token=readytokens[--nready];
+        mutex.unlock();
+        if(!group->isCancelled()) token->run();
+        mutex.lock();
+        }
+      draining=0;
+      }
+    mutex.unlock();
+    }
+  }
+
+
+// Start new items while tokens are free and the input lasts
+void FXPipeline::pump(){
+  while(!exhausted && !group->isCancelled() && atomicBoolCas(&inputbusy,0U,1U)){
+    Token* token=nullptr;
+    mutex.lock();
+    if(0<nfree){ token=freetokens[--nfree]; }
+    mutex.unlock();
+    if(token){
+      token->stage=0;
+      spawn(token);
+      return;
+      }
+    atomicSet(&inputbusy,0U);
+    if(atomicAdd(&nfree,0U)==0) return;
+    }
+  }
+
+
+// Move token through the stages
+void FXPipeline::advance(Token* token){
+
+  // First stage produces the item; it holds inputbusy
+  if(token->stage==0){
+    token->item=stages[0]->process(nullptr);
+    if(!token->item){
+      exhausted=1;
+      atomicSet(&inputbusy,0U);
+      retire(token);
+      return;
+      }
+    token->seq=sequence++;
+    token->stage=1;
+    atomicSet(&inputbusy,0U);
+    pump();
+    }
+
+  // Following stages
+  while(token->stage<stages.no()){
+    Stage* stage=stages[token->stage];
+    if(stage->mode==Serial){
+      Token* resume=nullptr;
+      stage->mutex.lock();
+      if(token->seq!=stage->next){
+        stage->parked[token->seq%limit]=token;
+        stage->mutex.unlock();
+        return;
+        }
+      stage->mutex.unlock();
+      token->item=stage->process(token->item);
+      stage->mutex.lock();
+      stage->next++;
+      resume=stage->parked[stage->next%limit];
+      if(resume && resume->seq==stage->next){
+        stage->parked[stage->next%limit]=nullptr;
+        }
+      else{
+        resume=nullptr;
+        }
+      stage->mutex.unlock();
+      if(resume) spawn(resume);
+      }
+    else{
+      token->item=stage->process(token->item);
+      }
+    token->stage++;
+    }
+  atomicAdd(&processed,FXulong(1));
+  retire(token);
+  }
+
+
+// Return token to the free list, and start another item
+void FXPipeline::retire(Token* token){
+  token->item=nullptr;
+  mutex.lock();
+  freetokens[nfree++]=token;
+  mutex.unlock();
+  pump();
+  }
+
+
+// Run pipeline with given number of tokens
+FXulong FXPipeline::run(FXuint ntokens){
+  if(group){ fxerror("FXPipeline::run: pipeline is already running.\n"); }
+  processed=0;
+  if(0<stages.no()){
+    FXTaskGroup taskgroup(threadpool);
+    FXint s;
+    FXuint t;
+    limit=FXMAX(ntokens,1);
+    tokens=new Token[limit];
+    freetokens=new Token*[limit];
+    readytokens=new Token*[limit];
+    for(t=0; t<limit; ++t){
+      tokens[t].pipeline=this;
+      freetokens[t]=&tokens[limit-t-1];
+      }
+    for(s=0; s<stages.no(); ++s){
+      stages[s]->next=0;
+      if(0<s && stages[s]->mode==Serial){
+        callocElms(stages[s]->parked,limit);
+        }
+      }
+    nfree=limit;
+    nready=0;
+    draining=0;
+    inputbusy=0;
+    exhausted=0;
+    sequence=0;
+    group=&taskgroup;
+    pump();
+    taskgroup.wait();
+    group=nullptr;
+    for(s=0; s<stages.no(); ++s){
+      freeElms(stages[s]->parked);
+      }
+    delete [] readytokens;
+    delete [] freetokens;
+    delete [] tokens;
+    readytokens=nullptr;
+    freetokens=nullptr;
+    tokens=nullptr;
+    }
+  return processed;
+  }
+
+
+// Destroy pipeline
+FXPipeline::~FXPipeline(){
+  }
+
+}
@@ -0,0 +1,1686 @@
+/********************************************************************************
+*                                                                               *
+*                        P i x e l   B u f f e r   O b j e c t                  *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "FXElement.h"
+#include "FXArray.h"
+#include "FXPtrList.h"
+#include "FXAtomic.h"
+#include "FXMutex.h"
+#include "FXSemaphore.h"
+#include "FXCompletion.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXLFQueue.h"
+#include "FXThreadPool.h"
+#include "FXTaskGroup.h"
+#include "FXParallel.h"
+#include "FXPixelBuffer.h"
+
+
+/*
+  Notes:
+  - The pixel algorithms used to live in FXImage; they're here so they can be
+    used, tested, and timed without an application or display.
+  - Operations are split into bands of rows, each of about BANDPIXELS pixels; the
+    vertical scale and shear work down the columns, and are split into bands of
+    columns instead.  With a thread pool, FXParallelFor processes the bands in
+    parallel; the bands are independent, so the result is the same either way.
+  - The 90 and 270 degree rotations read down the columns of the source; they're
+    done in square tiles of TILESIZE pixels, so the cache lines of a tile's source
+    columns are reused by the next rows of the tile, instead of being fetched again
+    for each row.  The 180 degree rotation and the mirrors stream through whole
+    rows, and don't need this.
+  - The smooth scaling algorithm is based on the idea of keeping track which
+    pixels of the source are contributing to each pixel in the destination;
+    see notes in FXImage.cpp.
+  - Mitchell and Lanczos scaling use separable filters, with 14-bit fixed point
+    weights precomputed for each destination row and column.  When reducing, the
+    filter is stretched over all source pixels under the destination pixel, so
+    there is no aliasing; reductions by a factor of 4 or more first average
+    blocks of pixels, an integer factor in each direction, to keep the filters short.
+    The factor divides the source size, so every block is whole, and the filters
+    see the same geometry as they would for the original pixels.
+    The horizontal pass interleaves two source pixels and the vertical pass two
+    source rows, so one SSE2 multiply-add applies two taps to all four channels.
+  - Compositing premultiplies a chunk of source and destination pixels, applies the
+    Porter-Duff operator, and unpremultiplies the result back into the destination;
+    all three steps work on four pixels at a time with SSE2.  Alpha is divided out
+    in single precision float, which is exact enough to round correctly.
+*/
+
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Pixels per band processed in parallel
+const FXint BANDPIXELS=65536;
+
+// Size of tiles of rotations
+const FXint TILESIZE=32;
+
+
+// Run fun(lo,hi) over the range [0,n) of rows or columns of len pixels each,
+// split into bands of about BANDPIXELS pixels; the bands are processed in
+// parallel if the calling thread has a thread pool
+template<typename Functor>
+static void bands(FXint n,FXint len,const Functor& fun){
+  FXThreadPool* pool=FXThreadPool::instance();
+  FXint by=FXMAX(BANDPIXELS/FXMAX(len,1),1);
+  if(pool && by<n){
+    FXParallelFor(pool,0,n,by,[&](FXint lo){ fun(lo,FXMIN(lo+by,n)); });
+    return;
+    }
+  fun(0,n);
+  }
+
+
+// Construct empty pixel buffer
+FXPixelBuffer::FXPixelBuffer():data(nullptr),width(0),height(0),owned(false){
+  }
+
+
+// Construct pixel buffer of given size
+FXPixelBuffer::FXPixelBuffer(FXint w,FXint h):data(nullptr),width(0),height(0),owned(false){
+  resize(w,h);
+  }
+
+
+// Construct pixel buffer around existing pixels
+FXPixelBuffer::FXPixelBuffer(FXColor* pix,FXint w,FXint h,FXbool own):data(pix),width(w),height(h),owned(own){
+  }
+
+
+// Change pixels
+void FXPixelBuffer::setData(FXColor* pix,FXint w,FXint h,FXbool own){
+  if(owned && data!=pix){ freeElms(data); }
+  data=pix;
+  width=w;
+  height=h;
+  owned=own;
+  }
+
+
+// Resize buffer; contents become undefined
+FXbool FXPixelBuffer::resize(FXint w,FXint h){
+  if(w<1) w=1;
+  if(h<1) h=1;
+  if(!owned){
+    FXColor* pix;
+    if(!allocElms(pix,(FXuval)w*h)) return false;
+    data=pix;
+    owned=true;
+    }
+  else if(w*h!=width*height){
+    if(!resizeElms(data,(FXuval)w*h)) return false;
+    }
+  width=w;
+  height=h;
+  return true;
+  }
+
+
+// Give up the pixels
+FXColor* FXPixelBuffer::release(){
+  FXColor* pix=data;
+  data=nullptr;
+  width=0;
+  height=0;
+  owned=false;
+  return pix;
+  }
+
+
+// Swap contents with another buffer
+void FXPixelBuffer::swap(FXPixelBuffer& other){
+  FXColor* pix=data; data=other.data; other.data=pix;
+  FXint w=width; width=other.width; other.width=w;
+  FXint h=height; height=other.height; other.height=h;
+  FXbool own=owned; owned=other.owned; other.owned=own;
+  }
+
+/*******************************************************************************/
+
+// Gamma-corrected image scaling.
+// In a nutshell: convert pixel value to intensities, scale, then convert
+// them back to pixel value:
+//
+//      I = pow(P,2.2)
+//      P = pow(I,1/2.2)
+//
+// Reference: http://www.ericbrasseur.org/gamma.html
+// At some future time this should be based around the gamma used in
+// FXVisual; this means generating the table at run time.
+
+// Table lookup: y=pow(x,2.2)
+static const FXuint gammatable[256]={
+       0,     1,     4,    11,    21,    34,    51,    72,
+      97,   125,   158,   195,   236,   282,   332,   386,
+     445,   509,   577,   650,   728,   810,   898,   990,
+    1087,  1189,  1297,  1409,  1526,  1649,  1776,  1909,
+    2048,  2191,  2340,  2494,  2653,  2818,  2988,  3164,
+    3346,  3532,  3725,  3923,  4126,  4335,  4550,  4771,
+    4997,  5229,  5466,  5710,  5959,  6214,  6475,  6742,
+    7014,  7293,  7577,  7868,  8164,  8466,  8775,  9089,
+    9410,  9736, 10069, 10407, 10752, 11103, 11460, 11824,
+   12193, 12569, 12951, 13339, 13733, 14134, 14541, 14954,
+   15374, 15800, 16232, 16671, 17116, 17567, 18025, 18490,
+   18961, 19438, 19922, 20412, 20908, 21412, 21922, 22438,
+   22961, 23490, 24026, 24569, 25118, 25674, 26237, 26806,
+   27382, 27965, 28554, 29150, 29753, 30362, 30978, 31601,
+   32231, 32867, 33511, 34161, 34818, 35482, 36152, 36830,
+   37514, 38205, 38903, 39608, 40320, 41039, 41765, 42497,
+   43237, 43984, 44737, 45498, 46266, 47040, 47822, 48610,
+   49406, 50209, 51019, 51836, 52660, 53491, 54329, 55174,
+   56027, 56886, 57753, 58627, 59508, 60396, 61291, 62194,
+   63103, 64020, 64944, 65876, 66815, 67760, 68714, 69674,
+   70642, 71617, 72599, 73588, 74585, 75590, 76601, 77620,
+   78646, 79680, 80721, 81769, 82825, 83888, 84958, 86036,
+   87122, 88214, 89314, 90422, 91537, 92660, 93790, 94927,
+   96072, 97224, 98384, 99552,100727,101909,103099,104297,
+  105502,106715,107935,109163,110398,111641,112892,114150,
+  115415,116689,117970,119259,120555,121859,123170,124490,
+  125817,127151,128493,129843,131201,132566,133940,135320,
+  136709,138105,139509,140921,142340,143768,145203,146646,
+  148096,149555,151021,152495,153977,155466,156964,158469,
+  159982,161503,163032,164569,166114,167666,169226,170795,
+  172371,173955,175547,177147,178754,180370,181994,183625,
+  185265,186912,188568,190231,191902,193582,195269,196964
+  };
+
+
+static FXuint gammaLookup(FXuint i){
+  return gammatable[i];
+  }
+
+
+static FXuint gammaInvertLookup(FXuint val){
+  FXint mid,low=0,high=255;
+  while((high-low)>1){
+    mid=low+(high-low)/2;
+    if(val<gammatable[mid])
+      high=mid;
+    else
+      low=mid;
+    }
+  return (gammatable[high]==val) ? high : low;
+  }
+
+
+// Horizontal box-filtered, gamma-corrected
+static void hscalergbagamma(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw){
+  FXint fin,fout,ar,ag,ab,aa;
+  FXint ss=4*sw;
+  FXint ds=4*dw;
+  FXuchar *end=dst+ds*dh;
+  FXuchar *d;
+  const FXuchar *s;
+  do{
+    s=src; src+=ss;
+    d=dst; dst+=ds;
+    fin=dw;
+    fout=sw;
+    ar=ag=ab=aa=0;
+    while(1){
+      if(fin<fout){
+        aa+=fin*s[3];
+        ar+=fin*gammaLookup(s[2]);
+        ag+=fin*gammaLookup(s[1]);
+        ab+=fin*gammaLookup(s[0]);
+        fout-=fin;
+        fin=dw;
+        s+=4;
+        }
+      else{
+        aa+=fout*s[3];              d[3]=aa/sw;
+        ar+=fout*gammaLookup(s[2]); d[2]=gammaInvertLookup(ar/sw);
+        ag+=fout*gammaLookup(s[1]); d[1]=gammaInvertLookup(ag/sw);
+        ab+=fout*gammaLookup(s[0]); d[0]=gammaInvertLookup(ab/sw);
+        ar=ag=ab=aa=0;
+        fin-=fout;
+        fout=sw;
+        d+=4;
+        if(d>=dst) break;
+        }
+      }
+    }
+  while(dst<end);
+  }
+
+
+// Vertical box-filtered, gamma-corrected, for nc columns of rows dw pixels wide
+static void vscalergbagamma(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint nc,FXint sh){
+  FXint fin,fout,ar,ag,ab,aa;
+  FXint ss=4*dw;
+  FXint ds=4*dw;
+  FXint dss=ds*dh;
+  FXuchar *end=dst+4*nc;
+  FXuchar *d,*dd;
+  const FXuchar *s;
+  do{
+    s=src; src+=4;
+    d=dst; dst+=4;
+    dd=d+dss;
+    fin=dh;
+    fout=sh;
+    ar=ag=ab=aa=0;
+    while(1){
+      if(fin<fout){
+        aa+=fin*s[3];
+        ar+=fin*gammaLookup(s[2]);
+        ag+=fin*gammaLookup(s[1]);
+        ab+=fin*gammaLookup(s[0]);
+        fout-=fin;
+        fin=dh;
+        s+=ss;
+        }
+      else{
+        aa+=fout*s[3];              d[3]=aa/sh;
+        ar+=fout*gammaLookup(s[2]); d[2]=gammaInvertLookup(ar/sh);
+        ag+=fout*gammaLookup(s[1]); d[1]=gammaInvertLookup(ag/sh);
+        ab+=fout*gammaLookup(s[0]); d[0]=gammaInvertLookup(ab/sh);
+        ar=ag=ab=aa=0;
+        fin-=fout;
+        fout=sh;
+        d+=ds;
+        if(d>=dd) break;
+        }
+      }
+    }
+  while(dst<end);
+  }
+
+
+// Horizontal box-filtered
+static void hscalergba(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint sw){
+  FXint fin,fout,ar,ag,ab,aa;
+  FXint ss=4*sw;
+  FXint ds=4*dw;
+  FXuchar *end=dst+ds*dh;
+  FXuchar *d;
+  const FXuchar *s;
+  do{
+    s=src; src+=ss;
+    d=dst; dst+=ds;
+    fin=dw;
+    fout=sw;
+    ar=ag=ab=aa=0;
+    while(1){
+      if(fin<fout){
+        aa+=fin*s[3];
+        ar+=fin*s[2];
+        ag+=fin*s[1];
+        ab+=fin*s[0];
+        fout-=fin;
+        fin=dw;
+        s+=4;
+        }
+      else{
+        aa+=fout*s[3]; d[3]=aa/sw; aa=0;
+        ar+=fout*s[2]; d[2]=ar/sw; ar=0;
+        ag+=fout*s[1]; d[1]=ag/sw; ag=0;
+        ab+=fout*s[0]; d[0]=ab/sw; ab=0;
+        fin-=fout;
+        fout=sw;
+        d+=4;
+        if(d>=dst) break;
+        }
+      }
+    }
+  while(dst<end);
+  }
+
+
+// Vertical box-filtered, for nc columns of rows dw pixels wide
+static void vscalergba(FXuchar *dst,const FXuchar* src,FXint dw,FXint dh,FXint nc,FXint sh){
+  FXint fin,fout,ar,ag,ab,aa;
+  FXint ss=4*dw;
+  FXint ds=4*dw;
+  FXint dss=ds*dh;
+  FXuchar *end=dst+4*nc;
+  FXuchar *d,*dd;
+  const FXuchar *s;
+  do{
+    s=src; src+=4;
+    d=dst; dst+=4;
+    dd=d+dss;
+    fin=dh;
+    fout=sh;
+    ar=ag=ab=aa=0;
+    while(1){
+      if(fin<fout){
+        aa+=fin*s[3];
+        ar+=fin*s[2];
+        ag+=fin*s[1];
+        ab+=fin*s[0];
+        fout-=fin;
+        fin=dh;
+        s+=ss;
+        }
+      else{
+        aa+=fout*s[3]; d[3]=aa/sh; aa=0;
+        ar+=fout*s[2]; d[2]=ar/sh; ar=0;
+        ag+=fout*s[1]; d[1]=ag/sh; ag=0;
+        ab+=fout*s[0]; d[0]=ab/sh; ab=0;
+        fin-=fout;
+        fout=sh;
+        d+=ds;
+        if(d>=dd) break;
+        }
+      }
+    }
+  while(dst<end);
+  }
+
+
+// Simple nearest neighbor scaling of rows [lo,hi); fast but ugly
+static void scalenearest(FXColor *dst,const FXColor* src,FXint dw,FXint dh,FXint sw,FXint sh,FXint lo,FXint hi){
+  FXint xs=(sw<<16)/dw;
+  FXint ys=(sh<<16)/dh;
+  FXint i,j,x,y;
+  const FXColor *q;
+  FXColor *p;
+  i=lo;
+  y=(ys>>1)+lo*ys;
+  p=dst+lo*dw;
+  do{
+    j=0;
+    x=xs>>1;
+    q=src+(y>>16)*sw;
+    do{
+      p[j]=q[x>>16];
+      x+=xs;
+      }
+    while(++j<dw);
+    p+=dw;
+    y+=ys;
+    }
+  while(++i<hi);
+  }
+
+
+// Mitchell-Netravali cubic filter, B=C=1/3; support 2
+static FXdouble mitchell(FXdouble x){
+  const FXdouble B=1.0/3.0;
+  const FXdouble C=1.0/3.0;
+  x=Math::fabs(x);
+  if(x<1.0) return ((12.0-9.0*B-6.0*C)*x*x*x+(-18.0+12.0*B+6.0*C)*x*x+(6.0-2.0*B))/6.0;
+  if(x<2.0) return ((-B-6.0*C)*x*x*x+(6.0*B+30.0*C)*x*x+(-12.0*B-48.0*C)*x+(8.0*B+24.0*C))/6.0;
+  return 0.0;
+  }
+
+
+// Lanczos windowed sinc filter; support 3
+static FXdouble lanczos3(FXdouble x){
+  x=Math::fabs(x);
+  if(x<1.0E-9) return 1.0;
+  if(x<3.0) return 3.0*Math::sin(PI*x)*Math::sin(PI*x/3.0)/(PI*PI*x*x);
+  return 0.0;
+  }
+
+
+// Fixed point precision of filter weights
+const FXint WEIGHTBITS=14;
+const FXint WEIGHTONE=1<<WEIGHTBITS;
+const FXint WEIGHTHALF=1<<(WEIGHTBITS-1);
+
+
+// Filter table for resampling one dimension from sn to dn pixels; destination
+// pixel i is the weighted sum of ntaps source pixels, starting at start[i]
+struct FilterTable {
+  FXint   *start;       // First source pixel of each destination pixel
+  FXshort *weight;      // Weights, ntaps per destination pixel
+  FXint    ntaps;       // Number of taps
+  FilterTable():start(nullptr),weight(nullptr),ntaps(0){ }
+  FXbool init(FXint dn,FXint sn,FXint quality);
+ ~FilterTable(){ freeElms(start); freeElms(weight); }
+  };
+
+
+// Build filter table; when reducing, the filter is stretched to cover the
+// source pixels which fall under each destination pixel.  Taps outside of
+// the source are folded onto the edge pixels, and the weights of each
+// destination pixel are rounded so they sum exactly to one.
+FXbool FilterTable::init(FXint dn,FXint sn,FXint quality){
+  FXdouble (*kernel)(FXdouble)=(quality==3)?mitchell:lanczos3;
+  FXdouble radius=(quality==3)?2.0:3.0;
+  FXdouble factor=(FXdouble)dn/(FXdouble)sn;
+  FXdouble stretch=FXMAX(1.0/factor,1.0);
+  FXdouble support=radius*stretch;
+  FXdouble center,total,*acc;
+  FXint i,j,k,lo,hi,st,sum,big;
+  ntaps=FXMIN((FXint)Math::ceil(2.0*support)+1,sn);
+  if(!allocElms(start,dn)) return false;
+  if(!callocElms(weight,dn*ntaps)) return false;
+  if(!allocElms(acc,ntaps)) return false;
+  for(i=0; i<dn; ++i){
+    center=(i+0.5)/factor-0.5;
+    lo=(FXint)Math::floor(center-support)+1;
+    hi=(FXint)Math::floor(center+support);
+    st=FXCLAMP(0,lo,sn-ntaps);
+    clearElms(acc,ntaps);
+    total=0.0;
+    for(j=lo; j<=hi; ++j){
+      k=FXCLAMP(0,j,sn-1)-st;
+      acc[k]+=kernel((j-center)/stretch);
+      total+=kernel((j-center)/stretch);
+      }
+    for(k=0,sum=0,big=0; k<ntaps; ++k){
+      weight[i*ntaps+k]=(FXshort)Math::lrint(acc[k]*WEIGHTONE/total);
+      sum+=weight[i*ntaps+k];
+      if(FXABS(weight[i*ntaps+k])>FXABS(weight[i*ntaps+big])) big=k;
+      }
+    weight[i*ntaps+big]+=WEIGHTONE-sum;
+    start[i]=st;
+    }
+  freeElms(acc);
+  return true;
+  }
+
+
+// Shrink rows [lo,hi) of dst by averaging blocks of kx by ky pixels of src,
+// which is sw pixels wide; kx and ky divide the source width and height
+static void shrinkbox(FXColor* dst,const FXColor* src,FXint sw,FXint mw,FXint kx,FXint ky,FXint lo,FXint hi){
+  const FXuint n=kx*ky;
+  FXint x,y,xx,yy;
+  FXuint r,g,b,a;
+  const FXuchar *s;
+  FXuchar *d;
+  for(y=lo; y<hi; ++y){
+    d=(FXuchar*)(dst+y*mw);
+    for(x=0; x<mw; ++x){
+      r=g=b=a=0;
+      for(yy=y*ky; yy<y*ky+ky; ++yy){
+        s=(const FXuchar*)(src+yy*sw);
+        for(xx=x*kx; xx<x*kx+kx; ++xx){
+          a+=s[4*xx+3];
+          r+=s[4*xx+2];
+          g+=s[4*xx+1];
+          b+=s[4*xx+0];
+          }
+        }
+      d[3]=(a+n/2)/n;
+      d[2]=(r+n/2)/n;
+      d[1]=(g+n/2)/n;
+      d[0]=(b+n/2)/n;
+      d+=4;
+      }
+    }
+  }
+
+
+// Clamp filtered channel to 0..255
+static inline FXuchar clampchannel(FXint v){
+  v=(v+WEIGHTHALF)>>WEIGHTBITS;
+  return (FXuchar)FXCLAMP(0,v,255);
+  }
+
+
+// Filter rows [lo,hi) horizontally from sw to dw pixels
+static void hresample(FXColor* dst,const FXColor* src,FXint dw,FXint sw,const FilterTable& f,FXint lo,FXint hi){
+  const FXint ntaps=f.ntaps;
+  const FXshort *w;
+  const FXColor *s;
+  FXColor *d;
+  FXint x,y,t;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i half=_mm_set1_epi32(WEIGHTHALF);
+  __m128i acc,pix,wgt;
+#else
+  const FXuchar *p;
+  FXuchar *q;
+  FXint r,g,b,a;
+#endif
+  for(y=lo; y<hi; ++y){
+    d=dst+y*dw;
+    for(x=0; x<dw; ++x){
+      s=src+y*sw+f.start[x];
+      w=f.weight+x*ntaps;
+#if defined(FOX_HAS_SSE2)
+      acc=zero;
+      for(t=0; t+1<ntaps; t+=2){        // Two taps at a time: interleave pixels, multiply-add pairs
+        pix=_mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(s[t]),_mm_cvtsi32_si128(s[t+1])),zero);
+        wgt=_mm_set1_epi32((FXint)(((FXuint)(FXushort)w[t+1]<<16)|(FXushort)w[t]));
+        acc=_mm_add_epi32(acc,_mm_madd_epi16(pix,wgt));
+        }
+      if(t<ntaps){
+        pix=_mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(s[t]),zero),zero);
+        wgt=_mm_set1_epi32((FXushort)w[t]);
+        acc=_mm_add_epi32(acc,_mm_madd_epi16(pix,wgt));
+        }
+      acc=_mm_srai_epi32(_mm_add_epi32(acc,half),WEIGHTBITS);
+      acc=_mm_packs_epi32(acc,acc);
+      d[x]=(FXColor)_mm_cvtsi128_si32(_mm_packus_epi16(acc,acc));
+#else
+      r=g=b=a=0;
+      for(t=0; t<ntaps; ++t){
+        p=(const FXuchar*)(s+t);
+        a+=p[3]*w[t];
+        r+=p[2]*w[t];
+        g+=p[1]*w[t];
+        b+=p[0]*w[t];
+        }
+      q=(FXuchar*)(d+x);
+      q[3]=clampchannel(a);
+      q[2]=clampchannel(r);
+      q[1]=clampchannel(g);
+      q[0]=clampchannel(b);
+#endif
+      }
+    }
+  }
+
+
+// Filter rows [lo,hi) of dst vertically; rows are w pixels wide
+static void vresample(FXColor* dst,const FXColor* src,FXint w,const FilterTable& f,FXint lo,FXint hi){
+  const FXint ntaps=f.ntaps;
+  const FXshort *wt;
+  const FXColor *s;
+  const FXuchar *p;
+  FXuchar *d;
+  FXint x,y,t,r,g,b,a;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i half=_mm_set1_epi32(WEIGHTHALF);
+  __m128i a0,a1,a2,a3,r0,r1,l8,h8,wgt;
+#endif
+  for(y=lo; y<hi; ++y){
+    s=src+f.start[y]*w;
+    wt=f.weight+y*ntaps;
+    x=0;
+#if defined(FOX_HAS_SSE2)
+    for(; x+4<=w; x+=4){                // Four pixels at a time, two rows at a time
+      a0=a1=a2=a3=zero;
+      for(t=0; t+1<ntaps; t+=2){
+        r0=_mm_loadu_si128((const __m128i*)(s+t*w+x));
+        r1=_mm_loadu_si128((const __m128i*)(s+(t+1)*w+x));
+        wgt=_mm_set1_epi32((FXint)(((FXuint)(FXushort)wt[t+1]<<16)|(FXushort)wt[t]));
+        l8=_mm_unpacklo_epi8(r0,r1);
+        h8=_mm_unpackhi_epi8(r0,r1);
+        a0=_mm_add_epi32(a0,_mm_madd_epi16(_mm_unpacklo_epi8(l8,zero),wgt));
+        a1=_mm_add_epi32(a1,_mm_madd_epi16(_mm_unpackhi_epi8(l8,zero),wgt));
+        a2=_mm_add_epi32(a2,_mm_madd_epi16(_mm_unpacklo_epi8(h8,zero),wgt));
+        a3=_mm_add_epi32(a3,_mm_madd_epi16(_mm_unpackhi_epi8(h8,zero),wgt));
+        }
+      if(t<ntaps){
+        r0=_mm_loadu_si128((const __m128i*)(s+t*w+x));
+        wgt=_mm_set1_epi32((FXushort)wt[t]);
+        l8=_mm_unpacklo_epi8(r0,zero);
+        h8=_mm_unpackhi_epi8(r0,zero);
+        a0=_mm_add_epi32(a0,_mm_madd_epi16(_mm_unpacklo_epi8(l8,zero),wgt));
+        a1=_mm_add_epi32(a1,_mm_madd_epi16(_mm_unpackhi_epi8(l8,zero),wgt));
+        a2=_mm_add_epi32(a2,_mm_madd_epi16(_mm_unpacklo_epi8(h8,zero),wgt));
+        a3=_mm_add_epi32(a3,_mm_madd_epi16(_mm_unpackhi_epi8(h8,zero),wgt));
+        }
+      a0=_mm_srai_epi32(_mm_add_epi32(a0,half),WEIGHTBITS);
+      a1=_mm_srai_epi32(_mm_add_epi32(a1,half),WEIGHTBITS);
+      a2=_mm_srai_epi32(_mm_add_epi32(a2,half),WEIGHTBITS);
+      a3=_mm_srai_epi32(_mm_add_epi32(a3,half),WEIGHTBITS);
+      _mm_storeu_si128((__m128i*)(dst+y*w+x),_mm_packus_epi16(_mm_packs_epi32(a0,a1),_mm_packs_epi32(a2,a3)));
+      }
+#endif
+    for(; x<w; ++x){
+      r=g=b=a=0;
+      for(t=0; t<ntaps; ++t){
+        p=(const FXuchar*)(s+t*w+x);
+        a+=p[3]*wt[t];
+        r+=p[2]*wt[t];
+        g+=p[1]*wt[t];
+        b+=p[0]*wt[t];
+        }
+      d=(FXuchar*)(dst+y*w+x);
+      d[3]=clampchannel(a);
+      d[2]=clampchannel(r);
+      d[1]=clampchannel(g);
+      d[0]=clampchannel(b);
+      }
+    }
+  }
+
+
+// Largest divisor of n no larger than k
+static FXint divisor(FXint n,FXint k){
+  while(n%k) --k;
+  return k;
+  }
+
+
+// Resample using separable filter; large reductions are first shrunk by
+// an integer factor using a box filter, so the filters stay short
+static FXbool resample(FXColor* dst,const FXColor* src,FXint dw,FXint dh,FXint sw,FXint sh,FXint quality){
+  FXint kx=divisor(sw,FXMAX(sw/(2*dw),1));
+  FXint ky=divisor(sh,FXMAX(sh/(2*dh),1));
+  FXint mw=sw/kx;
+  FXint mh=sh/ky;
+  FXColor *shrunk=nullptr;
+  FXColor *interim=nullptr;
+  FilterTable hf,vf;
+  FXbool ok=false;
+
+  // Shrink by integer factor first
+  if(1<kx || 1<ky){
+    if(!allocElms(shrunk,mw*mh)) goto x;
+    bands(mh,mw*kx*ky,[&](FXint lo,FXint hi){ shrinkbox(shrunk,src,sw,mw,kx,ky,lo,hi); });
+    src=shrunk;
+    }
+
+  // Horizontal pass into interim buffer
+  if(dw!=mw){
+    if(!hf.init(dw,mw,quality)) goto x;
+    if(!allocElms(interim,dw*mh)) goto x;
+    bands(mh,dw*hf.ntaps,[&](FXint lo,FXint hi){ hresample(interim,src,dw,mw,hf,lo,hi); });
+    src=interim;
+    }
+
+  // Vertical pass into destination
+  if(dh!=mh){
+    if(!vf.init(dh,mh,quality)) goto x;
+    bands(dh,dw*vf.ntaps,[&](FXint lo,FXint hi){ vresample(dst,src,dw,vf,lo,hi); });
+    }
+  else{
+    copyElms(dst,src,dw*dh);
+    }
+  ok=true;
+x:freeElms(interim);
+  freeElms(shrunk);
+  return ok;
+  }
+
+
+// Scale into other buffer
+FXbool FXPixelBuffer::scale(FXPixelBuffer& dst,FXint quality) const {
+  if(data && dst.data){
+    const FXint sw=width;
+    const FXint sh=height;
+    const FXint dw=dst.width;
+    const FXint dh=dst.height;
+    FXColor *interim;
+
+    // Same size
+    if(dw==sw && dh==sh){
+      copyElms(dst.data,data,sw*sh);
+      return true;
+      }
+
+    switch(quality){
+      case 0:           // Fast but ugly scale
+        bands(dh,dw,[&](FXint lo,FXint hi){ scalenearest(dst.data,data,dw,dh,sw,sh,lo,hi); });
+        break;
+      case 3:           // Mitchell filtered scale
+      case 4:           // Lanczos filtered scale
+        if(!resample(dst.data,data,dw,dh,sw,sh,quality)) return false;
+        break;
+      case 1:           // Slower box filtered scale
+      case 2:           // Slow gamma corrected scale
+      default:
+
+        // Allocate interim buffer
+        if(!allocElms(interim,dw*sh)) return false;
+
+        // Scale horizontally first, placing result into interim buffer
+        if(dw==sw){
+          copyElms(interim,data,dw*sh);
+          }
+        else if(quality==1){
+          bands(sh,dw,[&](FXint lo,FXint hi){ hscalergba((FXuchar*)(interim+lo*dw),(const FXuchar*)(data+lo*sw),dw,hi-lo,sw); });
+          }
+        else{
+          bands(sh,dw,[&](FXint lo,FXint hi){ hscalergbagamma((FXuchar*)(interim+lo*dw),(const FXuchar*)(data+lo*sw),dw,hi-lo,sw); });
+          }
+
+        // Scale vertically from the interim buffer into target buffer
+        if(dh==sh){
+          copyElms(dst.data,interim,dw*dh);
+          }
+        else if(quality==1){
+          bands(dw,dh,[&](FXint lo,FXint hi){ vscalergba((FXuchar*)(dst.data+lo),(const FXuchar*)(interim+lo),dw,dh,hi-lo,sh); });
+          }
+        else{
+          bands(dw,dh,[&](FXint lo,FXint hi){ vscalergbagamma((FXuchar*)(dst.data+lo),(const FXuchar*)(interim+lo),dw,dh,hi-lo,sh); });
+          }
+
+        // Free interim buffer
+        freeElms(interim);
+        break;
+      }
+    }
+  return true;
+  }
+
+
+// Scale to given size
+FXbool FXPixelBuffer::scale(FXint w,FXint h,FXint quality){
+  if(w<1) w=1;
+  if(h<1) h=1;
+  if(data && (w!=width || h!=height)){
+    FXPixelBuffer result(w,h);
+    if(!result.data || !scale(result,quality)) return false;
+    swap(result);
+    }
+  return true;
+  }
+
+/*******************************************************************************/
+
+// Mirror horizontally and/or vertically
+void FXPixelBuffer::mirror(FXbool horizontal,FXbool vertical){
+  if(data){
+    if(vertical && height>1){           // Mirror vertically
+      bands(height>>1,width,[&](FXint lo,FXint hi){
+        FXColor *pa,*pb,*paa,t;
+        for(FXint y=lo; y<hi; ++y){
+          pa=data+y*width;
+          pb=data+(height-1-y)*width;
+          paa=pa+width;
+          do{
+            t=*pa; *pa++=*pb; *pb++=t;
+            }
+          while(pa<paa);
+          }
+        });
+      }
+    if(horizontal && width>1){          // Mirror horizontally
+      bands(height,width,[&](FXint lo,FXint hi){
+        FXColor *pa,*pb,t;
+        for(FXint y=lo; y<hi; ++y){
+          pa=data+y*width;
+          pb=pa+width;
+          do{
+            t=*--pb; *pb=*pa; *pa++=t;
+            }
+          while(pa<pb);
+          }
+        });
+      }
+    }
+  }
+
+
+// Rotate 90 degrees ccw, tile rows [lo,hi) of destination: dst(x,y)=src(sw-1-y,x)
+static void rotate90(FXColor* dst,const FXColor* src,FXint sw,FXint sh,FXint lo,FXint hi){
+  const FXint dw=sh;
+  const FXint dh=sw;
+  FXint tx,ty,ex,ey,x,y;
+  const FXColor *s;
+  FXColor *d;
+  for(ty=lo*TILESIZE; ty<hi*TILESIZE && ty<dh; ty+=TILESIZE){
+    ey=FXMIN(ty+TILESIZE,dh);
+    for(tx=0; tx<dw; tx+=TILESIZE){
+      ex=FXMIN(tx+TILESIZE,dw);
+      for(y=ty; y<ey; ++y){
+        d=dst+y*dw;
+        s=src+(sw-1-y);
+        for(x=tx; x<ex; ++x){
+          d[x]=s[x*sw];
+          }
+        }
+      }
+    }
+  }
+
+
+// Rotate 270 degrees ccw, tile rows [lo,hi) of destination: dst(x,y)=src(y,sh-1-x)
+static void rotate270(FXColor* dst,const FXColor* src,FXint sw,FXint sh,FXint lo,FXint hi){
+  const FXint dw=sh;
+  const FXint dh=sw;
+  FXint tx,ty,ex,ey,x,y;
+  const FXColor *s;
+  FXColor *d;
+  for(ty=lo*TILESIZE; ty<hi*TILESIZE && ty<dh; ty+=TILESIZE){
+    ey=FXMIN(ty+TILESIZE,dh);
+    for(tx=0; tx<dw; tx+=TILESIZE){
+      ex=FXMIN(tx+TILESIZE,dw);
+      for(y=ty; y<ey; ++y){
+        d=dst+y*dw;
+        s=src+(sh-1)*sw+y;
+        for(x=tx; x<ex; ++x){
+          d[x]=s[-x*sw];
+          }
+        }
+      }
+    }
+  }
+
+
+// Rotate 180 degrees, rows [lo,hi) of destination: dst(x,y)=src(sw-1-x,sh-1-y)
+static void rotate180(FXColor* dst,const FXColor* src,FXint sw,FXint sh,FXint lo,FXint hi){
+  const FXColor *s;
+  FXColor *d,*e;
+  for(FXint y=lo; y<hi; ++y){
+    d=dst+y*sw;
+    e=d+sw;
+    s=src+(sh-y)*sw;
+    do{
+      *d++=*--s;
+      }
+    while(d<e);
+    }
+  }
+
+
+// Rotate into other buffer
+FXbool FXPixelBuffer::rotate(FXPixelBuffer& dst,FXint degrees) const {
+  degrees=(degrees+360)%360;
+  if(data && dst.data){
+    switch(degrees){
+      case 0:
+        copyElms(dst.data,data,width*height);
+        return true;
+      case 90:
+        bands((width+TILESIZE-1)/TILESIZE,TILESIZE*height,[&](FXint lo,FXint hi){ rotate90(dst.data,data,width,height,lo,hi); });
+        return true;
+      case 180:
+        bands(height,width,[&](FXint lo,FXint hi){ rotate180(dst.data,data,width,height,lo,hi); });
+        return true;
+      case 270:
+        bands((width+TILESIZE-1)/TILESIZE,TILESIZE*height,[&](FXint lo,FXint hi){ rotate270(dst.data,data,width,height,lo,hi); });
+        return true;
+      }
+    }
+  return false;
+  }
+
+
+// Rotate by degrees ccw
+FXbool FXPixelBuffer::rotate(FXint degrees){
+  degrees=(degrees+360)%360;
+  if(degrees==90 || degrees==180 || degrees==270){
+    if(data){
+      FXPixelBuffer result;
+      if(degrees==180){
+        if(!result.resize(width,height)) return false;
+        }
+      else{
+        if(!result.resize(height,width)) return false;
+        }
+      rotate(result,degrees);
+      swap(result);
+      }
+    return true;
+    }
+  return degrees==0;
+  }
+
+/*******************************************************************************/
+
+// Crop into other buffer
+void FXPixelBuffer::crop(FXPixelBuffer& dst,FXint x,FXint y,FXColor color) const {
+  if(data && dst.data){
+    const FXint dw=dst.width;
+    const FXint lx=FXCLAMP(0,-x,dw);
+    const FXint hx=FXCLAMP(lx,width-x,dw);
+    bands(dst.height,dw,[&](FXint lo,FXint hi){
+      FXColor *d,*e;
+      for(FXint j=lo; j<hi; ++j){
+        d=dst.data+j*dw;
+        e=d+dw;
+        if(0<=y+j && y+j<height && lx<hx){
+          while(d<dst.data+j*dw+lx){ *d++=color; }
+          copyElms(d,data+(y+j)*width+x+lx,hx-lx);
+          d+=hx-lx;
+          }
+        while(d<e){ *d++=color; }
+        }
+      });
+    }
+  }
+
+
+// Crop to rectangle
+FXbool FXPixelBuffer::crop(FXint x,FXint y,FXint w,FXint h,FXColor color){
+  if(w<1) w=1;
+  if(h<1) h=1;
+  if(data){
+    FXPixelBuffer result(w,h);
+    if(!result.data) return false;
+    crop(result,x,y,color);
+    swap(result);
+    }
+  return true;
+  }
+
+/*******************************************************************************/
+
+// Shear rows [lo,hi) in X
+static void shearx(FXuchar *out,const FXuchar* in,FXint nwidth,FXint owidth,FXint height,FXint shear,FXColor clr,FXint lo,FXint hi){
+  const FXuchar *pp,*ppp,*p;
+  FXuchar *qq,*q,*k;
+  FXuint r=FXREDVAL(clr);
+  FXuint g=FXGREENVAL(clr);
+  FXuint b=FXBLUEVAL(clr);
+  FXuint a=FXALPHAVAL(clr);
+  FXint dp=owidth<<2;
+  FXint dq=nwidth<<2;
+  FXint s,z,y,d;
+  if(shear>0){ y=height-1-lo; d=-1; } else { shear=-shear; y=lo; d=1; }
+  pp=in+lo*dp;
+  ppp=in+hi*dp;
+  qq=out+lo*dq;
+  do{
+    p=pp; pp+=dp;
+    q=qq; qq+=dq;
+    z=(y*shear-1)/FXMAX(height-1,1); y+=d;
+    s=z&255;
+    k=q+(z>>8)*4;
+    while(q<k){
+      q[3]=a;
+      q[2]=r;
+      q[1]=g;
+      q[0]=b;
+      q+=4;
+      }
+    q[3]=((a-p[3])*s+(p[3]<<8)+127)>>8;
+    q[2]=((r-p[2])*s+(p[2]<<8)+127)>>8;
+    q[1]=((g-p[1])*s+(p[1]<<8)+127)>>8;
+    q[0]=((b-p[0])*s+(p[0]<<8)+127)>>8;
+    q+=4;
+    p+=4;
+    while(p<pp){
+      q[3]=((p[3-4]-p[3])*s+(p[3]<<8)+127)>>8;
+      q[2]=((p[2-4]-p[2])*s+(p[2]<<8)+127)>>8;
+      q[1]=((p[1-4]-p[1])*s+(p[1]<<8)+127)>>8;
+      q[0]=((p[0-4]-p[0])*s+(p[0]<<8)+127)>>8;
+      q+=4;
+      p+=4;
+      }
+    q[3]=((p[3-4]-a)*s+(a<<8)+127)>>8;
+    q[2]=((p[2-4]-r)*s+(r<<8)+127)>>8;
+    q[1]=((p[1-4]-g)*s+(g<<8)+127)>>8;
+    q[0]=((p[0-4]-b)*s+(b<<8)+127)>>8;
+    q+=4;
+    while(q<qq){
+      q[3]=a;
+      q[2]=r;
+      q[1]=g;
+      q[0]=b;
+      q+=4;
+      }
+    }
+  while(pp!=ppp);
+  }
+
+
+// Shear columns [lo,hi) in Y
+static void sheary(FXuchar *out,const FXuchar* in,FXint width,FXint nheight,FXint oheight,FXint shear,FXColor clr,FXint lo,FXint hi){
+  const FXuchar *pp,*ppp,*p;
+  FXuchar *qq,*q,*k;
+  FXuint r=FXREDVAL(clr);
+  FXuint g=FXGREENVAL(clr);
+  FXuint b=FXBLUEVAL(clr);
+  FXuint a=FXALPHAVAL(clr);
+  FXint dp=width<<2;
+  FXint s,z,x,d;
+  if(shear>0){ x=width-1-lo; d=-1; } else { shear=-shear; x=lo; d=1; }
+  pp=in+dp*oheight+lo*4;
+  ppp=in+dp*oheight+hi*4;
+  qq=out+dp*nheight+lo*4;
+  do{
+    p=pp-dp*oheight;
+    q=qq-dp*nheight;
+    z=(x*shear-1)/FXMAX(width-1,1); x+=d;
+    s=z&255;
+    k=q+(z>>8)*dp;
+    while(q<k){
+      q[3]=r;
+      q[2]=g;
+      q[1]=b;
+      q[0]=a;
+      q+=dp;
+      }
+    q[3]=((a-p[3])*s+(p[3]<<8)+127)>>8;
+    q[2]=((r-p[2])*s+(p[2]<<8)+127)>>8;
+    q[1]=((g-p[1])*s+(p[1]<<8)+127)>>8;
+    q[0]=((b-p[0])*s+(p[0]<<8)+127)>>8;
+    q+=dp;
+    p+=dp;
+    while(p<pp){
+      q[3]=((p[3-dp]-p[3])*s+(p[3]<<8)+127)>>8;
+      q[2]=((p[2-dp]-p[2])*s+(p[2]<<8)+127)>>8;
+      q[1]=((p[1-dp]-p[1])*s+(p[1]<<8)+127)>>8;
+      q[0]=((p[0-dp]-p[0])*s+(p[0]<<8)+127)>>8;
+      q+=dp;
+      p+=dp;
+      }
+    q[3]=((p[3-dp]-a)*s+(a<<8)+127)>>8;
+    q[2]=((p[2-dp]-r)*s+(r<<8)+127)>>8;
+    q[1]=((p[1-dp]-g)*s+(g<<8)+127)>>8;
+    q[0]=((p[0-dp]-b)*s+(b<<8)+127)>>8;
+    q+=dp;
+    while(q<qq){
+      q[3]=a;
+      q[2]=r;
+      q[1]=g;
+      q[0]=b;
+      q+=dp;
+      }
+    pp+=4;
+    qq+=4;
+    }
+  while(pp!=ppp);
+  }
+
+
+// Shear horizontally into other buffer
+void FXPixelBuffer::xshear(FXPixelBuffer& dst,FXint shear,FXColor clr) const {
+  if(data && dst.data){
+    if(shear){
+      bands(height,dst.width,[&](FXint lo,FXint hi){ shearx((FXuchar*)dst.data,(const FXuchar*)data,dst.width,width,height,shear,clr,lo,hi); });
+      }
+    else{
+      copyElms(dst.data,data,width*height);
+      }
+    }
+  }
+
+
+// Shear horizontally
+FXbool FXPixelBuffer::xshear(FXint shear,FXColor clr){
+  if(data){
+    FXPixelBuffer result(width+((FXABS(shear)+255)>>8),height);
+    if(!result.data) return false;
+    xshear(result,shear,clr);
+    swap(result);
+    }
+  return true;
+  }
+
+
+// Shear vertically into other buffer
+void FXPixelBuffer::yshear(FXPixelBuffer& dst,FXint shear,FXColor clr) const {
+  if(data && dst.data){
+    if(shear){
+      bands(width,dst.height,[&](FXint lo,FXint hi){ sheary((FXuchar*)dst.data,(const FXuchar*)data,width,dst.height,height,shear,clr,lo,hi); });
+      }
+    else{
+      copyElms(dst.data,data,width*height);
+      }
+    }
+  }
+
+
+// Shear vertically
+FXbool FXPixelBuffer::yshear(FXint shear,FXColor clr){
+  if(data){
+    FXPixelBuffer result(width,height+((FXABS(shear)+255)>>8));
+    if(!result.data) return false;
+    yshear(result,shear,clr);
+    swap(result);
+    }
+  return true;
+  }
+
+/*******************************************************************************/
+
+// Fill with color
+void FXPixelBuffer::fill(FXColor color){
+  if(data){
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXColor *pix=data+lo*width;
+      FXColor *end=data+hi*width;
+      do{ *pix++=color; }while(pix<end);
+      });
+    }
+  }
+
+
+// Fade to uniform color
+void FXPixelBuffer::fade(FXColor color,FXint factor){
+  if(data){
+    FXuint s=factor;
+    FXuint t=~factor;
+    FXuint r=FXREDVAL(color)*t;
+    FXuint g=FXGREENVAL(color)*t;
+    FXuint b=FXBLUEVAL(color)*t;
+    FXuint a=FXALPHAVAL(color)*t;
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *pix=(FXuchar*)(data+lo*width);
+      FXuchar *end=(FXuchar*)(data+hi*width);
+      FXuint w;
+      do{
+        w=pix[3]*s+a; pix[3]=(w+(w>>8))>>8;
+        w=pix[2]*s+r; pix[2]=(w+(w>>8))>>8;
+        w=pix[1]*s+g; pix[1]=(w+(w>>8))>>8;
+        w=pix[0]*s+b; pix[0]=(w+(w>>8))>>8;
+        pix+=4;
+        }
+      while(pix<end);
+      });
+    }
+  }
+
+
+// Fill horizontal gradient
+void FXPixelBuffer::hgradient(FXColor left,FXColor right){
+  FXint rr,gg,bb,aa,dr,dg,db,da,r1,g1,b1,a1,r2,g2,b2,a2,x;
+  FXuchar *ptr=(FXuchar*)data;
+  if(ptr && width>1 && height>1){
+    r1=FXREDVAL(left);
+    r2=FXREDVAL(right);
+    rr=(r1<<16)+32768;
+    dr=((r2-r1)<<16)/(width-1);
+    g1=FXGREENVAL(left);
+    g2=FXGREENVAL(right);
+    gg=(g1<<16)+32768;
+    dg=((g2-g1)<<16)/(width-1);
+    b1=FXBLUEVAL(left);
+    b2=FXBLUEVAL(right);
+    bb=(b1<<16)+32768;
+    db=((b2-b1)<<16)/(width-1);
+    a1=FXALPHAVAL(left);
+    a2=FXALPHAVAL(right);
+    aa=(a1<<16)+32768;
+    da=((a2-a1)<<16)/(width-1);
+    x=width;
+    do{
+      ptr[3]=aa>>16; aa+=da;
+      ptr[2]=rr>>16; rr+=dr;
+      ptr[1]=gg>>16; gg+=dg;
+      ptr[0]=bb>>16; bb+=db;
+      ptr+=4;
+      }
+    while(--x);
+    bands(height-1,width,[&](FXint lo,FXint hi){
+      for(FXint y=lo+1; y<=hi; ++y){
+        copyElms(data+y*width,data,width);
+        }
+      });
+    }
+  }
+
+
+// Fill vertical gradient
+void FXPixelBuffer::vgradient(FXColor top,FXColor bottom){
+  FXint rr,gg,bb,aa,dr,dg,db,da,r1,g1,b1,a1,r2,g2,b2,a2;
+  if(data && width>1 && height>1){
+    r1=FXREDVAL(top);
+    r2=FXREDVAL(bottom);
+    rr=(r1<<16)+32768;
+    dr=((r2-r1)<<16)/(height-1);
+    g1=FXGREENVAL(top);
+    g2=FXGREENVAL(bottom);
+    gg=(g1<<16)+32768;
+    dg=((g2-g1)<<16)/(height-1);
+    b1=FXBLUEVAL(top);
+    b2=FXBLUEVAL(bottom);
+    bb=(b1<<16)+32768;
+    db=((b2-b1)<<16)/(height-1);
+    a1=FXALPHAVAL(top);
+    a2=FXALPHAVAL(bottom);
+    aa=(a1<<16)+32768;
+    da=((a2-a1)<<16)/(height-1);
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *ptr=(FXuchar*)(data+lo*width);
+      FXint a,r,g,b,x;
+      for(FXint y=lo; y<hi; ++y){
+        a=(aa+y*da)>>16;
+        r=(rr+y*dr)>>16;
+        g=(gg+y*dg)>>16;
+        b=(bb+y*db)>>16;
+        x=width;
+        do{
+          ptr[3]=a;
+          ptr[2]=r;
+          ptr[1]=g;
+          ptr[0]=b;
+          ptr+=4;
+          }
+        while(--x);
+        }
+      });
+    }
+  }
+
+
+// Fill with gradient
+void FXPixelBuffer::gradient(FXColor topleft,FXColor topright,FXColor bottomleft,FXColor bottomright){
+  FXint rl,gl,bl,al,rr,gr,br,ar,drl,dgl,dbl,dal,drr,dgr,dbr,dar;
+  FXint rtl,gtl,btl,atl,rtr,gtr,btr,atr,rbl,gbl,bbl,abl,rbr,gbr,bbr,abr;
+  if(data && width>1 && height>1){
+
+    rtl=FXREDVAL(topleft);
+    rbl=FXREDVAL(bottomleft);
+    rl=(rtl<<16)+32768; drl=((rbl-rtl)<<16)/(height-1);
+
+    gtl=FXGREENVAL(topleft);
+    gbl=FXGREENVAL(bottomleft);
+    gl=(gtl<<16)+32768; dgl=((gbl-gtl)<<16)/(height-1);
+
+    btl=FXBLUEVAL(topleft);
+    bbl=FXBLUEVAL(bottomleft);
+    bl=(btl<<16)+32768; dbl=((bbl-btl)<<16)/(height-1);
+
+    rtr=FXREDVAL(topright);
+    rbr=FXREDVAL(bottomright);
+    rr=(rtr<<16)+32768; drr=((rbr-rtr)<<16)/(height-1);
+
+    gtr=FXGREENVAL(topright);
+    gbr=FXGREENVAL(bottomright);
+    gr=(gtr<<16)+32768; dgr=((gbr-gtr)<<16)/(height-1);
+
+    btr=FXBLUEVAL(topright);
+    bbr=FXBLUEVAL(bottomright);
+    br=(btr<<16)+32768; dbr=((bbr-btr)<<16)/(height-1);
+
+    atl=FXALPHAVAL(topleft);
+    abl=FXALPHAVAL(bottomleft);
+    al=(atl<<16)+32768; dal=((abl-atl)<<16)/(height-1);
+
+    atr=FXALPHAVAL(topright);
+    abr=FXALPHAVAL(bottomright);
+    ar=(atr<<16)+32768; dar=((abr-atr)<<16)/(height-1);
+
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *ptr=(FXuchar*)(data+lo*width);
+      FXint r,g,b,a,dr,dg,db,da,x;
+      for(FXint y=lo; y<hi; ++y){
+        a=al+y*dal; da=(ar+y*dar-a)/(width-1);
+        r=rl+y*drl; dr=(rr+y*drr-r)/(width-1);
+        g=gl+y*dgl; dg=(gr+y*dgr-g)/(width-1);
+        b=bl+y*dbl; db=(br+y*dbr-b)/(width-1);
+        x=width;
+        do{
+          ptr[3]=a>>16; a+=da;
+          ptr[2]=r>>16; r+=dr;
+          ptr[1]=g>>16; g+=dg;
+          ptr[0]=b>>16; b+=db;
+          ptr+=4;
+          }
+        while(--x);
+        }
+      });
+    }
+  }
+
+
+// Blend over uniform color
+void FXPixelBuffer::blend(FXColor color){
+  if(data){
+    FXint r=FXREDVAL(color);
+    FXint g=FXGREENVAL(color);
+    FXint b=FXBLUEVAL(color);
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *pix=(FXuchar*)(data+lo*width);
+      FXuchar *end=(FXuchar*)(data+hi*width);
+      FXint s,w;
+      do{
+        s=pix[3];
+        w=(pix[2]-r)*s; pix[2]=r+((w+(w>>8)+128)>>8);
+        w=(pix[1]-g)*s; pix[1]=g+((w+(w>>8)+128)>>8);
+        w=(pix[0]-b)*s; pix[0]=b+((w+(w>>8)+128)>>8);          /* FIXME need to write new alpha also */
+        pix+=4;
+        }
+      while(pix<end);
+      });
+    }
+  }
+
+
+// Invert colors
+void FXPixelBuffer::invert(){
+  if(data){
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *pix=(FXuchar*)(data+lo*width);
+      FXuchar *end=(FXuchar*)(data+hi*width);
+      do{
+        pix[1]=255-pix[1];
+        pix[2]=255-pix[2];
+        pix[3]=255-pix[3];
+        pix+=4;
+        }
+      while(pix<end);
+      });
+    }
+  }
+
+
+// Colorize based on luminance
+void FXPixelBuffer::colorize(FXColor color){
+  if(data){
+    FXint r=FXREDVAL(color);
+    FXint g=FXGREENVAL(color);
+    FXint b=FXBLUEVAL(color);
+    bands(height,width,[&](FXint lo,FXint hi){
+      FXuchar *pix=(FXuchar*)(data+lo*width);
+      FXuchar *end=(FXuchar*)(data+hi*width);
+      FXint lum,w;
+      do{
+        if(pix[3]){
+          lum=(77*pix[2]+151*pix[1]+29*pix[0])>>8;
+          w=r*lum; pix[2]=(w+(w>>8))>>8;
+          w=g*lum; pix[1]=(w+(w>>8))>>8;
+          w=b*lum; pix[0]=(w+(w>>8))>>8;
+          }
+        pix+=4;
+        }
+      while(pix<end);
+      });
+    }
+  }
+
+
+/*******************************************************************************/
+
+// Pixels composited at a time, per thread
+const FXint CHUNKPIXELS=256;
+
+
+// Product of a and b divided by 255, rounded
+static inline FXuint mul255(FXuint a,FXuint b){
+  FXuint t=a*b+128;
+  return (t+(t>>8))>>8;
+  }
+
+
+#if defined(FOX_HAS_SSE2)
+
+// Products of 16-bit channels divided by 255, rounded
+static inline __m128i mul255v(__m128i a,__m128i b){
+  __m128i t=_mm_add_epi16(_mm_mullo_epi16(a,b),_mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+  }
+
+
+// Alpha of two 16-bit pixels, copied to all their channels
+static inline __m128i alphav(__m128i p){
+  return _mm_shufflehi_epi16(_mm_shufflelo_epi16(p,0xFF),0xFF);
+  }
+
+#endif
+
+
+// Premultiply n pixels of src into dst; src may be dst
+static void premultiplyrow(FXColor* dst,const FXColor* src,FXint n){
+  const FXuchar *s;
+  FXuchar *d;
+  FXint i=0;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i amask=_mm_set_epi16(-1,0,0,0,-1,0,0,0);
+  const __m128i aone=_mm_set_epi16(255,0,0,0,255,0,0,0);
+  __m128i p,lo,hi;
+  for(; i+4<=n; i+=4){                  // Scale colors by alpha, but not alpha itself
+    p=_mm_loadu_si128((const __m128i*)(src+i));
+    lo=_mm_unpacklo_epi8(p,zero);
+    hi=_mm_unpackhi_epi8(p,zero);
+    lo=mul255v(lo,_mm_or_si128(_mm_andnot_si128(amask,alphav(lo)),aone));
+    hi=mul255v(hi,_mm_or_si128(_mm_andnot_si128(amask,alphav(hi)),aone));
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_packus_epi16(lo,hi));
+    }
+#endif
+  for(; i<n; ++i){
+    s=(const FXuchar*)(src+i);
+    d=(FXuchar*)(dst+i);
+    d[3]=s[3];
+    d[2]=mul255(s[2],s[3]);
+    d[1]=mul255(s[1],s[3]);
+    d[0]=mul255(s[0],s[3]);
+    }
+  }
+
+
+// Unpremultiply n pixels of src into dst; src may be dst.  Colors are
+// clamped to alpha first, as rounding may have left them slightly larger
+static void unpremultiplyrow(FXColor* dst,const FXColor* src,FXint n){
+  const FXuchar *s;
+  FXuchar *d;
+  FXfloat f;
+  FXint i=0;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128 amask=_mm_castsi128_ps(_mm_set_epi32(-1,0,0,0));
+  const __m128 one=_mm_set1_ps(1.0f);
+  const __m128 half=_mm_set1_ps(0.5f);
+  const __m128 full=_mm_set1_ps(255.0f);
+  __m128i p,lo,hi,q[4];
+  __m128 v,a,m;
+  FXint j;
+  for(; i+4<=n; i+=4){
+    p=_mm_loadu_si128((const __m128i*)(src+i));
+    lo=_mm_unpacklo_epi8(p,zero);
+    hi=_mm_unpackhi_epi8(p,zero);
+    q[0]=_mm_unpacklo_epi16(lo,zero);
+    q[1]=_mm_unpackhi_epi16(lo,zero);
+    q[2]=_mm_unpacklo_epi16(hi,zero);
+    q[3]=_mm_unpackhi_epi16(hi,zero);
+    for(j=0; j<4; ++j){                 // One pixel at a time: scale colors by 255/alpha
+      v=_mm_cvtepi32_ps(q[j]);
+      a=_mm_shuffle_ps(v,v,0xFF);
+      m=_mm_and_ps(_mm_cmpgt_ps(a,_mm_setzero_ps()),_mm_div_ps(full,a));
+      m=_mm_or_ps(_mm_andnot_ps(amask,m),_mm_and_ps(amask,one));
+      q[j]=_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(v,a),m),half));
+      }
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_packus_epi16(_mm_packs_epi32(q[0],q[1]),_mm_packs_epi32(q[2],q[3])));
+    }
+#endif
+  for(; i<n; ++i){
+    s=(const FXuchar*)(src+i);
+    d=(FXuchar*)(dst+i);
+    if(s[3]){
+      f=255.0f/s[3];
+      d[2]=(FXuchar)(FXMIN(s[2],s[3])*f+0.5f);
+      d[1]=(FXuchar)(FXMIN(s[1],s[3])*f+0.5f);
+      d[0]=(FXuchar)(FXMIN(s[0],s[3])*f+0.5f);
+      d[3]=s[3];
+      }
+    else{
+      d[0]=d[1]=d[2]=d[3]=0;
+      }
+    }
+  }
+
+
+// Apply operator to premultiplied channel s over d, with alphas sa and da
+template<FXint op>
+static inline FXuint compositechannel(FXuint s,FXuint d,FXuint sa,FXuint da){
+  switch(op){
+    case FXPixelBuffer::CompositeOver: return s+mul255(d,255-sa);
+    case FXPixelBuffer::CompositeIn: return mul255(s,da);
+    case FXPixelBuffer::CompositeOut: return mul255(s,255-da);
+    case FXPixelBuffer::CompositeAtop: return mul255(s,da)+mul255(d,255-sa);
+    case FXPixelBuffer::CompositeXor: return mul255(s,255-da)+mul255(d,255-sa);
+    case FXPixelBuffer::CompositeAdd: return s+d;
+    case FXPixelBuffer::CompositeMultiply: return mul255(s,d)+mul255(s,255-da)+mul255(d,255-sa);
+    }
+  return d;
+  }
+
+
+#if defined(FOX_HAS_SSE2)
+
+// Apply operator to two premultiplied 16-bit pixels s over d
+template<FXint op>
+static inline __m128i compositevector(__m128i s,__m128i d){
+  const __m128i full=_mm_set1_epi16(255);
+  switch(op){
+    case FXPixelBuffer::CompositeOver: return _mm_add_epi16(s,mul255v(d,_mm_sub_epi16(full,alphav(s))));
+    case FXPixelBuffer::CompositeIn: return mul255v(s,alphav(d));
+    case FXPixelBuffer::CompositeOut: return mul255v(s,_mm_sub_epi16(full,alphav(d)));
+    case FXPixelBuffer::CompositeAtop: return _mm_add_epi16(mul255v(s,alphav(d)),mul255v(d,_mm_sub_epi16(full,alphav(s))));
+    case FXPixelBuffer::CompositeXor: return _mm_add_epi16(mul255v(s,_mm_sub_epi16(full,alphav(d))),mul255v(d,_mm_sub_epi16(full,alphav(s))));
+    case FXPixelBuffer::CompositeAdd: return _mm_add_epi16(s,d);
+    case FXPixelBuffer::CompositeMultiply: return _mm_add_epi16(mul255v(s,d),_mm_add_epi16(mul255v(s,_mm_sub_epi16(full,alphav(d))),mul255v(d,_mm_sub_epi16(full,alphav(s)))));
+    }
+  return d;
+  }
+
+#endif
+
+
+// Composite n premultiplied pixels of src onto dst; sums over 255 saturate
+template<FXint op>
+static void compositerow(FXColor* dst,const FXColor* src,FXint n){
+  const FXuchar *s;
+  FXuchar *d;
+  FXint i=0;
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  __m128i ps,pd,lo,hi;
+  for(; i+4<=n; i+=4){
+    ps=_mm_loadu_si128((const __m128i*)(src+i));
+    pd=_mm_loadu_si128((const __m128i*)(dst+i));
+    lo=compositevector<op>(_mm_unpacklo_epi8(ps,zero),_mm_unpacklo_epi8(pd,zero));
+    hi=compositevector<op>(_mm_unpackhi_epi8(ps,zero),_mm_unpackhi_epi8(pd,zero));
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_packus_epi16(lo,hi));
+    }
+#endif
+  for(; i<n; ++i){
+    s=(const FXuchar*)(src+i);
+    d=(FXuchar*)(dst+i);
+    d[0]=FXMIN(compositechannel<op>(s[0],d[0],s[3],d[3]),255);
+    d[1]=FXMIN(compositechannel<op>(s[1],d[1],s[3],d[3]),255);
+    d[2]=FXMIN(compositechannel<op>(s[2],d[2],s[3],d[3]),255);
+    d[3]=FXMIN(compositechannel<op>(s[3],d[3],s[3],d[3]),255);
+    }
+  }
+
+
+// Store n composited pixels res into dst, except where the source pixel in src is
+// fully transparent, and all operators but In and Out leave the destination alone;
+// there, the destination stays as it was, rather than going through premultiplied
+// alpha and back, which would change translucent pixels
+template<FXint op>
+static void storerow(FXColor* dst,const FXColor* res,const FXColor* src,FXint n){
+  FXint i=0;
+  if(op==FXPixelBuffer::CompositeIn || op==FXPixelBuffer::CompositeOut){
+    copyElms(dst,res,n);
+    return;
+    }
+#if defined(FOX_HAS_SSE2)
+  const __m128i zero=_mm_setzero_si128();
+  const __m128i amask=_mm_set1_epi32((FXint)0xFF000000);
+  __m128i m;
+  for(; i+4<=n; i+=4){
+    m=_mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i*)(src+i)),amask),zero);
+    _mm_storeu_si128((__m128i*)(dst+i),_mm_or_si128(_mm_and_si128(m,_mm_loadu_si128((const __m128i*)(dst+i))),_mm_andnot_si128(m,_mm_loadu_si128((const __m128i*)(res+i)))));
+    }
+#endif
+  for(; i<n; ++i){
+    if(src[i]&0xFF000000) dst[i]=res[i];
+    }
+  }
+
+
+// Composite rows [lo,hi) of rectangle w wide from src onto dst; the pixels are
+// premultiplied a chunk at a time, so only the result is unpremultiplied again
+template<FXint op>
+static void compositerows(FXColor* dst,FXint dstride,const FXColor* src,FXint sstride,FXint w,FXint lo,FXint hi){
+  FXColor s[CHUNKPIXELS];
+  FXColor d[CHUNKPIXELS];
+  FXint x,y,n;
+  for(y=lo; y<hi; ++y){
+    for(x=0; x<w; x+=n){
+      n=FXMIN(w-x,CHUNKPIXELS);
+      premultiplyrow(s,src+y*sstride+x,n);
+      premultiplyrow(d,dst+y*dstride+x,n);
+      compositerow<op>(d,s,n);
+      unpremultiplyrow(d,d,n);
+      storerow<op>(dst+y*dstride+x,d,src+y*sstride+x,n);
+      }
+    }
+  }
+
+
+// Convert to premultiplied alpha
+void FXPixelBuffer::premultiply(){
+  if(data){
+    bands(height,width,[&](FXint lo,FXint hi){ premultiplyrow(data+lo*width,data+lo*width,(hi-lo)*width); });
+    }
+  }
+
+
+// Convert to straight alpha
+void FXPixelBuffer::unpremultiply(){
+  if(data){
+    bands(height,width,[&](FXint lo,FXint hi){ unpremultiplyrow(data+lo*width,data+lo*width,(hi-lo)*width); });
+    }
+  }
+
+
+// Composite rectangle of other buffer onto this one
+void FXPixelBuffer::composite(const FXPixelBuffer& src,FXint sx,FXint sy,FXint w,FXint h,FXint dx,FXint dy,Operator op){
+  if(data && src.data && src.data!=data){
+
+    // Clip to source
+    if(sx<0){ w+=sx; dx-=sx; sx=0; }
+    if(sy<0){ h+=sy; dy-=sy; sy=0; }
+    if(sx+w>src.width){ w=src.width-sx; }
+    if(sy+h>src.height){ h=src.height-sy; }
+
+    // Clip to destination
+    if(dx<0){ w+=dx; sx-=dx; dx=0; }
+    if(dy<0){ h+=dy; sy-=dy; dy=0; }
+    if(dx+w>width){ w=width-dx; }
+    if(dy+h>height){ h=height-dy; }
+
+    // Anything left
+    if(0<w && 0<h){
+      FXColor* d=data+dy*width+dx;
+      const FXColor* s=src.data+sy*src.width+sx;
+      const FXint ds=width;
+      const FXint ss=src.width;
+      switch(op){
+        case CompositeOver:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeOver>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeIn:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeIn>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeOut:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeOut>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeAtop:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeAtop>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeXor:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeXor>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeAdd:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeAdd>(d,ds,s,ss,w,lo,hi); });
+          break;
+        case CompositeMultiply:
+          bands(h,w,[&](FXint lo,FXint hi){ compositerows<CompositeMultiply>(d,ds,s,ss,w,lo,hi); });
+          break;
+        }
+      }
+    }
+  }
+
+
+// Composite all of other buffer onto this one
+void FXPixelBuffer::composite(const FXPixelBuffer& src,FXint dx,FXint dy,Operator op){
+  composite(src,0,0,src.width,src.height,dx,dy,op);
+  }
+
+
+// Free pixels, if owned
+FXPixelBuffer::~FXPixelBuffer(){
+  if(owned){ freeElms(data); }
+  data=(FXColor*)-1L;
+  }
+
+}
@@ -110,6 +110,43 @@
 
   - If using epoll() instead of select() or pselect(), we may want to raise
     RLIMIT_NOFILE as we're able to go beyond FD_SETSIZE.
+
+  - Asynchronous reads and writes go through io_uring, unless configured with
+    --disable-io-uring, if the kernel allows it; io_uring_setup() may be refused by
+    older kernels, or blocked by a sandbox, in which case we fall back on epoll.
+    Reads and writes of regular files are submitted to the ring like any other, so
+    they don't hold up the calling thread.
+    We need IORING_FEAT_FAST_POLL (Linux 5.7), so that reads from pipes and sockets
+    don't tie up a kernel worker thread while waiting for data, and
+    IORING_FEAT_RW_CUR_POS (Linux 5.6), so that an offset of -1 means the current
+    file position, as it does for the epoll fallback.
+
+  - Submission queue entries are filled in by submitOperation(), but only handed
+    to the kernel just before polling; thus, operations submitted from a single
+    callback go to the kernel in a single io_uring_enter() call.
+
+  - The ring handle itself is watched by epoll, and becomes ready when there are
+    completion queue entries; we don't use io_uring for watching handles, so the
+    rest of the reactor is unchanged.  Completion queue entries are only reaped when
+    completions are dispatched, so when dispatch() is called without
+    DispatchCompletions the ring handle is taken out of the watched set, or else
+    it would stay raised, and the reactor would spin.
+
+  - No more operations are accepted than fit in the completion queue, so that
+    completion queue entries never need to be dropped.  Each operation in flight
+    has a record, whose address is the entry's user data, so that it can be
+    canceled by IORING_OP_ASYNC_CANCEL.
+
+  - Without io_uring, the operation's handle is duplicated, and the duplicate is
+    watched by epoll, as a handle may be watched only once in an epoll set; regular
+    files, which epoll won't watch, are always ready, so the operation is performed
+    right away, and just its completion is dispatched later; this is the one case
+    where an operation ties up the calling thread, so io_uring should be preferred.
+
+  - Operations which have not completed when the reactor exits are canceled; their
+    completions are not dispatched.  With io_uring, the reactor waits until the kernel
+    has posted the completions of the canceled operations, so that their buffers are
+    no longer in use once exit() returns.
 */
 
 // Bad handle value
@@ -151,6 +188,7 @@ FXbool FXReactor::init(){
 #if defined(HAVE_EPOLL_CREATE1)
       internals->handle=epoll_create1(EPOLL_CLOEXEC);
       if(internals->handle<0){ freeElms(internals); return false; }
+      openRing();
 #endif
       sigreceived=0;
       numhandles=0;
@@ -290,6 +328,314 @@ FXbool FXReactor::dispatchIdle(){
 
 /*******************************************************************************/
 
+#if defined(HAVE_IO_URING_H)
+
+// Number of submission queue entries
+const FXuint RINGSIZE=256;
+
+// Load value written by kernel
+static inline FXuint loadAcquire(const FXuint* ptr){
+  return __atomic_load_n(ptr,__ATOMIC_ACQUIRE);
+  }
+
+// Store value to be read by kernel
+static inline void storeRelease(FXuint* ptr,FXuint val){
+  __atomic_store_n(ptr,val,__ATOMIC_RELEASE);
+  }
+
+#endif
+
+
+// Set up io_uring, if the kernel allows it
+FXbool FXReactor::openRing(){
+#if defined(HAVE_IO_URING_H)
+  struct io_uring_params params;
+  struct epoll_event ev;
+  clearElms(&params,1);
+  internals->ring=(FXInputHandle)syscall(__NR_io_uring_setup,RINGSIZE,&params);
+  if(internals->ring<0) goto x;
+  if(!(params.features&IORING_FEAT_NODROP) || !(params.features&IORING_FEAT_FAST_POLL) || !(params.features&IORING_FEAT_RW_CUR_POS)) goto y;
+  internals->sqmapsize=params.sq_off.array+params.sq_entries*sizeof(FXuint);
+  internals->cqmapsize=params.cq_off.cqes+params.cq_entries*sizeof(struct io_uring_cqe);
+  if(params.features&IORING_FEAT_SINGLE_MMAP){
+    internals->sqmapsize=internals->cqmapsize=Math::imax(internals->sqmapsize,internals->cqmapsize);
+    }
+  internals->sqmap=mmap(nullptr,internals->sqmapsize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,internals->ring,IORING_OFF_SQ_RING);
+  if(internals->sqmap==MAP_FAILED) goto y;
+  internals->cqmap=internals->sqmap;
+  if(!(params.features&IORING_FEAT_SINGLE_MMAP)){
+    internals->cqmap=mmap(nullptr,internals->cqmapsize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,internals->ring,IORING_OFF_CQ_RING);
+    if(internals->cqmap==MAP_FAILED) goto z;
+    }
+  internals->sqes=(struct io_uring_sqe*)mmap(nullptr,params.sq_entries*sizeof(struct io_uring_sqe),PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,internals->ring,IORING_OFF_SQES);
+  if(internals->sqes==MAP_FAILED) goto w;
+  internals->sqhead=(FXuint*)((FXuchar*)internals->sqmap+params.sq_off.head);
+  internals->sqtail=(FXuint*)((FXuchar*)internals->sqmap+params.sq_off.tail);
+  internals->sqarray=(FXuint*)((FXuchar*)internals->sqmap+params.sq_off.array);
+  internals->sqmask=*(FXuint*)((FXuchar*)internals->sqmap+params.sq_off.ring_mask);
+  internals->cqhead=(FXuint*)((FXuchar*)internals->cqmap+params.cq_off.head);
+  internals->cqtail=(FXuint*)((FXuchar*)internals->cqmap+params.cq_off.tail);
+  internals->cqes=(struct io_uring_cqe*)((FXuchar*)internals->cqmap+params.cq_off.cqes);
+  internals->cqmask=*(FXuint*)((FXuchar*)internals->cqmap+params.cq_off.ring_mask);
+  internals->sqentries=params.sq_entries;
+  internals->cqentries=params.cq_entries;
+  internals->unsubmitted=0;
+  internals->inflight=0;
+  if(!callocElms(internals->operations,params.cq_entries)) goto v;
+  for(FXuint i=0; i<params.cq_entries; ++i){
+    internals->operations[i].next=internals->freeoperations;
+    internals->freeoperations=&internals->operations[i];
+    }
+  ev.events=EPOLLIN;
+  ev.data.fd=internals->ring;
+  if(epoll_ctl(internals->handle,EPOLL_CTL_ADD,internals->ring,&ev)!=0) goto u;
+  internals->ringwatched=true;
+  return true;
+u:freeElms(internals->operations);
+  internals->freeoperations=nullptr;
+v:munmap(internals->sqes,params.sq_entries*sizeof(struct io_uring_sqe));
+w:if(internals->cqmap!=internals->sqmap) munmap(internals->cqmap,internals->cqmapsize);
+z:munmap(internals->sqmap,internals->sqmapsize);
+y:close(internals->ring);
+x:internals->ring=BadHandle;
+#endif
+  return false;
+  }
+
+
+// Tear down io_uring; operations still in flight are canceled first, and their
+// completions reaped, so the kernel is done with their buffers
+void FXReactor::closeRing(){
+#if defined(HAVE_IO_URING_H)
+  if(internals->ring!=BadHandle){
+    struct io_uring_sqe *sqe;
+    FXReactorOperation *o;
+    FXuint i=0,head,tail;
+    while(internals->inflight){
+      while(i<internals->cqentries && (tail=*internals->sqtail)-loadAcquire(internals->sqhead)<internals->sqentries){
+        if(internals->operations[i].op){
+          sqe=&internals->sqes[tail&internals->sqmask];
+          clearElms(sqe,1);
+          sqe->opcode=IORING_OP_ASYNC_CANCEL;
+          sqe->fd=-1;
+          sqe->addr=(FXulong)(FXuval)&internals->operations[i];
+          sqe->user_data=0;                             // Cancellation has no record
+          internals->sqarray[tail&internals->sqmask]=tail&internals->sqmask;
+          storeRelease(internals->sqtail,tail+1);
+          internals->unsubmitted++;
+          }
+        i++;
+        }
+      flushOperations();
+      head=*internals->cqhead;
+      if(head==loadAcquire(internals->cqtail)){
+        if(syscall(__NR_io_uring_enter,internals->ring,0,1,IORING_ENTER_GETEVENTS,nullptr,0)<0 && errno!=EINTR && errno!=EBUSY) break;
+        continue;
+        }
+      if((o=(FXReactorOperation*)(FXuval)internals->cqes[head&internals->cqmask].user_data)!=nullptr){
+        o->op=0;
+        internals->inflight--;
+        }
+      storeRelease(internals->cqhead,head+1);
+      }
+    freeElms(internals->operations);
+    internals->freeoperations=nullptr;
+    munmap(internals->sqes,internals->sqentries*sizeof(struct io_uring_sqe));
+    if(internals->cqmap!=internals->sqmap) munmap(internals->cqmap,internals->cqmapsize);
+    munmap(internals->sqmap,internals->sqmapsize);
+    close(internals->ring);
+    internals->ring=BadHandle;
+    }
+#endif
+  }
+
+
+// Return true if asynchronous operations are performed by io_uring
+FXbool FXReactor::hasRing() const {
+#if defined(HAVE_IO_URING_H)
+  return internals && internals->ring!=BadHandle;
+#else
+  return false;
+#endif
+  }
+
+
+#if defined(HAVE_EPOLL_CREATE1)
+
+// Perform operation on handle
+static void performOperation(FXReactorOperation* o,FXInputHandle hnd){
+  ssize_t n;
+  if(o->op==FXReactor::OperationRead){
+    n=(o->off<0) ? ::read(hnd,o->buf,o->len) : ::pread(hnd,o->buf,o->len,o->off);
+    }
+  else{
+    n=(o->off<0) ? ::write(hnd,o->buf,o->len) : ::pwrite(hnd,o->buf,o->len,o->off);
+    }
+  o->result=(n<0) ? -errno : n;
+  }
+
+#endif
+
+
+// Submit asynchronous read or write
+FXbool FXReactor::submitOperation(FXuint op,FXInputHandle hnd,void* buf,FXival len,FXlong off,void* tag){
+#if defined(HAVE_EPOLL_CREATE1)
+  if(internals && 0<=hnd && 0<=len && (op==OperationRead || op==OperationWrite)){
+    FXReactorOperation *o;
+    struct epoll_event ev;
+    FXInputHandle dup;
+#if defined(HAVE_IO_URING_H)
+    if(internals->ring!=BadHandle){
+      struct io_uring_sqe *sqe;
+      FXuint tail=*internals->sqtail;
+      if(internals->inflight>=internals->cqentries || !internals->freeoperations) return false;
+      if(tail-loadAcquire(internals->sqhead)>=internals->sqentries){
+        flushOperations();
+        if(tail-loadAcquire(internals->sqhead)>=internals->sqentries) return false;
+        }
+      sqe=&internals->sqes[tail&internals->sqmask];
+      clearElms(sqe,1);
+      sqe->opcode=(op==OperationRead) ? IORING_OP_READ : IORING_OP_WRITE;
+      sqe->fd=hnd;
+      sqe->addr=(FXulong)(FXuval)buf;
+      sqe->len=(FXuint)Math::imin(len,(FXival)0x7FFFF000);
+      sqe->off=(FXulong)off;                            // All ones means current position
+      o=internals->freeoperations;
+      internals->freeoperations=o->next;
+      o->next=nullptr;
+      o->tag=tag;
+      o->buf=buf;
+      o->len=len;
+      o->off=off;
+      o->result=0;
+      o->op=op;
+      sqe->user_data=(FXulong)(FXuval)o;
+      internals->sqarray[tail&internals->sqmask]=tail&internals->sqmask;
+      storeRelease(internals->sqtail,tail+1);
+      internals->unsubmitted++;
+      internals->inflight++;
+      return true;
+      }
+#endif
+    if((dup=fcntl(hnd,F_DUPFD_CLOEXEC,0))<0) return false;
+    if(!allocElms(o,1)){ close(dup); return false; }
+    o->next=nullptr;
+    o->tag=tag;
+    o->buf=buf;
+    o->len=len;
+    o->off=off;
+    o->result=0;
+    o->op=op;
+    ev.events=((op==OperationRead) ? EPOLLIN : EPOLLOUT)|EPOLLONESHOT;
+    ev.data.fd=dup;
+    if(epoll_ctl(internals->handle,EPOLL_CTL_ADD,dup,&ev)!=0){
+      if(errno!=EPERM){ close(dup); freeElms(o); return false; }
+      performOperation(o,dup);                          // Regular file is always ready
+      close(dup);
+      if(internals->completed) internals->lastcompleted->next=o; else internals->completed=o;
+      internals->lastcompleted=o;
+      return true;
+      }
+    if(dup>=internals->numwaiting){
+      if(!resizeElms(internals->waiting,dup+1)){ epoll_ctl(internals->handle,EPOLL_CTL_DEL,dup,&ev); close(dup); freeElms(o); return false; }
+      clearElms(&internals->waiting[internals->numwaiting],dup+1-internals->numwaiting);
+      internals->numwaiting=dup+1;
+      }
+    internals->waiting[dup]=o;
+    return true;
+    }
+#endif
+  return false;
+  }
+
+
+// Hand submitted operations to the kernel
+void FXReactor::flushOperations(){
+#if defined(HAVE_IO_URING_H)
+  if(internals->ring!=BadHandle && internals->unsubmitted){
+    FXint n=(FXint)syscall(__NR_io_uring_enter,internals->ring,internals->unsubmitted,0,0,nullptr,0);
+    if(0<n) internals->unsubmitted-=n;
+    }
+#endif
+  }
+
+
+// Watch ring handle only while completions are dispatched; its completion queue
+// entries are not reaped otherwise, so it would stay raised
+void FXReactor::watchRing(FXuint flags){
+#if defined(HAVE_IO_URING_H)
+  FXbool flag=(flags&DispatchCompletions)!=0;
+  if(internals->ring!=BadHandle && internals->ringwatched!=flag){
+    struct epoll_event ev;
+    ev.events=flag?(FXuint)EPOLLIN:0U;
+    ev.data.fd=internals->ring;
+    if(epoll_ctl(internals->handle,EPOLL_CTL_MOD,internals->ring,&ev)==0) internals->ringwatched=flag;
+    }
+#endif
+  }
+
+
+// If raised handle belongs to an operation, perform it, and return true
+FXbool FXReactor::raisedOperation(FXInputHandle hnd){
+#if defined(HAVE_EPOLL_CREATE1)
+  struct epoll_event ev;
+  FXReactorOperation *o;
+#if defined(HAVE_IO_URING_H)
+  if(hnd==internals->ring) return true;
+#endif
+  if(0<=hnd && hnd<internals->numwaiting && (o=internals->waiting[hnd])!=nullptr){
+    internals->waiting[hnd]=nullptr;
+    epoll_ctl(internals->handle,EPOLL_CTL_DEL,hnd,&ev);
+    performOperation(o,hnd);
+    close(hnd);
+    if(internals->completed) internals->lastcompleted->next=o; else internals->completed=o;
+    internals->lastcompleted=o;
+    return true;
+    }
+#endif
+  return false;
+  }
+
+
+// Obtain next completed operation, if any
+FXbool FXReactor::nextCompletion(void*& tag,FXival& result){
+#if defined(HAVE_EPOLL_CREATE1)
+  FXReactorOperation *o;
+  if((o=internals->completed)!=nullptr){
+    internals->completed=o->next;
+    tag=o->tag;
+    result=o->result;
+    freeElms(o);
+    return true;
+    }
+#if defined(HAVE_IO_URING_H)
+  if(internals->ring!=BadHandle){
+    FXuint head=*internals->cqhead;
+    if(head!=loadAcquire(internals->cqtail)){
+      o=(FXReactorOperation*)(FXuval)internals->cqes[head&internals->cqmask].user_data;
+      result=internals->cqes[head&internals->cqmask].res;
+      storeRelease(internals->cqhead,head+1);
+      tag=o->tag;
+      o->op=0;
+      o->next=internals->freeoperations;
+      internals->freeoperations=o;
+      internals->inflight--;
+      return true;
+      }
+    }
+#endif
+#endif
+  return false;
+  }
+
+
+// Dispatch when asynchronous operation has completed
+FXbool FXReactor::dispatchCompletion(void*,FXival){
+  return false;
+  }
+
+/*******************************************************************************/
+
 #if defined(WIN32)
 
 // Find index of the given handle; -1 if not found
@@ -492,6 +838,8 @@ FXbool FXReactor::dispatch(FXTime blocking,FXuint flags){
     FXTime now,due,delay,interval;
     FXuint sig,nxt,mode,ms;
     FXInputHandle hnd;
+    FXival result;
+    void* tag;
 
     // Loop till we got something
     while(1){
@@ -521,6 +869,14 @@ FXbool FXReactor::dispatch(FXTime blocking,FXuint flags){
           }
         }
 
+      // Check for completed operation
+      if(flags&DispatchCompletions){
+        if(nextCompletion(tag,result)){
+          if(dispatchCompletion(tag,result)) return true; // Completion activity
+          continue;
+          }
+        }
+
       // Check active handles
       if(0<numraised){
         mode=0;
@@ -530,6 +886,7 @@ FXbool FXReactor::dispatch(FXTime blocking,FXuint flags){
         if(internals->events[current].events&EPOLLIN){ mode|=InputRead; }
         if(internals->events[current].events&EPOLLOUT){ mode|=InputWrite; }
         if(internals->events[current].events&EPOLLERR){ mode|=InputExcept; }
+        if(raisedOperation(hnd)) continue;              // Operation became ready
         if(dispatchHandle(hnd,mode,flags)) return true; // IO activity
         continue;
         }
@@ -537,6 +894,10 @@ FXbool FXReactor::dispatch(FXTime blocking,FXuint flags){
       // All handles have been handled...
       FXASSERT(numraised==0);
 
+      // Hand submitted operations to kernel
+      flushOperations();
+      watchRing(flags);
+
       // Select active handles and check signals; don't block
       numwatched=epoll_pwait(internals->handle,internals->events,ARRAYNUMBER(internals->events),0,nullptr);
 
@@ -561,6 +922,9 @@ FXbool FXReactor::dispatch(FXTime blocking,FXuint flags){
           ms=(FXuint)(interval/milliseconds);
           }
 
+        // Hand operations submitted by idle callback to kernel
+        flushOperations();
+
         // Select active handles and check signals, waiting for timeout or maximum block time
         numwatched=epoll_pwait(internals->handle,internals->events,ARRAYNUMBER(internals->events),ms,nullptr);
 
@@ -736,6 +1100,16 @@ FXbool FXReactor::exit(){
       remSignal(s);
       }
 #if defined(HAVE_EPOLL_CREATE1)
+    FXReactorOperation *o;
+    closeRing();
+    for(FXint h=0; h<internals->numwaiting; ++h){
+      if(internals->waiting[h]){ close(h); freeElms(internals->waiting[h]); }
+      }
+    while((o=internals->completed)!=nullptr){
+      internals->completed=o->next;
+      freeElms(o);
+      }
+    freeElms(internals->waiting);
     close(internals->handle);
 #endif
     freeElms(internals);
@@ -26,6 +26,18 @@
 namespace FX {
 
 
+// Asynchronous operation, performed when its handle becomes ready
+struct FXReactorOperation {
+  FXReactorOperation *next;                             // Next completed operation
+  void               *tag;                              // Tag passed to completion
+  void               *buf;                              // Buffer
+  FXival              len;                              // Length of buffer
+  FXlong              off;                              // File offset, or -1
+  FXival              result;                           // Result of read or write
+  FXuint              op;                               // Read or write
+  };
+
+
 // Platform dependent reactor internals
 struct FXReactor::Internals {
 #if defined(WIN32)
@@ -36,6 +48,33 @@ struct FXReactor::Internals {
   FXint              signotified[64];                   // Signal notify flag
   struct epoll_event events[128];                       // Events
   FXInputHandle      handle;                            // Poll handle
+  FXReactorOperation **waiting;                         // Operations waiting, by duplicated handle
+  FXint              numwaiting;                        // Size of waiting table
+  FXReactorOperation *completed;                        // Operations completed
+  FXReactorOperation *lastcompleted;                    // Last operation completed
+#if defined(HAVE_IO_URING_H)
+  FXInputHandle      ring;                              // Ring handle
+  FXbool             ringwatched;                       // Ring handle is watched by epoll
+  void              *sqmap;                             // Submission queue mapping
+  void              *cqmap;                             // Completion queue mapping
+  FXuval             sqmapsize;                         // Size of submission queue mapping
+  FXuval             cqmapsize;                         // Size of completion queue mapping
+  struct io_uring_sqe *sqes;                            // Submission queue entries
+  struct io_uring_cqe *cqes;                            // Completion queue entries
+  FXuint            *sqhead;                            // Submission queue head, moved by kernel
+  FXuint            *sqtail;                            // Submission queue tail
+  FXuint            *sqarray;                           // Submission queue indices
+  FXuint            *cqhead;                            // Completion queue head
+  FXuint            *cqtail;                            // Completion queue tail, moved by kernel
+  FXuint             sqmask;                            // Submission queue index mask
+  FXuint             cqmask;                            // Completion queue index mask
+  FXuint             sqentries;                         // Submission queue size
+  FXuint             cqentries;                         // Completion queue size
+  FXuint             unsubmitted;                       // Entries not yet submitted
+  FXuint             inflight;                          // Operations not yet completed
+  FXReactorOperation *operations;                       // Operation records, one per completion queue entry
+  FXReactorOperation *freeoperations;                   // Operation records not in use
+#endif
 #else
   FXint              signotified[64];                   // Signal notify flag
   fd_set             watched[3];                        // Watched handles
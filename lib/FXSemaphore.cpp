@@ -21,6 +21,10 @@
 #include "xincs.h"
 #include "fxver.h"
 #include "fxdefs.h"
+#include "FXAtomic.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
 #include "FXSemaphore.h"
 
 /*
@@ -48,16 +52,80 @@
     than strictly necessary on some machines.  It may actually be a good thing
     as this increases the odds of these datastructures living in dedicated
     cache-lines.
+
+  - On Linux, the semaphore is implemented directly on top of futexes: a count and a
+    number of waiters, both kept in the reserved space.  A post with nobody waiting,
+    or a wait when the count is positive, is a single atomic operation and does not
+    enter the kernel at all; only when the count is zero does the waiter block on the
+    count's futex, after spinning for a short while first.
+
+  - The waiter registers itself before checking the count, and the poster checks for
+    waiters after raising the count; both use sequentially consistent operations, so
+    either the waiter sees the new count, or the poster sees the waiter.
+
+  - Spinning is done SPINCOUNT times; set it to zero to block right away.
+
+  - Batch trywait(count) and post(count) adjust the count in one atomic step on Linux;
+    a post of more than one wakes all waiters, as it may satisfy several of them.
+    Elsewhere, they're simply repeated single operations.
 */
 
 #define TOPIC_CONSTRUCT 1000
 
+#define SPINCOUNT       100
+
 using namespace FX;
 
 /*******************************************************************************/
 
 namespace FX {
 
+#if defined(__linux__)
+
+// Semaphore count and number of waiters
+#define COUNT    ((volatile FXuint*)&data[0])
+#define WAITERS  ((volatile FXuint*)&data[1])
+
+
+// Try decrement count; return false if count was zero
+static inline FXbool decrementCount(volatile FXuint* count){
+  FXuint c;
+  while((c=__atomic_load_n(count,__ATOMIC_SEQ_CST))!=0){
+    if(atomicBoolCas(count,c,c-1)) return true;
+    }
+  return false;
+  }
+
+
+// Decrement count, blocking for at most nsec while count is zero
+static FXbool waitCount(volatile FXuint* count,volatile FXuint* waiters,FXTime nsec){
+  FXTime deadline=forever;
+  FXTime remaining=forever;
+  for(FXint spin=0; spin<SPINCOUNT; ++spin){
+    if(decrementCount(count)) return true;
+    FXThread::pause();
+    }
+  if(nsec<forever){
+    FXTime now=FXThread::steadytime();
+    if(nsec<forever-now) deadline=now+nsec;
+    }
+  atomicAdd(waiters,1U);
+  while(!decrementCount(count)){
+    if(deadline<forever){
+      remaining=deadline-FXThread::steadytime();
+      if(remaining<=0){
+        atomicAdd(waiters,-1U);
+        return false;
+        }
+      }
+    atomicWait(count,0,remaining);
+    }
+  atomicAdd(waiters,-1U);
+  return true;
+  }
+
+#endif
+
 
 // Initialize semaphore with given count
 FXSemaphore::FXSemaphore(FXint count){
@@ -75,6 +143,9 @@ FXSemaphore::FXSemaphore(FXint count){
   data[0]=count;
   pthread_cond_init((pthread_cond_t*)&data[1],nullptr);
   pthread_mutex_init((pthread_mutex_t*)&data[10],nullptr);
+#elif defined(__linux__)
+  data[0]=data[1]=0;
+  *COUNT=(FXuint)count;
 #else
   // If this fails on your machine, determine what value
   // of sizeof(sem_t) is supposed to be on your
@@ -100,6 +171,8 @@ FXbool FXSemaphore::wait(){
     return true;
     }
   return false;
+#elif defined(__linux__)
+  return waitCount(COUNT,WAITERS,forever);
 #else
   return sem_wait((sem_t*)data)==0;
 #endif
@@ -150,6 +223,11 @@ FXbool FXSemaphore::wait(FXTime nsec){
     return true;
     }
   return false;
+#elif defined(__linux__)
+  if(0<nsec){
+    return waitCount(COUNT,WAITERS,nsec);
+    }
+  return decrementCount(COUNT);
 #else
   if(0<nsec){
     if(nsec<forever){
@@ -191,12 +269,31 @@ FXbool FXSemaphore::trywait(){
     return true;
     }
   return false;
+#elif defined(__linux__)
+  return decrementCount(COUNT);
 #else
   return sem_trywait((sem_t*)data)==0;
 #endif
   }
 
 
+// Try decrement semaphore by up to count; return amount decremented
+FXint FXSemaphore::trywait(FXint count){
+#if defined(__linux__)
+  FXuint c,m;
+  while((c=__atomic_load_n(COUNT,__ATOMIC_SEQ_CST))!=0 && 0<count){
+    m=FXMIN(c,(FXuint)count);
+    if(atomicBoolCas(COUNT,c,c-m)) return m;
+    }
+  return 0;
+#else
+  FXint result=0;
+  while(result<count && trywait()){ ++result; }
+  return result;
+#endif
+  }
+
+
 // Increment semaphore
 FXbool FXSemaphore::post(){
 #if defined(WIN32)
@@ -209,12 +306,38 @@ FXbool FXSemaphore::post(){
     return true;
     }
   return false;
+#elif defined(__linux__)
+  atomicAdd(COUNT,1U);
+  if(__atomic_load_n(WAITERS,__ATOMIC_SEQ_CST)){ atomicNotify(COUNT); }
+  return true;
 #else
   return sem_post((sem_t*)data)==0;
 #endif
   }
 
 
+// Increment semaphore by count
+FXbool FXSemaphore::post(FXint count){
+#if defined(WIN32)
+  return count<=0 || ReleaseSemaphore((HANDLE)data[0],count,nullptr)!=0;
+#elif defined(__linux__)
+  if(0<count){
+    atomicAdd(COUNT,(FXuint)count);
+    if(__atomic_load_n(WAITERS,__ATOMIC_SEQ_CST)){
+      if(count==1) atomicNotify(COUNT); else atomicNotifyAll(COUNT);
+      }
+    }
+  return true;
+#else
+  while(0<count){
+    if(!post()) return false;
+    --count;
+    }
+  return true;
+#endif
+  }
+
+
 // Delete semaphore
 FXSemaphore::~FXSemaphore(){
 #if defined(WIN32)
@@ -222,6 +345,8 @@ FXSemaphore::~FXSemaphore(){
 #elif (defined(__APPLE__) || defined(__minix))
   pthread_mutex_destroy((pthread_mutex_t*)&data[10]);
   pthread_cond_destroy((pthread_cond_t*)&data[1]);
+#elif defined(__linux__)
+  // Nothing to release
 #else
   sem_destroy((sem_t*)data);
 #endif
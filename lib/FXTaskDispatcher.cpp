@@ -0,0 +1,179 @@
+/********************************************************************************
+*                                                                               *
+*                         T a s k   D i s p a t c h e r                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxmath.h"
+#include "FXAtomic.h"
+#include "FXElement.h"
+#include "FXHash.h"
+#include "FXPtrList.h"
+#include "FXMutex.h"
+#include "FXCallback.h"
+#include "FXRunnable.h"
+#include "FXAutoThreadStorageKey.h"
+#include "FXThread.h"
+#include "FXException.h"
+#include "FXReactor.h"
+#include "FXDispatcher.h"
+#include "FXTaskDispatcher.h"
+
+/*
+  Notes:
+
+  - Other threads post tasks to the dispatcher; these are collected in a list, and
+    the dispatching thread is woken up by writing a byte into a pipe.  Only the post
+    which finds the list empty writes the pipe; the dispatching thread drains the pipe
+    before taking the list, so that a task posted after that always finds the list
+    empty again and writes a new byte.
+
+  - On Windows, the pipe is replaced by an auto-reset event.
+
+  - Post checks the pipe while holding the lock, since exit() closes it under the
+    same lock; otherwise a late post could write into a closed, or reused, handle.
+
+  - The dispatching thread takes the whole list in one go, and then runs the tasks
+    without holding the lock; so posting never waits for a task to run.
+
+  - A task may call dispatch() recursively.  The nested call will not run any tasks,
+    but leaves them for the outer call, which checks again after it has run the
+    tasks it took; this keeps the tasks in the order they were posted.
+
+  - If a task throws, the tasks taken along with it which have not yet run are put
+    back, ahead of any tasks posted in the meantime, before the exception is passed on.
+
+  - Tasks still pending when the dispatcher exits are not run, nor deleted; the
+    dispatcher does not own them.
+*/
+
+// Bad handle value
+#if defined(WIN32)
+#define BadHandle  INVALID_HANDLE_VALUE
+#else
+#define BadHandle  -1
+#endif
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Construct task dispatcher object
+FXTaskDispatcher::FXTaskDispatcher(){
+  wakeup[0]=wakeup[1]=BadHandle;
+  }
+
+
+// Initialize dispatcher
+FXbool FXTaskDispatcher::init(){
+  if(FXDispatcher::init()){
+#if defined(WIN32)
+    if((wakeup[0]=::CreateEvent(nullptr,false,false,nullptr))==nullptr){ throw FXResourceException("unable to create event."); }
+#else
+    if(::pipe(wakeup)!=0){ throw FXResourceException("unable to create pipe."); }
+    ::fcntl(wakeup[0],F_SETFD,FD_CLOEXEC);
+    ::fcntl(wakeup[1],F_SETFD,FD_CLOEXEC);
+    ::fcntl(wakeup[0],F_SETFL,O_NONBLOCK);
+    ::fcntl(wakeup[1],F_SETFL,O_NONBLOCK);
+#endif
+    addHandle(HandleCallback::create<FXTaskDispatcher,&FXTaskDispatcher::onWakeup>(this),wakeup[0],InputRead);
+    return true;
+    }
+  return false;
+  }
+
+
+// Post task to be run by dispatching thread
+FXbool FXTaskDispatcher::post(FXRunnable* task){
+  FXbool result=false;
+  if(__likely(task)){
+    mutex.lock();
+    if(wakeup[0]!=BadHandle){
+      posted.append(task);
+      if(posted.no()==1) notify();
+      result=true;
+      }
+    mutex.unlock();
+    }
+  return result;
+  }
+
+
+// Wake up dispatching thread
+void FXTaskDispatcher::notify(){
+#if defined(WIN32)
+  ::SetEvent(wakeup[0]);
+#else
+  FXuchar byte=0;
+  if(::write(wakeup[1],&byte,1)!=1){ }
+#endif
+  }
+
+
+// Run tasks posted by other threads
+FXbool FXTaskDispatcher::onWakeup(FXDispatcher*,FXInputHandle,FXuint,void*){
+  FXbool result=false;
+#if !defined(WIN32)
+  FXuchar buffer[64];
+  while(0<::read(wakeup[0],buffer,sizeof(buffer))){ }
+#endif
+  if(running.no()==0){
+    while(1){
+      mutex.lock();
+      running.adopt(posted);
+      mutex.unlock();
+      if(running.no()==0) break;
+      for(FXival i=0; i<running.no(); ++i){
+        try{
+          running[i]->run();
+          }
+        catch(...){                     // Put back the tasks not yet run
+          running.erase(0,i+1);
+          mutex.lock();
+          running.append(posted);
+          posted.adopt(running);
+          if(0<posted.no()) notify();
+          mutex.unlock();
+          throw;
+          }
+        }
+      running.clear();
+      result=true;
+      }
+    }
+  return result;
+  }
+
+
+// Exit dispatcher
+FXbool FXTaskDispatcher::exit(){
+  if(wakeup[0]!=BadHandle){
+    remHandle(wakeup[0]);
+    mutex.lock();
+#if defined(WIN32)
+    ::CloseHandle(wakeup[0]);
+#else
+    ::close(wakeup[0]);
+    ::close(wakeup[1]);
+#endif
+    wakeup[0]=wakeup[1]=BadHandle;
+    posted.clear();
+    mutex.unlock();
+    }
+  return FXDispatcher::exit();
+  }
+
+
+// Destroy task dispatcher object
+FXTaskDispatcher::~FXTaskDispatcher(){
+  exit();
+  }
+
+}
@@ -19,6 +19,7 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>          *
 ********************************************************************************/
 #include "xincs.h"
+#include <exception>
 #include "fxver.h"
 #include "fxdefs.h"
 #include "fxmath.h"
@@ -51,20 +52,52 @@
     queue is empty will the calling thread drop out of the FXThreadPoll's processing loop to
     actually block for the completion semaphore.
 
+  - Task graphs are built from FXTaskGroup::Node objects.  Each node keeps a count of
+    predecessors which have not yet completed, plus one which is released when the node
+    is scheduled.  The thread which drops the count to zero hands the node to the thread
+    pool; thus, the worker completing the last predecessor starts the node, and nobody
+    needs to block in between stages.
+
+  - A node is counted in the task group's completion from the time it is scheduled;
+    it is only uncounted after all its successors have been released, so the group
+    can not appear done while part of the graph is still pending.
+
+  - When a node's runnable throws, its successors are marked as failed; a failed node
+    is not run, but released right away, passing the failure on to its own successors.
+
+  - Successors which become ready are handed to the thread pool; skipped ones, and ones
+    the thread pool does not accept, go on a worklist of the thread releasing them.  So
+    cancelling or failing a long chain of nodes, or running it on a stopped thread pool,
+    loops rather than recurses.  When a runnable run from the worklist throws, the rest
+    of the worklist is still processed, and the first exception is rethrown afterwards.
+
+  - Statistics are cheap: a counter of tasks submitted, from which the number completed
+    follows, and the time spent in wait().  When the thread pool collects timing
+    statistics, the task wrapper is stamped on creation, so the thread pool can
+    record how long it waited in the queue.
+
+  - A batch of tasks is wrapped in chunks of 64, each chunk being handed to the thread
+    pool in one go; wrappers of tasks the thread pool could not accept are deleted,
+    which uncounts them again.
+
   - Possible improvements:
 
       o For FXParallel, we could have a special flavor of FXTaskGroup::Task that does not wrap
         a FXRunnable but has a more streamlined implementation, thus avoiding allocs and frees.
 
-      o We would like some kind of early termination capability.  For instance, in a parallel
-        search algorithm we would like to stop (or never even start) tasks when one of them is
-        successful.
-
       o Another case of early termination would be the throwing of exceptions from one of the
         tasks.
 
-      o For now, we don't have a good mechanism for this; we do want to keep this light-weight
-        since FXTaskGroup is created on the stack in FXParallel.
+  - Cancellation is cooperative: a cancelled group's task wrappers and graph nodes skip their
+    runnable when they come up, so queued work is dropped at little cost; running tasks
+    must poll isCancelled() themselves.  Skipped nodes pass on failure to their successors.
+
+  - Each task wrapper makes its group the current one for the duration of the task, using a
+    thread-local variable.  A group constructed while a task runs, e.g. by FXParallelFor,
+    records the current group as its parent, and isCancelled() checks the chain of parents;
+    so cancelling a search also stops the parallel loops started by its tasks.  The parent
+    is sure to outlive the nested group, since the task creating the nested group waits
+    for it before it completes.
 */
 
 using namespace FX;
@@ -73,21 +106,27 @@ using namespace FX;
 
 namespace FX {
 
+// Task group of task running on calling thread
+FXAutoThreadStorageKey FXTaskGroup::currentgroup;
+
+
 // Create new group of tasks
-FXTaskGroup::FXTaskGroup():threadpool(FXThreadPool::instance()){
+FXTaskGroup::FXTaskGroup():threadpool(FXThreadPool::instance()),parent(current()),cancelled(0),submitted(0),waiting(0){
   if(!threadpool){ fxerror("FXTaskGroup::FXTaskGroup: No thread pool was set."); }
   }
 
 
 // Create new group of tasks
-FXTaskGroup::FXTaskGroup(FXThreadPool* p):threadpool(p){
+FXTaskGroup::FXTaskGroup(FXThreadPool* p):threadpool(p),parent(current()),cancelled(0),submitted(0),waiting(0){
   if(!threadpool){ fxerror("FXTaskGroup::FXTaskGroup: No thread pool was set."); }
   }
 
 
 // Construct task group task
-FXTaskGroup::Task::Task(FXTaskGroup* g,FXRunnable *r):taskgroup(g),runnable(r){
+FXTaskGroup::Task::Task(FXTaskGroup* g,FXRunnable *r):taskgroup(g),runnable(r),stamp(0){
+  if(taskgroup->threadpool->timing) stamp=FXThread::steadytime();
   taskgroup->completion.increment();
+  atomicAdd(&taskgroup->submitted,1U);
   }
 
 
@@ -99,45 +138,167 @@ FXTaskGroup::Task::~Task(){
 
 // Process task group task
 FXint FXTaskGroup::Task::run(){
-  try{
-    runnable->run();
-    }
-  catch(...){
-    delete this;
-    throw;
-    }
-/*
-  if(!group->isCancelled()){
+  if(stamp) taskgroup->threadpool->recordWait(FXThread::steadytime()-stamp);
+  if(!taskgroup->isCancelled()){
+    FXptr previous=currentgroup.get();
+    currentgroup.set(taskgroup);
     try{
       runnable->run();
       }
-    catch(const FXResourceException&){         // FIXME perhaps dedicated FXException type to cancel the group, and another FXException type to cancel everything recursively...
-      group->setCancelled(true);
+    catch(...){
+      currentgroup.set(previous);
+      delete this;
+      throw;
       }
+    currentgroup.set(previous);
     }
-*/
   delete this;
   return 0;
   }
 
 
+// Construct task graph node
+FXTaskGroup::Node::Node(FXRunnable* r):runnable(r),taskgroup(nullptr),pending(1),failed(0){
+  }
+
+
+// Run node after predecessor completed
+void FXTaskGroup::Node::after(Node* pred){
+  if(__likely(pred)){
+    pred->successors.append(this);
+    atomicAdd(&pending,1U);
+    }
+  }
+
+
+// Node has no more pending predecessors; hand it to the thread pool, or process
+// it here if it is to be skipped or the thread pool does not accept it
+void FXTaskGroup::Node::ready(){
+  if(failed || taskgroup->isCancelled() || !taskgroup->threadpool->execute(this)){
+    process();
+    }
+  }
+
+
+// Run node, or skip it if a predecessor failed, then release its successors,
+// passing on failure, and count it as completed.  Successors which become ready
+// are handed to the thread pool; those to be skipped, or which the thread pool
+// does not accept, are processed by this loop rather than recursively
+void FXTaskGroup::Node::process(){
+  FXTaskGroup* group=taskgroup;
+  FXPtrListOf<Node> work;
+  std::exception_ptr exception;
+  Node* node=this;
+  FXbool fail;
+  FXint i;
+  while(1){
+    fail=true;
+    if(!node->failed && !group->isCancelled()){
+      FXptr previous=currentgroup.get();
+      currentgroup.set(group);
+      try{
+        if(node->runnable) node->runnable->run();
+        fail=false;
+        }
+      catch(...){
+        if(!exception) exception=std::current_exception();
+        }
+      currentgroup.set(previous);
+      }
+    for(i=0; i<node->successors.no(); ++i){
+      Node* succ=node->successors[i];
+      if(fail) succ->failed=1;
+      if(atomicAdd(&succ->pending,-1U)==1){
+        if(succ->failed || group->isCancelled() || !group->threadpool->execute(succ)) work.push(succ);
+        }
+      }
+    group->completion.decrement();
+    if(work.no()==0) break;
+    node=work.tail();
+    work.pop();
+    }
+  if(exception) std::rethrow_exception(exception);
+  }
+
+
+// Process task graph node
+FXint FXTaskGroup::Node::run(){
+  process();
+  return 0;
+  }
+
+
+// Destroy task graph node
+FXTaskGroup::Node::~Node(){
+  }
+
+
+// Cancel or uncancel task group
+void FXTaskGroup::setCancelled(FXbool flag){
+  cancelled=flag;
+  }
+
+
+// Return task group of task running on calling thread
+FXTaskGroup* FXTaskGroup::current(){
+  return (FXTaskGroup*)currentgroup.get();
+  }
+
+
 // Start task
 FXbool FXTaskGroup::execute(FXRunnable* task){
   if(__likely(task)){
-    if(threadpool->execute(new FXTaskGroup::Task(this,task))){
+    FXTaskGroup::Task* wrapper=new FXTaskGroup::Task(this,task);
+    if(threadpool->execute(wrapper)){
       return true;
       }
+    delete wrapper;
     }
   return false;
   }
 
 
+// Start batch of tasks
+FXuint FXTaskGroup::execute(FXRunnable** batch,FXuint n){
+  FXRunnable* wrapped[64];
+  FXuint result=0,m,i;
+  while(result<n){
+    m=FXMIN(n-result,64);
+    for(i=0; i<m; ++i){
+      wrapped[i]=new FXTaskGroup::Task(this,batch[result+i]);
+      }
+    i=threadpool->execute(wrapped,m);
+    result+=i;
+    if(i<m){
+      while(i<m){ delete wrapped[i++]; }
+      break;
+      }
+    }
+  return result;
+  }
+
+
 // Start task in this task group, then wait till done
 FXbool FXTaskGroup::executeAndWait(FXRunnable* task){
   if(__likely(task)){
-    if(threadpool->executeAndWaitFor(new FXTaskGroup::Task(this,task),completion)){
+    FXTaskGroup::Task* wrapper=new FXTaskGroup::Task(this,task);
+    if(threadpool->executeAndWaitFor(wrapper,completion)){
       return true;
       }
+    delete wrapper;
+    }
+  return false;
+  }
+
+
+// Schedule task graph node
+FXbool FXTaskGroup::schedule(Node* node){
+  if(__likely(node && !node->taskgroup)){
+    node->taskgroup=this;
+    completion.increment();
+    atomicAdd(&submitted,1U);
+    if(atomicAdd(&node->pending,-1U)==1) node->ready();
+    return true;
     }
   return false;
   }
@@ -145,7 +306,9 @@ FXbool FXTaskGroup::executeAndWait(FXRunnable* task){
 
 // Wait for completion
 FXbool FXTaskGroup::wait(){
+  FXTime start=FXThread::steadytime();
   if(threadpool->waitFor(completion)){
+    waiting+=FXThread::steadytime()-start;
     return true;
     }
   return false;
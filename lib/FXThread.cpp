@@ -850,12 +850,10 @@ FXbool FXThread::affinity(FXulong mask){
 #elif defined(HAVE_PTHREAD_SETAFFINITY_NP)
   const FXulong bit=1;
   if(tid){
-    FXint ncpus=processors();
-    mask&=((bit<<ncpus)-1);
     if(mask){
       cpu_set_t cpuset;
       CPU_ZERO(&cpuset);
-      for(FXint cpu=0; cpu<ncpus; ++cpu){
+      for(FXint cpu=0; cpu<64; ++cpu){
         if((bit<<cpu)&mask){ CPU_SET(cpu,&cpuset); }
         }
       return pthread_setaffinity_np((pthread_t)tid,sizeof(cpuset),&cpuset)==0;
@@ -881,11 +879,10 @@ FXulong FXThread::affinity() const {
 #elif defined(HAVE_PTHREAD_SETAFFINITY_NP)
   const FXulong bit=1;
   if(tid){
-    FXint ncpus=processors();
     cpu_set_t cpuset;
     if(pthread_getaffinity_np((pthread_t)tid,sizeof(cpuset),&cpuset)==0){
       FXulong mask=0;
-      for(FXint cpu=0; cpu<ncpus; ++cpu){
+      for(FXint cpu=0; cpu<64; ++cpu){
         if(CPU_ISSET(cpu,&cpuset)){ mask|=(bit<<cpu); }
         }
       return mask;
@@ -22,6 +22,7 @@
 #include "fxver.h"
 #include "fxdefs.h"
 #include "fxmath.h"
+#include "fxendian.h"
 #include "FXException.h"
 #include "FXElement.h"
 #include "FXArray.h"
@@ -34,6 +35,7 @@
 #include "FXThread.h"
 #include "FXWorker.h"
 #include "FXLFQueue.h"
+#include "FXWSQueue.h"
 #include "FXThreadPool.h"
 
 /*
@@ -72,6 +74,79 @@
   - No new tasks can be posted when about to shut down; so when queue becomes empty, it
     will stay empty.
 
+  - With the work-stealing scheduler, each worker claims one of a fixed set of task
+    deques when it starts.  Tasks executed from inside a worker are pushed on its own
+    deque, where only the worker itself pushes and pops; other workers may only take
+    (steal) from the other end.  Tasks from outside threads still use the shared queue.
+
+  - The usedslots semaphore then counts all tasks available, whether in the shared
+    queue or in a deque.  A thread which obtained a used slot is entitled to exactly
+    one task; it tries its own deque first, then the shared queue, and then steals from
+    the other deques.  Since a task is always made visible before the used slot is
+    posted, one of these is sure to succeed, except when the pool is stopped.
+
+  - Deques belong to the thread pool, not to the workers: a worker expiring while its
+    deque is not yet empty simply releases the deque, the remaining tasks will be stolen
+    or picked up by the next worker claiming it.
+
+  - Each worker claims a slot when it starts; the slot number is the worker index, and
+    with work-stealing, it is also the index of the deque used by the worker.
+
+  - Compact placement pins the worker in slot i to the i-th processor in an ordering
+    where all physical cores come before their hyper-threads, and within that, cores
+    are grouped by package and by shared last level cache.  Thus adjacent worker slots
+    are on adjacent cores, and a parallel loop handing adjacent chunks to adjacent
+    workers keeps neighboring data in the same cache.
+
+  - On Linux, only the processors in the process's affinity mask are used, as their
+    numbers need not run from 0 to processors()-1, e.g. in a cpuset or under taskset;
+    their topology is read from /sys/devices/system/cpu.  Elsewhere, processors 0 up
+    to processors()-1 are simply used in numerical order.
+    Processors beyond the first 64 can not be expressed in the affinity mask, and
+    workers assigned to these are not pinned.
+
+  - High priority tasks go through a second shared queue, with its own free slots
+    semaphore; the usedslots semaphore counts tasks in both.  A worker holding a used
+    slot tries the high priority queue first, then its own deque, the normal queue,
+    and finally the other deques.
+
+  - Aging: after a run of consecutive high priority tasks (counted over all workers),
+    the high priority queue is skipped once, giving a pending normal task a turn;
+    if no normal task turns up, the high priority queue is tried again.  So normal
+    tasks get at least a fixed fraction of the workers' time, while an idle high
+    priority queue costs only a failed pop.  An aging of zero disables this, and
+    high priority tasks always go first.
+
+  - High priority tasks executed from a worker bypass its deque, since the deque is
+    only consulted after the high priority queue anyway.
+
+  - Batch execute claims as many free slots as it can get in one step, blocking only
+    if there is none at all; then it enters that many tasks with one batch push, and
+    posts the used slots once.  Worker threads are started as needed for the whole
+    batch up front.  From inside a worker, with work-stealing, the batch goes to the
+    worker's deque, as far as it has room.
+
+  - Statistics: task counts, queue high-water mark, and the time producers spent
+    blocked on a full queue cost only a few atomic adds per task and are always kept;
+    the blocked time is only measured when trywait() fails, i.e. when actually about
+    to block.  The queue count is of all tasks waiting to be run: in the shared queue,
+    the high priority queue, and the deques.
+
+  - Timing statistics need two clock readings per task, so they are optional.  The
+    busy and idle times are kept per worker slot, and only updated by the worker
+    owning the slot.  The arrays survive stop(), so they can be examined afterwards;
+    they are reallocated by the next start().
+
+  - Statistics may be switched on or off, and reset, while the pool runs.  A worker
+    takes a clock reading only when timing is on, and skips an interval when the
+    reading at its start was not taken.  Reset swaps each counter with zero, and the
+    workers add to the per slot times atomically, so no update is lost across a
+    reset; counters reset separately may be briefly inconsistent, e.g. a task in
+    flight at the reset is counted as completed but not as submitted.
+
+  - Tasks themselves carry no time stamp, so the queue wait can only be measured for
+    FXTaskGroup tasks, whose wrapper records the submission time.
+
 */
 
 #define TOPIC_DETAIL    1002
@@ -88,8 +163,105 @@ namespace FX {
 FXAutoThreadStorageKey FXThreadPool::reference;
 
 
+// Slot of worker thread, plus one
+FXAutoThreadStorageKey FXThreadPool::workerslot;
+
+
+#if defined(__linux__)
+
+extern FXAPI FXint __snprintf(FXchar* string,FXint length,const FXchar* format,...);
+
+
+// Read first number from sysfs file, return -1 if not available
+static FXint readTopology(FXint cpu,const FXchar* item){
+  FXchar path[128];
+  FXint result=-1;
+  __snprintf(path,sizeof(path),"/sys/devices/system/cpu/cpu%d/%s",cpu,item);
+  FILE* file=fopen(path,"r");
+  if(file){
+    if(fscanf(file,"%d",&result)!=1) result=-1;
+    fclose(file);
+    }
+  return result;
+  }
+
+
+// Return identifier of last level cache shared by cpu, being the first cpu sharing it
+static FXint readSharedCache(FXint cpu){
+  FXchar item[64];
+  FXint result=-1,level=-1;
+  for(FXint index=0; index<16; ++index){
+    __snprintf(item,sizeof(item),"cache/index%d/level",index);
+    FXint lev=readTopology(cpu,item);
+    if(lev<0) break;
+    if(lev>=level){
+      __snprintf(item,sizeof(item),"cache/index%d/shared_cpu_list",index);
+      result=readTopology(cpu,item);
+      level=lev;
+      }
+    }
+  return result;
+  }
+
+
+// Compare topology keys of two processors
+static FXbool keyBefore(const FXint* a,const FXint* b){
+  for(FXint k=0; k<4; ++k){
+    if(a[k]!=b[k]) return a[k]<b[k];
+    }
+  return false;
+  }
+
+#endif
+
+
+// Find processors this process may run on, ordered so that physical cores come
+// first, grouped by package and by shared cache, followed by their hyper-threads;
+// returns the number of processors, with their identifiers in a new array
+static FXint processorOrder(FXint*& order){
+  FXint n=0,i,j;
+#if defined(__linux__)
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  if(sched_getaffinity(0,sizeof(cpuset),&cpuset)==0 && allocElms(order,CPU_COUNT(&cpuset))){
+    for(i=0; i<CPU_SETSIZE; ++i){
+      if(CPU_ISSET(i,&cpuset)) order[n++]=i;
+      }
+    FXint *key;
+    if(0<n && allocElms(key,(order[n-1]+1)*4)){
+      for(i=0; i<n; ++i){
+        FXint cpu=order[i];
+        key[cpu*4+0]=(readTopology(cpu,"topology/thread_siblings_list")<cpu);
+        key[cpu*4+1]=readTopology(cpu,"topology/physical_package_id");
+        key[cpu*4+2]=readSharedCache(cpu);
+        key[cpu*4+3]=readTopology(cpu,"topology/core_id");
+        }
+      for(i=1; i<n; ++i){
+        FXint cpu=order[i];
+        for(j=i; 0<j && keyBefore(&key[cpu*4],&key[order[j-1]*4]); --j){
+          order[j]=order[j-1];
+          }
+        order[j]=cpu;
+        }
+      freeElms(key);
+      }
+    return n;
+    }
+#endif
+  FXint ncpus=FXThread::processors();
+  if(allocElms(order,ncpus)){
+    for(n=0; n<ncpus; ++n){
+      order[n]=n;
+      }
+    }
+  return n;
+  }
+
+
 // Create thread pool
-FXThreadPool::FXThreadPool(FXuint sz):queue(sz),freeslots(sz),usedslots(0),stacksize(0),expiration(forever),maximum(FXThread::processors()),minimum(1),workers(0),running(0){
+FXThreadPool::FXThreadPool(FXuint sz):queue(sz),urgent(sz),deques(nullptr),owners(nullptr),cpus(nullptr),freeslots(sz),urgentslots(sz),usedslots(0),stacksize(0),expiration(forever),maximum(FXThread::processors()),minimum(1),workers(0),running(0),scheduler(SchedulerShared),placement(PlacementNone),aging(8),streak(0),timing(false),submitted(0),completed(0),queued(0),highwater(0),blocked(0),busytime(nullptr),idletime(nullptr),nslots(0){
+  clearElms(waithist,LatencyBuckets);
+  clearElms(runhist,LatencyBuckets);
   FXTRACE((TOPIC_DETAIL,"FXThreadPool::FXThreadPool(%d)\n",sz));
   }
 
@@ -99,9 +271,9 @@ FXbool FXThreadPool::setSize(FXuint sz){
   if((sz<8) || (sz&(sz-1))){ fxerror("FXThreadPool::setSize: bad argument: %u.\n",sz); }
   if(atomicBoolCas(&running,0,2)){
     FXuint osz=queue.getSize();
-    if(setSize(sz)){
-      while(osz<sz){ ++osz; freeslots.post(); }
-      while(osz>sz){ --osz; freeslots.wait(); }
+    if(queue.setSize(sz) && urgent.setSize(sz)){
+      while(osz<sz){ ++osz; freeslots.post(); urgentslots.post(); }
+      while(osz>sz){ --osz; freeslots.wait(); urgentslots.wait(); }
       running=0;
       return true;
       }
@@ -155,6 +327,103 @@ FXbool FXThreadPool::setStackSize(FXuval sz){
   }
 
 
+// Change scheduling policy
+FXbool FXThreadPool::setScheduler(Scheduler policy){
+  if(atomicBoolCas(&running,0,2)){
+    scheduler=policy;
+    running=0;
+    return true;
+    }
+  return false;
+  }
+
+
+// Change aging of high priority tasks
+FXbool FXThreadPool::setAging(FXuint n){
+  if(atomicBoolCas(&running,0,2)){
+    aging=n;
+    running=0;
+    return true;
+    }
+  return false;
+  }
+
+
+// Change placement policy
+FXbool FXThreadPool::setPlacement(Placement policy){
+  if(atomicBoolCas(&running,0,2)){
+    placement=policy;
+    running=0;
+    return true;
+    }
+  return false;
+  }
+
+
+// Enable timing statistics
+FXbool FXThreadPool::setStatistics(FXbool flag){
+  atomicSet(&timing,(FXuint)flag);
+  return true;
+  }
+
+
+// Reset statistics; also while running, so each counter is swapped out atomically
+FXbool FXThreadPool::resetStatistics(){
+  FXuint i;
+  atomicSet(&submitted,FXULONG(0));
+  atomicSet(&completed,FXULONG(0));
+  atomicSet(&highwater,0U);
+  atomicSet(&blocked,FXLONG(0));
+  for(i=0; i<nslots; ++i){
+    atomicSet(&busytime[i],FXLONG(0));
+    atomicSet(&idletime[i],FXLONG(0));
+    }
+  for(i=0; i<LatencyBuckets; ++i){
+    atomicSet(&waithist[i],FXULONG(0));
+    atomicSet(&runhist[i],FXULONG(0));
+    }
+  return true;
+  }
+
+
+// Return time worker w spent running tasks
+FXTime FXThreadPool::getBusyTime(FXint w) const {
+  return (0<=w && w<(FXint)nslots) ? busytime[w] : 0;
+  }
+
+
+// Return time worker w spent waiting for tasks
+FXTime FXThreadPool::getIdleTime(FXint w) const {
+  return (0<=w && w<(FXint)nslots) ? idletime[w] : 0;
+  }
+
+
+// Return run time histogram bucket
+FXulong FXThreadPool::getRunHistogram(FXint b) const {
+  return (0<=b && b<LatencyBuckets) ? runhist[b] : 0;
+  }
+
+
+// Return queue wait histogram bucket
+FXulong FXThreadPool::getWaitHistogram(FXint b) const {
+  return (0<=b && b<LatencyBuckets) ? waithist[b] : 0;
+  }
+
+
+// Histogram bucket for time t; bucket 0 is below 1024ns, each next bucket twice as wide
+FXint FXThreadPool::latencyBucket(FXTime t){
+  FXulong q=((FXulong)t)>>10;
+  FXint b=q?64-(FXint)clz64(q):0;
+  return FXMIN(b,LatencyBuckets-1);
+  }
+
+
+// Record time a task spent waiting in the queue
+void FXThreadPool::recordWait(FXTime wait){
+  atomicAdd(&waithist[latencyBucket(wait)],FXULONG(1));
+  }
+
+
 // Return calling thread's thread pool
 FXThreadPool* FXThreadPool::instance(){
   return (FXThreadPool*)reference.get();
@@ -178,12 +447,103 @@ FXbool FXThreadPool::startWorker(){
   }
 
 
+// Claim unused worker slot, if any
+FXint FXThreadPool::claimSlot(){
+  for(FXuint i=0; i<maximum; ++i){
+    if(atomicBoolCas(&owners[i],0U,1U)) return i;
+    }
+  return -1;
+  }
+
+
+// Release worker slot
+void FXThreadPool::releaseSlot(FXint slot){
+  if(0<=slot){
+    atomicSet(&owners[slot],0U);
+    }
+  }
+
+
+// Return index of calling worker thread, or -1
+FXint FXThreadPool::getWorkerIndex() const {
+  if(instance()==this){
+    return (FXint)(FXival)workerslot.get()-1;
+    }
+  return -1;
+  }
+
+
+// Return calling thread's task deque, if it is one of our workers
+FXWSQueue* FXThreadPool::localDeque() const {
+  if(deques){
+    FXint slot=getWorkerIndex();
+    if(0<=slot) return &deques[slot];
+    }
+  return nullptr;
+  }
+
+
+// Claim a task after a used slot was obtained; return false if there is none
+FXbool FXThreadPool::claimTask(FXRunnable*& task){
+  FXWSQueue* local=localDeque();
+  FXuint first=local?(FXuint)(local-deques):0;
+  do{
+    if(aging==0 || streak<aging){
+      if(urgent.pop(task)){ urgentslots.post(); atomicAdd(&streak,1U); return true; }
+      }
+    atomicSet(&streak,0U);
+    if(local && local->pop((FXptr&)task)) return true;
+    if(queue.pop(task)){ freeslots.post(); return true; }
+    if(deques){
+      for(FXuint i=1; i<=maximum; ++i){
+        FXWSQueue* victim=&deques[(first+i)%maximum];
+        if(victim!=local && victim->take((FXptr&)task)) return true;
+        }
+      }
+    }
+  while(!tasks.done());
+  return false;
+  }
+
+
 // Start thread pool
 FXuint FXThreadPool::start(FXuint count){
   FXuint result=0;
   FXTRACE((TOPIC_DETAIL,"FXThreadPool::start(%u)\n",count));
   if(atomicBoolCas(&running,0,2)){
 
+    // Allocate worker slots
+    callocElms(owners,maximum);
+
+    // Allocate worker times
+    if(nslots!=maximum){
+      freeElms(busytime);
+      freeElms(idletime);
+      callocElms(busytime,maximum);
+      callocElms(idletime,maximum);
+      nslots=maximum;
+      }
+
+    // Allocate task deques for work-stealing
+    if(scheduler==SchedulerStealing){
+      deques=new FXWSQueue[maximum];
+      for(FXuint i=0; i<maximum; ++i){
+        deques[i].setSize(queue.getSize());
+        }
+      }
+
+    // Assign processors to worker slots
+    if(placement==PlacementCompact){
+      FXint *order=nullptr;
+      FXint n=processorOrder(order);
+      if(0<n && allocElms(cpus,maximum)){
+        for(FXuint i=0; i<maximum; ++i){
+          cpus[i]=order[i%n];
+          }
+        }
+      freeElms(order);
+      }
+
     // Start number of workers
     while(result<count && startWorker()){
       result++;
@@ -201,16 +561,34 @@ FXuint FXThreadPool::start(FXuint count){
 
 // Wait until counter becomes zero, return if no new tasks posted within timeout
 void FXThreadPool::runWhile(FXCompletion& comp,FXTime timeout){
+  FXint slot=getWorkerIndex();
+  FXTime t0=timing?FXThread::steadytime():0;
+  FXTime t1=0;
   FXRunnable* task;
-  while(!comp.done() && usedslots.wait(timeout) && queue.pop(task)){
-    freeslots.post();
+  while(!comp.done() && usedslots.wait(timeout) && claimTask(task)){
+    atomicAdd(&queued,-1U);
+    t1=0;
+    if(timing){
+      t1=FXThread::steadytime();
+      if(t0 && 0<=slot) atomicAdd(&idletime[slot],t1-t0);
+      }
     try{
       task->run();
       }
     catch(...){
+      atomicAdd(&completed,FXULONG(1));
       tasks.decrement();
       throw;
       }
+    atomicAdd(&completed,FXULONG(1));
+    t0=0;
+    if(timing){
+      t0=FXThread::steadytime();
+      if(t1){
+        if(0<=slot) atomicAdd(&busytime[slot],t0-t1);
+        atomicAdd(&runhist[latencyBucket(t0-t1)],FXULONG(1));
+        }
+      }
     tasks.decrement();
     }
   }
@@ -223,16 +601,25 @@ void FXThreadPool::runWhile(FXCompletion& comp,FXTime timeout){
 // the current count of workers.
 FXint FXThreadPool::run(){
   FXuint w=atomicAdd(&workers,1);
+  FXint slot=claimSlot();
   instance(this);
+  workerslot.set((FXptr)(FXival)(slot+1));
+  if(cpus && 0<=slot && cpus[slot]<64){
+    FXThread::self()->affinity(FXULONG(1)<<cpus[slot]);
+    }
   try{
     runWhile(threads,(w<minimum)?forever:expiration);
     }
   catch(...){
+    workerslot.set(nullptr);
+    releaseSlot(slot);
     instance(nullptr);
     atomicAdd(&workers,-1);
     threads.decrement();
     throw;
     }
+  workerslot.set(nullptr);
+  releaseSlot(slot);
   instance(nullptr);
   atomicAdd(&workers,-1);
   threads.decrement();
@@ -240,13 +627,42 @@ FXint FXThreadPool::run(){
   }
 
 
+// Block until free slot in queue, accumulating time spent blocked
+FXbool FXThreadPool::waitSlot(FXSemaphore& slots,FXTime blocking){
+  if(blocking){
+    FXTime start=FXThread::steadytime();
+    FXbool result=slots.wait(blocking);
+    atomicAdd(&blocked,FXThread::steadytime()-start);
+    return result;
+    }
+  return false;
+  }
+
+
+// Account for n tasks submitted, and maintain high-water mark
+void FXThreadPool::enqueued(FXuint n){
+  FXuint q=atomicAdd(&queued,n)+n;
+  atomicAdd(&submitted,(FXulong)n);
+  atomicMax(&highwater,q);
+  }
+
+
 // Try to add new task to the queue, waiting for space if necessary
 FXbool FXThreadPool::execute(FXRunnable* task,FXTime blocking){
   if(__likely(running==1 && task)){
     if(tasks.count()<threads.count() || maximum<=threads.count() || startWorker()){
-      if(freeslots.wait(blocking)){
+      FXWSQueue* local=localDeque();
+      if(local && 1<local->getFree()){
+        tasks.increment();
+        local->push(task);
+        enqueued(1);
+        usedslots.post();
+        return true;
+        }
+      if(freeslots.trywait() || waitSlot(freeslots,blocking)){
         tasks.increment();
         queue.push(task);
+        enqueued(1);
         usedslots.post();
         return true;
         }
@@ -256,6 +672,64 @@ FXbool FXThreadPool::execute(FXRunnable* task,FXTime blocking){
   }
 
 
+// Try to add new task with given priority, waiting for space if necessary
+FXbool FXThreadPool::execute(FXRunnable* task,Priority priority,FXTime blocking){
+  if(priority==PriorityHigh){
+    if(__likely(running==1 && task)){
+      if(tasks.count()<threads.count() || maximum<=threads.count() || startWorker()){
+        if(urgentslots.trywait() || waitSlot(urgentslots,blocking)){
+          tasks.increment();
+          urgent.push(task);
+          enqueued(1);
+          usedslots.post();
+          return true;
+          }
+        }
+      }
+    return false;
+    }
+  return execute(task,blocking);
+  }
+
+
+// Try to add n tasks to the queue, waiting for space if necessary
+FXuint FXThreadPool::execute(FXRunnable** batch,FXuint n,FXTime blocking){
+  FXuint result=0,m,p;
+  if(__likely(running==1 && batch)){
+    while(threads.count()<maximum && threads.count()<tasks.count()+n && startWorker()){ }
+    if(threads.count()){
+      FXWSQueue* local=localDeque();
+      if(local && 1<local->getFree()){
+        result=FXMIN(n,(FXuint)local->getFree()-1);
+        tasks.increment(result);
+        for(m=0; m<result; ++m){
+          local->push(batch[m]);
+          }
+        enqueued(result);
+        usedslots.post(result);
+        }
+      while(result<n){
+        m=freeslots.trywait(n-result);
+        if(!m){
+          if(!waitSlot(freeslots,blocking)) break;
+          m=1+freeslots.trywait(n-result-1);
+          }
+        tasks.increment(m);
+        p=queue.push(&batch[result],m);
+        if(p<m){
+          freeslots.post(m-p);
+          tasks.decrement(m-p);
+          }
+        enqueued(p);
+        usedslots.post(p);
+        result+=p;
+        }
+      }
+    }
+  return result;
+  }
+
+
 // Execute task, and wait for all completion of all tasks
 FXbool FXThreadPool::executeAndWait(FXRunnable* task,FXTime blocking){
   if(execute(task,blocking)){
@@ -311,6 +785,7 @@ FXbool FXThreadPool::stop(){
 
     // Queue empty now
     FXASSERT(queue.isEmpty());
+    FXASSERT(urgent.isEmpty());
 
     // Force all workers to stop
     while(w){ usedslots.post(); --w; }
@@ -321,6 +796,12 @@ FXbool FXThreadPool::stop(){
     // Reset usedslots semaphore to zero
     while(usedslots.trywait()){ }
 
+    // Release task deques and worker slots
+    delete [] deques;
+    freeElms(owners);
+    freeElms(cpus);
+    deques=nullptr;
+
     // Unset context reference if set to this context
     if(instance()==this) instance(nullptr);
 
@@ -336,6 +817,8 @@ FXbool FXThreadPool::stop(){
 FXThreadPool::~FXThreadPool(){
   FXTRACE((TOPIC_DETAIL,"FXThreadPool::~FXThreadPool()\n"));
   stop();
+  freeElms(busytime);
+  freeElms(idletime);
   }
 
 }
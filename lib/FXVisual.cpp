@@ -119,6 +119,7 @@ FXVisual::FXVisual():visual(nullptr),colormap(0),maxcolors(1000000),numcolors(0)
 #ifndef WIN32
   scrollgc=0;
   gc=0;
+  linear=0;
 #endif
   }
 
@@ -129,6 +130,7 @@ FXVisual::FXVisual(FXApp* a,FXuint flgs,FXuint hnt):FXId(a),visual(nullptr),colo
 #ifndef WIN32
   scrollgc=0;
   gc=0;
+  linear=0;
 #endif
   }
 
@@ -1115,6 +1117,7 @@ void FXVisual::create(){
 
       // Initialize colormap
       setupcolormap();
+      linear=0;
 
       // Make GC's for this visual
       scrollgc=setupgc(true);
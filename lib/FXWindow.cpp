@@ -3549,6 +3549,8 @@ FXWindow::~FXWindow(){
   if(getApp()->dropWindow==this) getApp()->dropWindow=nullptr;
   if(getApp()->refresherstop==this) getApp()->refresherstop=parent;
   if(getApp()->refresher==this) getApp()->refresher=parent;
+  if(flags&FLAG_REFRESH) getApp()->unlinkRefresh(this);
+  if(flags&FLAG_SUBSCRIBED) getApp()->unsubscribe(this);
   if(parent) parent->recalc();
   parent=(FXWindow*)-1L;
   owner=(FXWindow*)-1L;
@@ -0,0 +1,403 @@
+/********************************************************************************
+*                                                                               *
+*                         T r u e   C o l o r   R o w s                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 1997,2024 by Jeroen van der Zijp.   All Rights Reserved.        *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#include "xincs.h"
+#include "fxver.h"
+#include "fxdefs.h"
+#include "fxcpuid.h"
+#include "fxtruerow.h"
+
+
+/*
+  Notes:
+  - Conversion of rows of 32 bit BGRA pixels to true color pixels of 32, 24, or
+    dithered 16 bpp, used by FXImage when the visual's color tables are linear.
+  - The vector versions are selected at run time on x86; they convert whole
+    groups of pixels, and leave the remaining pixels to the plain version.
+  - They're here rather than in FXImage.cpp so that tests/truerow can check
+    each one against the plain version, without needing a display.
+*/
+
+
+// Vector instructions are selected at run time on x86; on ARM64, NEON is always there
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__)) && defined(HAVE_IMMINTRIN_H)
+#define VECTOR_X86 1
+#elif defined(__aarch64__) && defined(FOX_HAS_NEON)
+#define VECTOR_NEON 1
+#endif
+
+using namespace FX;
+
+/*******************************************************************************/
+
+namespace FX {
+
+
+// Make byte shuffle taking 4 pixels to 24 or 32 bpp pixels, and the alpha bytes to add
+static void makeshuffle(FXuchar ctl[],FXuchar alp[],FXuint bpp,const TrueLayout& lay){
+  for(FXuint i=0; i<16; ++i){
+    ctl[i]=0x80;
+    alp[i]=0;
+    }
+  for(FXuint p=0; p<4; ++p){
+    for(FXuint k=0; k<bpp; ++k){
+      if(lay.rs==(k<<3)) ctl[bpp*p+k]=(FXuchar)(4*p+2);
+      else if(lay.gs==(k<<3)) ctl[bpp*p+k]=(FXuchar)(4*p+1);
+      else if(lay.bs==(k<<3)) ctl[bpp*p+k]=(FXuchar)(4*p);
+      else alp[bpp*p+k]=(FXuchar)(lay.alpha>>(k<<3));
+      }
+    }
+  }
+
+
+// Convert row to 32 bpp
+static void truerow32(FXuchar* dst,const FXuchar* src,FXint n,const FXushort*,const TrueLayout& lay){
+  while(0<n--){
+    *((FXuint*)dst)=lay.alpha|((FXuint)src[2]<<lay.rs)|((FXuint)src[1]<<lay.gs)|((FXuint)src[0]<<lay.bs);
+    src+=4;
+    dst+=4;
+    }
+  }
+
+
+// Convert row to 24 bpp
+static void truerow24(FXuchar* dst,const FXuchar* src,FXint n,const FXushort*,const TrueLayout& lay){
+  FXuint val;
+  while(0<n--){
+    val=lay.alpha|((FXuint)src[2]<<lay.rs)|((FXuint)src[1]<<lay.gs)|((FXuint)src[0]<<lay.bs);
+    dst[0]=(FXuchar)val;
+    dst[1]=(FXuchar)(val>>8);
+    dst[2]=(FXuchar)(val>>16);
+    src+=4;
+    dst+=3;
+    }
+  }
+
+
+// Convert row to 16 bpp, dithered
+static void truerow16(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuint val,d;
+  for(FXint i=0; i<n; ++i){
+    d=dith[i&15];
+    val=lay.alpha|(((lay.rm*src[2]+d)/255)<<lay.rs)|(((lay.gm*src[1]+d)/255)<<lay.gs)|(((lay.bm*src[0]+d)/255)<<lay.bs);
+    if(lay.swap){
+      dst[0]=(FXuchar)(val>>8);
+      dst[1]=(FXuchar)val;
+      }
+    else{
+      dst[0]=(FXuchar)val;
+      dst[1]=(FXuchar)(val>>8);
+      }
+    src+=4;
+    dst+=2;
+    }
+  }
+
+#if defined(VECTOR_X86)
+
+// Convert row to 32 bpp using SSE2
+__attribute__((target("sse2")))
+static void truerow32_sse2(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  const __m128i mask=_mm_set1_epi32(0xFF);
+  const __m128i alpha=_mm_set1_epi32((FXint)lay.alpha);
+  const __m128i rs=_mm_cvtsi32_si128((FXint)lay.rs);
+  const __m128i gs=_mm_cvtsi32_si128((FXint)lay.gs);
+  const __m128i bs=_mm_cvtsi32_si128((FXint)lay.bs);
+  __m128i s,r,g,b;
+  while(4<=n){
+    s=_mm_loadu_si128((const __m128i*)src);
+    r=_mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(s,16),mask),rs);
+    g=_mm_sll_epi32(_mm_and_si128(_mm_srli_epi32(s,8),mask),gs);
+    b=_mm_sll_epi32(_mm_and_si128(s,mask),bs);
+    _mm_storeu_si128((__m128i*)dst,_mm_or_si128(_mm_or_si128(r,g),_mm_or_si128(b,alpha)));
+    src+=16;
+    dst+=16;
+    n-=4;
+    }
+  truerow32(dst,src,n,dith,lay);
+  }
+
+
+// Convert row to 32 bpp using AVX2
+__attribute__((target("avx2")))
+static void truerow32_avx2(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuchar c[16],a[16];
+  makeshuffle(c,a,4,lay);
+  const __m256i ctl=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)c));
+  const __m256i alp=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)a));
+  while(8<=n){
+    _mm256_storeu_si256((__m256i*)dst,_mm256_or_si256(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src),ctl),alp));
+    src+=32;
+    dst+=32;
+    n-=8;
+    }
+  truerow32(dst,src,n,dith,lay);
+  }
+
+
+// Convert row to 24 bpp using SSSE3
+__attribute__((target("ssse3")))
+static void truerow24_ssse3(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuchar c[16],a[16];
+  makeshuffle(c,a,3,lay);
+  const __m128i ctl=_mm_loadu_si128((const __m128i*)c);
+  const __m128i alp=_mm_loadu_si128((const __m128i*)a);
+  __m128i v;
+  while(4<=n){
+    v=_mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src),ctl),alp);
+    _mm_storel_epi64((__m128i*)dst,v);
+    *((FXint*)(dst+8))=_mm_cvtsi128_si32(_mm_srli_si128(v,8));
+    src+=16;
+    dst+=12;
+    n-=4;
+    }
+  truerow24(dst,src,n,dith,lay);
+  }
+
+
+// Convert row to 24 bpp using AVX2
+__attribute__((target("avx2")))
+static void truerow24_avx2(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuchar c[16],a[16];
+  makeshuffle(c,a,3,lay);
+  const __m256i ctl=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)c));
+  const __m256i alp=_mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)a));
+  __m256i v;
+  __m128i lo,hi;
+  while(8<=n){
+    v=_mm256_or_si256(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src),ctl),alp);
+    lo=_mm256_castsi256_si128(v);
+    hi=_mm256_extracti128_si256(v,1);
+    _mm_storel_epi64((__m128i*)dst,lo);
+    *((FXint*)(dst+8))=_mm_cvtsi128_si32(_mm_srli_si128(lo,8));
+    _mm_storel_epi64((__m128i*)(dst+12),hi);
+    *((FXint*)(dst+20))=_mm_cvtsi128_si32(_mm_srli_si128(hi,8));
+    src+=32;
+    dst+=24;
+    n-=8;
+    }
+  truerow24(dst,src,n,dith,lay);
+  }
+
+
+// Scale 8 bit channel to max levels, add dither, and divide by 255
+__attribute__((target("sse2")))
+static inline __m128i scale_sse2(__m128i x,__m128i max,__m128i d){
+  x=_mm_add_epi16(_mm_mullo_epi16(x,max),d);
+  return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x,_mm_set1_epi16(1)),_mm_srli_epi16(x,8)),8);
+  }
+
+
+// Convert row to 16 bpp, dithered, using SSE2
+__attribute__((target("sse2")))
+static void truerow16_sse2(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  const __m128i mask=_mm_set1_epi32(0xFF);
+  const __m128i alpha=_mm_set1_epi16((FXshort)lay.alpha);
+  const __m128i rm=_mm_set1_epi16((FXshort)lay.rm);
+  const __m128i gm=_mm_set1_epi16((FXshort)lay.gm);
+  const __m128i bm=_mm_set1_epi16((FXshort)lay.bm);
+  const __m128i rs=_mm_cvtsi32_si128((FXint)lay.rs);
+  const __m128i gs=_mm_cvtsi32_si128((FXint)lay.gs);
+  const __m128i bs=_mm_cvtsi32_si128((FXint)lay.bs);
+  const __m128i d=_mm_loadu_si128((const __m128i*)dith);
+  __m128i s0,s1,r,g,b,v;
+  while(8<=n){
+    s0=_mm_loadu_si128((const __m128i*)src);
+    s1=_mm_loadu_si128((const __m128i*)(src+16));
+    r=_mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0,16),mask),_mm_and_si128(_mm_srli_epi32(s1,16),mask));
+    g=_mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(s0,8),mask),_mm_and_si128(_mm_srli_epi32(s1,8),mask));
+    b=_mm_packs_epi32(_mm_and_si128(s0,mask),_mm_and_si128(s1,mask));
+    r=_mm_sll_epi16(scale_sse2(r,rm,d),rs);
+    g=_mm_sll_epi16(scale_sse2(g,gm,d),gs);
+    b=_mm_sll_epi16(scale_sse2(b,bm,d),bs);
+    v=_mm_or_si128(_mm_or_si128(r,g),_mm_or_si128(b,alpha));
+    if(lay.swap) v=_mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+    _mm_storeu_si128((__m128i*)dst,v);
+    src+=32;
+    dst+=16;
+    n-=8;
+    }
+  truerow16(dst,src,n,dith,lay);
+  }
+
+
+// Scale 8 bit channel to max levels, add dither, and divide by 255
+__attribute__((target("avx2")))
+static inline __m256i scale_avx2(__m256i x,__m256i max,__m256i d){
+  x=_mm256_add_epi16(_mm256_mullo_epi16(x,max),d);
+  return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x,_mm256_set1_epi16(1)),_mm256_srli_epi16(x,8)),8);
+  }
+
+
+// Convert row to 16 bpp, dithered, using AVX2; packing interleaves groups of 4
+// pixels, which is undone at the end, and the dither repeats every 4 pixels
+__attribute__((target("avx2")))
+static void truerow16_avx2(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  const __m256i mask=_mm256_set1_epi32(0xFF);
+  const __m256i alpha=_mm256_set1_epi16((FXshort)lay.alpha);
+  const __m256i rm=_mm256_set1_epi16((FXshort)lay.rm);
+  const __m256i gm=_mm256_set1_epi16((FXshort)lay.gm);
+  const __m256i bm=_mm256_set1_epi16((FXshort)lay.bm);
+  const __m128i rs=_mm_cvtsi32_si128((FXint)lay.rs);
+  const __m128i gs=_mm_cvtsi32_si128((FXint)lay.gs);
+  const __m128i bs=_mm_cvtsi32_si128((FXint)lay.bs);
+  const __m256i d=_mm256_loadu_si256((const __m256i*)dith);
+  __m256i s0,s1,r,g,b,v;
+  while(16<=n){
+    s0=_mm256_loadu_si256((const __m256i*)src);
+    s1=_mm256_loadu_si256((const __m256i*)(src+32));
+    r=_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0,16),mask),_mm256_and_si256(_mm256_srli_epi32(s1,16),mask));
+    g=_mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(s0,8),mask),_mm256_and_si256(_mm256_srli_epi32(s1,8),mask));
+    b=_mm256_packs_epi32(_mm256_and_si256(s0,mask),_mm256_and_si256(s1,mask));
+    r=_mm256_sll_epi16(scale_avx2(r,rm,d),rs);
+    g=_mm256_sll_epi16(scale_avx2(g,gm,d),gs);
+    b=_mm256_sll_epi16(scale_avx2(b,bm,d),bs);
+    v=_mm256_or_si256(_mm256_or_si256(r,g),_mm256_or_si256(b,alpha));
+    if(lay.swap) v=_mm256_or_si256(_mm256_slli_epi16(v,8),_mm256_srli_epi16(v,8));
+    _mm256_storeu_si256((__m256i*)dst,_mm256_permute4x64_epi64(v,0xD8));
+    src+=64;
+    dst+=32;
+    n-=16;
+    }
+  truerow16(dst,src,n,dith,lay);
+  }
+
+
+// Return features of processor
+static FXuint cpufeatures(){
+  static const FXuint features=fxCPUFeatures();
+  return features;
+  }
+
+#endif
+
+#if defined(VECTOR_NEON)
+
+// Convert row to 32 bpp using NEON
+static void truerow32_neon(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuchar c[16],a[16];
+  makeshuffle(c,a,4,lay);
+  const uint8x16_t ctl=vld1q_u8(c);
+  const uint8x16_t alp=vld1q_u8(a);
+  while(4<=n){
+    vst1q_u8(dst,vorrq_u8(vqtbl1q_u8(vld1q_u8(src),ctl),alp));
+    src+=16;
+    dst+=16;
+    n-=4;
+    }
+  truerow32(dst,src,n,dith,lay);
+  }
+
+
+// Convert row to 24 bpp using NEON
+static void truerow24_neon(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  FXuchar c[16],a[16];
+  makeshuffle(c,a,3,lay);
+  const uint8x16_t ctl=vld1q_u8(c);
+  const uint8x16_t alp=vld1q_u8(a);
+  uint8x16_t v;
+  while(4<=n){
+    v=vorrq_u8(vqtbl1q_u8(vld1q_u8(src),ctl),alp);
+    vst1_u8(dst,vget_low_u8(v));
+    vst1q_lane_u32((uint32_t*)(dst+8),vreinterpretq_u32_u8(v),2);
+    src+=16;
+    dst+=12;
+    n-=4;
+    }
+  truerow24(dst,src,n,dith,lay);
+  }
+
+
+// Scale 8 bit channel to max levels, add dither, and divide by 255
+static inline uint16x8_t scale_neon(uint16x8_t x,uint16x8_t max,uint16x8_t d){
+  x=vmlaq_u16(d,x,max);
+  return vshrq_n_u16(vaddq_u16(vaddq_u16(x,vdupq_n_u16(1)),vshrq_n_u16(x,8)),8);
+  }
+
+
+// Convert row to 16 bpp, dithered, using NEON
+static void truerow16_neon(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay){
+  const uint32x4_t mask=vdupq_n_u32(0xFF);
+  const uint16x8_t alpha=vdupq_n_u16((FXushort)lay.alpha);
+  const uint16x8_t rm=vdupq_n_u16((FXushort)lay.rm);
+  const uint16x8_t gm=vdupq_n_u16((FXushort)lay.gm);
+  const uint16x8_t bm=vdupq_n_u16((FXushort)lay.bm);
+  const int16x8_t rs=vdupq_n_s16((FXshort)lay.rs);
+  const int16x8_t gs=vdupq_n_s16((FXshort)lay.gs);
+  const int16x8_t bs=vdupq_n_s16((FXshort)lay.bs);
+  const uint16x8_t d=vld1q_u16(dith);
+  uint32x4_t s0,s1;
+  uint16x8_t r,g,b,v;
+  while(8<=n){
+    s0=vld1q_u32((const uint32_t*)src);
+    s1=vld1q_u32((const uint32_t*)(src+16));
+    r=vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(s0,16),mask)),vmovn_u32(vandq_u32(vshrq_n_u32(s1,16),mask)));
+    g=vcombine_u16(vmovn_u32(vandq_u32(vshrq_n_u32(s0,8),mask)),vmovn_u32(vandq_u32(vshrq_n_u32(s1,8),mask)));
+    b=vcombine_u16(vmovn_u32(vandq_u32(s0,mask)),vmovn_u32(vandq_u32(s1,mask)));
+    r=vshlq_u16(scale_neon(r,rm,d),rs);
+    g=vshlq_u16(scale_neon(g,gm,d),gs);
+    b=vshlq_u16(scale_neon(b,bm,d),bs);
+    v=vorrq_u16(vorrq_u16(r,g),vorrq_u16(b,alpha));
+    if(lay.swap) v=vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+    vst1q_u16((uint16_t*)dst,v);
+    src+=32;
+    dst+=16;
+    n-=8;
+    }
+  truerow16(dst,src,n,dith,lay);
+  }
+
+#endif
+
+
+// Get conversions of rows which this processor can run, plain one first
+FXint fxtruerowfuncs(TrueRowFunc funcs[],FXuint bpp){
+  FXint n=0;
+  if(bpp==32){
+    funcs[n++]=truerow32;
+#if defined(VECTOR_X86)
+    if(cpufeatures()&CPU_HAS_SSE2) funcs[n++]=truerow32_sse2;
+    if(cpufeatures()&CPU_HAS_AVX2) funcs[n++]=truerow32_avx2;
+#elif defined(VECTOR_NEON)
+    funcs[n++]=truerow32_neon;
+#endif
+    }
+  else if(bpp==24){
+    funcs[n++]=truerow24;
+#if defined(VECTOR_X86)
+    if(cpufeatures()&CPU_HAS_SSSE3) funcs[n++]=truerow24_ssse3;
+    if(cpufeatures()&CPU_HAS_AVX2) funcs[n++]=truerow24_avx2;
+#elif defined(VECTOR_NEON)
+    funcs[n++]=truerow24_neon;
+#endif
+    }
+  else if(bpp==16){
+    funcs[n++]=truerow16;
+#if defined(VECTOR_X86)
+    if(cpufeatures()&CPU_HAS_SSE2) funcs[n++]=truerow16_sse2;
+    if(cpufeatures()&CPU_HAS_AVX2) funcs[n++]=truerow16_avx2;
+#elif defined(VECTOR_NEON)
+    funcs[n++]=truerow16_neon;
+#endif
+    }
+  return n;
+  }
+
+}
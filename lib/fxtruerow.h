@@ -0,0 +1,51 @@
+/********************************************************************************
+*                                                                               *
+*                         T r u e   C o l o r   R o w s                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 1997,2024 by Jeroen van der Zijp.   All Rights Reserved.        *
+*********************************************************************************
+* This library is free software; you can redistribute it and/or modify          *
+* it under the terms of the GNU Lesser General Public License as published by   *
+* the Free Software Foundation; either version 3 of the License, or             *
+* (at your option) any later version.                                           *
+*                                                                               *
+* This library is distributed in the hope that it will be useful,               *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of                *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                 *
+* GNU Lesser General Public License for more details.                           *
+*                                                                               *
+* You should have received a copy of the GNU Lesser General Public License      *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>          *
+********************************************************************************/
+#ifndef FXTRUEROW_H
+#define FXTRUEROW_H
+
+namespace FX {
+
+
+// Layout of true color pixels, if the visual's color tables are linear, i.e.
+// without gamma correction.  For 24 and 32 bpp, the shifts are of bytes in
+// memory order; for 16 bpp, they're of bits in the pixel, which may need to
+// be byte-swapped.
+struct TrueLayout {
+  FXuint   alpha;               // Unused bits, set to 1
+  FXuint   rs,gs,bs;            // Shifts of red, green, blue
+  FXuint   rm,gm,bm;            // Largest red, green, blue
+  FXbool   swap;                // Swap bytes of pixel
+  FXint    dy;                  // Dither row of first row
+  FXushort dither[4][16];       // Dither of first 16 columns, for each dither row
+  };
+
+
+// Convert row of n pixels
+typedef void (*TrueRowFunc)(FXuchar* dst,const FXuchar* src,FXint n,const FXushort* dith,const TrueLayout& lay);
+
+
+// Get conversions of rows to 32, 24, or 16 bpp pixels which this processor can
+// run; the plain one comes first, and the fastest one last.  Returns how many.
+extern FXAPI FXint fxtruerowfuncs(TrueRowFunc funcs[],FXuint bpp);
+
+}
+
+#endif
@@ -2186,10 +2186,10 @@ FXbool PathFinderMain::previewImage(const FXString& filename){
         if((img->getWidth()>pw) || (img->getHeight()>ph)){
           FXdouble aspect=(FXdouble)img->getHeight() / (FXdouble)img->getWidth();
           if(aspect*pw<ph){
-            img->scale(pw,(pw*img->getHeight())/img->getWidth(),1);
+            img->scale(pw,(pw*img->getHeight())/img->getWidth(),4);
             }
           else{
-            img->scale((ph*img->getWidth())/img->getHeight(),ph,1);
+            img->scale((ph*img->getWidth())/img->getHeight(),ph,4);
             }
           }
         }
@@ -0,0 +1,339 @@
+/********************************************************************************
+*                                                                               *
+*                   A s y n c h r o n o u s   I / O   T e s t                   *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+#include "fxcrc.h"
+
+
+#if !defined(WIN32)
+
+/*******************************************************************************/
+
+// Block being read
+struct Block {
+  FXuchar *data;        // Buffer
+  FXlong   index;       // Block number
+  };
+
+
+// Reads a file in blocks, keeping a number of reads in flight; blocks may
+// complete in any order, so each block is checksummed separately
+class FileReader {
+private:
+  FXDispatcher *dispatcher;
+  FXInputHandle hnd;
+  FXlong        size;
+  FXival        blocksize;
+  FXlong        nblocks;
+  FXlong        next;
+  FXint         depth;
+  FXint         inflight;
+  Block        *blocks;
+public:
+  FXuint       *crcs;
+  FXlong        bytes;
+  FXint         errors;
+private:
+  FXbool submit(Block* b);
+  FXbool onRead(FXDispatcher*,FXInputHandle,FXival result,void* ptr);
+public:
+  FileReader(FXDispatcher* d,FXInputHandle h,FXlong sz,FXival bs,FXint dp);
+  FXbool done() const { return inflight==0; }
+ ~FileReader();
+  };
+
+
+// Start reading
+FileReader::FileReader(FXDispatcher* d,FXInputHandle h,FXlong sz,FXival bs,FXint dp):dispatcher(d),hnd(h),size(sz),blocksize(bs),next(0),depth(dp),inflight(0),bytes(0),errors(0){
+  nblocks=(size+blocksize-1)/blocksize;
+  crcs=new FXuint [nblocks];
+  blocks=new Block [depth];
+  for(FXint i=0; i<depth; ++i){
+    blocks[i].data=new FXuchar [blocksize];
+    submit(&blocks[i]);
+    }
+  }
+
+
+// Submit read of next block into b
+FXbool FileReader::submit(Block* b){
+  if(next<nblocks){
+    b->index=next++;
+    if(dispatcher->submitRead(FXDispatcher::CompletionCallback::create<FileReader,&FileReader::onRead>(this),hnd,b->data,blocksize,b->index*blocksize,b)){
+      inflight++;
+      return true;
+      }
+    fxmessage("Unable to submit read.\n");
+    errors++;
+    }
+  return false;
+  }
+
+
+// Block came in; checksum it, and read another
+FXbool FileReader::onRead(FXDispatcher*,FXInputHandle,FXival result,void* ptr){
+  Block* b=static_cast<Block*>(ptr);
+  inflight--;
+  if(result<0 || (result<blocksize && b->index<nblocks-1)){
+    fxmessage("Read of block %lld returned %ld.\n",b->index,result);
+    errors++;
+    return true;
+    }
+  crcs[b->index]=CRC32::CRC(~0U,b->data,result)^~0U;
+  bytes+=result;
+  submit(b);
+  return true;
+  }
+
+
+// Clean up
+FileReader::~FileReader(){
+  for(FXint i=0; i<depth; ++i){
+    delete [] blocks[i].data;
+    }
+  delete [] blocks;
+  delete [] crcs;
+  }
+
+
+/*******************************************************************************/
+
+// Pumps bytes from a buffer through a pipe, with a write and a read in flight
+class PipePump {
+private:
+  FXDispatcher *dispatcher;
+  FXInputHandle hnd[2];
+  const FXuchar*source;
+  FXival        size;
+  FXival        written;
+  FXuchar      *buffer;
+  FXival        chunk;
+public:
+  FXuint        crc;
+  FXival        received;
+  FXint         errors;
+  FXbool        finished;
+private:
+  FXbool onWrite(FXDispatcher*,FXInputHandle,FXival result,void*);
+  FXbool onRead(FXDispatcher*,FXInputHandle,FXival result,void*);
+public:
+  PipePump(FXDispatcher* d,const FXuchar* src,FXival sz,FXival ch);
+ ~PipePump();
+  };
+
+
+// Start pumping
+PipePump::PipePump(FXDispatcher* d,const FXuchar* src,FXival sz,FXival ch):dispatcher(d),source(src),size(sz),written(0),chunk(ch),crc(~0U),received(0),errors(0),finished(false){
+  if(::pipe(hnd)!=0){ fxmessage("Unable to create pipe.\n"); ::exit(1); }
+  buffer=new FXuchar [chunk];
+  if(!dispatcher->submitWrite(FXDispatcher::CompletionCallback::create<PipePump,&PipePump::onWrite>(this),hnd[1],source,FXMIN(chunk,size))) errors++;
+  if(!dispatcher->submitRead(FXDispatcher::CompletionCallback::create<PipePump,&PipePump::onRead>(this),hnd[0],buffer,chunk)) errors++;
+  }
+
+
+// Some bytes were written; write some more, or hang up
+FXbool PipePump::onWrite(FXDispatcher*,FXInputHandle,FXival result,void*){
+  if(result<0){ fxmessage("Write returned %ld.\n",result); errors++; return true; }
+  written+=result;
+  if(written<size){
+    if(!dispatcher->submitWrite(FXDispatcher::CompletionCallback::create<PipePump,&PipePump::onWrite>(this),hnd[1],source+written,FXMIN(chunk,size-written))) errors++;
+    }
+  else{
+    ::close(hnd[1]);
+    hnd[1]=-1;
+    }
+  return true;
+  }
+
+
+// Some bytes were read; read some more, until end of file
+FXbool PipePump::onRead(FXDispatcher*,FXInputHandle,FXival result,void*){
+  if(result<0){ fxmessage("Read returned %ld.\n",result); errors++; finished=true; return true; }
+  if(result==0){ crc^=~0U; finished=true; return true; }
+  crc=CRC32::CRC(crc,buffer,result);
+  received+=result;
+  if(!dispatcher->submitRead(FXDispatcher::CompletionCallback::create<PipePump,&PipePump::onRead>(this),hnd[0],buffer,chunk)){ errors++; finished=true; }
+  return true;
+  }
+
+
+// Clean up
+PipePump::~PipePump(){
+  if(hnd[0]>=0) ::close(hnd[0]);
+  if(hnd[1]>=0) ::close(hnd[1]);
+  delete [] buffer;
+  }
+
+
+// Completion of an operation held back while completions were not dispatched
+static FXbool onHeld(FXDispatcher*,FXInputHandle,FXival result,void* ptr){
+  *static_cast<FXival*>(ptr)=result;
+  return true;
+  }
+
+
+// Completion of an operation abandoned at exit; must never be called
+static FXbool onAbandoned(FXDispatcher*,FXInputHandle,FXival,void*){
+  fxmessage("Abandoned operation completed.\n");
+  return true;
+  }
+
+#endif
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options:\n",prog);
+  fxmessage("  --file <name>               File to read (default is to make one up).\n");
+  fxmessage("  --megs <number>             Size of file made up, and bytes through pipe, in MB.\n");
+  fxmessage("  --block <number>            Block size (kB).\n");
+  fxmessage("  --depth <number>            Number of reads in flight.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXString filename;
+  FXint megs=64;
+  FXint block=64;
+  FXint depth=16;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--file")==0){
+      if(++arg>=argc){ fxmessage("Missing file argument.\n"); exit(1); }
+      filename=argv[arg];
+      }
+    else if(strcmp(argv[arg],"--megs")==0){
+      if(++arg>=argc){ fxmessage("Missing megs argument.\n"); exit(1); }
+      megs=strtol(argv[arg],nullptr,0);
+      if(megs<1){ fxmessage("Value for megs (%d) too small.\n",megs); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--block")==0){
+      if(++arg>=argc){ fxmessage("Missing block argument.\n"); exit(1); }
+      block=strtol(argv[arg],nullptr,0);
+      if(block<1){ fxmessage("Value for block (%d) too small.\n",block); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--depth")==0){
+      if(++arg>=argc){ fxmessage("Missing depth argument.\n"); exit(1); }
+      depth=strtol(argv[arg],nullptr,0);
+      if(depth<1){ fxmessage("Value for depth (%d) too small.\n",depth); exit(1); }
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+#if !defined(WIN32)
+  FXDispatcher dispatcher;
+  FXRandom random(1234567);
+  FXival size=(FXival)megs<<20;
+  FXuchar *data=new FXuchar [size];
+  FXbool maketemp=filename.empty();
+  FXFile file;
+  FXint errors=0;
+
+  // Make up some data
+  for(FXival i=0; i<size; ++i){ data[i]=(FXuchar)(random.randLong()>>56); }
+
+  // Make up a file, unless one was given
+  if(maketemp){
+    filename=FXSystem::getTempDirectory()+PATHSEPSTRING "asyncio.dat";
+    if(!file.open(filename,FXIO::Writing) || file.writeBlock(data,size)!=size){ fxmessage("Unable to write %s.\n",filename.text()); exit(1); }
+    file.close();
+    }
+
+  dispatcher.init();
+
+  fxmessage("asynchronous operations %s\n",dispatcher.hasRing()?"using io_uring":"performed when ready");
+
+  // Read the file
+  if(!file.open(filename,FXIO::Reading)){ fxmessage("Unable to open %s.\n",filename.text()); exit(1); }
+
+  FXTime start=FXThread::steadytime();
+
+  FileReader reader(&dispatcher,file.handle(),file.size(),(FXival)block<<10,depth);
+  while(!reader.done()){
+    dispatcher.dispatch();
+    }
+
+  FXTime elapsed=FXThread::steadytime()-start;
+
+  // Same thing, the usual way
+  FXuchar *buffer=new FXuchar [(FXival)block<<10];
+  FXlong nblocks=(file.size()+((FXival)block<<10)-1)/((FXival)block<<10);
+  FXint mismatches=0;
+  file.position(0);
+  for(FXlong b=0; b<nblocks; ++b){
+    FXival n=file.readBlock(buffer,(FXival)block<<10);
+    if((CRC32::CRC(~0U,buffer,n)^~0U)!=reader.crcs[b]) mismatches++;
+    }
+  file.close();
+  delete [] buffer;
+  fxmessage("read %lld bytes in %.3lf s, %d blocks of %d kB in flight: %s\n",reader.bytes,elapsed*1.0E-9,depth,block,mismatches?"mismatch":"ok");
+  errors+=reader.errors+mismatches;
+
+  // Pump the data through a pipe
+  start=FXThread::steadytime();
+
+  PipePump pump(&dispatcher,data,size,(FXival)block<<10);
+  while(!pump.finished){
+    dispatcher.dispatch();
+    }
+
+  elapsed=FXThread::steadytime()-start;
+
+  FXuint expected=CRC32::CRC(~0U,data,size)^~0U;
+  fxmessage("pumped %ld bytes through pipe in %.3lf s: %s\n",pump.received,elapsed*1.0E-9,(pump.received==size && pump.crc==expected)?"ok":"mismatch");
+  errors+=pump.errors+(pump.received!=size || pump.crc!=expected);
+
+  // Completed read is held back while completions are not dispatched, without spinning
+  FXInputHandle idle[2];
+  FXuchar spare[16];
+  FXival held=0;
+  if(::pipe(idle)!=0){ fxmessage("Unable to create pipe.\n"); exit(1); }
+  if(::write(idle[1],"held",4)!=4) errors++;
+  if(!dispatcher.submitRead(FXDispatcher::CompletionCallback::create<&onHeld>(),idle[0],spare,sizeof(spare),-1,&held)) errors++;
+  start=FXThread::steadytime();
+  FXbool dispatched=dispatcher.dispatch(50000000,FXDispatcher::DispatchAll&~FXDispatcher::DispatchCompletions);
+  elapsed=FXThread::steadytime()-start;
+  while(!held){
+    dispatcher.dispatch();
+    }
+  fxmessage("read held back for %.3lf s: %s\n",elapsed*1.0E-9,(!dispatched && held==4)?"ok":"failed");
+  errors+=(dispatched || held!=4);
+
+  // Leave a read from an empty pipe in flight; exit must cancel it
+  memset(spare,0,sizeof(spare));
+  if(!dispatcher.submitRead(FXDispatcher::CompletionCallback::create<&onAbandoned>(),idle[0],spare,sizeof(spare))) errors++;
+  start=FXThread::steadytime();
+  dispatcher.exit();
+  elapsed=FXThread::steadytime()-start;
+  if(::write(idle[1],"late",4)!=4) errors++;
+  FXThread::sleep(10000000);
+  fxmessage("exit with read in flight in %.3lf s: %s\n",elapsed*1.0E-9,spare[0]?"buffer written after exit":"ok");
+  errors+=(spare[0]!=0);
+  ::close(idle[0]);
+  ::close(idle[1]);
+
+  if(maketemp) FXFile::remove(filename);
+  delete [] data;
+  return errors?1:0;
+#else
+  fxmessage("Asynchronous operations not supported on this platform.\n");
+  return 0;
+#endif
+  }
@@ -0,0 +1,209 @@
+/********************************************************************************
+*                                                                               *
+*                  M e s s a g e   C h a n n e l   T e s t                      *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+
+
+/*******************************************************************************/
+
+// Maximum number of workers
+const FXint MAXWORKERS=64;
+
+
+// Progress report
+struct Progress {
+  FXint worker;         // Worker number
+  FXint count;          // Reports sent so far
+  };
+
+
+// Receives progress reports in the main thread
+class Receiver : public FXObject {
+  FXDECLARE(Receiver)
+public:
+  FXint  last[MAXWORKERS];
+  FXlong delivered;
+  FXint  finished;
+  FXint  errors;
+public:
+  enum {
+    ID_PROGRESS=1,
+    ID_DONE=ID_PROGRESS+MAXWORKERS,
+    ID_LAST=ID_DONE+MAXWORKERS
+    };
+public:
+  Receiver();
+  long onCmdProgress(FXObject*,FXSelector,void*);
+  long onCmdDone(FXObject*,FXSelector,void*);
+  };
+
+
+// Map
+FXDEFMAP(Receiver) ReceiverMap[]={
+  FXMAPFUNCS(SEL_COMMAND,Receiver::ID_PROGRESS,Receiver::ID_DONE-1,Receiver::onCmdProgress),
+  FXMAPFUNCS(SEL_COMMAND,Receiver::ID_DONE,Receiver::ID_LAST-1,Receiver::onCmdDone)
+  };
+
+
+// Object implementation
+FXIMPLEMENT(Receiver,FXObject,ReceiverMap,ARRAYNUMBER(ReceiverMap))
+
+
+// Nothing received yet
+Receiver::Receiver():delivered(0),finished(0),errors(0){
+  for(FXint w=0; w<MAXWORKERS; ++w) last[w]=-1;
+  }
+
+
+// Reports from each worker must arrive in order; each worker has its own
+// message id, so coalescing keeps the latest report of each worker
+long Receiver::onCmdProgress(FXObject*,FXSelector sel,void* ptr){
+  const Progress* p=static_cast<const Progress*>(ptr);
+  if(!p || p->worker!=FXSELID(sel)-ID_PROGRESS || p->count<=last[p->worker]){
+    fxmessage("Bad progress report.\n");
+    errors++;
+    return 1;
+    }
+  last[p->worker]=p->count;
+  delivered++;
+  return 1;
+  }
+
+
+// Worker finished
+long Receiver::onCmdDone(FXObject*,FXSelector,void*){
+  finished++;
+  return 1;
+  }
+
+
+/*******************************************************************************/
+
+// Sends a stream of progress reports
+class Worker : public FXThread {
+private:
+  FXMessageChannel *channel;
+  Receiver         *receiver;
+  FXint             number;
+  FXint             count;
+public:
+  Worker(FXMessageChannel* c,Receiver* r,FXint n,FXint cnt):channel(c),receiver(r),number(n),count(cnt){ }
+  virtual FXint run();
+  };
+
+
+// Report progress, then say we're done
+FXint Worker::run(){
+  Progress p;
+  p.worker=number;
+  for(p.count=0; p.count<count; ++p.count){
+    channel->message(receiver,FXSEL(SEL_COMMAND,Receiver::ID_PROGRESS+number),&p,sizeof(p));
+    }
+  channel->message(receiver,FXSEL(SEL_COMMAND,Receiver::ID_DONE+number));
+  return 0;
+  }
+
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options:\n",prog);
+  fxmessage("  --workers <number>          Number of worker threads.\n");
+  fxmessage("  --count <number>            Number of reports per worker.\n");
+  fxmessage("  --coalesce                  Deliver only latest report of each worker.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXint nworkers=4;
+  FXint count=100000;
+  FXbool coalesce=false;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--workers")==0){
+      if(++arg>=argc){ fxmessage("Missing workers argument.\n"); exit(1); }
+      nworkers=strtol(argv[arg],nullptr,0);
+      if(nworkers<1 || nworkers>MAXWORKERS){ fxmessage("Value for workers (%d) out of range.\n",nworkers); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--count")==0){
+      if(++arg>=argc){ fxmessage("Missing count argument.\n"); exit(1); }
+      count=strtol(argv[arg],nullptr,0);
+      if(count<1){ fxmessage("Value for count (%d) too small.\n",count); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--coalesce")==0){
+      coalesce=true;
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+  // No need to open the display for this
+  FXApp application("Channel","FoxTest");
+  FXMessageChannel channel(&application);
+  Receiver receiver;
+  Worker* workers[MAXWORKERS];
+  FXint errors=0;
+
+  channel.setCoalesce(coalesce);
+
+  FXTime start=FXThread::steadytime();
+
+  // Start workers
+  for(FXint w=0; w<nworkers; ++w){
+    workers[w]=new Worker(&channel,&receiver,w,count);
+    workers[w]->start();
+    }
+
+  // Take reports until all are done
+  while(receiver.finished<nworkers){
+    application.runOneEvent();
+    }
+
+  FXTime elapsed=FXThread::steadytime()-start;
+
+  // Clean up
+  for(FXint w=0; w<nworkers; ++w){
+    workers[w]->join();
+    delete workers[w];
+    }
+
+  // Last report of each worker must have arrived; without coalescing, all of them
+  for(FXint w=0; w<nworkers; ++w){
+    if(receiver.last[w]!=count-1){ fxmessage("Last report of worker %d missing.\n",w); errors++; }
+    }
+  if(!coalesce && receiver.delivered!=(FXlong)nworkers*count){ fxmessage("Reports missing.\n"); errors++; }
+  errors+=receiver.errors;
+
+  fxmessage("%lld of %lld reports delivered in %.3lf s (%.0lf sent/s): %s\n",receiver.delivered,(FXlong)nworkers*count,elapsed*1.0E-9,nworkers*count/(elapsed*1.0E-9),errors?"failed":"ok");
+
+  // Main thread filling the channel itself is refused, rather than waiting forever
+  Receiver own;
+  Progress p;
+  p.worker=0;
+  for(p.count=0; p.count<count; ++p.count){
+    if(!channel.message(&own,FXSEL(SEL_COMMAND,Receiver::ID_PROGRESS),&p,sizeof(p))) break;
+    }
+  while(own.last[0]<p.count-1){
+    application.runOneEvent();
+    }
+  FXbool refused=(p.count<count) && own.errors==0;
+  if(!refused) errors++;
+  fxmessage("%d reports sent by main thread before channel was full: %s\n",p.count,refused?"ok":"failed");
+  return errors?1:0;
+  }
@@ -0,0 +1,200 @@
+/********************************************************************************
+*                                                                               *
+*                         C o r o u t i n e   T e s t                           *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+#include "fxcrc.h"
+#include "FXCoroutine.h"
+
+
+#if defined(FOX_HAVE_COROUTINES)
+
+/*******************************************************************************/
+
+// Message passed down a connection
+struct Message {
+  FXint  number;
+  FXuint payload[63];
+  };
+
+
+// Make-work on worker thread: checksum message many times
+static FXuint crunch(const Message& msg,FXint rounds){
+  FXuint crc=~0U;
+  for(FXint r=0; r<rounds; ++r){
+    for(FXuint i=0; i<ARRAYNUMBER(msg.payload); ++i){
+      crc=CRC32::CRC(crc,msg.payload[i]);
+      }
+    }
+  return crc^~0U;
+  }
+
+
+// Producer writes messages into the pipe at regular intervals, then hangs up
+FXCoTask<> producer(FXTaskDispatcher* disp,FXInputHandle hnd,FXint id,FXint count,FXTime interval){
+  Message msg;
+  for(FXint n=0; n<count; ++n){
+    co_await FXAwaitTimeout(disp,interval);
+    if(co_await FXAwaitHandle(disp,hnd,FXDispatcher::InputWrite)){
+      msg.number=n;
+      for(FXuint i=0; i<ARRAYNUMBER(msg.payload); ++i){ msg.payload[i]=id*1000003+n*31+i; }
+      if(::write(hnd,&msg,sizeof(msg))!=sizeof(msg)) break;
+      }
+    }
+  ::close(hnd);
+  }
+
+
+// Consumer reads messages from the pipe, checksums them on a worker thread,
+// and adds them up back on the dispatcher thread, until the pipe is closed
+FXCoTask<FXuint> consumer(FXTaskDispatcher* disp,FXThreadPool* pool,FXInputHandle hnd,FXint rounds,FXint* received){
+  FXuint total=0;
+  Message msg;
+  while(co_await FXAwaitHandle(disp,hnd,FXDispatcher::InputRead,FXLONG(5000000000))){
+    if(::read(hnd,&msg,sizeof(msg))!=sizeof(msg)) break;
+    co_await FXAwaitThreadPool(pool);
+    FXuint crc=crunch(msg,rounds);
+    co_await FXAwaitDispatcher(disp);
+    total+=crc;
+    *received+=1;
+    }
+  ::close(hnd);
+  co_return total;
+  }
+
+
+// Waits for all consumers, in turn
+FXCoTask<FXuint> collect(FXCoTask<FXuint>** consumers,FXint count){
+  FXuint total=0;
+  for(FXint c=0; c<count; ++c){
+    total+=co_await *consumers[c];
+    }
+  co_return total;
+  }
+
+
+// Same thing, serially
+static FXuint expected(FXint connections,FXint count,FXint rounds){
+  FXuint total=0;
+  Message msg;
+  for(FXint id=0; id<connections; ++id){
+    for(FXint n=0; n<count; ++n){
+      msg.number=n;
+      for(FXuint i=0; i<ARRAYNUMBER(msg.payload); ++i){ msg.payload[i]=id*1000003+n*31+i; }
+      total+=crunch(msg,rounds);
+      }
+    }
+  return total;
+  }
+
+#endif
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options:\n",prog);
+  fxmessage("  --threads <number>          Number of threads to start.\n");
+  fxmessage("  --connections <number>      Number of connections.\n");
+  fxmessage("  --messages <number>         Messages per connection.\n");
+  fxmessage("  --interval <number>         Interval between messages (ms).\n");
+  fxmessage("  --rounds <number>           Work per message.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXint nthreads=FXThread::processors();
+  FXint connections=100;
+  FXint messages=20;
+  FXint interval=10;
+  FXint rounds=1000;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--threads")==0){
+      if(++arg>=argc){ fxmessage("Missing threads number argument.\n"); exit(1); }
+      nthreads=strtol(argv[arg],nullptr,0);
+      if(nthreads<1){ fxmessage("Value for threads (%d) too small.\n",nthreads); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--connections")==0){
+      if(++arg>=argc){ fxmessage("Missing connections argument.\n"); exit(1); }
+      connections=strtol(argv[arg],nullptr,0);
+      if(connections<1){ fxmessage("Value for connections (%d) too small.\n",connections); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--messages")==0){
+      if(++arg>=argc){ fxmessage("Missing messages argument.\n"); exit(1); }
+      messages=strtol(argv[arg],nullptr,0);
+      }
+    else if(strcmp(argv[arg],"--interval")==0){
+      if(++arg>=argc){ fxmessage("Missing interval argument.\n"); exit(1); }
+      interval=strtol(argv[arg],nullptr,0);
+      }
+    else if(strcmp(argv[arg],"--rounds")==0){
+      if(++arg>=argc){ fxmessage("Missing rounds argument.\n"); exit(1); }
+      rounds=strtol(argv[arg],nullptr,0);
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+#if defined(FOX_HAVE_COROUTINES) && !defined(WIN32)
+  FXTaskDispatcher dispatcher;
+  FXThreadPool pool;
+  FXint received=0;
+  FXint c;
+
+  dispatcher.init();
+  pool.setMaximumThreads(nthreads);
+  pool.start(nthreads);
+
+  fxmessage("%d connections, %d messages each, on %d threads\n",connections,messages,nthreads);
+
+  FXTime start=FXThread::steadytime();
+
+  // Start a producer and consumer per connection
+  FXCoTask<FXuint>** consumers=new FXCoTask<FXuint>* [connections];
+  for(c=0; c<connections; ++c){
+    FXInputHandle h[2];
+    if(::pipe(h)!=0){ fxmessage("Unable to create pipe.\n"); exit(1); }
+    producer(&dispatcher,h[1],c,messages,interval*FXLONG(1000000)).detach();
+    consumers[c]=new FXCoTask<FXuint>(consumer(&dispatcher,&pool,h[0],rounds,&received));
+    consumers[c]->start();
+    }
+
+  // Collect results
+  FXCoTask<FXuint> total=collect(consumers,connections);
+  total.start();
+
+  // Dispatch till done
+  while(!total.done()){
+    dispatcher.dispatch();
+    }
+
+  FXTime elapsed=FXThread::steadytime()-start;
+
+  fxmessage("received %d messages in %.3lf s, total %08x (expected %08x)\n",received,elapsed*1.0E-9,total.get(),expected(connections,messages,rounds));
+
+  for(c=0; c<connections; ++c){
+    delete consumers[c];
+    }
+  delete [] consumers;
+
+  pool.stop();
+#else
+  fxmessage("Coroutines not supported by this compiler, or on this platform.\n");
+#endif
+  return 0;
+  }
@@ -0,0 +1,290 @@
+/********************************************************************************
+*                                                                               *
+*                  M e s s a g e   D i s p a t c h   T e s t                    *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+
+
+/*
+
+  Compares message dispatch through the flattened message maps of FXMetaClass
+  against the way it used to be done: search the message map of the class,
+  and if the message isn't there, pass it to the base class's handle().
+
+  The classes below mimic the depth and message map sizes of a widget like
+  FXTextField; each has, besides handle(), an oldHandle() doing dispatch
+  the old way.  The same handlers are called either way.
+
+  Also checks that the flattened lookup finds the same handlers as searching
+  the message maps one class at a time, for a number of FOX classes.
+
+*/
+
+/*******************************************************************************/
+
+// Message map of ten consecutive message ids
+#define TENFUNCS(type,key,func) \
+  FXMAPFUNC(type,key+0,func),FXMAPFUNC(type,key+1,func),FXMAPFUNC(type,key+2,func),FXMAPFUNC(type,key+3,func),FXMAPFUNC(type,key+4,func), \
+  FXMAPFUNC(type,key+5,func),FXMAPFUNC(type,key+6,func),FXMAPFUNC(type,key+7,func),FXMAPFUNC(type,key+8,func),FXMAPFUNC(type,key+9,func)
+
+
+// Dispatch as it used to be done
+#define OLDHANDLE(classname,baseclassname) \
+  long classname::oldHandle(FXObject* sender,FXSelector sel,void* ptr){ \
+    const FXMapEntry* me=(const FXMapEntry*)metaClass.search(sel); \
+    return me ? (this->* me->func)(sender,sel,ptr) : baseclassname::oldHandle(sender,sel,ptr); \
+    }
+
+
+// Like FXId
+class Level1 : public FXObject {
+  FXDECLARE(Level1)
+public:
+  FXlong count;
+public:
+  enum {
+    ID_LEVEL1=1,
+    ID_LAST=ID_LEVEL1+100
+    };
+public:
+  long onMessage(FXObject*,FXSelector,void*){ count++; return 1; }
+public:
+  Level1():count(0){ }
+  virtual long oldHandle(FXObject* sender,FXSelector sel,void* ptr){ return onDefault(sender,sel,ptr); }
+  };
+
+
+// Like FXDrawable
+class Level2 : public Level1 {
+  FXDECLARE(Level2)
+public:
+  enum {
+    ID_LEVEL2=Level1::ID_LAST,
+    ID_LAST=ID_LEVEL2+100
+    };
+public:
+  Level2(){ }
+  virtual long oldHandle(FXObject* sender,FXSelector sel,void* ptr);
+  };
+
+
+// Like FXWindow
+class Level3 : public Level2 {
+  FXDECLARE(Level3)
+public:
+  enum {
+    ID_LEVEL3=Level2::ID_LAST,
+    ID_LAST=ID_LEVEL3+100
+    };
+public:
+  Level3(){ }
+  virtual long oldHandle(FXObject* sender,FXSelector sel,void* ptr);
+  };
+
+
+// Like FXFrame
+class Level4 : public Level3 {
+  FXDECLARE(Level4)
+public:
+  enum {
+    ID_LEVEL4=Level3::ID_LAST,
+    ID_LAST=ID_LEVEL4+100
+    };
+public:
+  Level4(){ }
+  virtual long oldHandle(FXObject* sender,FXSelector sel,void* ptr);
+  };
+
+
+// Like FXTextField
+class Level5 : public Level4 {
+  FXDECLARE(Level5)
+public:
+  enum {
+    ID_LEVEL5=Level4::ID_LAST,
+    ID_LAST=ID_LEVEL5+100
+    };
+public:
+  Level5(){ }
+  virtual long oldHandle(FXObject* sender,FXSelector sel,void* ptr);
+  };
+
+
+// Message maps
+FXIMPLEMENT(Level1,FXObject,nullptr,0)
+
+
+FXDEFMAP(Level2) Level2Map[]={
+  FXMAPFUNC(SEL_UPDATE,Level2::ID_LEVEL2,Level2::onMessage),
+  FXMAPFUNC(SEL_COMMAND,Level2::ID_LEVEL2,Level2::onMessage),
+  };
+
+FXIMPLEMENT(Level2,Level1,Level2Map,ARRAYNUMBER(Level2Map))
+OLDHANDLE(Level2,Level1)
+
+
+FXDEFMAP(Level3) Level3Map[]={
+  FXMAPFUNC(SEL_UPDATE,0,Level3::onMessage),
+  FXMAPFUNC(SEL_PAINT,0,Level3::onMessage),
+  FXMAPFUNC(SEL_MOTION,0,Level3::onMessage),
+  FXMAPFUNC(SEL_CONFIGURE,0,Level3::onMessage),
+  FXMAPFUNC(SEL_MAP,0,Level3::onMessage),
+  FXMAPFUNC(SEL_UNMAP,0,Level3::onMessage),
+  FXMAPFUNC(SEL_ENTER,0,Level3::onMessage),
+  FXMAPFUNC(SEL_LEAVE,0,Level3::onMessage),
+  FXMAPFUNC(SEL_FOCUSIN,0,Level3::onMessage),
+  FXMAPFUNC(SEL_FOCUSOUT,0,Level3::onMessage),
+  TENFUNCS(SEL_DND_ENTER,0,Level3::onMessage),
+  TENFUNCS(SEL_COMMAND,Level3::ID_LEVEL3,Level3::onMessage),
+  TENFUNCS(SEL_COMMAND,Level3::ID_LEVEL3+10,Level3::onMessage),
+  TENFUNCS(SEL_COMMAND,Level3::ID_LEVEL3+20,Level3::onMessage),
+  TENFUNCS(SEL_UPDATE,Level3::ID_LEVEL3,Level3::onMessage),
+  TENFUNCS(SEL_UPDATE,Level3::ID_LEVEL3+10,Level3::onMessage),
+  };
+
+FXIMPLEMENT(Level3,Level2,Level3Map,ARRAYNUMBER(Level3Map))
+OLDHANDLE(Level3,Level2)
+
+
+FXDEFMAP(Level4) Level4Map[]={
+  FXMAPFUNC(SEL_PAINT,0,Level4::onMessage),
+  };
+
+FXIMPLEMENT(Level4,Level3,Level4Map,ARRAYNUMBER(Level4Map))
+OLDHANDLE(Level4,Level3)
+
+
+FXDEFMAP(Level5) Level5Map[]={
+  FXMAPFUNC(SEL_PAINT,0,Level5::onMessage),
+  FXMAPFUNC(SEL_LEFTBUTTONPRESS,0,Level5::onMessage),
+  FXMAPFUNC(SEL_LEFTBUTTONRELEASE,0,Level5::onMessage),
+  FXMAPFUNC(SEL_KEYPRESS,0,Level5::onMessage),
+  FXMAPFUNC(SEL_KEYRELEASE,0,Level5::onMessage),
+  FXMAPFUNC(SEL_SELECTION_LOST,0,Level5::onMessage),
+  FXMAPFUNC(SEL_SELECTION_GAINED,0,Level5::onMessage),
+  FXMAPFUNC(SEL_SELECTION_REQUEST,0,Level5::onMessage),
+  FXMAPFUNC(SEL_CLIPBOARD_LOST,0,Level5::onMessage),
+  FXMAPFUNC(SEL_CLIPBOARD_GAINED,0,Level5::onMessage),
+  TENFUNCS(SEL_COMMAND,Level5::ID_LEVEL5,Level5::onMessage),
+  TENFUNCS(SEL_COMMAND,Level5::ID_LEVEL5+10,Level5::onMessage),
+  TENFUNCS(SEL_COMMAND,Level5::ID_LEVEL5+20,Level5::onMessage),
+  TENFUNCS(SEL_UPDATE,Level5::ID_LEVEL5,Level5::onMessage),
+  TENFUNCS(SEL_UPDATE,Level5::ID_LEVEL5+10,Level5::onMessage),
+  };
+
+FXIMPLEMENT(Level5,Level4,Level5Map,ARRAYNUMBER(Level5Map))
+OLDHANDLE(Level5,Level4)
+
+
+/*******************************************************************************/
+
+// Search message maps one class at a time
+static const void* searchChain(const FXMetaClass* metaclass,FXSelector sel){
+  const void* entry;
+  while(metaclass){
+    if((entry=metaclass->search(sel))!=nullptr) return entry;
+    metaclass=metaclass->getBaseClass();
+    }
+  return nullptr;
+  }
+
+
+// Check flattened lookup against searching class by class
+static FXint checkClass(const FXMetaClass* metaclass,FXRandom& random){
+  const FXchar* name=metaclass->getClassName();
+  FXint errors=0;
+  FXSelector sel;
+  for(FXuint type=0; type<SEL_LAST+2; ++type){
+    for(FXuint id=0; id<1200; ++id){
+      sel=FXSEL(type,id);
+      if(metaclass->lookup(sel)!=searchChain(metaclass,sel)){ fxmessage("%s: lookup of %u:%u differs.\n",name,type,id); errors++; }
+      }
+    }
+  for(FXint i=0; i<100000; ++i){
+    sel=(FXSelector)random.randLong();
+    if(metaclass->lookup(sel)!=searchChain(metaclass,sel)){ fxmessage("%s: lookup of %u:%u differs.\n",name,FXSELTYPE(sel),FXSELID(sel)); errors++; }
+    }
+  return errors;
+  }
+
+
+// Time n dispatches of message sel, the new and the old way
+static FXint timeMessage(Level5& object,const FXchar* what,FXSelector sel,FXint n){
+  FXObject* obj=&object;
+  FXlong before,after;
+  FXTime start,newtime,oldtime;
+  before=object.count;
+  start=FXThread::steadytime();
+  for(FXint i=0; i<n; ++i){
+    obj->handle(nullptr,sel,nullptr);
+    }
+  newtime=FXThread::steadytime()-start;
+  after=object.count;
+  start=FXThread::steadytime();
+  for(FXint i=0; i<n; ++i){
+    object.oldHandle(nullptr,sel,nullptr);
+    }
+  oldtime=FXThread::steadytime()-start;
+  fxmessage("%-30s old: %6.2lf ns  new: %6.2lf ns  speedup: %5.2lf\n",what,(FXdouble)oldtime/n,(FXdouble)newtime/n,(FXdouble)oldtime/(FXdouble)newtime);
+  if(after-before!=object.count-after){ fxmessage("Handlers called differ.\n"); return 1; }
+  return 0;
+  }
+
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options:\n",prog);
+  fxmessage("  --count <number>            Number of dispatches of each message.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXint count=10000000;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--count")==0){
+      if(++arg>=argc){ fxmessage("Missing count argument.\n"); exit(1); }
+      count=strtol(argv[arg],nullptr,0);
+      if(count<1){ fxmessage("Value for count (%d) too small.\n",count); exit(1); }
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+  static const FXMetaClass *const classes[]={FXMETACLASS(FXObject),FXMETACLASS(FXApp),FXMETACLASS(FXDataTarget),FXMETACLASS(FXWindow),FXMETACLASS(FXFrame),FXMETACLASS(FXTextField),FXMETACLASS(FXText),FXMETACLASS(FXTable),FXMETACLASS(FXMainWindow),FXMETACLASS(FXFileSelector),FXMETACLASS(FXMDIChild),FXMETACLASS(Level5)};
+  FXRandom random(1234567);
+  Level5 object;
+  FXint errors=0;
+
+  // Same handlers found either way
+  for(FXuint c=0; c<ARRAYNUMBER(classes); ++c){
+    errors+=checkClass(classes[c],random);
+    }
+
+  // Time a few messages
+  errors+=timeMessage(object,"handled by Level5",FXSEL(SEL_KEYPRESS,0),count);
+  errors+=timeMessage(object,"range handled by Level5",FXSEL(SEL_UPDATE,Level5::ID_LEVEL5+15),count);
+  errors+=timeMessage(object,"handled by Level3",FXSEL(SEL_UPDATE,0),count);
+  errors+=timeMessage(object,"range handled by Level3",FXSEL(SEL_COMMAND,Level3::ID_LEVEL3+25),count);
+  errors+=timeMessage(object,"handled by Level2",FXSEL(SEL_COMMAND,Level2::ID_LEVEL2),count);
+  errors+=timeMessage(object,"not handled",FXSEL(SEL_IO_READ,7),count);
+
+  fxmessage("%s\n",errors?"failed":"ok");
+  return errors?1:0;
+  }
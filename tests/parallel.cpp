@@ -54,6 +54,57 @@ void looping(FXint i){
   }
 
 
+// Sum of indexes in [fm,to)
+FXdouble sumindexes(FXuint fm,FXuint to,FXdouble sum){
+  for(FXuint i=fm; i<to; ++i){ sum+=(FXdouble)i; }
+  return sum;
+  }
+
+
+// Add two values
+FXdouble add(FXdouble a,FXdouble b){
+  return a+b;
+  }
+
+
+// Compare two values
+FXint compare(const FXdouble& a,const FXdouble& b){
+  return (a>b)-(a<b);
+  }
+
+
+// Sorted item, counting how many are alive
+struct Item {
+  static volatile FXint alive;
+  FXdouble value;
+  Item():value(0.0){ atomicAdd(&alive,1); }
+  Item(const Item& other):value(other.value){ atomicAdd(&alive,1); }
+  Item& operator=(const Item& other){ value=other.value; return *this; }
+ ~Item(){ atomicAdd(&alive,-1); }
+  };
+
+volatile FXint Item::alive=0;
+
+
+// Sort items with a compare which throws after a while; returns true if
+// it threw, and every item it made was deleted
+FXbool sortthrowing(FXThreadPool* pool,FXival num,FXival cutoff,FXival nc){
+  FXRandom random(FXLONG(128628761545));
+  FXival budget=num*4;
+  FXbool threw=false;
+  Item *items=new Item[num];
+  for(FXival i=0; i<num; ++i){ items[i].value=random.randDouble(); }
+  try{
+    FXParallelSort(pool,items,num,cutoff,nc,[&](const Item& a,const Item& b){ if(--budget<0){ throw budget; } return compare(a.value,b.value); });
+    }
+  catch(FXival){
+    threw=true;
+    }
+  delete [] items;
+  return threw && Item::alive==0;
+  }
+
+
 // Low-level interface to thread pool
 class Job : public FXRunnable {
 public:
@@ -69,6 +120,88 @@ FXint Job::run(){
   return 0;
   }
 
+// Short task reporting its kind when it runs
+class Work : public FXRunnable {
+  const FXchar* kind;
+  FXuint        number;
+public:
+  Work(const FXchar* k,FXuint n):kind(k),number(n){}
+  virtual FXint run();
+  };
+
+
+// Report, then self-destruct
+FXint Work::run(){
+  FXThread::sleep(1000000);
+  fxmessage("%s %u th %p\n",kind,number,(void*)FXThread::current());
+  delete this;
+  return 0;
+  }
+
+
+// Number of items searched
+volatile FXuint searched=0;
+
+
+// Search task scanning a number of items in parallel
+class Search : public FXRunnable {
+public:
+  Search(){}
+  virtual FXint run();
+  };
+
+
+// Search items, one millisecond each; stops early when cancelled
+FXint Search::run(){
+  FXParallelFor(0,100,1,[](FXint){ FXThread::sleep(1000000); atomicAdd(&searched,1U); });
+  return 0;
+  }
+
+
+// Stage in a task graph
+class Stage : public FXRunnable {
+  const FXchar* name;
+public:
+  Stage(const FXchar* nm):name(nm){}
+  virtual FXint run();
+  };
+
+
+// Perform make-work procedure for the stage
+FXint Stage::run(){
+  fxmessage("Stage %s start th %p\n",name,(void*)FXThread::current());
+  looping(0);
+  fxmessage("Stage %s done  th %p\n",name,(void*)FXThread::current());
+  return 0;
+  }
+
+
+// Counts how often it was run
+class Tick : public FXRunnable {
+public:
+  volatile FXuint count;
+public:
+  Tick():count(0){}
+  virtual FXint run(){ atomicAdd(&count,1U); return 0; }
+  };
+
+// Fibonacci number, computing one half in parallel through a future;
+// waiting for the future helps out, so nested waits do not deadlock.
+struct Fibonacci {
+  FXint n;
+  Fibonacci(FXint x):n(x){}
+  FXlong operator()() const {
+    if(n<20){
+      FXlong a=0,b=1,t;
+      for(FXint i=0; i<n; ++i){ t=a+b; a=b; b=t; }
+      return a;
+      }
+    FXFuture<FXlong> f1=FXThreadPool::instance()->async(Fibonacci(n-1));
+    FXlong f2=Fibonacci(n-2)();
+    return f1.get()+f2;
+    }
+  };
+
 /*******************************************************************************/
 
 // Print options
@@ -80,13 +213,24 @@ void printusage(const char* prog){
   fxmessage("  --jobs <number>             Number of jobs to run.\n");
   fxmessage("  --size <number>             Queue size.\n");
   fxmessage("  --pieces <number>           Split in this many pieces.\n");
+  fxmessage("  --grain <number>            Grain size for dynamic loop.\n");
+  fxmessage("  --aging <number>            High priority tasks before a normal one (0=never).\n");
   fxmessage("  -tracelevel <number>        Set trace level.\n");
   fxmessage("  -W, --wait                  Calling thread waits.\n");
+  fxmessage("  -S, --steal                 Use work-stealing scheduler.\n");
+  fxmessage("  -C, --compact               Pin workers to processors, compact placement.\n");
+  fxmessage("  -T, --statistics            Collect and print timing statistics.\n");
   fxmessage("  -h, --help                  Print help.\n");
   fxmessage("  -N, --null                  Test create/destroy pool.\n");
   fxmessage("  -P, --pool                  Test thread pool.\n");
   fxmessage("  -L, --loop                  Test parallel loop.\n");
+  fxmessage("  -D, --dynamic               Test dynamic parallel loop.\n");
   fxmessage("  -I, --invoke                Test parallel invoke.\n");
+  fxmessage("  -A, --algorithms            Test parallel reduce, scan, and sort.\n");
+  fxmessage("  -G, --graph                 Test task graph.\n");
+  fxmessage("  -F, --future                Test futures.\n");
+  fxmessage("  -R, --priority              Test task priorities.\n");
+  fxmessage("  -X, --cancel                Test task group cancellation.\n");
   }
 
 
@@ -111,8 +255,14 @@ int main(int argc,char* argv[]){
   FXuint nthreads=1;
   FXuint size=512;
   FXuint njobs=10;
+  FXuint grain=1;
+  FXuint aging=8;
   FXuint test=2;
   FXuint wait=0;
+  FXuint steal=0;
+  FXuint compact=0;
+  FXuint statistics=0;
+  FXTime start;
 
   // Grab a few arguments
   for(FXint arg=1; arg<argc; ++arg){
@@ -131,6 +281,15 @@ int main(int argc,char* argv[]){
       if(pieces<1){ fxmessage("Value for pieces number of pieces (%d) too small.\n",pieces); exit(1); }
       if(pieces>FXParallelMax){ fxmessage("Value for pieces number of pieces (%d) too large (%d).\n",pieces,FXParallelMax); exit(1); }
       }
+    else if(strcmp(argv[arg],"--grain")==0){
+      if(++arg>=argc){ fxmessage("Missing grain size argument.\n"); exit(1); }
+      grain=strtoul(argv[arg],nullptr,0);
+      if(grain<1){ fxmessage("Value for grain size (%d) too small.\n",grain); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--aging")==0){
+      if(++arg>=argc){ fxmessage("Missing aging argument.\n"); exit(1); }
+      aging=strtoul(argv[arg],nullptr,0);
+      }
     else if(strcmp(argv[arg],"--minimum")==0){
       if(++arg>=argc){ fxmessage("Missing threads number argument.\n"); exit(1); }
       minimum=strtoul(argv[arg],nullptr,0);
@@ -155,15 +314,42 @@ int main(int argc,char* argv[]){
     else if(strcmp(argv[arg],"-W")==0 || strcmp(argv[arg],"--wait")==0){
       wait=1;
       }
+    else if(strcmp(argv[arg],"-S")==0 || strcmp(argv[arg],"--steal")==0){
+      steal=1;
+      }
+    else if(strcmp(argv[arg],"-C")==0 || strcmp(argv[arg],"--compact")==0){
+      compact=1;
+      }
+    else if(strcmp(argv[arg],"-T")==0 || strcmp(argv[arg],"--statistics")==0){
+      statistics=1;
+      }
     else if(strcmp(argv[arg],"-P")==0 || strcmp(argv[arg],"--pool")==0){
       test=1;
       }
     else if(strcmp(argv[arg],"-L")==0 || strcmp(argv[arg],"--loop")==0){
       test=2;
       }
+    else if(strcmp(argv[arg],"-D")==0 || strcmp(argv[arg],"--dynamic")==0){
+      test=4;
+      }
     else if(strcmp(argv[arg],"-I")==0 || strcmp(argv[arg],"--invoke")==0){
       test=3;
       }
+    else if(strcmp(argv[arg],"-A")==0 || strcmp(argv[arg],"--algorithms")==0){
+      test=5;
+      }
+    else if(strcmp(argv[arg],"-G")==0 || strcmp(argv[arg],"--graph")==0){
+      test=6;
+      }
+    else if(strcmp(argv[arg],"-F")==0 || strcmp(argv[arg],"--future")==0){
+      test=7;
+      }
+    else if(strcmp(argv[arg],"-R")==0 || strcmp(argv[arg],"--priority")==0){
+      test=8;
+      }
+    else if(strcmp(argv[arg],"-X")==0 || strcmp(argv[arg],"--cancel")==0){
+      test=9;
+      }
     else if(strcmp(argv[arg],"-N")==0 || strcmp(argv[arg],"--null")==0){
       test=0;
       }
@@ -188,6 +374,18 @@ int main(int argc,char* argv[]){
   pool.setMaximumThreads(maximum);
   pool.setExpiration(1000000);
 
+  // Set scheduler
+  pool.setScheduler(steal?FXThreadPool::SchedulerStealing:FXThreadPool::SchedulerShared);
+
+  // Set placement
+  pool.setPlacement(compact?FXThreadPool::PlacementCompact:FXThreadPool::PlacementNone);
+
+  // Set aging of high priority tasks
+  pool.setAging(aging);
+
+  // Collect timing statistics
+  pool.setStatistics(statistics);
+
   fxmessage("starting %d of maximum of %d threads, keeping at least %d\n",nthreads,maximum,minimum);
 
   // Start context
@@ -197,6 +395,9 @@ int main(int argc,char* argv[]){
 
   getchar();
 
+  // Start timing
+  start=FXThread::steadytime();
+
   // Test plain thread pool usage
   if(1==test){
 
@@ -240,6 +441,178 @@ int main(int argc,char* argv[]){
     fxmessage("...done\n");
     }
 
+  // Test dynamic loop
+  if(4==test){
+    fxmessage("%d-way dynamic parallel for-loop, grain %d...\n",nthreads,grain);
+
+    // Do something in parallel, handing out iterations on the fly
+    FXParallelForDynamic(0U,njobs,1U,grain,pieces,looping);
+
+    fxmessage("...done!\n");
+    }
+
+  // Test parallel algorithms
+  if(5==test){
+    FXuint count=njobs*100000;
+    FXdouble *values=new FXdouble [count];
+    FXRandom random(FXThread::time());
+    FXdouble sum;
+    FXuint i;
+
+    fxmessage("parallel reduce over %u items...\n",count);
+    sum=FXParallelReduce(0U,count,grain,0.0,sumindexes,add);
+    fxmessage("...done: %s\n",(sum==0.5*count*(count-1.0))?"ok":"failed");
+
+    fxmessage("parallel scan over %u items...\n",count);
+    for(i=0; i<count; ++i){ values[i]=1.0; }
+    FXParallelInclusiveScan(values,values,(FXival)count,(FXival)grain,0.0,add);
+    fxmessage("...done: %s\n",(values[count-1]==count)?"ok":"failed");
+
+    fxmessage("parallel sort of %u items...\n",count);
+    for(i=0; i<count; ++i){ values[i]=random.randDouble(); }
+    FXParallelSort(values,(FXival)count,(FXival)grain,compare);
+    for(i=1; i<count && values[i-1]<=values[i]; ++i){ }
+    fxmessage("...done: %s\n",(i==count)?"ok":"failed");
+
+    fxmessage("sort of %u items on stopped pool...\n",count);
+    FXThreadPool stopped;
+    for(i=0; i<count; ++i){ values[i]=random.randDouble(); }
+    FXParallelSort(&stopped,values,(FXival)count,(FXival)grain,(FXival)4,compare);
+    for(i=1; i<count && values[i-1]<=values[i]; ++i){ }
+    fxmessage("...done: %s\n",(i==count)?"ok":"failed");
+
+    fxmessage("sort with throwing compare...\n");
+    fxmessage("...done: %s\n",(sortthrowing(&stopped,1000,1000,1) && sortthrowing(&stopped,1000,100,4))?"ok":"failed");
+
+    delete [] values;
+    }
+
+  // Test task graph
+  if(6==test){
+    Stage decode("decode"),scale1("scale 1"),scale2("scale 2"),quantize("quantize"),encode("encode");
+    FXTaskGroup::Node n1(&decode),n2(&scale1),n3(&scale2),n4(&quantize),n5(&encode);
+    FXTaskGroup group(&pool);
+
+    fxmessage("task graph...\n");
+
+    // Both scale stages follow decode; quantize waits for both; encode follows quantize
+    n2.after(&n1);
+    n3.after(&n1);
+    n4.after(&n2);
+    n4.after(&n3);
+    n5.after(&n4);
+
+    // Schedule in arbitrary order
+    group.schedule(&n5);
+    group.schedule(&n4);
+    group.schedule(&n3);
+    group.schedule(&n2);
+    group.schedule(&n1);
+
+    // Only the final join blocks
+    group.wait();
+
+    fxmessage("...done!\n");
+
+    // Long chains are released by a loop, not recursively
+    const FXint length=100000;
+    FXTaskGroup::Node *chain=new FXTaskGroup::Node[length];
+    FXTaskGroup cancelled(&pool);
+    Tick tick;
+    FXint i;
+
+    fxmessage("cancelled chain of %d nodes...\n",length);
+    for(i=0; i<length; ++i){
+      chain[i].setRunnable(&tick);
+      chain[i].after((0<i)?&chain[i-1]:nullptr);
+      }
+    cancelled.setCancelled(true);
+    for(i=length-1; 0<=i; --i){
+      cancelled.schedule(&chain[i]);
+      }
+    cancelled.wait();
+    fxmessage("...done: %s\n",(tick.count==0 && chain[length-1].isSkipped())?"ok":"failed");
+    delete [] chain;
+
+    fxmessage("chain of %d nodes on stopped pool...\n",length);
+    chain=new FXTaskGroup::Node[length];
+    FXThreadPool stopped;
+    FXTaskGroup direct(&stopped);
+    for(i=0; i<length; ++i){
+      chain[i].setRunnable(&tick);
+      chain[i].after((0<i)?&chain[i-1]:nullptr);
+      }
+    for(i=length-1; 0<=i; --i){
+      direct.schedule(&chain[i]);
+      }
+    direct.wait();
+    fxmessage("...done: %s\n",(tick.count==(FXuint)length)?"ok":"failed");
+    delete [] chain;
+    }
+
+  // Test futures
+  if(7==test){
+    fxmessage("futures...\n");
+
+    // Recursive computation through futures
+    FXFuture<FXlong> result=pool.async(Fibonacci(20+njobs));
+
+    fxmessage("...done: fibonacci(%u)=%lld\n",20+njobs,result.get());
+
+    // Only the first value set sticks, also when set from several threads at once
+    FXuint kept=0;
+    for(FXint round=0; round<1000; ++round){
+      FXPromise<FXlong> promise;
+      FXFuture<FXlong> future=promise.getFuture();
+      FXFuture<FXbool> first=pool.async([&promise,round](){ return promise.setValue(round); });
+      FXbool second=promise.setValue(-1);
+      if(first.get()!=second && future.get()==(second?-1:round)) kept++;
+      }
+    fxmessage("...done: first value kept %u of 1000 times\n",kept);
+    }
+
+  // Test priorities
+  if(8==test){
+    fxmessage("priorities: %d background and %d interactive jobs...\n",njobs,njobs);
+
+    // Background jobs first
+    for(FXuint j=0; j<njobs; ++j){
+      pool.execute(new Work("background",j));
+      }
+
+    // Interactive jobs overtake them, except for aging
+    for(FXuint j=0; j<njobs; ++j){
+      pool.execute(new Work("interactive",j),FXThreadPool::PriorityHigh);
+      }
+
+    pool.wait();
+
+    fxmessage("...done!\n");
+    }
+
+  // Test cancellation
+  if(9==test){
+    FXTaskGroup group(&pool);
+    Search *searches=new Search[njobs];
+
+    fxmessage("cancel: %d searches of 100 items...\n",njobs);
+
+    // Start searches
+    for(FXuint j=0; j<njobs; ++j){
+      group.execute(&searches[j]);
+      }
+
+    // Abort after a short while
+    FXThread::sleep(50000000);
+    group.setCancelled(true);
+    group.wait();
+
+    fxmessage("...done: searched %u of %u items\n",searched,njobs*100);
+    delete [] searches;
+    }
+
+  fxmessage("elapsed: %.3lfs (%s scheduler)\n",(FXThread::steadytime()-start)*1.0E-9,steal?"stealing":"shared");
+
   fxmessage("running: %d!\n",pool.getRunningThreads());
 
   // Wait for user
@@ -248,6 +621,42 @@ int main(int argc,char* argv[]){
   fxmessage("stopping...\n");
   pool.stop();
   fxmessage("...done!\n");
+
+  // Statistics can be switched on and reset while a pool runs
+  {
+  FXThreadPool live;
+  Tick tick;
+  FXulong waits=0;
+  FXint i;
+  live.start(2);
+  live.setStatistics(true);
+  FXTaskGroup group(&live);
+  for(i=0; i<100; ++i){ group.execute(&tick); }
+  group.wait();
+  for(i=0; i<FXThreadPool::LatencyBuckets; ++i){ waits+=live.getWaitHistogram(i); }
+  FXbool ok=(live.getSubmittedTasks()==100 && waits==100);
+  live.resetStatistics();
+  for(i=0,waits=0; i<FXThreadPool::LatencyBuckets; ++i){ waits+=live.getWaitHistogram(i); }
+  ok&=(live.getSubmittedTasks()==0 && live.getHighWater()==0 && waits==0);
+  for(i=0; i<10; ++i){ group.execute(&tick); }
+  group.wait();
+  ok&=(live.getSubmittedTasks()==10);
+  live.stop();
+  fxmessage("live statistics: %s\n",ok?"ok":"failed");
+  }
+
+  // Print statistics
+  fxmessage("tasks: %llu submitted, %llu completed, high-water %u, producers blocked %.3lfms\n",pool.getSubmittedTasks(),pool.getCompletedTasks(),pool.getHighWater(),pool.getBlockedTime()*1.0E-6);
+  if(statistics){
+    for(FXint w=0; w<(FXint)pool.getMaximumThreads(); ++w){
+      fxmessage("worker %2d: busy %.3lfms idle %.3lfms\n",w,pool.getBusyTime(w)*1.0E-6,pool.getIdleTime(w)*1.0E-6);
+      }
+    for(FXint b=0; b<FXThreadPool::LatencyBuckets; ++b){
+      if(pool.getRunHistogram(b) || pool.getWaitHistogram(b)){
+        fxmessage("latency < %8lldus: run %8llu wait %8llu\n",FXLONG(1)<<b,pool.getRunHistogram(b),pool.getWaitHistogram(b));
+        }
+      }
+    }
   return 0;
   }
 
@@ -0,0 +1,250 @@
+/********************************************************************************
+*                                                                               *
+*                         P i p e l i n e   T e s t                             *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+#include "fxcrc.h"
+
+
+/*******************************************************************************/
+
+// Chunk of input data
+struct Chunk {
+  FXlong   number;      // Chunk number
+  FXuchar *data;        // Data
+  FXival   size;        // Number of bytes
+  FXuint   crc;         // Checksum of data
+  };
+
+
+// Checksum a buffer, the given number of rounds, to simulate harder work
+static FXuint checksum(const FXuchar* data,FXival size,FXuint rounds){
+  FXuint crc=~0U;
+  for(FXuint r=0; r<rounds; ++r){
+    for(FXival i=0; i<size; ++i){
+      crc=CRC32::CRC(crc,data[i]);
+      }
+    }
+  return crc^~0U;
+  }
+
+
+// Reads chunks from a file, or makes them up if no file was given
+class Reader : public FXPipeline::Stage {
+private:
+  FXFile  file;
+  FXRandom random;
+  FXlong  remaining;
+  FXival  chunksize;
+  FXlong  number;
+public:
+  FXlong  total;
+public:
+  Reader(FXival cs):FXPipeline::Stage(FXPipeline::Serial),random(1234567),remaining(0),chunksize(cs),number(0),total(0){ }
+  FXbool open(const FXString& name){ if(!file.open(name,FXIO::Reading)) return false; remaining=file.size(); return true; }
+  void synthesize(FXlong bytes){ remaining=bytes; }
+  virtual FXptr process(FXptr);
+  };
+
+
+// Read next chunk; return null at the end
+FXptr Reader::process(FXptr){
+  if(0<remaining){
+    Chunk* chunk=new Chunk;
+    chunk->number=number++;
+    chunk->size=(FXival)FXMIN(remaining,chunksize);
+    chunk->data=new FXuchar[chunk->size];
+    chunk->crc=0;
+    if(file.isOpen()){
+      chunk->size=file.readBlock(chunk->data,chunk->size);
+      if(chunk->size<=0){ delete [] chunk->data; delete chunk; remaining=0; return nullptr; }
+      }
+    else{
+      for(FXival i=0; i<chunk->size; ++i){ chunk->data[i]=(FXuchar)random.randLong(); }
+      }
+    remaining-=chunk->size;
+    total+=chunk->size;
+    return chunk;
+    }
+  return nullptr;
+  }
+
+
+// Checksums chunks, in parallel
+class Summer : public FXPipeline::Stage {
+private:
+  FXuint rounds;
+public:
+  Summer(FXuint r):FXPipeline::Stage(FXPipeline::Parallel),rounds(r){ }
+  virtual FXptr process(FXptr item){
+    Chunk* chunk=(Chunk*)item;
+    chunk->crc=checksum(chunk->data,chunk->size,rounds);
+    return chunk;
+    }
+  };
+
+
+// Combines checksums of chunks, in order
+class Writer : public FXPipeline::Stage {
+public:
+  FXlong expect;
+  FXuint digest;
+  FXbool inorder;
+public:
+  Writer():FXPipeline::Stage(FXPipeline::Serial),expect(0),digest(~0U),inorder(true){ }
+  virtual FXptr process(FXptr item){
+    Chunk* chunk=(Chunk*)item;
+    if(chunk->number!=expect) inorder=false;
+    digest=CRC32::CRC(digest,chunk->crc);
+    expect++;
+    delete [] chunk->data;
+    delete chunk;
+    return nullptr;
+    }
+  };
+
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options [file]:\n",prog);
+  fxmessage("  --threads <number>          Number of threads to start.\n");
+  fxmessage("  --tokens <number>           Maximum number of chunks in flight.\n");
+  fxmessage("  --chunk <number>            Chunk size in bytes.\n");
+  fxmessage("  --megs <number>             Megabytes of data to make up if no file given.\n");
+  fxmessage("  --rounds <number>           Checksum each chunk this many times.\n");
+  fxmessage("  -v, --verify                Verify against serial computation.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXuint nthreads=FXThread::processors();
+  FXuint ntokens=0;
+  FXival chunksize=1048576;
+  FXlong megs=64;
+  FXuint rounds=1;
+  FXuint verify=0;
+  FXString filename;
+  FXTime start;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--threads")==0){
+      if(++arg>=argc){ fxmessage("Missing threads number argument.\n"); exit(1); }
+      nthreads=strtoul(argv[arg],nullptr,0);
+      if(nthreads<1){ fxmessage("Value for threads (%d) too small.\n",nthreads); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--tokens")==0){
+      if(++arg>=argc){ fxmessage("Missing tokens number argument.\n"); exit(1); }
+      ntokens=strtoul(argv[arg],nullptr,0);
+      if(ntokens<1){ fxmessage("Value for tokens (%d) too small.\n",ntokens); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--chunk")==0){
+      if(++arg>=argc){ fxmessage("Missing chunk size argument.\n"); exit(1); }
+      chunksize=strtoul(argv[arg],nullptr,0);
+      if(chunksize<1){ fxmessage("Value for chunk size too small.\n"); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--megs")==0){
+      if(++arg>=argc){ fxmessage("Missing megabytes argument.\n"); exit(1); }
+      megs=strtoul(argv[arg],nullptr,0);
+      }
+    else if(strcmp(argv[arg],"--rounds")==0){
+      if(++arg>=argc){ fxmessage("Missing rounds argument.\n"); exit(1); }
+      rounds=strtoul(argv[arg],nullptr,0);
+      if(rounds<1){ fxmessage("Value for rounds (%d) too small.\n",rounds); exit(1); }
+      }
+    else if(strcmp(argv[arg],"-v")==0 || strcmp(argv[arg],"--verify")==0){
+      verify=1;
+      }
+    else if(argv[arg][0]!='-'){
+      filename=argv[arg];
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+  // Default to a few tokens per thread
+  if(ntokens==0) ntokens=nthreads*4;
+
+  // Create thread pool
+  FXThreadPool pool;
+  pool.setMaximumThreads(nthreads);
+  pool.start(nthreads);
+
+  // Stages
+  Reader reader(chunksize);
+  Summer summer(rounds);
+  Writer writer;
+
+  // Input
+  if(!filename.empty()){
+    if(!reader.open(filename)){ fxmessage("Unable to open: %s\n",filename.text()); exit(1); }
+    }
+  else{
+    reader.synthesize(megs*1048576);
+    }
+
+  // Set up pipeline
+  FXPipeline pipeline(&pool);
+  pipeline.append(&reader);
+  pipeline.append(&summer);
+  pipeline.append(&writer);
+
+  fxmessage("running pipeline with %u threads and %u tokens\n",nthreads,ntokens);
+
+  // Run it
+  start=FXThread::steadytime();
+  FXulong chunks=pipeline.run(ntokens);
+  FXTime elapsed=FXThread::steadytime()-start;
+
+  pool.stop();
+
+  fxmessage("chunks: %llu bytes: %lld digest: %08x order: %s\n",chunks,reader.total,writer.digest,writer.inorder?"ok":"WRONG");
+  fxmessage("elapsed: %.3lf s, %.1lf MB/s\n",elapsed*1.0E-9,(reader.total/1048576.0)/(elapsed*1.0E-9+1.0E-9));
+
+  // Many small items through the stopped pool, which are run by the calling thread
+  {
+  Reader tiny(1);
+  Summer sum(1);
+  Writer last;
+  FXPipeline stopped(&pool);
+  tiny.synthesize(1000000);
+  stopped.append(&tiny);
+  stopped.append(&sum);
+  stopped.append(&last);
+  FXulong items=stopped.run(ntokens);
+  fxmessage("stopped pool: items: %llu order: %s\n",items,(items==1000000 && last.inorder)?"ok":"WRONG");
+  }
+
+  // Same thing, serially
+  if(verify){
+    Reader again(chunksize);
+    FXuint digest=~0U;
+    Chunk* chunk;
+    if(!filename.empty()) again.open(filename); else again.synthesize(megs*1048576);
+    start=FXThread::steadytime();
+    while((chunk=(Chunk*)again.process(nullptr))!=nullptr){
+      digest=CRC32::CRC(digest,checksum(chunk->data,chunk->size,rounds));
+      delete [] chunk->data;
+      delete chunk;
+      }
+    elapsed=FXThread::steadytime()-start;
+    fxmessage("serial digest: %08x %s\n",digest,(digest==writer.digest)?"matches":"DIFFERS");
+    fxmessage("serial elapsed: %.3lf s, %.1lf MB/s\n",elapsed*1.0E-9,(again.total/1048576.0)/(elapsed*1.0E-9+1.0E-9));
+    }
+  return 0;
+  }
@@ -0,0 +1,408 @@
+/********************************************************************************
+*                                                                               *
+*                     P i x e l   B u f f e r   T e s t                         *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+
+
+/*******************************************************************************/
+
+// Fill buffer with random pixels
+static void randomize(FXPixelBuffer& buf,FXRandom& random){
+  FXColor *pix=buf.getData();
+  for(FXint i=0; i<buf.getWidth()*buf.getHeight(); ++i){
+    pix[i]=(FXColor)random.next();
+    }
+  }
+
+
+// Compare buffers
+static FXbool same(const FXPixelBuffer& a,const FXPixelBuffer& b){
+  if(a.getWidth()!=b.getWidth() || a.getHeight()!=b.getHeight()) return false;
+  return memcmp(a.getData(),b.getData(),sizeof(FXColor)*a.getWidth()*a.getHeight())==0;
+  }
+
+
+// Report outcome of check
+static FXint check(const char* what,FXint w,FXint h,FXbool ok){
+  if(!ok){ fxmessage("%s %dx%d: failed\n",what,w,h); }
+  return ok?0:1;
+  }
+
+
+// Rotations, mirrors, and crops against naive loops
+static FXint testgeometry(FXint w,FXint h,FXRandom& random){
+  FXPixelBuffer src(w,h);
+  FXint errors=0;
+  FXint x,y;
+  randomize(src,random);
+
+  FXPixelBuffer r90(h,w);
+  FXPixelBuffer r180(w,h);
+  FXPixelBuffer r270(h,w);
+  src.rotate(r90,90);
+  src.rotate(r180,180);
+  src.rotate(r270,270);
+  FXbool ok90=true,ok180=true,ok270=true;
+  for(y=0; y<w; ++y){
+    for(x=0; x<h; ++x){
+      ok90&=(r90.getPixel(x,y)==src.getPixel(w-1-y,x));
+      ok270&=(r270.getPixel(x,y)==src.getPixel(y,h-1-x));
+      }
+    }
+  for(y=0; y<h; ++y){
+    for(x=0; x<w; ++x){
+      ok180&=(r180.getPixel(x,y)==src.getPixel(w-1-x,h-1-y));
+      }
+    }
+  errors+=check("rotate 90",w,h,ok90);
+  errors+=check("rotate 180",w,h,ok180);
+  errors+=check("rotate 270",w,h,ok270);
+
+  FXPixelBuffer mir(w,h);
+  FXbool okh=true,okv=true;
+  memcpy(mir.getData(),src.getData(),sizeof(FXColor)*w*h);
+  mir.mirror(true,false);
+  for(y=0; y<h; ++y){
+    for(x=0; x<w; ++x){ okh&=(mir.getPixel(x,y)==src.getPixel(w-1-x,y)); }
+    }
+  memcpy(mir.getData(),src.getData(),sizeof(FXColor)*w*h);
+  mir.mirror(false,true);
+  for(y=0; y<h; ++y){
+    for(x=0; x<w; ++x){ okv&=(mir.getPixel(x,y)==src.getPixel(x,h-1-y)); }
+    }
+  errors+=check("mirror horizontal",w,h,okh);
+  errors+=check("mirror vertical",w,h,okv);
+
+  FXint cx=-w/4,cy=h/3;
+  FXPixelBuffer crp(w/2+w/3+1,h);
+  FXbool okc=true;
+  src.crop(crp,cx,cy,FXRGBA(1,2,3,4));
+  for(y=0; y<crp.getHeight(); ++y){
+    for(x=0; x<crp.getWidth(); ++x){
+      FXbool inside=(0<=x+cx && x+cx<w && 0<=y+cy && y+cy<h);
+      okc&=(crp.getPixel(x,y)==(inside?src.getPixel(x+cx,y+cy):FXRGBA(1,2,3,4)));
+      }
+    }
+  errors+=check("crop",w,h,okc);
+  return errors;
+  }
+
+
+// Transpose src into dst
+static void transpose(FXPixelBuffer& dst,const FXPixelBuffer& src){
+  dst.resize(src.getHeight(),src.getWidth());
+  for(FXint y=0; y<src.getHeight(); ++y){
+    for(FXint x=0; x<src.getWidth(); ++x){ dst.setPixel(y,x,src.getPixel(x,y)); }
+    }
+  }
+
+
+// Check ramp of n pixels, step apart, rises monotonically, is symmetric about its
+// middle, and ends within a destination pixel's worth of the ends of the source ramp
+static FXbool checkramp(const FXColor* pix,FXint n,FXint step,FXint sn){
+  FXint slack=255/(sn-1)*((sn+n-1)/n)+1;
+  FXbool ok=(FXREDVAL(pix[0])<=slack) && (255-slack<=FXREDVAL(pix[(n-1)*step]));
+  for(FXint i=0; i<n; ++i){
+    if(0<i && FXREDVAL(pix[i*step])<FXREDVAL(pix[(i-1)*step])) ok=false;
+    if(FXABS(FXREDVAL(pix[i*step])+FXREDVAL(pix[(n-1-i)*step])-255)>1) ok=false;
+    }
+  return ok;
+  }
+
+
+// Mitchell and Lanczos scaling: constant images stay exactly constant, ramps stay
+// monotone and symmetric, and vector and scalar filter code agree bit for bit
+static FXint testfilter(FXRandom& random){
+  static const FXint sizes[][4]={{37,29,101,73},{101,73,37,29},{256,200,20,17},{255,199,9,7},{61,41,7,300}};
+  static const FXint lengths[]={500,256,97,40,20,7};
+  FXPixelBuffer src,dst,tra,res;
+  FXint errors=0;
+  FXint q,i,x,y;
+  FXbool ok;
+  for(q=3; q<=4; ++q){
+    const FXchar* name=(q==3)?"mitchell":"lanczos";
+
+    // Constant stays constant, up and down
+    for(i=0; i<(FXint)ARRAYNUMBER(sizes); ++i){
+      src.resize(sizes[i][0],sizes[i][1]);
+      dst.resize(sizes[i][2],sizes[i][3]);
+      src.fill(FXRGBA(200,100,50,180));
+      src.scale(dst,q);
+      for(x=0,ok=true; x<dst.getWidth()*dst.getHeight(); ++x){ ok&=(dst.getData()[x]==FXRGBA(200,100,50,180)); }
+      errors+=check(name,sizes[i][2],sizes[i][3],ok);
+      }
+
+    // Horizontal and vertical ramps; sources of 256 pixels, so each pixel is one level up
+    for(i=0; i<(FXint)ARRAYNUMBER(lengths); ++i){
+      src.resize(256,3);
+      for(y=0; y<3; ++y){
+        for(x=0; x<256; ++x){ src.setPixel(x,y,FXRGBA(x,x,x,255)); }
+        }
+      dst.resize(lengths[i],3);
+      src.scale(dst,q);
+      errors+=check(name,lengths[i],3,checkramp(dst.getData()+dst.getWidth(),lengths[i],1,256));
+      transpose(tra,src);
+      res.resize(3,lengths[i]);
+      tra.scale(res,q);
+      errors+=check(name,3,lengths[i],checkramp(res.getData()+1,lengths[i],3,256));
+      }
+
+    // Seven columns: the vertical filter does the first four with vector code, if
+    // available, and the last three with scalar code; these repeat the first three
+    src.resize(7,41);
+    randomize(src,random);
+    for(y=0; y<41; ++y){
+      for(x=4; x<7; ++x){ src.setPixel(x,y,src.getPixel(x-4,y)); }
+      }
+    for(i=0; i<(FXint)ARRAYNUMBER(lengths); ++i){
+      dst.resize(7,lengths[i]);
+      src.scale(dst,q);
+      for(y=0,ok=true; y<lengths[i]; ++y){
+        for(x=4; x<7; ++x){ ok&=(dst.getPixel(x,y)==dst.getPixel(x-4,y)); }
+        }
+      errors+=check(name,7,lengths[i],ok);
+
+      // Horizontal filter agrees with the vertical one on the transposed image
+      transpose(tra,src);
+      res.resize(lengths[i],7);
+      tra.scale(res,q);
+      transpose(tra,dst);
+      errors+=check(name,lengths[i],7,same(tra,res));
+      }
+    }
+  return errors;
+  }
+
+
+// Compositing of straight alpha pixels against direct evaluation of the operators
+static FXint testcomposite(FXint w,FXint h,FXRandom& random){
+  static const char *const names[]={"over","in","out","atop","xor","add","multiply"};
+  FXPixelBuffer src(w,h);
+  FXPixelBuffer dst(w,h);
+  FXPixelBuffer res(w,h);
+  FXint errors=0;
+  FXdouble s,d,sa,da,r,worst;
+  FXint op,i,c,kept;
+  randomize(src,random);
+  randomize(dst,random);
+  for(i=0; i<w*h; i+=7){                // Some fully transparent source pixels
+    src.getData()[i]&=0x00FFFFFF;
+    }
+  for(op=FXPixelBuffer::CompositeOver; op<=FXPixelBuffer::CompositeMultiply; ++op){
+    memcpy(res.getData(),dst.getData(),sizeof(FXColor)*w*h);
+    res.composite(src,0,0,(FXPixelBuffer::Operator)op);
+    worst=0.0;
+    for(i=0; i<w*h; ++i){
+      const FXuchar* ps=(const FXuchar*)(src.getData()+i);
+      const FXuchar* pd=(const FXuchar*)(dst.getData()+i);
+      const FXuchar* pr=(const FXuchar*)(res.getData()+i);
+      sa=ps[3]/255.0;
+      da=pd[3]/255.0;
+      for(c=0; c<4; ++c){               // Compare premultiplied, in units of 1/255
+        s=(c==3)?sa:ps[c]*sa/255.0;
+        d=(c==3)?da:pd[c]*da/255.0;
+        switch(op){
+          case FXPixelBuffer::CompositeOver: r=s+d*(1.0-sa); break;
+          case FXPixelBuffer::CompositeIn: r=s*da; break;
+          case FXPixelBuffer::CompositeOut: r=s*(1.0-da); break;
+          case FXPixelBuffer::CompositeAtop: r=s*da+d*(1.0-sa); break;
+          case FXPixelBuffer::CompositeXor: r=s*(1.0-da)+d*(1.0-sa); break;
+          case FXPixelBuffer::CompositeAdd: r=FXMIN(s+d,1.0); break;
+          default: r=s*d+s*(1.0-da)+d*(1.0-sa); break;
+          }
+        worst=FXMAX(worst,Math::fabs(r-((c==3)?pr[3]:pr[c]*pr[3]/255.0)/255.0)*255.0);
+        }
+      }
+    errors+=check(names[op],w,h,worst<=2.5);
+
+    // Except for in and out, a transparent source pixel leaves the destination exactly as is
+    if(op!=FXPixelBuffer::CompositeIn && op!=FXPixelBuffer::CompositeOut){
+      for(i=kept=0; i<w*h; i+=7){
+        kept+=(res.getData()[i]==dst.getData()[i]);
+        }
+      errors+=check(names[op],w,h,kept==(w*h+6)/7);
+      }
+    }
+
+  // Compositing a buffer onto itself does nothing
+  memcpy(res.getData(),dst.getData(),sizeof(FXColor)*w*h);
+  res.composite(res,1,1,FXPixelBuffer::CompositeOver);
+  errors+=check("composite self",w,h,memcmp(res.getData(),dst.getData(),sizeof(FXColor)*w*h)==0);
+
+  // Only the clipped rectangle changes; clipping to the source leaves 25x23 at
+  // w-15,h-13, and clipping to the destination leaves 15x13 of that
+  res.fill(FXRGBA(10,20,30,255));
+  dst.fill(FXRGBA(200,0,0,255));
+  res.composite(dst,-5,-7,30,30,w-20,h-20);
+  FXint count=0;
+  for(i=0; i<w*h; ++i){ count+=(res.getData()[i]==FXRGBA(200,0,0,255)); }
+  errors+=check("composite clip",w,h,count==15*13 && res.getPixel(w-15,h-13)==FXRGBA(200,0,0,255));
+  return errors;
+  }
+
+
+// Run every operation; results should not depend on the number of threads
+static void runall(const FXPixelBuffer& src,FXPixelBuffer* out){
+  out[0].resize(src.getWidth()*3/2,src.getHeight()*2/3); src.scale(out[0],0);
+  out[1].resize(src.getWidth()*3/2,src.getHeight()*2/3); src.scale(out[1],1);
+  out[2].resize(src.getWidth()*2/3,src.getHeight()*3/2); src.scale(out[2],2);
+  out[3].resize(src.getWidth()+3,src.getHeight()); src.xshear(out[3],700,FXRGB(255,0,0));
+  out[4].resize(src.getWidth()+2,src.getHeight()); src.xshear(out[4],-300,FXRGB(0,255,0));
+  out[5].resize(src.getWidth(),src.getHeight()+3); src.yshear(out[5],700,FXRGB(0,0,255));
+  out[6].resize(src.getWidth(),src.getHeight()+2); src.yshear(out[6],-300,FXRGB(0,0,0));
+  out[7].resize(src.getWidth(),src.getHeight()); out[7].gradient(FXRGB(255,0,0),FXRGB(0,255,0),FXRGB(0,0,255),FXRGBA(255,255,255,0));
+  out[8].resize(src.getWidth(),src.getHeight()); out[8].hgradient(FXRGB(255,0,0),FXRGB(0,255,0));
+  out[9].resize(src.getWidth(),src.getHeight()); out[9].vgradient(FXRGB(255,0,0),FXRGB(0,255,0));
+  out[10].resize(src.getWidth(),src.getHeight()); memcpy(out[10].getData(),src.getData(),sizeof(FXColor)*src.getWidth()*src.getHeight());
+  out[10].fade(FXRGB(128,128,128),100);
+  out[10].blend(FXRGB(20,40,60));
+  out[10].colorize(FXRGB(200,100,50));
+  out[10].invert();
+  out[11].resize(src.getWidth()*3/2,src.getHeight()*2/3); src.scale(out[11],3);
+  out[12].resize(src.getWidth()*2/3,src.getHeight()*3/2); src.scale(out[12],4);
+  out[13].resize(src.getWidth()/5+1,src.getHeight()/7+1); src.scale(out[13],4);
+  out[14].resize(src.getWidth(),src.getHeight()); out[14].vgradient(FXRGBA(255,0,0,0),FXRGBA(0,0,255,255));
+  out[14].composite(src,3,5,src.getWidth(),src.getHeight(),0,0,FXPixelBuffer::CompositeOver);
+  out[14].composite(src,0,0,FXPixelBuffer::CompositeMultiply);
+  }
+
+
+// Compare single-threaded against parallel
+static FXint testparallel(FXint w,FXint h,FXThreadPool* pool,FXRandom& random){
+  static const char *const names[]={"scale 0","scale 1","scale 2","xshear +","xshear -","yshear +","yshear -","gradient","hgradient","vgradient","fade/blend/colorize/invert","scale 3","scale 4","scale 4 reduce","composite"};
+  FXPixelBuffer src(w,h);
+  FXPixelBuffer ser[15];
+  FXPixelBuffer par[15];
+  FXint errors=0;
+  randomize(src,random);
+  FXThreadPool::instance(nullptr);
+  runall(src,ser);
+  FXThreadPool::instance(pool);
+  runall(src,par);
+  for(FXint i=0; i<15; ++i){
+    errors+=check(names[i],w,h,same(ser[i],par[i]));
+    }
+  return errors;
+  }
+
+
+// Time operation
+template<typename Functor>
+static void timeit(const char* what,FXint count,const Functor& fun){
+  FXTime start=FXThread::steadytime();
+  for(FXint i=0; i<count; ++i){ fun(); }
+  FXTime elapsed=FXThread::steadytime()-start;
+  fxmessage("%-16s %10.3lf ms\n",what,elapsed*1.0E-6/count);
+  }
+
+
+// Time operations on large buffer
+static void benchmark(FXint w,FXint h,FXint count,FXRandom& random){
+  FXPixelBuffer src(w,h);
+  FXPixelBuffer rot(h,w);
+  FXPixelBuffer flat(w,h);
+  FXPixelBuffer big(w*3/2,h*3/2);
+  FXPixelBuffer small(w/10,h/10);
+  FXPixelBuffer sheared(w+4,h);
+  randomize(src,random);
+  fxmessage("%dx%d pixels, %d threads\n",w,h,FXThreadPool::instance()?FXThreadPool::instance()->getRunningThreads():1);
+  timeit("rotate 90",count,[&](){ src.rotate(rot,90); });
+  timeit("rotate 180",count,[&](){ src.rotate(flat,180); });
+  timeit("rotate 270",count,[&](){ src.rotate(rot,270); });
+  timeit("mirror",count,[&](){ flat.mirror(true,true); });
+  timeit("crop",count,[&](){ src.crop(flat,w/4,h/4); });
+  timeit("scale 0",count,[&](){ src.scale(big,0); });
+  timeit("scale 1",count,[&](){ src.scale(big,1); });
+  timeit("scale 2",count,[&](){ src.scale(big,2); });
+  timeit("scale 3",count,[&](){ src.scale(big,3); });
+  timeit("scale 4",count,[&](){ src.scale(big,4); });
+  timeit("scale 4 reduce",count,[&](){ src.scale(small,4); });
+  timeit("xshear",count,[&](){ src.xshear(sheared,1000); });
+  timeit("gradient",count,[&](){ flat.gradient(FXRGB(255,0,0),FXRGB(0,255,0),FXRGB(0,0,255),FXRGB(0,0,0)); });
+  timeit("fade",count,[&](){ flat.fade(FXRGB(128,128,128),100); });
+  timeit("composite",count,[&](){ flat.composite(src,0,0,FXPixelBuffer::CompositeOver); });
+  }
+
+
+/*******************************************************************************/
+
+// Print options
+void printusage(const char* prog){
+  fxmessage("%s options:\n",prog);
+  fxmessage("  --threads <number>          Number of threads.\n");
+  fxmessage("  --size <number>             Width and height of benchmark image.\n");
+  fxmessage("  --count <number>            Number of benchmark repetitions.\n");
+  fxmessage("  -h, --help                  Print help.\n");
+  }
+
+
+// Test program
+int main(int argc,char* argv[]){
+  FXint nthreads=4;
+  FXint size=1024;
+  FXint count=10;
+
+  // Grab a few arguments
+  for(FXint arg=1; arg<argc; ++arg){
+    if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0){
+      printusage(argv[0]);
+      exit(0);
+      }
+    else if(strcmp(argv[arg],"--threads")==0){
+      if(++arg>=argc){ fxmessage("Missing threads argument.\n"); exit(1); }
+      nthreads=strtol(argv[arg],nullptr,0);
+      if(nthreads<1){ fxmessage("Value for threads (%d) too small.\n",nthreads); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--size")==0){
+      if(++arg>=argc){ fxmessage("Missing size argument.\n"); exit(1); }
+      size=strtol(argv[arg],nullptr,0);
+      if(size<2){ fxmessage("Value for size (%d) too small.\n",size); exit(1); }
+      }
+    else if(strcmp(argv[arg],"--count")==0){
+      if(++arg>=argc){ fxmessage("Missing count argument.\n"); exit(1); }
+      count=strtol(argv[arg],nullptr,0);
+      if(count<1){ fxmessage("Value for count (%d) too small.\n",count); exit(1); }
+      }
+    else{
+      fxmessage("Bad argument: %s.\n",argv[arg]);
+      printusage(argv[0]);
+      exit(1);
+      }
+    }
+
+  // No application or display needed
+  FXRandom random(FXLONG(128628761545));
+  FXThreadPool pool;
+  FXint errors=0;
+
+  pool.setMaximumThreads(nthreads);
+  pool.start(nthreads);
+
+  // Odd sizes exercise partial tiles and bands
+  errors+=testgeometry(1,1,random);
+  errors+=testgeometry(1,77,random);
+  errors+=testgeometry(97,1,random);
+  errors+=testgeometry(33,31,random);
+  errors+=testgeometry(1000,37,random);
+  errors+=testgeometry(301,517,random);
+
+  errors+=testcomposite(97,31,random);
+  errors+=testfilter(random);
+
+  errors+=testparallel(7,5,&pool,random);
+  errors+=testparallel(1021,333,&pool,random);
+  errors+=testparallel(250,900,&pool,random);
+
+  fxmessage("pixel buffer tests: %s\n",errors?"failed":"ok");
+
+  // Time kernels
+  benchmark(size,size,count,random);
+
+  pool.stop();
+  return errors?1:0;
+  }
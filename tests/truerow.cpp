@@ -0,0 +1,129 @@
+/********************************************************************************
+*                                                                               *
+*                     T r u e   C o l o r   R o w   T e s t                     *
+*                                                                               *
+*********************************************************************************
+* Copyright (C) 2024 by Jeroen van der Zijp.   All Rights Reserved.             *
+********************************************************************************/
+#include "xincs.h"
+#include "fx.h"
+#include "../lib/fxtruerow.h"
+
+
+/*******************************************************************************/
+
+// Ordered dither matrix, same as that of the visual
+static const FXushort dithermatrix[16]={
+   0*16,  8*16,  2*16, 10*16,
+  12*16,  4*16, 14*16,  6*16,
+   3*16, 11*16,  1*16,  9*16,
+  15*16,  7*16, 13*16,  5*16,
+  };
+
+
+// Pixel layouts to try: alpha, shifts, largest values, swap
+struct Layout {
+  const char* name;
+  FXuint      bpp;
+  FXuint      alpha;
+  FXuint      rs,gs,bs;
+  FXuint      rm,gm,bm;
+  FXbool      swap;
+  };
+
+
+// Layouts of visuals seen on LSB and MSB displays
+static const Layout layouts[]={
+  {"32 bpp argb",   32,0xFF000000,16, 8, 0,255,255,255,false},
+  {"32 bpp xrgb",   32,0x00000000,16, 8, 0,255,255,255,false},
+  {"32 bpp bgra",   32,0x000000FF, 8,16,24,255,255,255,false},
+  {"32 bpp xbgr",   32,0x00000000, 0, 8,16,255,255,255,false},
+  {"24 bpp rgb",    24,0x00000000,16, 8, 0,255,255,255,false},
+  {"24 bpp bgr",    24,0x00000000, 0, 8,16,255,255,255,false},
+  {"16 bpp 565",    16,0x00000000,11, 5, 0, 31, 63, 31,false},
+  {"16 bpp 565 msb",16,0x00000000,11, 5, 0, 31, 63, 31,true},
+  {"16 bpp 555",    16,0x00008000,10, 5, 0, 31, 31, 31,false},
+  {"16 bpp 555 msb",16,0x00008000,10, 5, 0, 31, 31, 31,true},
+  {"16 bpp bgr 565",16,0x00000000, 0, 5,11, 31, 63, 31,false},
+  };
+
+
+// Widths around every vector width, and some long odd ones
+static FXint widths(FXint i){
+  return (i<72) ? i : (i==72) ? 127 : (i==73) ? 333 : 1001;
+  }
+
+
+// Compare each vector conversion against the plain one, on random rows; the
+// whole destination is compared, so writes past the end of the row show up
+static FXint testlayout(const Layout& l,FXRandom& random){
+  const FXint maxwidth=1001;
+  const FXint slack=64;
+  FXuchar *src=new FXuchar[maxwidth*4+slack];
+  FXuchar *ref=new FXuchar[maxwidth*4+slack];
+  FXuchar *dst=new FXuchar[maxwidth*4+slack];
+  TrueRowFunc funcs[4];
+  TrueLayout lay;
+  FXint errors=0;
+  FXint nfuncs,f,i,w,row,off,b;
+
+  // Set up layout
+  lay.alpha=l.alpha;
+  lay.rs=l.rs;
+  lay.gs=l.gs;
+  lay.bs=l.bs;
+  lay.rm=l.rm;
+  lay.gm=l.gm;
+  lay.bm=l.bm;
+  lay.swap=l.swap;
+  lay.dy=0;
+  for(row=0; row<4; ++row){
+    for(i=0; i<16; ++i){
+      lay.dither[row][i]=dithermatrix[(row<<2)|((i+row)&3)];
+      }
+    }
+
+  nfuncs=fxtruerowfuncs(funcs,l.bpp);
+  for(f=1; f<nfuncs; ++f){
+    for(i=0; i<75; ++i){
+      w=widths(i);
+      row=i&3;
+      off=(i>>2)&3;                     // Misalign destination by a few bytes
+      for(b=0; b<maxwidth*4+slack; ++b){
+        src[b]=(FXuchar)random.next();
+        ref[b]=dst[b]=(FXuchar)(b*7+1);
+        }
+      funcs[0](ref+off,src,w,lay.dither[row],lay);
+      funcs[f](dst+off,src,w,lay.dither[row],lay);
+      if(memcmp(ref,dst,maxwidth*4+slack)!=0){
+        fxmessage("%s: conversion %d of %d, width %d: failed\n",l.name,f,nfuncs-1,w);
+        errors++;
+        }
+      }
+    }
+  fxmessage("%-16s %d vector conversions: %s\n",l.name,nfuncs-1,errors?"failed":"ok");
+  delete [] src;
+  delete [] ref;
+  delete [] dst;
+  return errors;
+  }
+
+
+/*******************************************************************************/
+
+// Test program
+int main(int,char**){
+  FXRandom random(FXLONG(712649102834));
+  FXint errors=0;
+
+  // No application or display needed
+  for(FXuint l=0; l<ARRAYNUMBER(layouts); ++l){
+    errors+=testlayout(layouts[l],random);
+    }
+  if(errors){
+    fxmessage("%d failures\n",errors);
+    return 1;
+    }
+  fxmessage("all conversions ok\n");
+  return 0;
+  }